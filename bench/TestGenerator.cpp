@@ -0,0 +1,42 @@
+#include "generator.h"
+
+#include "proto/test-config.pb.h"
+
+#include <gtest/gtest.h>
+
+namespace config_much::bench {
+
+TEST(GeneratorTests, SameSeed) {
+    GeneratorOptions options;
+    options.field_density = 0.5;
+    options.error_rate    = 0.1;
+
+    // Benchmarks compare runs, the same seed must give the same input
+    Generator first{test_config::Config::descriptor(), options};
+    Generator second{test_config::Config::descriptor(), options};
+    ASSERT_FALSE(first.yaml().empty());
+    ASSERT_EQ(first.yaml(), second.yaml());
+    ASSERT_EQ(first.env("BENCH"), second.env("BENCH"));
+
+    options.seed = 7;
+    ASSERT_NE(Generator(test_config::Config::descriptor(), options).yaml(), first.yaml());
+}
+
+TEST(GeneratorTests, FitToSize) {
+    GeneratorOptions options;
+    options.seed          = 0;
+    options.field_density = 0.5;
+
+    // With this seed one more element adds more than the whole first sample
+    Generator generator{test_config::Validated::descriptor(), options};
+    generator.fit_to_size(4096);
+    ASSERT_GT(generator.options().repeated_length, 1);
+    ASSERT_GT(generator.yaml().size(), 1024);
+
+    // Without repeated fields the length is left alone
+    Generator flat{test_config::SubField::descriptor(), options};
+    flat.fit_to_size(4096);
+    ASSERT_EQ(flat.options().repeated_length, options.repeated_length);
+}
+
+} // namespace config_much::bench
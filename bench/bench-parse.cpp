@@ -0,0 +1,384 @@
+#include "config-much.h"
+#include "generator.h"
+#include "internal/bytes-value.h"
+#include "internal/case-convert.h"
+#include "internal/field-table.h"
+#include "internal/parser-env.h"
+#include "internal/parser-yaml.h"
+#include "internal/yaml-scanner.h"
+#include "internal/yaml-writer.h"
+
+#include "proto/test-config.pb.h"
+
+#include <benchmark/benchmark.h>
+#include <google/protobuf/descriptor.pb.h>
+#include <google/protobuf/dynamic_message.h>
+#include <google/protobuf/util/json_util.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+#include <unordered_set>
+
+// Every allocation of the process is counted, benchmarks report the ones made by what they measure
+namespace {
+std::atomic<uint64_t> allocations{0};
+} // namespace
+
+void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    void* ptr = std::malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+// Out of line, or compilers see free() called on what new returned once both are inlined
+[[gnu::noinline]] void operator delete(void* ptr) noexcept { std::free(ptr); }
+[[gnu::noinline]] void operator delete(void* ptr, size_t /*size*/) noexcept { std::free(ptr); }
+
+namespace config_much::bench {
+
+namespace {
+std::string make_yaml(size_t size) {
+    Generator generator{test_config::Config::descriptor(), {}};
+    generator.fit_to_size(size);
+    return generator.yaml();
+}
+} // namespace
+
+void BM_LoadYaml(benchmark::State& state) {
+    const auto input = make_yaml(state.range(0));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(YAML::Load(input));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input.size()));
+}
+BENCHMARK(BM_LoadYaml)->RangeMultiplier(8)->Range(1 << 10, 1 << 22);
+
+void BM_ParseYaml(benchmark::State& state) {
+    const auto input = make_yaml(state.range(0));
+    const auto node  = YAML::Load(input);
+    internal::ParserYaml parser("/bench.yml");
+
+    for (auto _ : state) {
+        test_config::Config cfg;
+        benchmark::DoNotOptimize(parser.parse(&cfg, node));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input.size()));
+}
+BENCHMARK(BM_ParseYaml)->RangeMultiplier(8)->Range(1 << 10, 1 << 22);
+
+void BM_ScanYaml(benchmark::State& state) {
+    const auto input = make_yaml(state.range(0));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(internal::YamlDocument::scan(input));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input.size()));
+}
+BENCHMARK(BM_ScanYaml)->RangeMultiplier(8)->Range(1 << 10, 1 << 22);
+
+// Load and parse from a buffer, with yaml-cpp or the scanner
+void BM_ParseYamlBackend(benchmark::State& state) {
+    const auto input   = make_yaml(state.range(0));
+    const auto backend = static_cast<internal::ParserYaml::Backend>(state.range(1));
+    if (backend == internal::ParserYaml::SCANNER && !internal::YamlDocument::scan(input)) {
+        state.SkipWithError("input not covered by the scanner");
+        return;
+    }
+
+    for (auto _ : state) {
+        test_config::Config cfg;
+        internal::ParserYaml parser(std::make_unique<MemorySource>("/bench.yml", input));
+        benchmark::DoNotOptimize(parser.set_backend(backend).parse(&cfg));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input.size()));
+}
+BENCHMARK(BM_ParseYamlBackend)->ArgsProduct({{1 << 10, 1 << 16, 1 << 22}, {0, 1}});
+
+// The same file parsed as several layers, one after the other or as an overlay
+void BM_ParseLayers(benchmark::State& state) {
+    const auto input = make_yaml(1 << 16);
+    Parser parser;
+    for (int64_t i = 0; i < state.range(0); i++) {
+        parser.add_buffer("/bench" + std::to_string(i) + ".yml", input);
+    }
+    parser.set_overlay(state.range(1) != 0);
+
+    for (auto _ : state) {
+        test_config::Config cfg;
+        benchmark::DoNotOptimize(parser.parse(&cfg));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input.size() * state.range(0)));
+}
+BENCHMARK(BM_ParseLayers)->ArgsProduct({{1, 4, 16}, {0, 1}});
+
+// Components with a section each, every one reading the file on its own or all dispatched from one pass
+void BM_ParseSections(benchmark::State& state) {
+    const auto sections = static_cast<size_t>(state.range(0));
+    std::string input;
+    for (size_t i = 0; i < sections; i++) {
+        input += "s" + std::to_string(i) + ":\n";
+        std::istringstream lines(make_yaml(1 << 14));
+        for (std::string line; std::getline(lines, line);) {
+            input += "  " + line + "\n";
+        }
+    }
+
+    std::vector<test_config::Config> configs(sections);
+    SectionRegistry registry;
+    registry.add_buffer("/bench.yml", input);
+    for (size_t i = 0; i < sections; i++) {
+        registry.bind("s" + std::to_string(i), &configs[i]);
+    }
+
+    for (auto _ : state) {
+        for (auto& cfg : configs) {
+            cfg.Clear();
+        }
+        if (state.range(1) != 0) {
+            benchmark::DoNotOptimize(registry.parse());
+            continue;
+        }
+        for (size_t i = 0; i < sections; i++) {
+            internal::ParserYaml parser(std::make_unique<MemorySource>("/bench.yml", input));
+            YAML::Node root;
+            benchmark::DoNotOptimize(parser.load(&root));
+            benchmark::DoNotOptimize(parser.parse(&configs[i], root["s" + std::to_string(i)]));
+        }
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input.size()));
+}
+BENCHMARK(BM_ParseSections)->ArgsProduct({{1, 4, 16}, {0, 1}});
+
+// Resolving camelCase keys to fields, converting each key to snake_case or matching it as written
+void BM_FindField(benchmark::State& state) {
+    const auto* descriptor = test_config::Config::descriptor();
+    const auto& table      = internal::FieldTable::get(descriptor);
+    std::vector<std::string> keys;
+    for (int i = 0; i < descriptor->field_count(); i++) {
+        keys.push_back(table.camel_name(descriptor->field(i)));
+    }
+
+    const uint64_t before = allocations.load();
+    for (auto _ : state) {
+        for (const auto& key : keys) {
+            if (state.range(0) == 0) {
+                benchmark::DoNotOptimize(descriptor->FindFieldByName(case_convert::camel_to_snake(key)));
+            } else {
+                benchmark::DoNotOptimize(table.find(key));
+            }
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * keys.size()));
+    state.counters["allocs_per_key"] =
+        static_cast<double>(allocations.load() - before) / static_cast<double>(state.iterations() * keys.size());
+}
+BENCHMARK(BM_FindField)->Arg(0)->Arg(1);
+
+// A message with sections top-level Config fields, built at runtime
+const google::protobuf::Descriptor* wide_descriptor(int sections) {
+    using google::protobuf::FieldDescriptorProto;
+    static google::protobuf::DescriptorPool pool(google::protobuf::DescriptorPool::generated_pool());
+
+    google::protobuf::FileDescriptorProto file;
+    file.set_name("wide" + std::to_string(sections) + ".proto");
+    file.set_syntax("proto3");
+    file.add_dependency(test_config::Config::descriptor()->file()->name());
+    auto* message = file.add_message_type();
+    message->set_name("Wide" + std::to_string(sections));
+    for (int i = 0; i < sections; i++) {
+        auto* field = message->add_field();
+        field->set_name("section" + std::to_string(i));
+        field->set_number(i + 1);
+        field->set_label(FieldDescriptorProto::LABEL_OPTIONAL);
+        field->set_type(FieldDescriptorProto::TYPE_MESSAGE);
+        field->set_type_name(".test_config.Config");
+    }
+
+    const auto* built = pool.FindFileByName(file.name());
+    if (built == nullptr) {
+        built = pool.BuildFile(file);
+    }
+    return built->message_type(0);
+}
+
+// A wide file decoded in sequence, or by a pool of range(0) threads
+void BM_ParseParallel(benchmark::State& state) {
+    const auto* descriptor = wide_descriptor(32);
+    Generator generator{descriptor, {}};
+    generator.fit_to_size(1 << 20);
+    const auto input = generator.yaml();
+
+    google::protobuf::DynamicMessageFactory factory;
+    std::unique_ptr<google::protobuf::Message> msg(factory.GetPrototype(descriptor)->New());
+
+    const auto threads = static_cast<size_t>(state.range(0));
+    WorkStealingPool pool(std::max<size_t>(threads, 1));
+    internal::ParserYaml parser(std::make_unique<MemorySource>("/wide.yml", input));
+    parser.set_backend(internal::ParserYaml::SCANNER);
+    if (threads != 0) {
+        parser.set_parallel(pool.executor(), 1);
+    }
+
+    for (auto _ : state) {
+        msg->Clear();
+        benchmark::DoNotOptimize(parser.parse(msg.get()));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input.size()));
+}
+BENCHMARK(BM_ParseParallel)->Arg(0)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
+void BM_ParseRepeatedEnum(benchmark::State& state) {
+    std::string input = "field_repeated_enum:\n";
+    for (int64_t i = 0; i < state.range(0); i++) {
+        input += (i % 2) == 0 ? "- type1\n" : "- TYPE2\n";
+    }
+    const auto node = YAML::Load(input);
+    internal::ParserYaml parser("/bench.yml");
+
+    for (auto _ : state) {
+        test_config::Config cfg;
+        benchmark::DoNotOptimize(parser.parse(&cfg, node));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ParseRepeatedEnum)->RangeMultiplier(8)->Range(1 << 6, 1 << 15);
+
+void BM_ParseEnv(benchmark::State& state) {
+    GeneratorOptions options;
+    options.repeated_length = state.range(0);
+    for (const auto& [name, value] : Generator{test_config::Config::descriptor(), options}.env("BENCH")) {
+        setenv(name.c_str(), value.c_str(), 1);
+    }
+    internal::ParserEnv parser("BENCH");
+
+    for (auto _ : state) {
+        test_config::Config cfg;
+        benchmark::DoNotOptimize(parser.parse(&cfg));
+    }
+}
+BENCHMARK(BM_ParseEnv)->RangeMultiplier(8)->Range(1, 1 << 9);
+
+void BM_Base64Decode(benchmark::State& state) {
+    // Every value is valid base64, so decoding never bails out early
+    std::string input(state.range(0), 'A');
+    for (size_t i = 0; i < input.size(); i++) {
+        input[i] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"[(i * 7) % 64];
+    }
+    const bool simd = state.range(1) != 0;
+
+    std::string out;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(internal::base64_decode(input, &out, simd));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input.size()));
+}
+BENCHMARK(BM_Base64Decode)->ArgsProduct({{1 << 10, 1 << 16, 1 << 22}, {0, 1}});
+
+void BM_ParseMetrics(benchmark::State& state) {
+    const auto input = make_yaml(state.range(0));
+
+    Metrics metrics;
+    Parser parser;
+    parser.add_buffer("/bench.yml", input);
+    if (state.range(1) != 0) {
+        parser.set_metrics(&metrics);
+    }
+
+    for (auto _ : state) {
+        test_config::Config cfg;
+        benchmark::DoNotOptimize(parser.parse(&cfg));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input.size()));
+}
+BENCHMARK(BM_ParseMetrics)->ArgsProduct({{1 << 10, 1 << 16}, {0, 1}});
+
+void BM_LookupPath(benchmark::State& state) {
+    test_config::Config cfg;
+    cfg.mutable_field_message()->set_enabled(true);
+    const FlatView view(cfg);
+    const bool flat = state.range(0) != 0;
+
+    for (auto _ : state) {
+        if (flat) {
+            benchmark::DoNotOptimize(view.get<bool>("field_message.enabled"));
+            continue;
+        }
+
+        // What generic components do without a view
+        const auto* field = cfg.GetDescriptor()->FindFieldByName("field_message");
+        const auto& msg   = cfg.GetReflection()->GetMessage(cfg, field);
+        benchmark::DoNotOptimize(
+            msg.GetReflection()->GetBool(msg, msg.GetDescriptor()->FindFieldByName("enabled")));
+    }
+}
+BENCHMARK(BM_LookupPath)->Arg(0)->Arg(1);
+
+void BM_Contains(benchmark::State& state) {
+    test_config::Lists lists;
+    for (int64_t i = 0; i < state.range(0); i++) {
+        lists.add_hosts("tenant-" + std::to_string(i * 2) + ".example.com");
+    }
+    std::vector<std::string> probes;
+    for (int64_t i = 0; i < 1024; i++) {
+        probes.push_back("tenant-" + std::to_string(i * 7 % (state.range(0) * 2)) + ".example.com");
+    }
+
+    // The second argument is the index kind, -1 for the set every service builds for itself without one
+    const auto* field = lists.GetDescriptor()->FindFieldByName("hosts");
+    const std::unordered_set<std::string> set(lists.hosts().begin(), lists.hosts().end());
+    const MembershipIndex index(lists, field, static_cast<MembershipIndex::Kind>(std::max<int64_t>(state.range(1), 0)));
+
+    size_t i = 0;
+    for (auto _ : state) {
+        const auto& probe = probes[i++ % probes.size()];
+        benchmark::DoNotOptimize(state.range(1) < 0 ? set.count(probe) != 0 : index.contains(probe));
+    }
+}
+BENCHMARK(BM_Contains)->ArgsProduct({{1 << 10, 1 << 20}, {-1, 0, 1, 2}});
+
+void BM_WriteYaml(benchmark::State& state) {
+    const auto input = make_yaml(state.range(0));
+    test_config::Config cfg;
+    internal::ParserYaml("/bench.yml").parse(&cfg, YAML::Load(input));
+    const bool json = state.range(1) != 0;
+
+    std::string out;
+    for (auto _ : state) {
+        out.clear();
+        if (json) {
+            benchmark::DoNotOptimize(google::protobuf::util::MessageToJsonString(cfg, &out));
+        } else {
+            internal::YamlWriter().write(cfg, &out);
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * out.size()));
+}
+BENCHMARK(BM_WriteYaml)->ArgsProduct({{1 << 10, 1 << 16, 1 << 22}, {0, 1}});
+
+void BM_Fingerprint(benchmark::State& state) {
+    const auto input = make_yaml(state.range(0));
+    test_config::Config cfg;
+    internal::ParserYaml("/bench.yml").parse(&cfg, YAML::Load(input));
+    const bool serialize = state.range(1) != 0;
+
+    for (auto _ : state) {
+        if (serialize) {
+            benchmark::DoNotOptimize(std::hash<std::string>{}(cfg.SerializeAsString()));
+        } else {
+            benchmark::DoNotOptimize(Fingerprint(cfg).value());
+        }
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * cfg.ByteSizeLong()));
+}
+BENCHMARK(BM_Fingerprint)->ArgsProduct({{1 << 10, 1 << 16, 1 << 22}, {0, 1}});
+
+} // namespace config_much::bench
+
+BENCHMARK_MAIN();
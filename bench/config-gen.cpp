@@ -0,0 +1,113 @@
+#include "generator.h"
+
+#include <google/protobuf/descriptor.h>
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+void usage(const char* prog) {
+    std::cout << prog << " <MESSAGE> [OPTIONS]" << std::endl << std::endl;
+    std::cout << "<MESSAGE>" << std::endl
+              << "\tFull name of the message to generate, i.e. test_config.Config" << std::endl
+              << std::endl;
+    std::cout << "Options:" << std::endl
+              << "\t--seed <N>            Seed for the generator (default 42)" << std::endl
+              << "\t--depth <N>           Maximum sub-message depth (default 8)" << std::endl
+              << "\t--density <F>         Probability of a field being emitted (default 1.0)" << std::endl
+              << "\t--repeated <N>        Length of repeated fields (default 4)" << std::endl
+              << "\t--string-length <N>   Length of string values (default 16)" << std::endl
+              << "\t--enum-density <F>    Probability of non-default enum values (default 0.5)" << std::endl
+              << "\t--error-rate <F>      Probability of injecting an invalid value (default 0)" << std::endl
+              << "\t--camelcase           Emit camelCase keys" << std::endl
+              << "\t--size <BYTES>        Scale repeated fields to approximate this output size" << std::endl
+              << "\t--env <PREFIX>        Emit NAME=value environment lines instead of YAML" << std::endl
+              << "\t-o <FILE>             Write to FILE instead of stdout" << std::endl;
+}
+
+int main(int argc, const char* argv[]) {
+    using namespace google::protobuf;
+
+    if (argc < 2) {
+        std::cerr << "Missing required argument" << std::endl;
+        usage(argv[0]);
+        return -1;
+    }
+
+    const Descriptor* descriptor = DescriptorPool::generated_pool()->FindMessageTypeByName(argv[1]);
+    if (descriptor == nullptr) {
+        std::cerr << "Unknown message '" << argv[1] << "'" << std::endl;
+        return -1;
+    }
+
+    config_much::bench::GeneratorOptions options;
+    size_t size            = 0;
+    const char* env_prefix = nullptr;
+    const char* output     = nullptr;
+
+    for (int i = 2; i < argc; i++) {
+        const char* arg = argv[i];
+        if (std::strcmp(arg, "--camelcase") == 0) {
+            options.camelcase = true;
+            continue;
+        }
+
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            usage(argv[0]);
+            return -1;
+        }
+        const char* value = argv[++i];
+
+        if (std::strcmp(arg, "--seed") == 0) {
+            options.seed = std::stoull(value);
+        } else if (std::strcmp(arg, "--depth") == 0) {
+            options.max_depth = std::stoi(value);
+        } else if (std::strcmp(arg, "--density") == 0) {
+            options.field_density = std::stod(value);
+        } else if (std::strcmp(arg, "--repeated") == 0) {
+            options.repeated_length = std::stoull(value);
+        } else if (std::strcmp(arg, "--string-length") == 0) {
+            options.string_length = std::stoull(value);
+        } else if (std::strcmp(arg, "--enum-density") == 0) {
+            options.enum_density = std::stod(value);
+        } else if (std::strcmp(arg, "--error-rate") == 0) {
+            options.error_rate = std::stod(value);
+        } else if (std::strcmp(arg, "--size") == 0) {
+            size = std::stoull(value);
+        } else if (std::strcmp(arg, "--env") == 0) {
+            env_prefix = value;
+        } else if (std::strcmp(arg, "-o") == 0) {
+            output = value;
+        } else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            usage(argv[0]);
+            return -1;
+        }
+    }
+
+    config_much::bench::Generator generator{descriptor, options};
+    if (size != 0) {
+        generator.fit_to_size(size);
+    }
+
+    std::ofstream file;
+    if (output != nullptr) {
+        file.open(output);
+        if (!file) {
+            std::cerr << "Failed to open " << output << std::endl;
+            return -1;
+        }
+    }
+    std::ostream& out = output != nullptr ? file : std::cout;
+
+    if (env_prefix != nullptr) {
+        for (const auto& [name, value] : generator.env(env_prefix)) {
+            out << name << '=' << value << std::endl;
+        }
+    } else {
+        out << generator.yaml();
+    }
+
+    return 0;
+}
@@ -0,0 +1,265 @@
+#include "generator.h"
+
+#include "internal/case-convert.h"
+
+#include <algorithm>
+
+namespace config_much::bench {
+
+// Static helpers
+namespace {
+/**
+ * splitmix64, unlike the standard distributions its output is the same
+ * on every platform and standard library.
+ */
+class Rng {
+public:
+    explicit Rng(uint64_t seed) : state_(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (state_ += 0x9e3779b97f4a7c15ULL);
+        z          = (z ^ (z >> 30U)) * 0xbf58476d1ce4e5b9ULL;
+        z          = (z ^ (z >> 27U)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31U);
+    }
+
+    uint64_t below(uint64_t n) { return n == 0 ? 0 : next() % n; }
+    bool chance(double p) { return static_cast<double>(next() >> 11U) * 0x1.0p-53 < p; }
+
+private:
+    uint64_t state_;
+};
+
+class Writer {
+public:
+    Writer(const GeneratorOptions& options) : options_(options), rng_(options.seed) {}
+
+    void yaml(const google::protobuf::Descriptor* descriptor, int depth, std::string& out);
+    void env(const google::protobuf::Descriptor* descriptor, const std::string& prefix, int depth,
+             std::vector<std::pair<std::string, std::string>>& out);
+
+private:
+    std::string scalar(const google::protobuf::FieldDescriptor* field, bool yaml);
+    std::string invalid(const google::protobuf::FieldDescriptor* field);
+    std::string random_string();
+    std::string random_decimal();
+
+    static bool is_supported(const google::protobuf::FieldDescriptor* field);
+
+    const GeneratorOptions& options_;
+    Rng rng_;
+    uint64_t unknown_ = 0;
+};
+
+bool Writer::is_supported(const google::protobuf::FieldDescriptor* field) {
+    using namespace google::protobuf;
+
+    if (field->type() == FieldDescriptor::TYPE_BYTES || field->type() == FieldDescriptor::TYPE_GROUP) {
+        return false;
+    }
+    return !(field->is_repeated() && field->type() == FieldDescriptor::TYPE_MESSAGE);
+}
+
+std::string Writer::random_string() {
+    static constexpr std::string_view alphabet = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+
+    std::string out;
+    out.reserve(options_.string_length);
+    for (size_t i = 0; i < options_.string_length; i++) {
+        out += alphabet[rng_.below(alphabet.size())];
+    }
+    return out;
+}
+
+std::string Writer::random_decimal() {
+    auto integer  = static_cast<int64_t>(rng_.below(2000000)) - 1000000;
+    auto fraction = rng_.below(1000);
+
+    std::string out = std::to_string(integer) + ".";
+    if (fraction < 100) {
+        out += fraction < 10 ? "00" : "0";
+    }
+    return out + std::to_string(fraction);
+}
+
+std::string Writer::invalid(const google::protobuf::FieldDescriptor* field) {
+    using namespace google::protobuf;
+
+    switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_BOOL:
+        return "maybe";
+    case FieldDescriptor::CPPTYPE_ENUM:
+        return "NOT_AN_ENUM_VALUE";
+    case FieldDescriptor::CPPTYPE_STRING:
+    case FieldDescriptor::CPPTYPE_MESSAGE:
+        // Any scalar is a valid string, a sequence is not
+        return "[]";
+    default:
+        return "not_a_number";
+    }
+}
+
+std::string Writer::scalar(const google::protobuf::FieldDescriptor* field, bool yaml) {
+    using namespace google::protobuf;
+
+    if (options_.error_rate > 0 && rng_.chance(options_.error_rate)) {
+        return invalid(field);
+    }
+
+    switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+        return std::to_string(static_cast<int32_t>(rng_.next()));
+    case FieldDescriptor::CPPTYPE_INT64:
+        return std::to_string(static_cast<int64_t>(rng_.next()));
+    case FieldDescriptor::CPPTYPE_UINT32:
+        return std::to_string(static_cast<uint32_t>(rng_.next()));
+    case FieldDescriptor::CPPTYPE_UINT64:
+        return std::to_string(rng_.next());
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+    case FieldDescriptor::CPPTYPE_FLOAT:
+        return random_decimal();
+    case FieldDescriptor::CPPTYPE_BOOL:
+        return rng_.chance(0.5) ? "true" : "false";
+    case FieldDescriptor::CPPTYPE_ENUM: {
+        const EnumDescriptor* desc = field->enum_type();
+        if (desc->value_count() > 1 && rng_.chance(options_.enum_density)) {
+            return desc->value(static_cast<int>(1 + rng_.below(desc->value_count() - 1)))->name();
+        }
+        return desc->value(0)->name();
+    }
+    case FieldDescriptor::CPPTYPE_STRING:
+        return yaml ? '"' + random_string() + '"' : random_string();
+    case FieldDescriptor::CPPTYPE_MESSAGE:
+        break;
+    }
+    return ""; // Unreachable
+}
+
+void Writer::yaml(const google::protobuf::Descriptor* descriptor, int depth, std::string& out) {
+    const std::string indent(static_cast<size_t>(depth) * 2, ' ');
+
+    for (int i = 0; i < descriptor->field_count(); i++) {
+        const auto* field = descriptor->field(i);
+        if (!is_supported(field) || !rng_.chance(options_.field_density)) {
+            continue;
+        }
+
+        const std::string name = options_.camelcase ? case_convert::snake_to_camel(field->name()) : field->name();
+
+        if (field->is_repeated()) {
+            out += indent + name + ":";
+            if (options_.repeated_length == 0) {
+                out += " []\n";
+                continue;
+            }
+
+            out += '\n';
+            for (size_t j = 0; j < options_.repeated_length; j++) {
+                out += indent + "- " + scalar(field, true) + '\n';
+            }
+            continue;
+        }
+
+        if (field->message_type() != nullptr) {
+            if (depth + 1 >= options_.max_depth) {
+                continue;
+            }
+
+            std::string sub;
+            yaml(field->message_type(), depth + 1, sub);
+            out += indent + name + ":" + (sub.empty() ? " {}\n" : "\n" + sub);
+            continue;
+        }
+
+        out += indent + name + ": " + scalar(field, true) + '\n';
+    }
+
+    if (options_.error_rate > 0 && rng_.chance(options_.error_rate)) {
+        out += indent + "unknown_field_" + std::to_string(unknown_++) + ": 1\n";
+    }
+}
+
+void Writer::env(const google::protobuf::Descriptor* descriptor, const std::string& prefix, int depth,
+                 std::vector<std::pair<std::string, std::string>>& out) {
+    for (int i = 0; i < descriptor->field_count(); i++) {
+        const auto* field = descriptor->field(i);
+        if (!is_supported(field) || !rng_.chance(options_.field_density)) {
+            continue;
+        }
+
+        const std::string name = prefix + '_' + case_convert::all_caps(case_convert::camel_to_snake(field->name()));
+
+        if (field->is_repeated()) {
+            for (size_t j = 0; j < options_.repeated_length; j++) {
+                out.emplace_back(name + '_' + std::to_string(j), scalar(field, false));
+            }
+            continue;
+        }
+
+        if (field->message_type() != nullptr) {
+            if (depth + 1 < options_.max_depth) {
+                env(field->message_type(), name, depth + 1, out);
+            }
+            continue;
+        }
+
+        out.emplace_back(name, scalar(field, false));
+    }
+}
+
+bool has_repeated(const google::protobuf::Descriptor* descriptor, int depth, int max_depth) {
+    if (depth >= max_depth) {
+        return false;
+    }
+
+    for (int i = 0; i < descriptor->field_count(); i++) {
+        const auto* field = descriptor->field(i);
+        if (field->is_repeated()) {
+            return true;
+        }
+
+        if (field->message_type() != nullptr && has_repeated(field->message_type(), depth + 1, max_depth)) {
+            return true;
+        }
+    }
+    return false;
+}
+} // namespace
+
+std::string Generator::yaml() const {
+    std::string out;
+    Writer{options_}.yaml(descriptor_, 0, out);
+    return out;
+}
+
+std::vector<std::pair<std::string, std::string>> Generator::env(const std::string& prefix) const {
+    std::vector<std::pair<std::string, std::string>> out;
+    Writer{options_}.env(descriptor_, case_convert::all_caps(prefix), 0, out);
+    return out;
+}
+
+void Generator::fit_to_size(size_t target_bytes) {
+    if (!has_repeated(descriptor_, 0, options_.max_depth)) {
+        return;
+    }
+
+    // Size grows linearly with the length of repeated fields, sample two
+    // points and solve for the length.
+    options_.repeated_length = 1;
+    const size_t one         = yaml().size();
+    options_.repeated_length = 2;
+    const size_t two         = yaml().size();
+
+    if (two <= one) {
+        options_.repeated_length = 1;
+        return;
+    }
+
+    // Fields drawn differ between samples, one element can cost more than the whole first sample
+    const auto per_element   = static_cast<int64_t>(two - one);
+    const auto base          = static_cast<int64_t>(one) - per_element;
+    const auto length        = (static_cast<int64_t>(target_bytes) - base) / per_element;
+    options_.repeated_length = static_cast<size_t>(std::max<int64_t>(1, length));
+}
+
+} // namespace config_much::bench
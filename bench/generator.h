@@ -0,0 +1,53 @@
+#pragma once
+
+#include <google/protobuf/descriptor.h>
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace config_much::bench {
+
+struct GeneratorOptions {
+    uint64_t seed          = 42;    ///< Same seed and options always produce the same output
+    int max_depth          = 8;     ///< Stop descending into sub-messages past this depth
+    double field_density   = 1.0;   ///< Probability of any given field being emitted
+    size_t repeated_length = 4;     ///< Number of elements in repeated fields
+    size_t string_length   = 16;    ///< Length of generated string values
+    double enum_density    = 0.5;   ///< Probability of an enum taking a non-default value
+    bool camelcase         = false; ///< Emit YAML keys in camelCase
+    double error_rate      = 0.0;   ///< Probability of a value being replaced by an invalid one
+};
+
+/**
+ * Produces synthetic configuration inputs for any message Descriptor,
+ * used to drive benchmarks and scaling tests.
+ */
+class Generator {
+public:
+    Generator(const google::protobuf::Descriptor* descriptor, GeneratorOptions options)
+        : descriptor_(descriptor), options_(options) {}
+
+    /// Generate a YAML document for the descriptor.
+    std::string yaml() const;
+
+    /// Generate a set of environment variables understood by ParserEnv.
+    std::vector<std::pair<std::string, std::string>> env(const std::string& prefix) const;
+
+    /**
+     * Adjust the length of repeated fields so the generated YAML is
+     * roughly target_bytes long.
+     *
+     * Has no effect on descriptors without repeated fields.
+     */
+    void fit_to_size(size_t target_bytes);
+
+    const GeneratorOptions& options() const { return options_; }
+
+private:
+    const google::protobuf::Descriptor* descriptor_;
+    GeneratorOptions options_;
+};
+
+} // namespace config_much::bench
@@ -1,12 +1,33 @@
 #pragma once
 
+#include "internal/atomic-snapshot.h"
+#include "internal/byte-source.h"
+#include "internal/config-history.h"
+#include "internal/default-values.h"
+#include "internal/deferred-sections.h"
+#include "internal/executor.h"
+#include "internal/fingerprint.h"
+#include "internal/flat-view.h"
+#include "internal/membership-index.h"
+#include "internal/memory-budget.h"
+#include "internal/metrics.h"
 #include "internal/parser-env.h"
 #include "internal/parser-error.h"
 #include "internal/parser-interface.h"
+#include "internal/parser-proto.h"
 #include "internal/parser-yaml.h"
+#include "internal/provenance.h"
+#include "internal/section-registry.h"
+#include "internal/shared-config.h"
+#include "internal/validation.h"
+#include "internal/work-stealing-pool.h"
 
 #include <google/protobuf/message.h>
 
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
 #include <optional>
 
 namespace config_much {
@@ -14,41 +35,428 @@ class Parser {
 public:
     Parser() = default;
 
-    ParserResult parse(google::protobuf::Message* msg) {
+    ParserResult parse(google::protobuf::Message* msg) { return parse(msg, nullptr); }
+
+    /**
+     * Run parse on the provided executor.
+     *
+     * The Parser and msg must outlive the returned future. Setting
+     * cancelled stops the parse before the next file or the environment
+     * is processed, in which case msg might be partially filled.
+     * Exceptions thrown by a source or a library while parsing are
+     * rethrown by the future's get().
+     */
+    std::future<ParserResult> parse_async(google::protobuf::Message* msg, const Executor& executor,
+                                          std::shared_ptr<std::atomic_bool> cancelled = nullptr) {
+        auto promise = std::make_shared<std::promise<ParserResult>>();
+        auto future  = promise->get_future();
+
+        executor([this, msg, promise, cancelled = std::move(cancelled)] {
+            try {
+                promise->set_value(parse(msg, cancelled.get()));
+            } catch (...) {
+                promise->set_exception(std::current_exception());
+            }
+        });
+        return future;
+    }
+
+    /// Files ending in .binpb or .txtpb are read as protobuf, anything else as YAML.
+    Parser& add_file(const std::filesystem::path& path) {
+        auto format = internal::ParserProto::format_for(path);
+        if (format) {
+            parsers_.emplace_back(std::make_unique<internal::ParserProto>(path, *format));
+        } else {
+            parsers_.emplace_back(std::make_unique<internal::ParserYaml>(path));
+        }
+        return *this;
+    }
+
+    /// Parse YAML from any source, i.e. a MemorySource or an FdSource.
+    Parser& add_source(std::unique_ptr<ByteSource> source) {
+        parsers_.emplace_back(std::make_unique<internal::ParserYaml>(std::move(source)));
+        return *this;
+    }
+
+    /// Parse YAML held in memory, data must outlive the Parser.
+    Parser& add_buffer(const std::string& name, std::string_view data) {
+        return add_source(std::make_unique<MemorySource>(name, data));
+    }
+
+    Parser& set_env_var_prefix(const std::string& prefix) {
+        parser_env_ = internal::ParserEnv(prefix);
+        metric_sources_.clear();
+        return *this;
+    }
+
+    /**
+     * Track which file or environment variable set each field.
+     *
+     * provenance is cleared and filled on every parse, it must outlive
+     * the Parser or be unset with nullptr.
+     */
+    Parser& set_provenance(Provenance* provenance) {
+        provenance_ = provenance;
+        return *this;
+    }
+
+    /**
+     * Count parses, errors and bytes read, and time every source.
+     *
+     * metrics can be shared by several Parsers, it must outlive them or
+     * be unset with nullptr.
+     */
+    Parser& set_metrics(Metrics* metrics) {
+        metrics_ = metrics;
+        metric_sources_.clear();
+        return *this;
+    }
+
+    /**
+     * Leave fields marked (config_much.deferred) to sections decoded on first access.
+     *
+     * Deferred fields stay unset in the parsed message, they are read
+     * through sections, which every parse resets. sections must outlive
+     * the Parser or be unset with nullptr.
+     */
+    Parser& set_deferred(DeferredSections* sections) {
+        deferred_ = sections;
+        return *this;
+    }
+
+    /**
+     * Publish a FlatView of the message after every successful parse.
+     *
+     * Readers load the latest view from flat_view whenever they like, a
+     * view they hold stays valid through later parses. Index options
+     * the view can't honour fail the parse. flat_view must outlive the
+     * Parser or be unset with nullptr.
+     */
+    Parser& set_flat_view(AtomicSnapshot<FlatView>* flat_view) {
+        flat_view_ = flat_view;
+        return *this;
+    }
+
+    /**
+     * Merge consecutive YAML files before decoding them instead of decoding each in turn.
+     *
+     * The result is the same, later files win key by key, but fields
+     * are decoded once no matter how many files set them. Errors in
+     * values a later file replaces aren't reported. Protobuf files and
+     * the environment still apply one after the other.
+     */
+    Parser& set_overlay(bool overlay) {
+        overlay_ = overlay;
+        return *this;
+    }
+
+    /**
+     * Decode large top-level sub-messages of YAML files in parallel on executor.
+     *
+     * Sub-messages are decoded the same way and errors come in the same
+     * order, see ParserYaml::set_parallel. Has no effect while
+     * provenance is tracked. executor must outlive the Parser, an empty
+     * one turns it off.
+     */
+    Parser& set_parallel(Executor executor) {
+        parallel_ = std::move(executor);
+        return *this;
+    }
+
+    /**
+     * Record every successful parse in history, along with the hashes of the files and buffers read.
+     *
+     * Sources are hashed as parsers get them, decompressed, and only
+     * while a history is set. Failed parses aren't recorded. history
+     * must outlive the Parser or be unset with nullptr.
+     */
+    Parser& set_history(ConfigHistory* history) {
+        history_ = history;
+        return *this;
+    }
+
+    /**
+     * Publish a Fingerprint of the message after every successful parse.
+     *
+     * With a history, the fingerprint is the one of the recorded
+     * version rather than a second hash of the message. fingerprint
+     * must outlive the Parser or be unset with nullptr.
+     */
+    Parser& set_fingerprint(AtomicSnapshot<Fingerprint>* fingerprint) {
+        fingerprint_ = fingerprint;
+        return *this;
+    }
+
+    /**
+     * Stop parsing once it used more than bytes of memory, 0 for no limit.
+     *
+     * Parsers charge every source they load and every node they decode
+     * to a MemoryBudget and stop decoding, even in the middle of a file,
+     * as soon as it is exceeded. The parse then fails with an error
+     * naming that source, or every file of an overlay, leaving msg
+     * partially filled. Charges are estimates, see MemoryBudget, not a
+     * hard limit on what the parse allocates.
+     */
+    Parser& set_memory_budget(size_t bytes) {
+        memory_budget_ = bytes;
+        return *this;
+    }
+
+private:
+    ParserResult parse(google::protobuf::Message* msg, const std::atomic_bool* cancelled) {
+        const auto start = std::chrono::steady_clock::now();
+        auto res         = parse_all(msg, cancelled);
+
+        std::shared_ptr<const FlatView> view;
+        if (!res && flat_view_ != nullptr) {
+            view = std::make_shared<const FlatView>(*msg);
+            if (!view->errors().empty()) {
+                res = view->errors();
+            }
+        }
+        if (metrics_ != nullptr) {
+            metrics_->parse_done(std::chrono::steady_clock::now() - start, res.has_value());
+            metrics_->measure(msg);
+        }
+
+        // Readers only ever see views of configurations that parsed cleanly
+        if (!res && flat_view_ != nullptr) {
+            flat_view_->store(std::move(view));
+        }
+        if (!res && history_ != nullptr) {
+            auto version = history_->record(*msg, sources());
+            if (fingerprint_ != nullptr) {
+                fingerprint_->store(std::shared_ptr<const Fingerprint>(version, &version->fingerprint()));
+            }
+        } else if (!res && fingerprint_ != nullptr) {
+            fingerprint_->store(std::make_shared<const Fingerprint>(*msg));
+        }
+        return res;
+    }
+
+    ParserResult parse_all(google::protobuf::Message* msg, const std::atomic_bool* cancelled) {
         std::vector<ParserError> errors;
+        auto is_cancelled = [cancelled] { return cancelled != nullptr && cancelled->load(); };
 
+        // Read all files up front with as few syscalls as possible, hashing them only matters for the history
+        std::vector<FileSource*> files;
         for (auto& parser : parsers_) {
-            auto err = parser->parse(msg);
+            auto* source = parser->source();
+            if (source != nullptr) {
+                source->set_hash_content(history_ != nullptr);
+            }
+            if (source != nullptr && source->as_file() != nullptr) {
+                files.push_back(source->as_file());
+            }
+        }
+        if (files.size() > 1) {
+            BatchReader{}.read(files);
+        }
+
+        if (provenance_ != nullptr) {
+            provenance_->clear();
+        }
+
+        // Every source layers on top of the defaults declared in the schema
+        const auto& defaults = internal::DefaultValues::get(*msg);
+        defaults.apply(msg, provenance_);
+        errors = defaults.errors();
+
+        if (deferred_ != nullptr) {
+            deferred_->reset(*msg);
+        }
+
+        // Charged by every source of this parse, each parser is handed it right before it runs
+        std::unique_ptr<MemoryBudget> budget;
+        if (memory_budget_ != 0) {
+            budget = std::make_unique<MemoryBudget>(memory_budget_);
+        }
+
+        for (size_t i = 0; i < parsers_.size(); i++) {
+            if (is_cancelled()) {
+                // Don't keep prefetched content around for the next parse
+                for (auto* file : files) {
+                    file->release();
+                }
+                return cancel();
+            }
+
+            size_t layers = 1;
+            while (overlay_ && i + layers < parsers_.size() && parsers_[i]->as_yaml() != nullptr &&
+                   parsers_[i + layers]->as_yaml() != nullptr) {
+                layers++;
+            }
+
+            const size_t first = i;
+            ParserResult err;
+            if (layers > 1) {
+                err = parse_layers(i, layers, msg, budget.get());
+                i += layers - 1;
+            } else {
+                parsers_[i]->set_provenance(provenance_);
+                parsers_[i]->set_deferred(deferred_);
+                parsers_[i]->set_budget(budget.get());
+                if (auto* yaml = parsers_[i]->as_yaml()) {
+                    yaml->set_parallel(parallel_);
+                }
+                err = parse_one(*parsers_[i], msg, source_metrics(i));
+            }
             if (err) {
+                add_errors(Metrics::FILE, err->size());
                 errors.insert(errors.end(), err->begin(), err->end());
             }
+
+            if (budget && budget->exceeded()) {
+                for (auto* file : files) {
+                    file->release();
+                }
+                // Overlaid files are decoded together, the budget can't tell them apart
+                std::string names;
+                for (size_t j = first; j <= i; j++) {
+                    auto* source = parsers_[j]->source();
+                    names += j > first ? ", " : "";
+                    names += source != nullptr ? source->name().string() : "";
+                }
+                errors.push_back(over_budget(names));
+                return errors;
+            }
         }
 
         if (parser_env_) {
-            auto err = parser_env_->parse(msg);
+            if (is_cancelled()) {
+                return cancel();
+            }
+
+            parser_env_->set_provenance(provenance_);
+            parser_env_->set_deferred(deferred_);
+            parser_env_->set_budget(budget.get());
+            auto err = parse_one(*parser_env_, msg, source_metrics(parsers_.size()));
             if (err) {
+                add_errors(Metrics::ENV, err->size());
                 errors.insert(errors.end(), err->begin(), err->end());
             }
+
+            if (budget && budget->exceeded()) {
+                errors.push_back(over_budget(parser_env_->prefix() + "_*"));
+                return errors;
+            }
         }
 
+        // Required fields can be set by any source, only check them once all are done
+        const size_t before    = errors.size();
+        const auto& validation = internal::ValidationProgram::get(msg->GetDescriptor());
+        validation.check_complete(*msg, "", errors, deferred_ == nullptr);
+        add_errors(Metrics::REQUIRED, errors.size() - before);
+
         if (!errors.empty()) {
             return errors;
         }
         return {};
     }
 
-    Parser& add_file(const std::filesystem::path& path) {
-        parsers_.emplace_back(std::make_unique<internal::ParserYaml>(path));
-        return *this;
+    /// Run a single parser, timing it when metrics are enabled.
+    static ParserResult parse_one(ParserInterface& parser, google::protobuf::Message* msg, Metrics::Source* metrics) {
+        if (metrics == nullptr) {
+            return parser.parse(msg);
+        }
+
+        auto* source         = parser.source();
+        const uint64_t bytes = source != nullptr ? source->bytes_read() : 0;
+        const auto start     = std::chrono::steady_clock::now();
+
+        auto err = parser.parse(msg);
+        metrics->latency.observe(std::chrono::steady_clock::now() - start);
+        if (source != nullptr) {
+            metrics->bytes.fetch_add(source->bytes_read() - bytes, std::memory_order_relaxed);
+        }
+        if (err) {
+            metrics->errors.fetch_add(err->size(), std::memory_order_relaxed);
+        }
+        return err;
     }
 
-    Parser& set_env_var_prefix(const std::string& prefix) {
-        parser_env_ = internal::ParserEnv(prefix);
-        return *this;
+    /// Parse count YAML parsers starting at first as an overlay, only their bytes read are measured.
+    ParserResult parse_layers(size_t first, size_t count, google::protobuf::Message* msg, MemoryBudget* budget) {
+        std::vector<internal::ParserYaml*> layers;
+        std::vector<uint64_t> bytes;
+        for (size_t i = first; i < first + count; i++) {
+            auto* parser = parsers_[i]->as_yaml();
+            parser->set_provenance(provenance_);
+            parser->set_deferred(deferred_);
+            parser->set_budget(budget);
+            parser->set_parallel(parallel_);
+            layers.push_back(parser);
+            bytes.push_back(parser->source()->bytes_read());
+        }
+
+        auto err = internal::ParserYaml::parse_overlay(layers, msg);
+        for (size_t i = 0; i < count; i++) {
+            auto* metrics = source_metrics(first + i);
+            if (metrics != nullptr) {
+                metrics->bytes.fetch_add(layers[i]->source()->bytes_read() - bytes[i], std::memory_order_relaxed);
+            }
+        }
+        return err;
+    }
+
+    std::vector<ConfigVersion::Source> sources() {
+        std::vector<ConfigVersion::Source> out;
+        for (auto& parser : parsers_) {
+            auto* source = parser->source();
+            if (source != nullptr) {
+                out.push_back({source->name().string(), source->content_hash()});
+            }
+        }
+        return out;
+    }
+
+    /// Metrics of the i-th parser, the environment comes after every file.
+    Metrics::Source* source_metrics(size_t i) {
+        if (metrics_ == nullptr) {
+            return nullptr;
+        }
+
+        // Resolved once, parsers are only ever appended
+        if (metric_sources_.size() != parsers_.size() + 1) {
+            metric_sources_.clear();
+            for (auto& parser : parsers_) {
+                auto* source = parser->source();
+                metric_sources_.push_back(&metrics_->source(source != nullptr ? source->name().string() : ""));
+            }
+            metric_sources_.push_back(parser_env_ ? &metrics_->source(parser_env_->prefix() + "_*") : nullptr);
+        }
+        return metric_sources_[i];
+    }
+
+    void add_errors(Metrics::ErrorKind kind, size_t count) {
+        if (metrics_ != nullptr && count != 0) {
+            metrics_->add_errors(kind, count);
+        }
+    }
+
+    ParserError over_budget(const std::string& source) {
+        add_errors(Metrics::BUDGET, 1);
+        ParserError err;
+        err << "Memory budget of " << memory_budget_ << " bytes exceeded while parsing " << source;
+        return err;
+    }
+
+    ParserResult cancel() {
+        add_errors(Metrics::CANCELLED, 1);
+        return {{"Parse cancelled"}};
     }
 
-private:
     std::vector<std::unique_ptr<ParserInterface>> parsers_;
     std::optional<internal::ParserEnv> parser_env_;
+    Provenance* provenance_                   = nullptr;
+    Metrics* metrics_                         = nullptr;
+    DeferredSections* deferred_               = nullptr;
+    AtomicSnapshot<FlatView>* flat_view_      = nullptr;
+    ConfigHistory* history_                   = nullptr;
+    AtomicSnapshot<Fingerprint>* fingerprint_ = nullptr;
+    bool overlay_                             = false;
+    size_t memory_budget_                     = 0;
+    Executor parallel_;
+    std::vector<Metrics::Source*> metric_sources_;
 };
 } // namespace config_much
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+namespace config_much {
+
+/**
+ * Holds the current version of a value, replaced as a whole.
+ *
+ * Readers get a shared_ptr that keeps the version they loaded alive
+ * for as long as they need it, even if a newer one is stored meanwhile.
+ */
+template <typename T> class AtomicSnapshot {
+public:
+    AtomicSnapshot() = default;
+    explicit AtomicSnapshot(std::shared_ptr<const T> value) : value_(std::move(value)) {}
+
+    /// nullptr until a first value is stored.
+    std::shared_ptr<const T> load() const {
+#if __cpp_lib_atomic_shared_ptr
+        return value_.load(std::memory_order_acquire);
+#else
+        return std::atomic_load_explicit(&value_, std::memory_order_acquire);
+#endif
+    }
+
+    void store(std::shared_ptr<const T> value) {
+#if __cpp_lib_atomic_shared_ptr
+        value_.store(std::move(value), std::memory_order_release);
+#else
+        std::atomic_store_explicit(&value_, std::move(value), std::memory_order_release);
+#endif
+    }
+
+    /// Store value and return the one it replaced.
+    std::shared_ptr<const T> exchange(std::shared_ptr<const T> value) {
+#if __cpp_lib_atomic_shared_ptr
+        return value_.exchange(std::move(value), std::memory_order_acq_rel);
+#else
+        return std::atomic_exchange_explicit(&value_, std::move(value), std::memory_order_acq_rel);
+#endif
+    }
+
+private:
+#if __cpp_lib_atomic_shared_ptr
+    std::atomic<std::shared_ptr<const T>> value_;
+#else
+    std::shared_ptr<const T> value_;
+#endif
+};
+
+} // namespace config_much
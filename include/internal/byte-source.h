@@ -0,0 +1,168 @@
+#pragma once
+
+#include "internal/parser-error.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace config_much {
+
+class FileSource;
+
+/**
+ * Provides the raw bytes parsers work on.
+ *
+ * Sources are loaded right before a parse and released right after it,
+ * so reloads always see up to date content.
+ */
+class ByteSource {
+public:
+    virtual ~ByteSource()                    = default;
+    ByteSource(const ByteSource&)            = delete;
+    ByteSource(ByteSource&&)                 = delete;
+    ByteSource& operator=(const ByteSource&) = delete;
+    ByteSource& operator=(ByteSource&&)      = delete;
+
+    ByteSource(std::filesystem::path name) : name_(std::move(name)) {}
+
+    virtual std::optional<ParserError> load() = 0;
+    virtual void release() {}
+
+    /// Bytes of the source, only valid between load() and release().
+    virtual std::string_view data() const = 0;
+
+    /// Name used to identify the source in error messages.
+    const std::filesystem::path& name() const { return name_; }
+
+    /// Sources that can take part in a batched read return themselves here.
+    virtual FileSource* as_file() { return nullptr; }
+
+    /// Bytes loaded over the lifetime of the source, across all loads.
+    uint64_t bytes_read() const { return bytes_read_; }
+
+    /**
+     * Hash of data() as of the last successful load, kept after release().
+     *
+     * It covers the bytes parsers get, decompressed ones for compressed
+     * files. Only computed while set_hash_content(true), 0 otherwise.
+     */
+    uint64_t content_hash() const { return content_hash_; }
+
+    /// Hash what the following loads hand to parsers, off by default as it reads every byte once more.
+    void set_hash_content(bool hash) { hash_content_ = hash; }
+
+protected:
+    /// Record a successful load that read bytes_read bytes, data() holds what parsers get.
+    void loaded(size_t bytes_read);
+
+private:
+    std::filesystem::path name_;
+    uint64_t bytes_read_   = 0;
+    uint64_t content_hash_ = 0;
+    bool hash_content_     = false;
+};
+
+/// Bytes already in memory, the caller must keep them alive.
+class MemorySource : public ByteSource {
+public:
+    MemorySource(std::filesystem::path name, std::string_view data) : ByteSource(std::move(name)), data_(data) {}
+
+    std::optional<ParserError> load() override {
+        loaded(data_.size());
+        return {};
+    }
+    std::string_view data() const override { return data_; }
+
+private:
+    std::string_view data_;
+};
+
+/// Maps a file into memory instead of reading it.
+class MmapSource : public ByteSource {
+public:
+    MmapSource(std::filesystem::path path) : ByteSource(std::move(path)) {}
+    ~MmapSource() override { MmapSource::release(); }
+
+    MmapSource(const MmapSource&)            = delete;
+    MmapSource(MmapSource&&)                 = delete;
+    MmapSource& operator=(const MmapSource&) = delete;
+    MmapSource& operator=(MmapSource&&)      = delete;
+
+    std::optional<ParserError> load() override;
+    void release() override;
+    std::string_view data() const override { return {addr_, size_}; }
+
+private:
+    const char* addr_ = nullptr;
+    size_t size_      = 0;
+};
+
+/// Reads from a descriptor opened by the caller, which keeps ownership of it.
+class FdSource : public ByteSource {
+public:
+    FdSource(int fd, std::filesystem::path name) : ByteSource(std::move(name)), fd_(fd) {}
+
+    std::optional<ParserError> load() override;
+    void release() override { buffer_ = std::string(); }
+    std::string_view data() const override { return buffer_; }
+
+private:
+    int fd_;
+    std::string buffer_;
+};
+
+/**
+ * Reads a file into memory, on its own or as part of a BatchReader.
+ *
+ * gzip and zstd files are recognized by their first bytes and handed to
+ * parsers decompressed, whatever their name. Files decompressing to more
+ * than max_decompressed bytes fail to load.
+ */
+class FileSource : public ByteSource {
+public:
+    static constexpr size_t MAX_DECOMPRESSED = size_t{1} << 30U;
+
+    FileSource(std::filesystem::path path, size_t max_decompressed = MAX_DECOMPRESSED)
+        : ByteSource(std::move(path)), max_decompressed_(max_decompressed) {}
+
+    std::optional<ParserError> load() override;
+    void release() override;
+    std::string_view data() const override { return buffer_; }
+
+    FileSource* as_file() override { return this; }
+
+private:
+    friend class BatchReader;
+
+    size_t max_decompressed_;
+    bool loaded_ = false;
+    std::optional<ParserError> error_;
+    std::string buffer_;
+};
+
+/**
+ * Loads several FileSources at once.
+ *
+ * When io_uring is available all reads are submitted with a single
+ * syscall, otherwise the files are read one by one with pread.
+ */
+class BatchReader {
+public:
+    BatchReader(bool use_io_uring = true) : use_io_uring_(use_io_uring) {}
+
+    /// Errors are not returned, they are reported by load() on each source.
+    void read(const std::vector<FileSource*>& files);
+
+    /// Whether the last read went through io_uring.
+    bool used_io_uring() const { return used_io_uring_; }
+
+private:
+    bool use_io_uring_;
+    bool used_io_uring_ = false;
+};
+
+} // namespace config_much
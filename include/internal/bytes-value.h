@@ -0,0 +1,34 @@
+#pragma once
+
+#include "internal/parser-error.h"
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace config_much::internal {
+
+/**
+ * Decode standard base64 into out.
+ *
+ * Whitespace is skipped and trailing padding is optional. When the CPU
+ * supports it, runs of clean input are decoded with AVX2, anything else
+ * goes through the scalar decoder.
+ */
+std::optional<ParserError> base64_decode(std::string_view input, std::string* out, bool allow_simd = true);
+
+/// Append input to out as standard base64, with padding.
+void base64_encode(std::string_view input, std::string* out);
+
+/**
+ * Decode the value of a bytes field.
+ *
+ * Values starting with "file:" reference a file whose content is copied
+ * into out straight from a mapping of it, relative paths are resolved
+ * against base_dir. Anything else is decoded as base64.
+ */
+std::optional<ParserError> parse_bytes(std::string_view value, const std::filesystem::path& base_dir,
+                                       std::string* out);
+
+} // namespace config_much::internal
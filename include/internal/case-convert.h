@@ -1,6 +1,9 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
 
 namespace config_much::case_convert {
 
@@ -8,4 +11,25 @@ std::string all_caps(const std::string& input);
 std::string snake_to_camel(const std::string& input);
 std::string camel_to_snake(const std::string& input, bool capitalize = false);
 
+/**
+ * Whether two names are spellings of the same name, without allocating.
+ *
+ * Names are split into words at '_' and '-', where camelCase or
+ * PascalCase words start and between letters and digits, then the
+ * words are compared ignoring case. "field_i32", "fieldI32",
+ * "field-i32" and "FIELD_I32" are all the same name.
+ */
+bool same_name(std::string_view lhs, std::string_view rhs);
+
+/// Hash that is the same for every spelling of a name, see same_name.
+uint64_t name_hash(std::string_view name);
+
+/// Hash and equality for containers keyed by names in any spelling.
+struct NameHash {
+    size_t operator()(std::string_view name) const { return name_hash(name); }
+};
+struct NameEqual {
+    bool operator()(std::string_view lhs, std::string_view rhs) const { return same_name(lhs, rhs); }
+};
+
 } // namespace config_much::case_convert
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "internal/atomic-snapshot.h"
+#include "internal/fingerprint.h"
+#include "internal/parser-error.h"
+
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/message.h>
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace config_much {
+
+/**
+ * A configuration as it was after a successful parse.
+ *
+ * The message is split into its top-level sub-messages, the sections,
+ * and the rest of its fields. Sections that didn't change from the
+ * previous version are the same objects, not copies.
+ */
+class ConfigVersion {
+public:
+    struct Source {
+        std::string name;
+        uint64_t hash = 0; ///< ByteSource::content_hash of what was parsed
+    };
+
+    /// Increases by one with every recorded version, starting at 1.
+    uint64_t number() const { return number_; }
+    std::chrono::system_clock::time_point parsed_at() const { return parsed_at_; }
+    const std::vector<Source>& sources() const { return sources_; }
+
+    /// Sub-message in the top-level field name, nullptr when it is unset or there is no such field.
+    const google::protobuf::Message* section(std::string_view name) const;
+
+    /// Every section is hashed on every record, those hashes tell which sections changed.
+    const Fingerprint& fingerprint() const { return fingerprint_; }
+
+    /// Fields of the message other than sections.
+    const google::protobuf::Message& root() const { return *root_; }
+
+    /// Rebuild the whole configuration into msg, of the type that was recorded.
+    void copy_to(google::protobuf::Message* msg) const;
+
+private:
+    friend class ConfigHistory;
+
+    uint64_t number_ = 0;
+    std::chrono::system_clock::time_point parsed_at_;
+    std::vector<Source> sources_;
+    Fingerprint fingerprint_;
+
+    std::shared_ptr<const google::protobuf::Message> root_;
+    std::vector<const google::protobuf::FieldDescriptor*> fields_;           ///< Section fields
+    std::vector<std::shared_ptr<const google::protobuf::Message>> sections_; ///< Per field, nullptr when unset
+};
+
+/**
+ * The last few versions of a configuration, one of which is current.
+ *
+ * Readers load current() whenever they like, a version they hold stays
+ * valid after it drops out of the history. Rolling back republishes a
+ * version still held without touching any file, in a single atomic
+ * store.
+ */
+class ConfigHistory {
+public:
+    /// Keep the last capacity versions, at least one.
+    explicit ConfigHistory(size_t capacity) : capacity_(capacity > 0 ? capacity : 1) {}
+
+    /**
+     * Record msg as a new version and make it current.
+     *
+     * Sections, and the rest of the message, equal to those of the
+     * newest version recorded so far are shared with it, only changed
+     * ones are copied. Parts are compared by the hashes of the
+     * fingerprint, then field by field when those match so a collision
+     * never shares a stale part. Records are serialized, readers don't
+     * wait for them.
+     */
+    std::shared_ptr<const ConfigVersion> record(const google::protobuf::Message& msg,
+                                                std::vector<ConfigVersion::Source> sources);
+
+    /// nullptr until a first version is recorded.
+    std::shared_ptr<const ConfigVersion> current() const { return current_.load(); }
+
+    /// Versions still held, oldest first.
+    std::vector<std::shared_ptr<const ConfigVersion>> versions() const;
+
+    /// Make version number current again, fails once it dropped out of the history.
+    ParserResult rollback(uint64_t number);
+
+    /// Make the version recorded before the current one current again.
+    ParserResult rollback();
+
+private:
+    size_t capacity_;
+    uint64_t next_number_ = 1;
+    AtomicSnapshot<ConfigVersion> current_;
+
+    std::mutex record_mutex_; ///< Held for a whole record
+    mutable std::mutex mutex_;
+    std::deque<std::shared_ptr<const ConfigVersion>> versions_;
+};
+
+} // namespace config_much
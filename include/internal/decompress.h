@@ -0,0 +1,34 @@
+#pragma once
+
+#include "internal/parser-error.h"
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace config_much::internal {
+
+enum class Compression {
+    NONE,
+    GZIP,
+    ZSTD,
+};
+
+/// Compression of a source, found from its first bytes.
+Compression detect_compression(std::string_view data);
+
+/**
+ * Replace the gzip or zstd stream in buffer by what it decompresses to.
+ *
+ * The output starts at a small multiple of the compressed size, or at
+ * the size the stream declares when that is smaller, and grows as the
+ * decoder writes into it in place, there is no intermediate copy.
+ * Streams decompressing to more than max_size bytes are rejected
+ * before that much is allocated. Concatenated gzip members and zstd frames are
+ * decompressed one after the other. zstd needs the library built with
+ * CONFIG_MUCH_ZSTD. Buffers that aren't compressed are left as they are.
+ */
+std::optional<ParserError> decompress(const std::filesystem::path& name, std::string& buffer, size_t max_size);
+
+} // namespace config_much::internal
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "internal/parser-error.h"
+#include "internal/provenance.h"
+
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/message.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace config_much::internal {
+
+/**
+ * The defaults declared with [(config_much.default_value) = "..."].
+ *
+ * Each default is decoded once into a prototype of the message, which
+ * is copied over the message before every parse instead of setting
+ * fields one by one. Defaults that fail to decode are reported on
+ * every parse, the prototype holds the others. The prototype comes
+ * from msg.New(), the DynamicMessageFactory of a dynamic message must
+ * never be destroyed either.
+ */
+class DefaultValues {
+public:
+    /// Prototypes are built on first use and live for the rest of the process.
+    static const DefaultValues& get(const google::protobuf::Message& msg);
+
+    explicit DefaultValues(const google::protobuf::Message& msg);
+
+    /// Whether the message declares any default, nested messages included.
+    bool empty() const { return prototype_ == nullptr; }
+
+    /// The message holding every default, nullptr when empty.
+    const google::protobuf::Message* prototype() const { return prototype_.get(); }
+
+    /// Replace the content of msg by the defaults, recording them as coming from the .proto files declaring them.
+    void apply(google::protobuf::Message* msg, Provenance* provenance) const;
+
+    const std::vector<ParserError>& errors() const { return errors_; }
+
+private:
+    struct Origin {
+        std::vector<const google::protobuf::FieldDescriptor*> fields; ///< From the root to the field
+        std::string file;                                             ///< .proto file declaring the default
+    };
+
+    /// path holds the fields leading to msg.
+    void collect(google::protobuf::Message* msg, std::vector<const google::protobuf::FieldDescriptor*>& path,
+                 std::vector<const google::protobuf::Descriptor*>& stack);
+
+    std::unique_ptr<google::protobuf::Message> prototype_;
+    std::vector<Origin> origins_;
+    std::vector<ParserError> errors_;
+};
+
+} // namespace config_much::internal
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "internal/executor.h"
+#include "internal/parser-error.h"
+
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/message.h>
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+namespace config_much {
+
+/**
+ * Top-level sub-messages marked (config_much.deferred), decoded on demand.
+ *
+ * During a parse, sources only hand over the part of their input that
+ * belongs to a deferred field, which is decoded the first time the
+ * section is accessed or by prefetch(). Sections are decoded at most
+ * once and independently of each other, readers of one section never
+ * wait on another.
+ *
+ * Parsing again replaces every section, it must not overlap with
+ * readers. Provenance isn't tracked for fields of deferred sections.
+ */
+class DeferredSections {
+public:
+    /// Decodes the share of a section one source holds into a message of the root type.
+    using Layer = std::function<ParserResult(google::protobuf::Message* root)>;
+
+    DeferredSections() = default;
+
+    /// Whether field is a singular sub-message marked deferred.
+    static bool marked(const google::protobuf::FieldDescriptor* field);
+
+    /// Drop every section and prepare new empty ones for the deferred fields of root.
+    void reset(const google::protobuf::Message& root);
+
+    /// Whether sources should hand field over instead of decoding it.
+    bool is_deferred(const google::protobuf::FieldDescriptor* field) const { return find(field) != nullptr; }
+
+    /// Layers are applied in the order they are added, like the sources they come from.
+    void add(const google::protobuf::FieldDescriptor* field, Layer layer);
+
+    /// The section held by field name, decoded on first access, nullptr for unknown names.
+    const google::protobuf::Message* get(std::string_view name);
+
+    template <typename T> const T* get(std::string_view name) {
+        const auto* msg = get(name);
+        return msg != nullptr && msg->GetDescriptor() == T::descriptor() ? static_cast<const T*>(msg) : nullptr;
+    }
+
+    /// Errors found while decoding the section, which is decoded if it wasn't yet.
+    ParserResult errors(std::string_view name);
+
+    /// Decode every section on executor, one task per section.
+    void prefetch(const Executor& executor);
+
+private:
+    struct Section {
+        const google::protobuf::FieldDescriptor* field = nullptr;
+        std::unique_ptr<google::protobuf::Message> root; ///< Only ever has field set
+        std::vector<Layer> layers;
+        std::once_flag once;
+        ParserResult errors;
+    };
+
+    static const google::protobuf::Message& decode(Section& section);
+
+    Section* find(const google::protobuf::FieldDescriptor* field) const;
+    Section* find(std::string_view name) const;
+
+    // Shared with prefetch tasks, which can outlive a reset
+    std::vector<std::shared_ptr<Section>> sections_;
+};
+
+} // namespace config_much
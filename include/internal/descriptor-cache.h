@@ -0,0 +1,44 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace config_much::internal {
+
+/**
+ * Values built once per descriptor and kept for the rest of the process.
+ *
+ * Entries are keyed by the descriptor's address and never evicted, so
+ * descriptors must come from the generated pool or from a
+ * DescriptorPool that is never destroyed: a pool built again can reuse
+ * the addresses of the old descriptors and be handed their stale
+ * values. Lookups of values already built only take a shared lock.
+ */
+template <typename K, typename T> class DescriptorCache {
+public:
+    /// Value of key, built by make, which returns a std::unique_ptr<T>, the first time it is asked for.
+    template <typename Make> const T& get(const K* key, Make&& make) {
+        {
+            std::shared_lock lock(mutex_);
+            auto it = values_.find(key);
+            if (it != values_.end()) {
+                return *it->second;
+            }
+        }
+
+        std::unique_lock lock(mutex_);
+        auto& value = values_[key];
+        if (!value) {
+            value = make();
+        }
+        return *value;
+    }
+
+private:
+    std::shared_mutex mutex_;
+    std::unordered_map<const K*, std::unique_ptr<T>> values_;
+};
+
+} // namespace config_much::internal
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <google/protobuf/descriptor.h>
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace config_much::internal {
+
+/**
+ * Resolves enum values by name or number without allocating.
+ *
+ * Names are matched case insensitively, numbers are only accepted if
+ * the enum defines them.
+ */
+class EnumTable {
+public:
+    /// Tables are built on first use and live for the rest of the process.
+    static const EnumTable& get(const google::protobuf::EnumDescriptor* descriptor);
+
+    explicit EnumTable(const google::protobuf::EnumDescriptor* descriptor);
+
+    std::optional<int> resolve(std::string_view value) const;
+
+private:
+    struct Slot {
+        std::string_view name; ///< Empty for unused slots
+        int number = 0;
+    };
+
+    std::optional<int> resolve_name(std::string_view name) const;
+    std::optional<int> resolve_number(std::string_view value) const;
+
+    std::vector<Slot> slots_;
+    std::vector<int> numbers_;
+    uint64_t mask_ = 0;
+};
+
+} // namespace config_much::internal
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <functional>
+#include <thread>
+
+namespace config_much {
+
+/**
+ * Anything that can run a task, possibly on a different thread.
+ *
+ * Thread pools, event loops or task schedulers can be adapted to this
+ * by wrapping their submit method in a lambda.
+ */
+using Executor = std::function<void(std::function<void()>)>;
+
+/// Runs every task on a newly spawned, detached thread.
+inline Executor thread_executor() {
+    return [](std::function<void()> task) { std::thread(std::move(task)).detach(); };
+}
+
+/// Runs every task on the calling thread before returning.
+inline Executor inline_executor() {
+    return [](std::function<void()> task) { task(); };
+}
+
+} // namespace config_much
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <google/protobuf/descriptor.h>
+
+#include <string>
+
+namespace config_much::internal {
+
+/**
+ * Path of a field from the root message, as the chain of fields leading to it.
+ *
+ * Parsers link one on the stack for every level they descend, so
+ * walking a message allocates nothing. The dotted form, e.g.
+ * "field_message.enabled", is only built for errors and lookups.
+ */
+struct FieldPath {
+    const FieldPath* parent                        = nullptr;
+    const google::protobuf::FieldDescriptor* field = nullptr; ///< nullptr for the root message
+
+    FieldPath child(const google::protobuf::FieldDescriptor* f) const { return {this, f}; }
+
+    bool empty() const { return field == nullptr; }
+
+    /// Schema names of the fields from the root joined by dots, empty for the root.
+    std::string str() const {
+        std::string out;
+        append_to(&out);
+        return out;
+    }
+
+    void append_to(std::string* out) const {
+        if (field == nullptr) {
+            return;
+        }
+        if (parent != nullptr && !parent->empty()) {
+            parent->append_to(out);
+            out->push_back('.');
+        }
+        out->append(field->name());
+    }
+};
+
+} // namespace config_much::internal
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <google/protobuf/descriptor.h>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace config_much::internal {
+
+/**
+ * Resolves keys to the fields of a message without allocating.
+ *
+ * Keys can spell field names in any convention, snake_case, camelCase,
+ * kebab-case or SCREAMING_SNAKE_CASE, and files can mix them freely.
+ */
+class FieldTable {
+public:
+    /// Tables are built on first use and live for the rest of the process.
+    static const FieldTable& get(const google::protobuf::Descriptor* descriptor);
+
+    explicit FieldTable(const google::protobuf::Descriptor* descriptor);
+
+    /// The field key names, nullptr if there's none.
+    const google::protobuf::FieldDescriptor* find(std::string_view key) const;
+
+    /// camelCase name of a field of the message, as snake_to_camel spells it.
+    const std::string& camel_name(const google::protobuf::FieldDescriptor* field) const {
+        return camel_names_[field->index()];
+    }
+
+private:
+    std::vector<const google::protobuf::FieldDescriptor*> slots_; ///< nullptr for unused slots
+    std::vector<std::string> camel_names_;
+    uint64_t mask_ = 0;
+};
+
+} // namespace config_much::internal
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/message.h>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace config_much {
+
+namespace internal {
+/// Hash of data, the same on every platform.
+uint64_t hash_bytes(std::string_view data);
+
+/**
+ * Canonical hash of the content of msg.
+ *
+ * Fields are hashed by number in number order, map entries in any
+ * order give the same hash, all NaNs are the same and unknown fields
+ * are ignored. The hash doesn't depend on the process, the
+ * platform or the protobuf version. Top-level sub-message fields are
+ * skipped when sections is false.
+ */
+uint64_t hash_message(const google::protobuf::Message& msg, bool sections = true);
+} // namespace internal
+
+/**
+ * Deterministic fingerprint of a configuration, with a hash per top-level sub-message.
+ *
+ * Equal configurations have equal fingerprints on every instance, so
+ * comparing fingerprints is enough to detect drift across a fleet and
+ * sections() tells which parts drifted.
+ */
+class Fingerprint {
+public:
+    struct Section {
+        const google::protobuf::FieldDescriptor* field;
+        uint64_t hash;
+    };
+
+    Fingerprint() = default;
+    explicit Fingerprint(const google::protobuf::Message& msg);
+
+    uint64_t value() const { return value_; }
+
+    /// Top-level sub-messages that are set, in field number order.
+    const std::vector<Section>& sections() const { return sections_; }
+
+    /// Hash of the sub-message in the top-level field name, nullopt when it is unset.
+    std::optional<uint64_t> section(std::string_view name) const;
+
+    /// Names of the sections that differ from other, set in only one of them included.
+    std::vector<std::string> changed(const Fingerprint& other) const;
+
+    /// The value as 16 hex digits.
+    std::string hex() const;
+
+    friend bool operator==(const Fingerprint& lhs, const Fingerprint& rhs) { return lhs.value_ == rhs.value_; }
+    friend bool operator!=(const Fingerprint& lhs, const Fingerprint& rhs) { return lhs.value_ != rhs.value_; }
+
+private:
+    friend class ConfigHistory;
+
+    /// Start from the hash of everything but the sections, which are then added in field number order.
+    explicit Fingerprint(uint64_t rest) : rest_(rest), value_(rest) {}
+    void add(const google::protobuf::FieldDescriptor* field, uint64_t hash);
+
+    uint64_t rest_  = 0;
+    uint64_t value_ = 0;
+    std::vector<Section> sections_;
+};
+
+} // namespace config_much
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "internal/membership-index.h"
+#include "internal/parser-error.h"
+
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/message.h>
+
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace config_much {
+
+/**
+ * A parsed message flattened into a single blob, indexed by field path.
+ *
+ * Every singular scalar, string and enum field reachable through
+ * singular sub-messages gets an entry, e.g. "field_message.enabled".
+ * Unset sub-messages are flattened with their default values, except
+ * for recursive types which are only followed while set. Repeated
+ * fields are left out, except those marked with a membership index,
+ * e.g. [(config_much.index) = HASH], whose index is built into the view.
+ * An index on a field that can't have one is reported in errors().
+ *
+ * Scalars sit in 8 byte slots at the start of the blob, in field order,
+ * so their offsets only depend on the message type. Lookups go through
+ * a perfect hash of the paths and never allocate.
+ */
+class FlatView {
+public:
+    explicit FlatView(const google::protobuf::Message& msg);
+
+    /**
+     * Value at path, nullopt for unknown paths or when T doesn't match the field.
+     *
+     * T is one of bool, int32_t, int64_t, uint32_t, uint64_t, float,
+     * double or std::string_view for string and bytes fields. Enums
+     * are read as int32_t, the view must outlive returned string_views.
+     */
+    template <typename T> std::optional<T> get(std::string_view path) const {
+        const Slot* slot = find(path);
+        if (slot == nullptr || !matches<T>(slot->type)) {
+            return {};
+        }
+
+        if constexpr (std::is_same_v<T, std::string_view>) {
+            return std::string_view(blob_.data() + slot->value, slot->size);
+        } else {
+            T value;
+            std::memcpy(&value, blob_.data() + slot->value, sizeof(T));
+            return value;
+        }
+    }
+
+    /// Index of the repeated field at path, nullptr when it isn't marked with one. Lives as long as the view.
+    const MembershipIndex* index(std::string_view path) const {
+        const Slot* slot = find(path);
+        return slot != nullptr && slot->type == INDEX ? &indexes_[slot->value] : nullptr;
+    }
+
+    /// Whether the indexed field at path holds value, false when it has no index.
+    bool contains(std::string_view path, std::string_view value) const {
+        const auto* found = index(path);
+        return found != nullptr && found->contains(value);
+    }
+
+    bool contains(std::string_view path, uint64_t value) const {
+        const auto* found = index(path);
+        return found != nullptr && found->contains(value);
+    }
+
+    /// Number of scalar paths in the view, indexes aside.
+    size_t size() const { return size_; }
+
+    const std::string& blob() const { return blob_; }
+
+    /// Index options on singular fields, or on fields of a type other than string, bytes, integer or enum.
+    const std::vector<ParserError>& errors() const { return errors_; }
+
+private:
+    struct Slot {
+        uint32_t path      = 0; ///< Offset of the path in the blob
+        uint32_t path_size = 0;
+        uint32_t value     = 0; ///< Offset of the value in the blob
+        uint32_t size      = 0; ///< Length of string values
+        uint8_t type       = 0; ///< FieldDescriptor::CppType, 0 for empty slots or INDEX
+    };
+
+    /// Type of the slots of indexed fields, whose value is their position in indexes_.
+    static constexpr uint8_t INDEX = UINT8_MAX;
+
+    template <typename T> static bool matches(uint8_t type) {
+        using google::protobuf::FieldDescriptor;
+        if constexpr (std::is_same_v<T, bool>) {
+            return type == FieldDescriptor::CPPTYPE_BOOL;
+        } else if constexpr (std::is_same_v<T, int32_t>) {
+            return type == FieldDescriptor::CPPTYPE_INT32 || type == FieldDescriptor::CPPTYPE_ENUM;
+        } else if constexpr (std::is_same_v<T, int64_t>) {
+            return type == FieldDescriptor::CPPTYPE_INT64;
+        } else if constexpr (std::is_same_v<T, uint32_t>) {
+            return type == FieldDescriptor::CPPTYPE_UINT32;
+        } else if constexpr (std::is_same_v<T, uint64_t>) {
+            return type == FieldDescriptor::CPPTYPE_UINT64;
+        } else if constexpr (std::is_same_v<T, float>) {
+            return type == FieldDescriptor::CPPTYPE_FLOAT;
+        } else if constexpr (std::is_same_v<T, double>) {
+            return type == FieldDescriptor::CPPTYPE_DOUBLE;
+        } else if constexpr (std::is_same_v<T, std::string_view>) {
+            return type == FieldDescriptor::CPPTYPE_STRING;
+        } else {
+            static_assert(!sizeof(T), "Unsupported type for FlatView::get");
+        }
+    }
+
+    const Slot* find(std::string_view path) const;
+
+    std::string blob_;
+    std::vector<Slot> slots_;
+    std::vector<uint32_t> seeds_; ///< Per bucket displacement of the perfect hash
+    std::vector<MembershipIndex> indexes_;
+    size_t size_ = 0;
+    std::vector<ParserError> errors_;
+};
+
+} // namespace config_much
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/message.h>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace config_much {
+
+/**
+ * The distinct values of a repeated field, for membership checks.
+ *
+ * Built once from string, bytes, integer or enum fields, the index owns
+ * a copy of the values and outlives the message. Integers of every
+ * width are compared as 64 bits, sign extended, so contains(-1) finds
+ * -1 in an int32 field. Fields of any other type give an empty index,
+ * see supports(). HASH indexes keep their values in the table alone.
+ */
+class MembershipIndex {
+public:
+    enum Kind : uint8_t {
+        SORTED, ///< Binary search over the sorted values
+        HASH,   ///< Open addressing table probed 16 slots at a time
+        BLOOM,  ///< Binary search behind a bloom filter
+    };
+
+    MembershipIndex(const google::protobuf::Message& msg, const google::protobuf::FieldDescriptor* field, Kind kind);
+
+    /// Whether field is of a type an index can be built from.
+    static bool supports(const google::protobuf::FieldDescriptor* field);
+
+    /// Whether a string or bytes field holds value, always false for integer fields.
+    bool contains(std::string_view value) const;
+
+    /// Whether an integer or enum field holds value, always false for string fields.
+    bool contains(uint64_t value) const;
+
+    /// Number of distinct values.
+    size_t size() const { return size_; }
+
+    Kind kind() const { return kind_; }
+
+private:
+    struct View {
+        uint32_t offset = 0; ///< Into blob_
+        uint32_t size   = 0;
+    };
+
+    std::string_view view(const View& v) const { return {blob_.data() + v.offset, v.size}; }
+
+    template <typename Equal> bool probe(uint64_t hash, Equal&& equal) const;
+    bool maybe(uint64_t hash) const;
+    void build_table(const std::vector<uint64_t>& hashes);
+
+    Kind kind_;
+    bool strings_ = false;
+    size_t size_  = 0;
+
+    std::string blob_;           ///< String values, back to back
+    std::vector<View> views_;    ///< SORTED and BLOOM only, sorted string values
+    std::vector<uint64_t> ints_; ///< SORTED and BLOOM only, sorted integer values
+
+    std::vector<int8_t> control_; ///< HASH only, 7 bits of the hash of each slot's value or EMPTY
+    std::vector<uint64_t> slots_; ///< HASH only, the integer or the offset and size of the string in each slot
+    std::vector<uint64_t> bloom_; ///< BLOOM only, a block of 64 bits per hash
+};
+
+} // namespace config_much
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+namespace config_much {
+
+/**
+ * Bytes a parse may use, charged by the parsers as they decode.
+ *
+ * Charges are estimates taken without walking the message: a source's
+ * loaded bytes, then a fixed cost for every decoded node plus the
+ * length of its text, meant to cover the document's tree and the field
+ * the node fills. Nothing is measured: yaml-cpp's node tree, with the
+ * default backend, and the message's own growth are only covered as
+ * far as NODE_COST happens to cover them, so this isn't a hard limit.
+ * Parsers stop decoding at the first charge past the limit. Safe to
+ * charge from several threads.
+ */
+class MemoryBudget {
+public:
+    /// Charged for every decoded node on top of its text.
+    static constexpr size_t NODE_COST = 64;
+
+    explicit MemoryBudget(size_t limit) : limit_(limit) {}
+
+    /// Add bytes to the bytes used, false once they went past the limit.
+    bool charge(size_t bytes) { return used_.fetch_add(bytes, std::memory_order_relaxed) + bytes <= limit_; }
+
+    bool exceeded() const { return used_.load(std::memory_order_relaxed) > limit_; }
+
+    size_t limit() const { return limit_; }
+    size_t used() const { return used_.load(std::memory_order_relaxed); }
+
+private:
+    size_t limit_;
+    std::atomic<size_t> used_{0};
+};
+
+} // namespace config_much
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <google/protobuf/message.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace config_much {
+
+/**
+ * Counters and latency histograms about parses, cheap enough to leave on.
+ *
+ * Recording only touches relaxed atomics, the registry of sources is
+ * locked when a source is first seen and when exporting. Everything is
+ * cumulative, except the message sizes which describe the last parse.
+ */
+class Metrics {
+public:
+    enum ErrorKind : uint8_t {
+        FILE = 0,  ///< Reading or parsing a file or buffer
+        ENV,       ///< Parsing environment variables
+        REQUIRED,  ///< Required fields still missing after every source
+        CANCELLED, ///< Parse cancelled before it was done
+        BUDGET,    ///< Parse stopped at the memory budget
+        ERROR_KINDS,
+    };
+
+    /// Latencies in power of two buckets, from 1us to about 33s.
+    class Histogram {
+    public:
+        static constexpr size_t BUCKETS = 26;
+
+        void observe(std::chrono::nanoseconds duration);
+
+        /// Upper bound of bucket i in seconds, i == BUCKETS is the +Inf bucket.
+        static double bound(size_t i);
+
+        /// Observations that fell in bucket i, not cumulative.
+        uint64_t bucket(size_t i) const { return buckets_[i].load(std::memory_order_relaxed); }
+        uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+        double sum() const { return static_cast<double>(sum_ns_.load(std::memory_order_relaxed)) / 1e9; }
+
+    private:
+        std::array<std::atomic<uint64_t>, BUCKETS + 1> buckets_{};
+        std::atomic<uint64_t> count_{0};
+        std::atomic<uint64_t> sum_ns_{0};
+    };
+
+    /// What is known about one file, buffer or environment prefix.
+    struct Source {
+        explicit Source(std::string n) : name(std::move(n)) {}
+
+        const std::string name;
+        std::atomic<uint64_t> bytes{0};
+        std::atomic<uint64_t> errors{0};
+        Histogram latency;
+    };
+
+    enum class Type : uint8_t { COUNTER, GAUGE, HISTOGRAM };
+
+    /// A single value handed to collect(), laid out like a Prometheus sample.
+    struct Sample {
+        std::string_view family; ///< e.g. config_much_parses_total
+        Type type;
+        std::string_view suffix; ///< _bucket, _sum or _count for histograms, empty otherwise
+        std::string labels;      ///< Escaped label set without braces, e.g. source="app.yml"
+        double value;
+    };
+
+    using Callback = std::function<void(const Sample&)>;
+
+    Metrics()                          = default;
+    Metrics(const Metrics&)            = delete;
+    Metrics(Metrics&&)                 = delete;
+    Metrics& operator=(const Metrics&) = delete;
+    Metrics& operator=(Metrics&&)      = delete;
+    ~Metrics()                         = default;
+
+    /// Registered on first use, the reference stays valid as long as the Metrics.
+    Source& source(const std::string& name);
+
+    void parse_done(std::chrono::nanoseconds duration, bool failed);
+
+    void add_errors(ErrorKind kind, size_t count) { errors_[kind].fetch_add(count, std::memory_order_relaxed); }
+
+    /**
+     * Record the memory used by msg and by each of its set top-level sub-messages.
+     *
+     * msg is walked once, it is left as it was but mustn't be read
+     * meanwhile: its sub-messages are detached while the rest of it is
+     * measured.
+     */
+    void measure(google::protobuf::Message* msg);
+
+    uint64_t parses() const { return parses_.load(std::memory_order_relaxed); }
+    uint64_t failures() const { return failures_.load(std::memory_order_relaxed); }
+    uint64_t errors(ErrorKind kind) const { return errors_[kind].load(std::memory_order_relaxed); }
+    const Histogram& latency() const { return latency_; }
+
+    /// Hand every sample to callback, samples of a family come one after the other.
+    void collect(const Callback& callback) const;
+
+    /// Everything in the Prometheus text exposition format.
+    std::string prometheus() const;
+
+private:
+    std::atomic<uint64_t> parses_{0};
+    std::atomic<uint64_t> failures_{0};
+    std::array<std::atomic<uint64_t>, ERROR_KINDS> errors_{};
+    Histogram latency_;
+
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<Source>> sources_;
+    size_t message_bytes_ = 0;
+    std::vector<std::pair<std::string, size_t>> field_bytes_;
+};
+
+} // namespace config_much
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "internal/case-convert.h"
+#include "internal/field-path.h"
 #include "internal/parser-interface.h"
 
 #include <gtest/gtest_prod.h>
@@ -12,15 +13,25 @@ public:
 
     ParserResult parse(google::protobuf::Message* msg) override;
 
+    const std::string& prefix() const { return prefix_; }
+
 private:
     FRIEND_TEST(ParserEnvTests, CamelToSnakeCase);
     FRIEND_TEST(ParserEnvTests, ToUpper);
     FRIEND_TEST(ParserEnvTests, CookEnvVar);
 
-    static void parse(google::protobuf::Message* msg, const std::string& prefix,
-                      const google::protobuf::FieldDescriptor* field);
-    static void parse_array(google::protobuf::Message* msg, const std::string& prefix,
-                            const google::protobuf::FieldDescriptor* field);
+    ParserResult parse(google::protobuf::Message* msg, const std::string& prefix,
+                       const google::protobuf::FieldDescriptor* field, const FieldPath& path);
+    ParserResult parse_array(google::protobuf::Message* msg, const std::string& prefix,
+                             const google::protobuf::FieldDescriptor* field);
+    ParserResult parse_array_enum(google::protobuf::Message* msg, const std::string& prefix,
+                                  const google::protobuf::FieldDescriptor* field);
+    ParserResult parse_array_bytes(google::protobuf::Message* msg, const std::string& prefix,
+                                   const google::protobuf::FieldDescriptor* field);
+
+    /// Bookkeeping after a field is set, records its provenance and validates it.
+    ParserResult field_set(const google::protobuf::Message* msg, const google::protobuf::FieldDescriptor* field,
+                           const FieldPath& path, const std::string& env_var);
 
     // Transformation methods for Environment Variables
     static std::string cook_env_var(const std::string& prefix, const std::string& suffix);
@@ -1,8 +1,12 @@
 #pragma once
 
+#include <charconv>
+#include <filesystem>
 #include <optional>
 #include <ostream>
-#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 
 namespace config_much {
@@ -21,12 +25,46 @@ public:
 
     const std::string& what() const { return msg_; }
 
-    template <typename T> friend ParserError& operator<<(ParserError& e, const T msg) {
-        std::stringstream ss;
-        ss << msg;
-        e.msg_ += ss.str();
+    // Appending formats in place, without a stream, so errors can be built where exceptions and locales are off
+    friend ParserError& operator<<(ParserError& e, std::string_view msg) {
+        e.msg_ += msg;
         return e;
     }
+    friend ParserError& operator<<(ParserError& e, const char* msg) { return e << std::string_view(msg); }
+    friend ParserError& operator<<(ParserError& e, const std::string& msg) { return e << std::string_view(msg); }
+    friend ParserError& operator<<(ParserError& e, char c) {
+        e.msg_ += c;
+        return e;
+    }
+    friend ParserError& operator<<(ParserError& e, const ParserError& other) { return e << other.msg_; }
+
+    /// Quoted like std::quoted, the way streams print paths.
+    friend ParserError& operator<<(ParserError& e, const std::filesystem::path& path) {
+        e.msg_ += '"';
+        for (char c : path.native()) {
+            if (c == '"' || c == '\\') {
+                e.msg_ += '\\';
+            }
+            e.msg_ += c;
+        }
+        e.msg_ += '"';
+        return e;
+    }
+
+    /// Numbers as streams print them by default, floating point with 6 significant digits.
+    template <typename T, std::enable_if_t<std::is_arithmetic_v<T> && !std::is_same_v<T, char>, int> = 0>
+    friend ParserError& operator<<(ParserError& e, T value) {
+        char buf[32];
+        std::to_chars_result res;
+        if constexpr (std::is_same_v<T, bool>) {
+            return e << (value ? '1' : '0');
+        } else if constexpr (std::is_floating_point_v<T>) {
+            res = std::to_chars(buf, buf + sizeof(buf), value, std::chars_format::general, 6);
+        } else {
+            res = std::to_chars(buf, buf + sizeof(buf), value);
+        }
+        return e << std::string_view(buf, res.ptr - buf);
+    }
 
     friend std::ostream& operator<<(std::ostream& os, const ParserError& err) {
         os << err.what();
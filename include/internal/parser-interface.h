@@ -1,11 +1,20 @@
 #pragma once
 
+#include "memory-budget.h"
 #include "parser-error.h"
+#include "provenance.h"
 
 #include <google/protobuf/message.h>
 
 namespace config_much {
 
+class ByteSource;
+class DeferredSections;
+
+namespace internal {
+class ParserYaml;
+} // namespace internal
+
 class ParserInterface {
 public:
     virtual ~ParserInterface()                         = default;
@@ -16,5 +25,25 @@ public:
     ParserInterface()                                  = default;
 
     virtual ParserResult parse(google::protobuf::Message* msg) = 0;
+
+    /// The source the parser reads from, if any.
+    virtual ByteSource* source() { return nullptr; }
+
+    /// YAML parsers return themselves here, so they can be parsed as layers of one document.
+    virtual internal::ParserYaml* as_yaml() { return nullptr; }
+
+    /// Record the origin of the fields set by the following parses, nullptr to stop.
+    void set_provenance(Provenance* provenance) { provenance_ = provenance; }
+
+    /// Hand deferred fields over to sections instead of decoding them, nullptr to stop.
+    void set_deferred(DeferredSections* deferred) { deferred_ = deferred; }
+
+    /// Charge what the following parses decode to budget and stop once it is exceeded, nullptr to stop.
+    void set_budget(MemoryBudget* budget) { budget_ = budget; }
+
+protected:
+    Provenance* provenance_     = nullptr;
+    DeferredSections* deferred_ = nullptr;
+    MemoryBudget* budget_       = nullptr;
 };
 } // namespace config_much
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "internal/byte-source.h"
+#include "internal/field-path.h"
+#include "internal/parser-interface.h"
+
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/text_format.h>
+
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace config_much::internal {
+/**
+ * Reads configuration serialized by protobuf itself.
+ *
+ * Layering follows the YAML parser, singular fields present in the
+ * input overwrite the ones already set and repeated fields are replaced
+ * as a whole instead of being appended to, as protobuf's merge would do.
+ */
+class ParserProto : public ParserInterface {
+public:
+    enum Format : uint8_t {
+        BINARY = 0, ///< Wire format, usually .binpb
+        TEXT,       ///< Text format, usually .txtpb
+    };
+
+    /// Binary files are mapped and parsed in place, text files are read.
+    ParserProto(const std::filesystem::path& file, Format format)
+        : ParserProto(format == BINARY ? std::unique_ptr<ByteSource>(std::make_unique<MmapSource>(file))
+                                       : std::make_unique<FileSource>(file),
+                      format) {}
+
+    ParserProto(std::unique_ptr<ByteSource> source, Format format)
+        : file_(source->name()), source_(std::move(source)), format_(format) {}
+
+    ParserResult parse(google::protobuf::Message* msg) override;
+
+    ByteSource* source() override { return source_.get(); }
+
+    /// Format to use for a file based on its extension, YAML files have none.
+    static std::optional<Format> format_for(const std::filesystem::path& file);
+
+private:
+    /// A field present in the input.
+    struct Touched {
+        google::protobuf::Message* msg;
+        const google::protobuf::FieldDescriptor* field;
+        std::string path; ///< Only spelled out for fields with rules, to report their errors
+        uint32_t line;
+        int kept = 0;                                                  ///< Elements held before a binary merge
+        std::unique_ptr<google::protobuf::Message> previous = nullptr; ///< Time value held before a binary merge
+    };
+
+    /// A deferred field left out of a binary merge, as a range of the input.
+    struct Skipped {
+        const google::protobuf::FieldDescriptor* field;
+        int begin;
+        int end;
+    };
+
+    ParserResult parse_binary(google::protobuf::Message* msg, std::string_view data);
+    ParserResult parse_text(google::protobuf::Message* msg, std::string_view data);
+
+    /// Merge a text format message parsed on its own, tree is optional.
+    ParserResult merge(google::protobuf::Message* msg, const google::protobuf::Message& layer,
+                       const google::protobuf::TextFormat::ParseInfoTree* tree);
+
+    bool scan(google::protobuf::io::CodedInputStream* input, google::protobuf::Message* msg, const FieldPath& path,
+              std::vector<Touched>& touched, std::vector<Skipped>& skipped);
+    void walk(const google::protobuf::Message& layer, google::protobuf::Message* msg, const FieldPath& path,
+              const google::protobuf::TextFormat::ParseInfoTree* tree, std::vector<Touched>& touched);
+
+    /// Record the provenance of a field present in the input and add it to touched.
+    void touch(google::protobuf::Message* msg, const FieldPath& path, uint32_t line, std::vector<Touched>& touched);
+
+    /// Deferred fields are only looked for at the top level.
+    bool is_deferred(const google::protobuf::FieldDescriptor* field, const FieldPath& path) const;
+
+    ParserResult finish(const std::vector<Touched>& touched);
+
+    std::filesystem::path file_;
+    std::unique_ptr<ByteSource> source_;
+    Format format_;
+    Provenance::SourceId source_id_ = 0;
+};
+} // namespace config_much::internal
@@ -1,11 +1,22 @@
 #pragma once
 
+#include "internal/byte-source.h"
+#include "internal/executor.h"
+#include "internal/field-path.h"
+#include "internal/field-table.h"
 #include "internal/parser-interface.h"
+#include "internal/time-parse.h"
+#include "internal/yaml-overlay.h"
+#include "internal/yaml-scanner.h"
 
 #include <yaml-cpp/yaml.h>
 
 #include <exception>
 #include <filesystem>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
 
 namespace config_much::internal {
 class ParserYaml : public ParserInterface {
@@ -16,38 +27,153 @@ public:
         UNKNOWN_FIELDS_ONLY, ///< Fail on unknown fields, but allow missing fields
     };
 
+    enum Backend : uint8_t {
+        YAML_CPP = 0, ///< Parse everything with yaml-cpp
+        SCANNER,      ///< Use YamlDocument, yaml-cpp only for what it doesn't cover
+    };
+
     ParserYaml(std::filesystem::path file, bool camelcase = false, ParserYaml::ValidationMode v = PERMISSIVE)
-        : file_(std::move(file)), camelcase_(camelcase), validation_mode_(v) {}
+        : ParserYaml(std::make_unique<FileSource>(std::move(file)), camelcase, v) {}
+
+    ParserYaml(std::unique_ptr<ByteSource> source, bool camelcase = false, ParserYaml::ValidationMode v = PERMISSIVE)
+        : file_(source->name()), source_(std::move(source)), camelcase_(camelcase), validation_mode_(v) {}
 
     ParserResult parse(google::protobuf::Message* msg) override;
     ParserResult parse(google::protobuf::Message* msg, const YAML::Node& node);
 
+    /// Read the whole source with yaml-cpp, the source is released either way.
+    std::optional<ParserError> load(YAML::Node* root);
+
+    /**
+     * Parse the files of several parsers as layers of a single document.
+     *
+     * Gives the same message as parsing them one after the other, but
+     * every field is decoded once, from the last layer that sets it.
+     * Values that later layers replace are never decoded, so they can't
+     * fail the parse. Layers are read with yaml-cpp and parsed with the
+     * options and the provenance of the first one.
+     */
+    static ParserResult parse_overlay(const std::vector<ParserYaml*>& layers, google::protobuf::Message* msg);
+
+    ByteSource* source() override { return source_.get(); }
+    ParserYaml* as_yaml() override { return this; }
+
+    /// Pick how files are read, the result is the same either way.
+    ParserYaml& set_backend(Backend backend) {
+        backend_ = backend;
+        return *this;
+    }
+
+    /**
+     * Decode large top-level sub-messages on executor, next to each other.
+     *
+     * Sub-messages whose map holds at least min_keys keys are handed out
+     * as tasks, the calling thread decodes its share and waits for the
+     * rest. Each task only writes to its own sub-message and errors come
+     * in the same order as when decoding in sequence. Ignored while
+     * provenance is tracked, an empty executor turns it off.
+     */
+    ParserYaml& set_parallel(Executor executor, size_t min_keys = 8) {
+        parallel_          = std::move(executor);
+        parallel_min_keys_ = min_keys;
+        return *this;
+    }
+
     const std::filesystem::path& get_file() { return file_; }
 
 private:
-    ParserResult parse(google::protobuf::Message* msg, const YAML::Node& node,
-                       const google::protobuf::FieldDescriptor* field, const std::string& path);
-    ParserResult parse_array(google::protobuf::Message* msg, const YAML::Node& node,
+    /// A top-level sub-message decoded by the parallel executor.
+    template <typename Node> struct Subtree {
+        const google::protobuf::FieldDescriptor* field;
+        google::protobuf::Message* msg;
+        Node node;
+        size_t errors_at; ///< Where its errors go among the document's
+        ParserResult errors;
+    };
+
+    template <typename Node> ParserResult parse_document(google::protobuf::Message* msg, const Node& node);
+    template <typename Node>
+    ParserResult parse(google::protobuf::Message* msg, const Node& node, const google::protobuf::FieldDescriptor* field,
+                       const FieldPath& path);
+    template <typename Node>
+    ParserResult parse_array(google::protobuf::Message* msg, const Node& node,
                              const google::protobuf::FieldDescriptor* field);
-    template <typename T>
-    ParserResult parse_array_inner(google::protobuf::Message* msg, const YAML::Node& node,
+    template <typename T, typename Node>
+    ParserResult parse_array_inner(google::protobuf::Message* msg, const Node& node,
                                    const google::protobuf::FieldDescriptor* field);
-    ParserResult parse_array_enum(google::protobuf::Message* msg, const YAML::Node& node,
+    template <typename Node>
+    ParserResult parse_array_enum(google::protobuf::Message* msg, const Node& node,
                                   const google::protobuf::FieldDescriptor* field);
-    ParserResult parse_scalar(google::protobuf::Message* msg, const YAML::Node& node,
+    template <typename Node>
+    ParserResult parse_array_bytes(google::protobuf::Message* msg, const Node& node,
+                                   const google::protobuf::FieldDescriptor* field);
+    template <typename Node>
+    ParserResult parse_scalar(google::protobuf::Message* msg, const Node& node,
                               const google::protobuf::FieldDescriptor* field, const std::string& name);
 
-    ParserResult find_unknown_fields(const google::protobuf::Message& msg, const YAML::Node& node);
+    template <typename Node>
+    ParserResult parse_time(google::protobuf::Message* msg, const Node& node,
+                            const google::protobuf::FieldDescriptor* field, TimeType type, const std::string& name);
 
-    ParserError wrap_error(const std::exception& e);
+    template <typename Node> void decode_parallel(std::vector<Subtree<Node>>& subtrees);
+    template <typename Node> ParserResult decode_subtree(const Subtree<Node>& subtree);
 
-    template <typename T> std::variant<T, ParserError> try_convert(const YAML::Node& node);
+    /// Hand a deferred field over to its section.
+    template <typename Node> void defer(const Node& node, const google::protobuf::FieldDescriptor* field);
+
+    template <typename Node> ParserResult find_unknown_fields(const google::protobuf::Message& msg, const Node& node);
+
+    /// Bookkeeping after a field is set, records its provenance and validates it.
+    template <typename Node>
+    ParserResult field_set(const google::protobuf::Message* msg, const google::protobuf::FieldDescriptor* field,
+                           const FieldPath& path, const Node& node);
+
+    ParserError wrap_error(const std::exception& e, const std::filesystem::path& file);
+
+    /// Name of a field as documents spell it, in the convention the parser was set up with. Paths use field->name().
+    const std::string& field_name(const google::protobuf::FieldDescriptor* field) const {
+        return camelcase_ ? FieldTable::get(field->containing_type()).camel_name(field) : field->name();
+    }
+
+    /// File the node was read from, one of the layers for overlays.
+    template <typename Node> const std::filesystem::path& file_of(const Node& node) const {
+        if constexpr (std::is_same_v<Node, OverlayNode>) {
+            return node.file();
+        } else {
+            return file_;
+        }
+    }
+
+    template <typename Node> Provenance::SourceId source_of(const Node& node) const {
+        if constexpr (std::is_same_v<Node, OverlayNode>) {
+            return layer_sources_.at(node.layer());
+        } else {
+            return source_id_;
+        }
+    }
+
+    template <typename T> std::variant<T, ParserError> try_convert(const YAML::Node& node) {
+        return try_convert<T>(node, file_);
+    }
+    template <typename T>
+    std::variant<T, ParserError> try_convert(const YAML::Node& node, const std::filesystem::path& file);
+    template <typename T> std::variant<T, ParserError> try_convert(const YamlNode& node);
+    template <typename T> std::variant<T, ParserError> try_convert(const OverlayNode& node) {
+        return try_convert<T>(node.yaml(), node.file());
+    }
     template <typename T> bool is_error(const std::variant<T, ParserError>& res) {
         return std::holds_alternative<ParserError>(res);
     }
 
     std::filesystem::path file_;
+    std::unique_ptr<ByteSource> source_;
     bool camelcase_;
     ValidationMode validation_mode_;
+    Provenance::SourceId source_id_ = 0;
+    Backend backend_                = YAML_CPP;
+    Executor parallel_;
+    size_t parallel_min_keys_ = 8;
+    std::vector<Provenance::SourceId> layer_sources_; ///< Of each layer while parsing an overlay
+    std::shared_ptr<const void> nodes_;               ///< Owner of the nodes being parsed if they don't own themselves
 };
 } // namespace config_much::internal
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "internal/field-path.h"
+
+#include <google/protobuf/descriptor.h>
+
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace config_much {
+
+/**
+ * Keeps track of which source set each field of a parsed message.
+ *
+ * Fields are looked up by their path, e.g. "field_message.enabled",
+ * made of the names in the schema whichever way a source spells them.
+ * Entries are kept per field, a repeated field has a single entry
+ * pointing at where the whole field was set, no matter its length.
+ *
+ * Fields are recorded as a table of nodes, one per field under the
+ * node of its parent, holding the id of a source and a line. Recording
+ * never spells a path out, find() matches names against the nodes.
+ */
+class Provenance {
+public:
+    using SourceId = uint32_t;
+
+    struct Origin {
+        std::string source; ///< File path or environment variable name
+        uint32_t line = 0;  ///< Line in the file, 0 for environment variables
+
+        friend bool operator==(const Origin& lhs, const Origin& rhs) {
+            return lhs.source == rhs.source && lhs.line == rhs.line;
+        }
+
+        friend std::ostream& operator<<(std::ostream& os, const Origin& origin) {
+            os << origin.source;
+            if (origin.line != 0) {
+                os << ':' << origin.line;
+            }
+            return os;
+        }
+    };
+
+    /// Register a source, the returned id is used to record fields set by it.
+    SourceId add_source(std::string name);
+
+    /// Set the origin of the field at path, replacing any previous one.
+    void record(const internal::FieldPath& path, SourceId source, uint32_t line = 0);
+
+    std::optional<Origin> find(const std::string& path) const;
+
+    /// Number of fields recorded.
+    size_t size() const { return recorded_; }
+
+    void clear();
+
+private:
+    /// Parent of the root message's fields, and source of nodes only holding recorded children.
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    struct Node {
+        const google::protobuf::FieldDescriptor* field;
+        uint32_t parent;
+        SourceId source = NONE;
+        uint32_t line   = 0;
+    };
+
+    struct Key {
+        uint32_t parent;
+        const google::protobuf::FieldDescriptor* field;
+
+        friend bool operator==(const Key& lhs, const Key& rhs) {
+            return lhs.parent == rhs.parent && lhs.field == rhs.field;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            return std::hash<const void*>()(key.field) ^ (static_cast<size_t>(key.parent) * 0x9e3779b97f4a7c15ULL);
+        }
+    };
+
+    /// Node of the field at path, added with its parents when missing.
+    uint32_t node(const internal::FieldPath& path);
+
+    std::vector<std::string> sources_;
+    std::vector<Node> nodes_;
+    std::unordered_map<Key, uint32_t, KeyHash> children_; ///< Node of each field under its parent's
+    size_t recorded_ = 0;
+};
+
+} // namespace config_much
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "internal/byte-source.h"
+#include "internal/parser-error.h"
+#include "internal/parser-yaml.h"
+
+#include <google/protobuf/message.h>
+
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace config_much {
+
+/**
+ * Parses the configuration of several components in a single pass.
+ *
+ * Each component binds a top-level section of the YAML files to its own
+ * message, e.g. "http" for everything under `http:`, which also reads
+ * the environment variables starting with PREFIX_HTTP_. Every file is
+ * read and loaded once no matter how many sections are bound, and each
+ * component gets its own result. Top-level keys no section is bound to
+ * are ignored, they may belong to another binary.
+ */
+class SectionRegistry {
+public:
+    /// Every file is read as YAML.
+    SectionRegistry& add_file(const std::filesystem::path& path) {
+        files_.push_back(std::make_unique<internal::ParserYaml>(path));
+        return *this;
+    }
+
+    SectionRegistry& add_source(std::unique_ptr<ByteSource> source) {
+        files_.push_back(std::make_unique<internal::ParserYaml>(std::move(source)));
+        return *this;
+    }
+
+    /// Parse YAML held in memory, data must outlive the registry.
+    SectionRegistry& add_buffer(const std::string& name, std::string_view data) {
+        return add_source(std::make_unique<MemorySource>(name, data));
+    }
+
+    /// Sections read the variables starting with prefix, then their own name.
+    SectionRegistry& set_env_var_prefix(const std::string& prefix) {
+        env_prefix_ = prefix;
+        return *this;
+    }
+
+    /// Route section to msg, which must outlive the registry. Binding a section again replaces its message.
+    SectionRegistry& bind(const std::string& section, google::protobuf::Message* msg);
+
+    /// Fill every bound message, the result of each is found under its section's name.
+    std::unordered_map<std::string, ParserResult> parse();
+
+private:
+    struct Binding {
+        std::string section;
+        google::protobuf::Message* msg;
+    };
+
+    std::vector<std::unique_ptr<internal::ParserYaml>> files_;
+    std::optional<std::string> env_prefix_;
+    std::vector<Binding> bindings_;
+};
+
+} // namespace config_much
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "internal/parser-error.h"
+
+#include <google/protobuf/message.h>
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <variant>
+
+namespace config_much {
+
+namespace internal {
+// Layout at the start of the shared segment, the serialized message
+// follows right after it.
+struct SharedHeader {
+    std::atomic<uint64_t> seq;  ///< Seqlock counter, odd while a write is in progress
+    std::atomic<uint64_t> size; ///< Size of the serialized message
+    uint64_t capacity;          ///< Bytes available for the serialized message
+};
+} // namespace internal
+
+/**
+ * Writes serialized configuration messages into a shared memory
+ * segment so other processes don't need to parse the same files.
+ *
+ * Only a single publisher per segment is supported.
+ */
+class SharedConfigPublisher {
+public:
+    SharedConfigPublisher(const SharedConfigPublisher&)            = delete;
+    SharedConfigPublisher& operator=(const SharedConfigPublisher&) = delete;
+    SharedConfigPublisher(SharedConfigPublisher&& other) noexcept;
+    SharedConfigPublisher& operator=(SharedConfigPublisher&& other) noexcept;
+    ~SharedConfigPublisher();
+
+    /**
+     * Create a named POSIX shared memory segment, readers attach to it by name.
+     *
+     * Fails if the name is taken, by another publisher or one that
+     * crashed before unlinking it.
+     */
+    static std::variant<SharedConfigPublisher, ParserError> create(const std::string& name, size_t capacity);
+
+    /// Create an anonymous segment backed by a memfd, readers attach through fd().
+    static std::variant<SharedConfigPublisher, ParserError> create(size_t capacity);
+
+    ParserResult publish(const google::protobuf::Message& msg);
+
+    uint64_t generation() const;
+    int fd() const { return fd_; }
+
+private:
+    SharedConfigPublisher() = default;
+
+    std::optional<ParserError> map(size_t capacity);
+
+    std::string name_;
+    int fd_                         = -1;
+    size_t mapped_                  = 0;
+    internal::SharedHeader* header_ = nullptr;
+};
+
+/**
+ * Attaches to a segment written by a SharedConfigPublisher and
+ * deserializes the message only when a new generation is available.
+ */
+class SharedConfigReader {
+public:
+    SharedConfigReader(const SharedConfigReader&)            = delete;
+    SharedConfigReader& operator=(const SharedConfigReader&) = delete;
+    SharedConfigReader(SharedConfigReader&& other) noexcept;
+    SharedConfigReader& operator=(SharedConfigReader&& other) noexcept;
+    ~SharedConfigReader();
+
+    static std::variant<SharedConfigReader, ParserError> attach(const std::string& name);
+    static std::variant<SharedConfigReader, ParserError> attach(int fd);
+
+    /**
+     * Load the latest published message into msg if it changed since
+     * the last call.
+     *
+     * Gives up with a ParserError if a write stays in progress for about
+     * 100ms, as when the publisher died in the middle of one.
+     *
+     * @returns true if msg was updated, false if no new generation was
+     *          published, a ParserError if the message could not be read.
+     */
+    std::variant<bool, ParserError> poll(google::protobuf::Message* msg);
+
+    /// Same as poll, but hands out the raw serialized bytes.
+    std::variant<bool, ParserError> poll(std::string* bytes);
+
+    uint64_t generation() const { return generation_; }
+
+private:
+    SharedConfigReader() = default;
+
+    static std::variant<SharedConfigReader, ParserError> map(int fd);
+
+    size_t mapped_                        = 0;
+    const internal::SharedHeader* header_ = nullptr;
+    uint64_t generation_                  = 0;
+    std::string buffer_;
+};
+
+} // namespace config_much
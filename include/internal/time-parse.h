@@ -0,0 +1,60 @@
+#pragma once
+
+#include "internal/parser-error.h"
+
+#include <google/protobuf/message.h>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <variant>
+
+namespace config_much::internal {
+
+enum class TimeType : uint8_t {
+    NONE = 0,  ///< Not a well-known time type
+    DURATION,  ///< google.protobuf.Duration
+    TIMESTAMP, ///< google.protobuf.Timestamp
+};
+
+/// Seconds and nanos, laid out the same way as Duration and Timestamp.
+struct TimeValue {
+    int64_t seconds = 0;
+    int32_t nanos   = 0;
+
+    friend bool operator==(const TimeValue& lhs, const TimeValue& rhs) {
+        return lhs.seconds == rhs.seconds && lhs.nanos == rhs.nanos;
+    }
+};
+
+TimeType time_type(const google::protobuf::Descriptor* descriptor);
+
+/**
+ * Parse a human readable duration, like "250ms", "1h30m" or "-1.5s".
+ *
+ * Valid units are ns, us, ms, s, m, h and d. On failure, the returned
+ * error describes what is wrong with the input.
+ */
+std::variant<TimeValue, ParserError> parse_duration(std::string_view input);
+
+/// Parse an RFC 3339 timestamp, like "2024-02-29T12:30:00.5+01:00".
+std::variant<TimeValue, ParserError> parse_timestamp(std::string_view input);
+
+std::variant<TimeValue, ParserError> parse_time(TimeType type, std::string_view input);
+
+/// Fill a Duration or Timestamp message through reflection.
+void set_time(google::protobuf::Message* msg, const TimeValue& value);
+
+/// Read a Duration or Timestamp message through reflection.
+TimeValue get_time(const google::protobuf::Message& msg);
+
+/**
+ * Append value in the form parse_time reads back, like "1.5s" or
+ * "2024-02-29T12:30:00Z".
+ *
+ * Returns false, leaving out untouched, for values outside the range
+ * of the type or with seconds and nanos of different signs.
+ */
+bool format_time(TimeType type, const TimeValue& value, std::string* out);
+
+} // namespace config_much::internal
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "internal/parser-error.h"
+
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/message.h>
+
+#include <optional>
+#include <regex>
+#include <string>
+#include <vector>
+
+namespace config_much::internal {
+
+/**
+ * The (config_much.rules) options of a message type, compiled once.
+ *
+ * Value rules are checked by the parsers right after they set a field,
+ * rules that depend on every source, like required, are checked once
+ * the whole parse is done.
+ */
+class ValidationProgram {
+public:
+    /// Compiled on first use and kept for the lifetime of the process.
+    static const ValidationProgram& get(const google::protobuf::Descriptor* descriptor);
+
+    explicit ValidationProgram(const google::protobuf::Descriptor* descriptor);
+
+    bool has_rules(const google::protobuf::FieldDescriptor* field) const {
+        return field->index() < static_cast<int>(by_index_.size()) && by_index_[field->index()] >= 0;
+    }
+
+    /// Check the value a parser just set on field, path is only used for errors.
+    std::optional<ParserError> check(const google::protobuf::Message& msg,
+                                     const google::protobuf::FieldDescriptor* field, const std::string& path) const;
+
+    /**
+     * Check the rules that need all sources to be parsed first, recursing into set sub-messages.
+     *
+     * Deferred fields are left out when with_deferred is false, they are
+     * checked once their section is decoded.
+     */
+    void check_complete(const google::protobuf::Message& msg, const std::string& path,
+                        std::vector<ParserError>& errors, bool with_deferred = true) const;
+
+private:
+    enum Flags : uint8_t {
+        MIN       = 1U << 0U,
+        MAX       = 1U << 1U,
+        MIN_LEN   = 1U << 2U,
+        MAX_LEN   = 1U << 3U,
+        PATTERN   = 1U << 4U,
+        REQUIRED  = 1U << 5U,
+        NON_EMPTY = 1U << 6U,
+    };
+
+    struct Rule {
+        const google::protobuf::FieldDescriptor* field = nullptr;
+
+        uint8_t flags    = 0;
+        double min       = 0;
+        double max       = 0;
+        uint64_t min_len = 0;
+        uint64_t max_len = 0;
+        std::string pattern_str;
+        std::optional<std::regex> pattern;
+        std::optional<ParserError> error; ///< Set when the rule itself is broken
+    };
+
+    std::optional<ParserError> check_element(const Rule& rule, const google::protobuf::Message& msg, int index,
+                                             const std::string& path) const;
+
+    std::vector<Rule> rules_;
+    std::vector<int> by_index_; ///< Field index to its rule, -1 when it has none
+    std::vector<const google::protobuf::FieldDescriptor*> required_;
+    std::vector<const google::protobuf::FieldDescriptor*> required_deferred_;
+    std::vector<const google::protobuf::FieldDescriptor*> nested_;
+};
+
+} // namespace config_much::internal
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "internal/executor.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace config_much {
+
+/**
+ * A fixed set of threads, each with its own queue of tasks.
+ *
+ * Tasks submitted by a worker go to its own queue, others are spread
+ * over the queues in turn. Workers run their newest task first and
+ * steal the oldest task of another worker once their queue is empty.
+ * Tasks still queued when the pool is destroyed are run before the
+ * threads exit. Submitting and claiming tasks only lock the queues
+ * involved, the pool's own lock is only taken to put a worker to sleep
+ * and to wake one.
+ */
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(size_t threads = std::thread::hardware_concurrency());
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&)            = delete;
+    WorkStealingPool(WorkStealingPool&&)                 = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(WorkStealingPool&&)      = delete;
+
+    void submit(std::function<void()> task);
+
+    /// Submits to the pool, which must outlive the executor.
+    Executor executor() {
+        return [this](std::function<void()> task) { submit(std::move(task)); };
+    }
+
+    size_t size() const { return threads_.size(); }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    void run(size_t index);
+
+    /// Take a task from the back of queue index, or from the front of any other.
+    bool take(size_t index, std::function<void()>* task);
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> threads_;
+    std::atomic<size_t> pending_  = 0; ///< Tasks queued and not yet taken
+    std::atomic<size_t> sleeping_ = 0; ///< Workers waiting on wake_
+    std::atomic<size_t> next_     = 0; ///< Spreads tasks from outside the pool over the queues
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stop_ = false; ///< Guarded by mutex_
+};
+
+} // namespace config_much
@@ -0,0 +1,168 @@
+#pragma once
+
+#include "internal/case-convert.h"
+
+#include <yaml-cpp/yaml.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace config_much::internal {
+
+class YamlOverlay;
+
+/**
+ * A node of a YamlOverlay, a handle into the overlay.
+ *
+ * Same API as YamlNode, plus the layer the value was taken from. Items
+ * of sequences also hold their yaml-cpp node.
+ */
+class OverlayNode {
+public:
+    class iterator {
+    public:
+        OverlayNode operator*() const;
+        iterator& operator++() {
+            pos_++;
+            if (sequence_) {
+                ++item_;
+            }
+            return *this;
+        }
+        bool operator!=(const iterator& rhs) const { return pos_ != rhs.pos_; }
+
+    private:
+        friend class OverlayNode;
+        iterator(const YamlOverlay* overlay, uint32_t parent, size_t pos)
+            : overlay_(overlay), parent_(parent), pos_(pos) {}
+        iterator(const YamlOverlay* overlay, uint32_t parent, YAML::const_iterator item)
+            : overlay_(overlay), parent_(parent), pos_(0), item_(std::move(item)), sequence_(true) {}
+
+        const YamlOverlay* overlay_;
+        uint32_t parent_;
+        size_t pos_;
+        YAML::const_iterator item_; ///< Sequences only
+        bool sequence_ = false;
+    };
+
+    /// An undefined node, what looking up a missing key returns.
+    OverlayNode() = default;
+
+    explicit operator bool() const { return overlay_ != nullptr; }
+
+    YAML::NodeType::value Type() const;
+    bool IsNull() const { return Type() == YAML::NodeType::Null; }
+    bool IsScalar() const { return Type() == YAML::NodeType::Scalar; }
+    bool IsSequence() const { return Type() == YAML::NodeType::Sequence; }
+    bool IsMap() const { return Type() == YAML::NodeType::Map; }
+
+    const std::string& Scalar() const { return yaml().Scalar(); }
+    std::string_view key() const;
+    YAML::Mark Mark() const { return yaml().Mark(); }
+    size_t size() const;
+
+    OverlayNode operator[](std::string_view key) const;
+
+    iterator begin() const;
+    iterator end() const { return {overlay_, index_, size()}; }
+
+    /// The node of the layer the value comes from, the last one holding the map for merged maps.
+    const YAML::Node& yaml() const;
+
+    /// Index of that layer, in the order they were added.
+    uint32_t layer() const;
+
+    /// File of that layer.
+    const std::filesystem::path& file() const;
+
+private:
+    friend class YamlOverlay;
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    OverlayNode(const YamlOverlay* overlay, uint32_t index) : overlay_(overlay), index_(index) {}
+    OverlayNode(const YamlOverlay* overlay, uint32_t index, YAML::Node item)
+        : overlay_(overlay), index_(index), item_(std::move(item)), is_item_(true) {}
+
+    const YamlOverlay* overlay_ = nullptr;
+    uint32_t index_             = NONE; ///< The sequence for items
+    YAML::Node item_;                   ///< Items of sequences aren't entries, they're only ever iterated over
+    bool is_item_ = false;
+};
+
+/**
+ * YAML files layered on top of each other, seen as a single document.
+ *
+ * Maps are merged key by key and anything else is replaced whole by
+ * the last layer that sets it, which is what parsing the files one
+ * after the other into the same message amounts to. Keys spelling the
+ * same name in different conventions are the same key. Only the
+ * winning values are ever decoded.
+ */
+class YamlOverlay {
+public:
+    /// Put root, a map read from file, on top of the layers added so far.
+    void add(std::filesystem::path file, const YAML::Node& root);
+
+    /// A map, undefined until a layer is added.
+    OverlayNode root() const { return entries_.empty() ? OverlayNode() : OverlayNode(this, 0); }
+
+    size_t layers() const { return files_.size(); }
+
+private:
+    friend class OverlayNode;
+    friend class OverlayNode::iterator;
+
+    struct Entry {
+        std::string_view key; ///< Key in the parent map, owned by node's document
+        YAML::Node node;
+        uint32_t layer = 0;
+        bool map       = false;
+        std::vector<uint32_t> children;
+    };
+
+    uint32_t insert(std::string_view key, const YAML::Node& node, uint32_t layer);
+    void merge(uint32_t index, const YAML::Node& node, uint32_t layer);
+
+    std::vector<std::filesystem::path> files_;
+    std::vector<Entry> entries_;
+    /// Position of each key among children, maps only. Spellings of the same name are the same key.
+    std::vector<std::unordered_map<std::string_view, size_t, case_convert::NameHash, case_convert::NameEqual>> keys_;
+};
+
+inline OverlayNode OverlayNode::iterator::operator*() const {
+    if (sequence_) {
+        return {overlay_, parent_, *item_};
+    }
+    return {overlay_, overlay_->entries_[parent_].children[pos_]};
+}
+
+inline YAML::NodeType::value OverlayNode::Type() const {
+    if (overlay_ == nullptr) {
+        return YAML::NodeType::Undefined;
+    }
+    if (is_item_) {
+        return item_.Type();
+    }
+    const auto& entry = overlay_->entries_[index_];
+    return entry.map ? YAML::NodeType::Map : entry.node.Type();
+}
+
+inline std::string_view OverlayNode::key() const {
+    return overlay_ != nullptr && !is_item_ ? overlay_->entries_[index_].key : std::string_view();
+}
+
+inline size_t OverlayNode::size() const {
+    if (overlay_ == nullptr || is_item_) {
+        return 0;
+    }
+    const auto& entry = overlay_->entries_[index_];
+    return entry.map ? entry.children.size() : entry.node.size();
+}
+
+inline uint32_t OverlayNode::layer() const { return overlay_ != nullptr ? overlay_->entries_[index_].layer : 0; }
+
+} // namespace config_much::internal
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <yaml-cpp/mark.h>
+#include <yaml-cpp/node/type.h>
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace config_much::internal {
+
+class YamlDocument;
+
+/**
+ * Convert a scalar the way YAML::Node::as<T>() does, nullopt where it would throw.
+ *
+ * T is one of bool, int32_t, int64_t, uint32_t, uint64_t, float,
+ * double, std::string or std::string_view.
+ */
+template <typename T> std::optional<T> convert_scalar(std::string_view value);
+
+/**
+ * A node of a YamlDocument, a small handle that is cheap to copy.
+ *
+ * Mirrors the parts of YAML::Node that ParserYaml uses, down to the
+ * names, so the parser is written once for both.
+ */
+class YamlNode {
+public:
+    class iterator {
+    public:
+        YamlNode operator*() const { return {doc_, index_}; }
+        iterator& operator++();
+        bool operator!=(const iterator& rhs) const { return index_ != rhs.index_; }
+
+    private:
+        friend class YamlNode;
+        iterator(const YamlDocument* doc, uint32_t index) : doc_(doc), index_(index) {}
+
+        const YamlDocument* doc_;
+        uint32_t index_;
+    };
+
+    /// An undefined node, what looking up a missing key returns.
+    YamlNode() = default;
+
+    explicit operator bool() const { return doc_ != nullptr; }
+
+    YAML::NodeType::value Type() const;
+    bool IsNull() const { return Type() == YAML::NodeType::Null; }
+    bool IsScalar() const { return Type() == YAML::NodeType::Scalar; }
+    bool IsSequence() const { return Type() == YAML::NodeType::Sequence; }
+    bool IsMap() const { return Type() == YAML::NodeType::Map; }
+
+    /// Unescaped value of a scalar, empty for anything else.
+    std::string_view Scalar() const;
+
+    /// Key of the node in its parent map, empty otherwise.
+    std::string_view key() const;
+
+    /// Where the node starts in the input, lines and columns count from 0 like yaml-cpp's.
+    YAML::Mark Mark() const;
+
+    /// Number of children of a map or sequence.
+    size_t size() const;
+
+    /// First value of a map for key, an undefined node when there is none.
+    YamlNode operator[](std::string_view key) const;
+
+    iterator begin() const;
+    iterator end() const { return {doc_, NONE}; }
+
+    /// convert_scalar() of a scalar node, with nulls spelled out as "null" for strings like as<std::string>().
+    template <typename T> std::optional<T> convert() const;
+
+private:
+    friend class YamlDocument;
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    YamlNode(const YamlDocument* doc, uint32_t index) : doc_(doc), index_(index) {}
+
+    const YamlDocument* doc_ = nullptr;
+    uint32_t index_          = NONE;
+};
+
+/**
+ * A YAML document read by config-much's own scanner instead of yaml-cpp.
+ *
+ * Covers the subset configuration files use: block maps and sequences,
+ * flow collections on a single line, plain and quoted scalars on a
+ * single line and comments. Line breaks, indentation and the characters
+ * that end scalars are found 16 bytes at a time with SSE2 where
+ * available. Scalars point into the input unless they hold escapes and
+ * all nodes live in a single vector.
+ */
+class YamlDocument {
+public:
+    /**
+     * Scan input, nullptr when it is outside the subset or not valid YAML.
+     *
+     * Anchors, tags, block scalars, multi-line scalars, quoted keys and
+     * multiple documents are all left to yaml-cpp, as are errors so they
+     * are reported the usual way. The document points into input unless
+     * copy is set.
+     */
+    static std::shared_ptr<const YamlDocument> scan(std::string_view input, bool copy = false);
+
+    YamlNode root() const { return {this, root_}; }
+
+    /// Number of nodes in the document.
+    size_t size() const { return entries_.size(); }
+
+private:
+    friend class YamlNode;
+    friend class YamlNode::iterator;
+    class Scanner;
+
+    struct Entry {
+        std::string_view key;   ///< Key in the parent map
+        std::string_view value; ///< Scalars only
+        uint32_t line              = 0;
+        uint32_t column            = 0;
+        uint32_t pos               = 0;
+        uint32_t first             = YamlNode::NONE; ///< First child
+        uint32_t last              = YamlNode::NONE; ///< Last child, to append in order
+        uint32_t next              = YamlNode::NONE; ///< Next sibling
+        uint32_t size              = 0;
+        YAML::NodeType::value type = YAML::NodeType::Null;
+    };
+
+    std::string copy_;
+    std::vector<Entry> entries_;
+    std::deque<std::string> decoded_; ///< Scalars that held escapes, deque keeps them in place
+    uint32_t root_ = 0;
+};
+
+inline YamlNode::iterator& YamlNode::iterator::operator++() {
+    index_ = doc_->entries_[index_].next;
+    return *this;
+}
+
+inline YAML::NodeType::value YamlNode::Type() const {
+    return doc_ != nullptr ? doc_->entries_[index_].type : YAML::NodeType::Undefined;
+}
+
+inline std::string_view YamlNode::Scalar() const {
+    return doc_ != nullptr ? doc_->entries_[index_].value : std::string_view();
+}
+
+inline std::string_view YamlNode::key() const {
+    return doc_ != nullptr ? doc_->entries_[index_].key : std::string_view();
+}
+
+inline size_t YamlNode::size() const { return doc_ != nullptr ? doc_->entries_[index_].size : 0; }
+
+inline YamlNode::iterator YamlNode::begin() const {
+    return {doc_, doc_ != nullptr ? doc_->entries_[index_].first : NONE};
+}
+
+} // namespace config_much::internal
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "internal/parser-error.h"
+
+#include <google/protobuf/message.h>
+
+#include <optional>
+#include <string>
+
+namespace config_much::internal {
+
+/**
+ * Serializes messages to YAML that ParserYaml reads back as the same message.
+ *
+ * Set fields are written in field number order, along with unset fields
+ * that declare a [(config_much.default_value)], so a Parser applying the
+ * defaults first reads them back as 0, "" or [] too. Strings and bytes
+ * are always double quoted, bytes as base64, enums by name and time
+ * types in their human form. Set but empty sub-messages are written as
+ * `{}` so they stay set once read back.
+ */
+class YamlWriter {
+public:
+    /// Field names are written in camelCase, matching ParserYaml's camelcase option.
+    explicit YamlWriter(bool camelcase = false) : camelcase_(camelcase) {}
+
+    /// Append msg to out.
+    void write(const google::protobuf::Message& msg, std::string* out) const;
+
+    /// Write msg to fd in chunks, the fd is left open.
+    std::optional<ParserError> write(const google::protobuf::Message& msg, int fd) const;
+
+private:
+    bool camelcase_;
+};
+
+} // namespace config_much::internal
@@ -0,0 +1,462 @@
+#include "internal/byte-source.h"
+
+#include "internal/decompress.h"
+#include "internal/fingerprint.h"
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+
+namespace config_much {
+
+// Static helpers
+namespace {
+ParserError errno_error(const std::filesystem::path& name, const char* action, int error) {
+    ParserError err;
+    err << name << ": " << action << ": " << std::strerror(error);
+    return err;
+}
+
+std::optional<ParserError> pread_all(int fd, const std::filesystem::path& name, std::string& buffer,
+                                     size_t offset = 0) {
+    while (offset < buffer.size()) {
+        ssize_t res = pread(fd, buffer.data() + offset, buffer.size() - offset, static_cast<off_t>(offset));
+        if (res < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno_error(name, "Failed to read", errno);
+        }
+
+        if (res == 0) {
+            // The file shrunk under us
+            buffer.resize(offset);
+            break;
+        }
+        offset += res;
+    }
+    return {};
+}
+
+std::optional<ParserError> read_stream(int fd, const std::filesystem::path& name, std::string& buffer) {
+    constexpr size_t CHUNK = 64 * 1024;
+
+    buffer.clear();
+    for (;;) {
+        const size_t offset = buffer.size();
+        buffer.resize(offset + CHUNK);
+
+        ssize_t res = read(fd, buffer.data() + offset, CHUNK);
+        if (res < 0) {
+            buffer.resize(offset);
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno_error(name, "Failed to read", errno);
+        }
+
+        buffer.resize(offset + res);
+        if (res == 0) {
+            return {};
+        }
+    }
+}
+
+/// Reads from the start of fd into buffer, sized by fstat when possible.
+std::optional<ParserError> read_fd(int fd, const std::filesystem::path& name, std::string& buffer) {
+    struct stat st {};
+    if (fstat(fd, &st) != 0) {
+        return errno_error(name, "Failed to stat", errno);
+    }
+
+    if (!S_ISREG(st.st_mode)) {
+        return read_stream(fd, name, buffer);
+    }
+
+    buffer.resize(st.st_size);
+    return pread_all(fd, name, buffer);
+}
+
+/**
+ * Minimal io_uring setup, only what is needed to submit a batch of
+ * reads and wait for them.
+ */
+class Uring {
+public:
+    Uring()                        = default;
+    Uring(const Uring&)            = delete;
+    Uring(Uring&&)                 = delete;
+    Uring& operator=(const Uring&) = delete;
+    Uring& operator=(Uring&&)      = delete;
+
+    ~Uring() {
+        if (sqes_ != nullptr) {
+            munmap(sqes_, sqes_size_);
+        }
+        if (cq_ptr_ != nullptr && cq_ptr_ != sq_ptr_) {
+            munmap(cq_ptr_, cq_size_);
+        }
+        if (sq_ptr_ != nullptr) {
+            munmap(sq_ptr_, sq_size_);
+        }
+        if (fd_ != -1) {
+            close(fd_);
+        }
+    }
+
+    bool setup(unsigned entries) {
+        io_uring_params params{};
+        fd_ = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (fd_ < 0) {
+            fd_ = -1;
+            return false;
+        }
+
+        entries_ = params.sq_entries;
+        sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+        const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap) {
+            sq_size_ = std::max(sq_size_, cq_size_);
+        }
+
+        sq_ptr_ = map(sq_size_, IORING_OFF_SQ_RING);
+        if (sq_ptr_ == nullptr) {
+            return false;
+        }
+
+        cq_ptr_ = single_mmap ? sq_ptr_ : map(cq_size_, IORING_OFF_CQ_RING);
+        if (cq_ptr_ == nullptr) {
+            return false;
+        }
+
+        sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_      = static_cast<io_uring_sqe*>(map(sqes_size_, IORING_OFF_SQES));
+        if (sqes_ == nullptr) {
+            return false;
+        }
+
+        sq_head_  = offset<unsigned>(sq_ptr_, params.sq_off.head);
+        sq_tail_  = offset<unsigned>(sq_ptr_, params.sq_off.tail);
+        sq_mask_  = *offset<unsigned>(sq_ptr_, params.sq_off.ring_mask);
+        sq_array_ = offset<unsigned>(sq_ptr_, params.sq_off.array);
+        cq_head_  = offset<unsigned>(cq_ptr_, params.cq_off.head);
+        cq_tail_  = offset<unsigned>(cq_ptr_, params.cq_off.tail);
+        cq_mask_  = *offset<unsigned>(cq_ptr_, params.cq_off.ring_mask);
+        cqes_     = offset<io_uring_cqe>(cq_ptr_, params.cq_off.cqes);
+        return true;
+    }
+
+    unsigned entries() const { return entries_; }
+
+    /// Reads pushed that the kernel didn't take yet.
+    unsigned pending() const { return *sq_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE); }
+
+    void push_read(int fd, char* buf, size_t len, size_t off, uint64_t user_data) {
+        const unsigned tail  = *sq_tail_;
+        const unsigned index = tail & sq_mask_;
+
+        io_uring_sqe* sqe = &sqes_[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode    = IORING_OP_READ;
+        sqe->fd        = fd;
+        sqe->addr      = reinterpret_cast<uint64_t>(buf);
+        sqe->len       = static_cast<uint32_t>(std::min<size_t>(len, UINT32_MAX));
+        sqe->off       = off;
+        sqe->user_data = user_data;
+
+        sq_array_[index] = index;
+        __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    }
+
+    /// Submit up to to_submit pending reads and wait for wait_for completions, pending() tells what was taken.
+    int enter(unsigned to_submit, unsigned wait_for) {
+        for (;;) {
+            auto res = syscall(__NR_io_uring_enter, fd_, to_submit, wait_for, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (res >= 0 || errno != EINTR) {
+                return res < 0 ? -errno : 0;
+            }
+            // Only what wasn't taken before the interruption is left to submit
+            to_submit = std::min(to_submit, pending());
+        }
+    }
+
+    /// Wait for a completion without submitting anything, with poll if io_uring_enter itself fails.
+    void wait() {
+        if (enter(0, 1) != 0) {
+            pollfd pfd{fd_, POLLIN, 0};
+            while (poll(&pfd, 1, -1) < 0 && errno == EINTR) {
+            }
+        }
+    }
+
+    template <typename F> void reap(F&& callback) {
+        unsigned head = *cq_head_;
+        while (head != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+            const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+            callback(cqe.user_data, cqe.res);
+            head++;
+        }
+        __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    }
+
+private:
+    void* map(size_t size, off_t off) const {
+        void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, off);
+        return ptr == MAP_FAILED ? nullptr : ptr;
+    }
+
+    template <typename T> static T* offset(void* base, uint32_t off) {
+        return reinterpret_cast<T*>(static_cast<char*>(base) + off);
+    }
+
+    int fd_           = -1;
+    unsigned entries_ = 0;
+
+    void* sq_ptr_       = nullptr;
+    void* cq_ptr_       = nullptr;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sq_size_     = 0;
+    size_t cq_size_     = 0;
+    size_t sqes_size_   = 0;
+
+    unsigned* sq_head_  = nullptr;
+    unsigned* sq_tail_  = nullptr;
+    unsigned* sq_array_ = nullptr;
+    unsigned sq_mask_   = 0;
+    unsigned* cq_head_  = nullptr;
+    unsigned* cq_tail_  = nullptr;
+    unsigned cq_mask_   = 0;
+    io_uring_cqe* cqes_ = nullptr;
+};
+
+struct ReadRequest {
+    FileSource* file;
+    std::string* buffer;
+    std::optional<ParserError>* error;
+    int fd;
+    size_t offset = 0;
+    bool done     = false;
+};
+
+/**
+ * Run all requests through the ring.
+ *
+ * Requests the kernel can't serve are left as not done so the caller
+ * can fall back to pread.
+ */
+void uring_read(Uring& ring, std::vector<ReadRequest>& requests) {
+    std::deque<size_t> queue;
+    for (size_t i = 0; i < requests.size(); i++) {
+        queue.push_back(i);
+    }
+
+    // Reads the kernel took and didn't complete yet, it may still write into their buffers
+    unsigned inflight = 0;
+    auto complete     = [&](uint64_t index, int32_t res) {
+        inflight--;
+        auto& req = requests[index];
+        if (res == -EAGAIN || res == -EINTR) {
+            queue.push_back(index);
+        } else if (res == -EINVAL || res == -EOPNOTSUPP) {
+            // Kernels without IORING_OP_READ, pread will handle it
+        } else if (res < 0) {
+            *req.error = errno_error(req.file->name(), "Failed to read", -res);
+            req.done   = true;
+        } else if (res == 0) {
+            req.buffer->resize(req.offset);
+            req.done = true;
+        } else {
+            req.offset += res;
+            if (req.offset < req.buffer->size()) {
+                queue.push_back(index);
+            } else {
+                req.done = true;
+            }
+        }
+    };
+
+    while (!queue.empty() || inflight > 0) {
+        while (!queue.empty() && inflight + ring.pending() < ring.entries()) {
+            auto& req = requests[queue.front()];
+            ring.push_read(req.fd, req.buffer->data() + req.offset, req.buffer->size() - req.offset, req.offset,
+                           queue.front());
+            queue.pop_front();
+        }
+
+        const unsigned queued = ring.pending();
+        const int err         = ring.enter(queued, inflight + queued);
+        inflight += queued - ring.pending();
+        if (err != 0) {
+            // What is left goes to pread, which must not race reads still in flight into the same buffers.
+            // Reads never submitted are dropped with the ring.
+            while (inflight > 0) {
+                ring.wait();
+                ring.reap(complete);
+            }
+            return;
+        }
+
+        ring.reap(complete);
+    }
+}
+} // namespace
+
+void ByteSource::loaded(size_t bytes_read) {
+    bytes_read_ += bytes_read;
+    content_hash_ = hash_content_ ? internal::hash_bytes(data()) : 0;
+}
+
+std::optional<ParserError> MmapSource::load() {
+    release();
+
+    int fd = open(name().c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return errno_error(name(), "Failed to open", errno);
+    }
+
+    struct stat st {};
+    if (fstat(fd, &st) != 0) {
+        auto err = errno_error(name(), "Failed to stat", errno);
+        close(fd);
+        return err;
+    }
+
+    if (st.st_size == 0) {
+        close(fd);
+        loaded(0);
+        return {};
+    }
+
+    void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    int error  = errno;
+    close(fd);
+    if (addr == MAP_FAILED) {
+        return errno_error(name(), "Failed to map", error);
+    }
+
+    madvise(addr, st.st_size, MADV_SEQUENTIAL);
+    addr_ = static_cast<const char*>(addr);
+    size_ = st.st_size;
+    loaded(size_);
+    return {};
+}
+
+void MmapSource::release() {
+    if (addr_ != nullptr) {
+        munmap(const_cast<char*>(addr_), size_);
+    }
+    addr_ = nullptr;
+    size_ = 0;
+}
+
+std::optional<ParserError> FdSource::load() {
+    struct stat st {};
+    if (fstat(fd_, &st) != 0) {
+        return errno_error(name(), "Failed to stat", errno);
+    }
+
+    std::optional<ParserError> err;
+    if (S_ISREG(st.st_mode)) {
+        buffer_.resize(st.st_size);
+        err = pread_all(fd_, name(), buffer_);
+    } else {
+        // Pipes and sockets are consumed from wherever they are at
+        err = read_stream(fd_, name(), buffer_);
+    }
+
+    if (!err) {
+        loaded(buffer_.size());
+    }
+    return err;
+}
+
+std::optional<ParserError> FileSource::load() {
+    std::optional<ParserError> err;
+    if (loaded_) {
+        err = std::exchange(error_, std::nullopt);
+    } else {
+        loaded_ = true;
+        int fd  = open(name().c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1) {
+            return errno_error(name(), "Failed to open", errno);
+        }
+
+        err = read_fd(fd, name(), buffer_);
+        close(fd);
+    }
+
+    if (!err) {
+        const size_t read = buffer_.size();
+        err               = internal::decompress(name(), buffer_, max_decompressed_);
+        if (!err) {
+            loaded(read);
+        }
+    }
+    return err;
+}
+
+void FileSource::release() {
+    buffer_ = std::string();
+    error_.reset();
+    loaded_ = false;
+}
+
+void BatchReader::read(const std::vector<FileSource*>& files) {
+    used_io_uring_ = false;
+
+    std::vector<ReadRequest> requests;
+    requests.reserve(files.size());
+
+    for (auto* file : files) {
+        if (file->loaded_) {
+            continue;
+        }
+
+        file->loaded_ = true;
+        file->error_.reset();
+
+        int fd = open(file->name().c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1) {
+            file->error_ = errno_error(file->name(), "Failed to open", errno);
+            continue;
+        }
+
+        struct stat st {};
+        if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+            file->error_ = read_fd(fd, file->name(), file->buffer_);
+            close(fd);
+            continue;
+        }
+
+        file->buffer_.resize(st.st_size);
+        requests.push_back({file, &file->buffer_, &file->error_, fd});
+    }
+
+    if (use_io_uring_ && !requests.empty()) {
+        Uring ring;
+        if (ring.setup(std::min<unsigned>(requests.size(), 64))) {
+            used_io_uring_ = true;
+            uring_read(ring, requests);
+        }
+    }
+
+    for (auto& req : requests) {
+        if (!req.done) {
+            *req.error = pread_all(req.fd, req.file->name(), *req.buffer, req.offset);
+        }
+        close(req.fd);
+    }
+}
+
+} // namespace config_much
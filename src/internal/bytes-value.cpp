@@ -0,0 +1,265 @@
+#include "internal/bytes-value.h"
+#include "internal/byte-source.h"
+
+#include <array>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace config_much::internal {
+
+// Static helpers
+namespace {
+constexpr uint8_t INVALID = 0xff;
+constexpr uint8_t SKIP    = 0xfe;
+constexpr uint8_t PAD     = 0xfd;
+
+constexpr std::string_view FILE_PREFIX = "file:";
+
+constexpr std::array<uint8_t, 256> make_table() {
+    std::array<uint8_t, 256> table{};
+    for (auto& v : table) {
+        v = INVALID;
+    }
+
+    constexpr std::string_view alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    for (size_t i = 0; i < alphabet.size(); i++) {
+        table[static_cast<uint8_t>(alphabet[i])] = static_cast<uint8_t>(i);
+    }
+
+    table[' ']  = SKIP;
+    table['\t'] = SKIP;
+    table['\r'] = SKIP;
+    table['\n'] = SKIP;
+    table['=']  = PAD;
+    return table;
+}
+
+constexpr auto TABLE = make_table();
+
+struct Decoder {
+    char* out;
+    uint32_t acc = 0;
+    int count    = 0; ///< Sextets held in acc
+    int padding  = 0;
+};
+
+/// Decode from pos until past stop and on a quantum boundary, or the end of input.
+std::optional<ParserError> decode_scalar(std::string_view input, size_t& pos, size_t stop, Decoder& d) {
+    for (; pos < input.size(); pos++) {
+        if (pos >= stop && d.count == 0) {
+            break;
+        }
+
+        const uint8_t v = TABLE[static_cast<uint8_t>(input[pos])];
+        if (v == SKIP) {
+            continue;
+        }
+
+        if (v == PAD) {
+            if (d.count < 2 || d.count + d.padding >= 4) {
+                ParserError err;
+                err << "unexpected padding at offset " << pos;
+                return err;
+            }
+            d.padding++;
+            continue;
+        }
+
+        if (v == INVALID || d.padding > 0) {
+            ParserError err;
+            err << "invalid character at offset " << pos;
+            return err;
+        }
+
+        d.acc = (d.acc << 6U) | v;
+        if (++d.count == 4) {
+            d.out[0] = static_cast<char>(d.acc >> 16U);
+            d.out[1] = static_cast<char>(d.acc >> 8U);
+            d.out[2] = static_cast<char>(d.acc);
+            d.out += 3;
+            d.acc   = 0;
+            d.count = 0;
+        }
+    }
+    return {};
+}
+
+std::optional<ParserError> finish(Decoder& d) {
+    switch (d.count) {
+    case 1:
+        return {"truncated input"};
+    case 2:
+        *d.out++ = static_cast<char>(d.acc >> 4U);
+        break;
+    case 3:
+        *d.out++ = static_cast<char>(d.acc >> 10U);
+        *d.out++ = static_cast<char>(d.acc >> 2U);
+        break;
+    default:
+        break;
+    }
+
+    if (d.padding > 0 && d.count + d.padding != 4) {
+        return {"incomplete padding"};
+    }
+    return {};
+}
+
+#if defined(__x86_64__)
+bool has_avx2() {
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+
+/**
+ * Decode 32 characters at a time into 24 bytes, see
+ * http://0x80.pl/notesen/2016-01-17-sse-base64-decoding.html
+ *
+ * Stops at the first block holding anything outside the alphabet and
+ * returns how much of the input was consumed. Each store writes a full
+ * register, out needs 8 bytes of room past the decoded data.
+ */
+__attribute__((target("avx2"))) size_t decode_avx2(const char* in, size_t len, char* out) {
+    const __m256i lut_lo   = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A,
+                                              0x1B, 0x1B, 0x1B, 0x1A, 0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                              0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m256i lut_hi   = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10,
+                                              0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                              0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m256i lut_roll = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0, 0, 16, 19, 4,
+                                              -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+
+    const __m256i pack = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1, 2, 1, 0, 6, 5, 4, 10,
+                                          9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+    const __m256i mask_2f = _mm256_set1_epi8(0x2f);
+    const __m256i lanes   = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, -1, -1);
+
+    size_t pos = 0;
+    for (; len - pos >= 32; pos += 32, out += 24) {
+        __m256i str = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + pos));
+
+        // Classify every character by its nibbles, valid ones have no bits in common
+        const __m256i hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(str, 4), mask_2f);
+        const __m256i lo_nibbles = _mm256_and_si256(str, mask_2f);
+        const __m256i hi         = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+        const __m256i lo         = _mm256_shuffle_epi8(lut_lo, lo_nibbles);
+        if (!_mm256_testz_si256(lo, hi)) {
+            break;
+        }
+
+        // Shift each character down to its sextet, '/' shares a nibble with '+'
+        const __m256i eq_2f = _mm256_cmpeq_epi8(str, mask_2f);
+        const __m256i roll  = _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(eq_2f, hi_nibbles));
+        str                 = _mm256_add_epi8(str, roll);
+
+        // Merge sextets into 24 bit groups and move them to the front
+        str = _mm256_maddubs_epi16(str, _mm256_set1_epi32(0x01400140));
+        str = _mm256_madd_epi16(str, _mm256_set1_epi32(0x00011000));
+        str = _mm256_shuffle_epi8(str, pack);
+        str = _mm256_permutevar8x32_epi32(str, lanes);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), str);
+    }
+    return pos;
+}
+#endif
+} // namespace
+
+std::optional<ParserError> base64_decode(std::string_view input, std::string* out, bool allow_simd) {
+    // Room for the kernel's last full register store, trimmed at the end
+    out->resize(input.size() / 4 * 3 + 3 + 32);
+    Decoder d{out->data()};
+
+#if defined(__x86_64__)
+    const bool simd = allow_simd && has_avx2();
+#else
+    (void)allow_simd;
+#endif
+
+    size_t pos = 0;
+    while (pos < input.size()) {
+        size_t stop = input.size();
+#if defined(__x86_64__)
+        if (simd && d.count == 0) {
+            const size_t consumed = decode_avx2(input.data() + pos, input.size() - pos, d.out);
+            pos += consumed;
+            d.out += consumed / 4 * 3;
+
+            // Whatever stopped the kernel, whitespace, padding or an actual
+            // error, is left for the scalar decoder to deal with.
+            stop = pos + 32;
+        }
+#endif
+        auto err = decode_scalar(input, pos, stop, d);
+        if (err) {
+            return err;
+        }
+    }
+
+    auto err = finish(d);
+    if (err) {
+        return err;
+    }
+
+    out->resize(d.out - out->data());
+    return {};
+}
+
+void base64_encode(std::string_view input, std::string* out) {
+    constexpr std::string_view alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    const size_t start = out->size();
+    out->resize(start + (input.size() + 2) / 3 * 4);
+    char* o = out->data() + start;
+
+    size_t i = 0;
+    for (; i + 3 <= input.size(); i += 3) {
+        const uint32_t v = static_cast<uint32_t>(static_cast<uint8_t>(input[i])) << 16U |
+                           static_cast<uint32_t>(static_cast<uint8_t>(input[i + 1])) << 8U |
+                           static_cast<uint8_t>(input[i + 2]);
+        *o++ = alphabet[(v >> 18U) & 0x3fU];
+        *o++ = alphabet[(v >> 12U) & 0x3fU];
+        *o++ = alphabet[(v >> 6U) & 0x3fU];
+        *o++ = alphabet[v & 0x3fU];
+    }
+
+    if (i < input.size()) {
+        uint32_t v = static_cast<uint32_t>(static_cast<uint8_t>(input[i])) << 16U;
+        if (i + 1 < input.size()) {
+            v |= static_cast<uint32_t>(static_cast<uint8_t>(input[i + 1])) << 8U;
+        }
+        *o++ = alphabet[(v >> 18U) & 0x3fU];
+        *o++ = alphabet[(v >> 12U) & 0x3fU];
+        *o++ = i + 1 < input.size() ? alphabet[(v >> 6U) & 0x3fU] : '=';
+        *o++ = '=';
+    }
+}
+
+std::optional<ParserError> parse_bytes(std::string_view value, const std::filesystem::path& base_dir,
+                                       std::string* out) {
+    if (value.substr(0, FILE_PREFIX.size()) != FILE_PREFIX) {
+        return base64_decode(value, out);
+    }
+
+    std::filesystem::path path = value.substr(FILE_PREFIX.size());
+    if (path.empty()) {
+        return {"empty file reference"};
+    }
+
+    if (path.is_relative()) {
+        path = base_dir / path;
+    }
+
+    MmapSource source(path);
+    auto err = source.load();
+    if (err) {
+        return err;
+    }
+
+    out->assign(source.data());
+    return {};
+}
+
+} // namespace config_much::internal
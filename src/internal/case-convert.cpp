@@ -2,6 +2,87 @@
 #include <algorithm>
 
 namespace config_much::case_convert {
+
+// Static helpers
+namespace {
+bool is_separator(char c) { return c == '_' || c == '-'; }
+bool is_upper(char c) { return c >= 'A' && c <= 'Z'; }
+bool is_lower(char c) { return c >= 'a' && c <= 'z'; }
+bool is_digit(char c) { return c >= '0' && c <= '9'; }
+char lower(char c) { return is_upper(c) ? static_cast<char>(c - 'A' + 'a') : c; }
+
+/// Walks the letters and digits of a name, flagging the ones that start a word.
+class Letters {
+public:
+    explicit Letters(std::string_view name) : name_(name) {}
+
+    /// False past the last one, c is in lower case.
+    bool next(char* c, bool* word_start) {
+        bool separated = pos_ == 0;
+        while (pos_ < name_.size() && is_separator(name_[pos_])) {
+            separated = true;
+            pos_++;
+        }
+        if (pos_ == name_.size()) {
+            return false;
+        }
+
+        const char cur = name_[pos_];
+        *c             = lower(cur);
+        *word_start    = separated;
+        if (!separated) {
+            // The last capital of a run starts the next word, as in HTTPServer
+            const char prev  = name_[pos_ - 1];
+            const bool camel = is_upper(cur) && !is_upper(prev);
+            const bool run   = is_upper(cur) && pos_ + 1 < name_.size() && is_lower(name_[pos_ + 1]);
+            *word_start       = camel || run || is_digit(cur) != is_digit(prev);
+        }
+        pos_++;
+        return true;
+    }
+
+private:
+    std::string_view name_;
+    size_t pos_ = 0;
+};
+} // namespace
+
+bool same_name(std::string_view lhs, std::string_view rhs) {
+    if (lhs == rhs) {
+        return true;
+    }
+
+    Letters left(lhs);
+    Letters right(rhs);
+    char l           = 0;
+    char r           = 0;
+    bool left_start  = false;
+    bool right_start = false;
+    for (;;) {
+        const bool more = left.next(&l, &left_start);
+        if (more != right.next(&r, &right_start)) {
+            return false;
+        }
+        if (!more) {
+            return true;
+        }
+        if (l != r || left_start != right_start) {
+            return false;
+        }
+    }
+}
+
+uint64_t name_hash(std::string_view name) {
+    // FNV-1a over the lower case letters and digits, equal words give equal hashes
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (char c : name) {
+        if (!is_separator(c)) {
+            h ^= static_cast<uint8_t>(lower(c));
+            h *= 0x100000001b3ULL;
+        }
+    }
+    return h;
+}
 std::string all_caps(const std::string& input) {
     std::string out;
     out.resize(input.length());
@@ -0,0 +1,161 @@
+#include "internal/config-history.h"
+
+#include <google/protobuf/field_mask.pb.h>
+#include <google/protobuf/util/field_mask_util.h>
+#include <google/protobuf/util/message_differencer.h>
+
+#include <algorithm>
+
+namespace config_much {
+
+const google::protobuf::Message* ConfigVersion::section(std::string_view name) const {
+    for (size_t i = 0; i < fields_.size(); i++) {
+        if (fields_[i]->name() == name) {
+            return sections_[i].get();
+        }
+    }
+    return nullptr;
+}
+
+void ConfigVersion::copy_to(google::protobuf::Message* msg) const {
+    msg->CopyFrom(*root_);
+    const auto* reflection = msg->GetReflection();
+    for (size_t i = 0; i < fields_.size(); i++) {
+        if (sections_[i] != nullptr) {
+            reflection->MutableMessage(msg, fields_[i])->CopyFrom(*sections_[i]);
+        }
+    }
+}
+
+std::shared_ptr<const ConfigVersion> ConfigHistory::record(const google::protobuf::Message& msg,
+                                                           std::vector<ConfigVersion::Source> sources) {
+    using google::protobuf::FieldDescriptor;
+    using google::protobuf::util::MessageDifferencer;
+
+    // Every version is compared to the one recorded right before it, readers only wait on mutex_
+    std::lock_guard record_lock(record_mutex_);
+    std::shared_ptr<const ConfigVersion> previous;
+    {
+        std::lock_guard lock(mutex_);
+        if (!versions_.empty() && versions_.back()->root_->GetDescriptor() == msg.GetDescriptor()) {
+            previous = versions_.back();
+        }
+    }
+
+    auto version        = std::make_shared<ConfigVersion>();
+    version->parsed_at_ = std::chrono::system_clock::now();
+    version->sources_   = std::move(sources);
+
+    // Parts are compared by their hash, which the fingerprint needs anyway, and confirmed field by field so a
+    // collision can't share a stale part. Only changed ones are copied, the rest without its sections.
+    const uint64_t rest    = internal::hash_message(msg, false);
+    version->fingerprint_  = Fingerprint(rest);
+    const auto* descriptor = msg.GetDescriptor();
+    const auto* reflection = msg.GetReflection();
+
+    std::vector<const FieldDescriptor*> others;
+    for (int i = 0; i < descriptor->field_count(); i++) {
+        const auto* field = descriptor->field(i);
+        if (field->is_repeated() || field->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE) {
+            others.push_back(field);
+        } else {
+            version->fields_.push_back(field);
+        }
+    }
+
+    if (previous != nullptr && previous->fingerprint_.rest_ == rest &&
+        MessageDifferencer().CompareWithFields(*previous->root_, msg, others, others)) {
+        version->root_ = previous->root_;
+    } else {
+        google::protobuf::FieldMask mask;
+        for (const auto* field : others) {
+            mask.add_paths(field->name());
+        }
+        std::unique_ptr<google::protobuf::Message> root(msg.New());
+        google::protobuf::util::FieldMaskUtil::MergeMessageTo(msg, mask, {}, root.get());
+        version->root_ = std::move(root);
+    }
+
+    std::vector<uint64_t> hashes; // Per section field, 0 for unset ones
+    for (size_t idx = 0; idx < version->fields_.size(); idx++) {
+        const auto* field = version->fields_[idx];
+        std::shared_ptr<const google::protobuf::Message> section;
+        uint64_t hash = 0;
+        if (reflection->HasField(msg, field)) {
+            const auto& value = reflection->GetMessage(msg, field);
+            hash              = internal::hash_message(value);
+            if (previous != nullptr && previous->sections_[idx] != nullptr &&
+                previous->fingerprint_.section(field->name()) == hash &&
+                MessageDifferencer::Equals(*previous->sections_[idx], value)) {
+                section = previous->sections_[idx];
+            } else {
+                std::unique_ptr<google::protobuf::Message> copy(value.New());
+                copy->CopyFrom(value);
+                section = std::move(copy);
+            }
+        }
+        version->sections_.push_back(std::move(section));
+        hashes.push_back(hash);
+    }
+
+    // Sections are fingerprinted in field number order
+    std::vector<size_t> order;
+    for (size_t i = 0; i < version->fields_.size(); i++) {
+        if (version->sections_[i] != nullptr) {
+            order.push_back(i);
+        }
+    }
+    std::sort(order.begin(), order.end(),
+              [&fields = version->fields_](size_t a, size_t b) { return fields[a]->number() < fields[b]->number(); });
+    for (size_t i : order) {
+        version->fingerprint_.add(version->fields_[i], hashes[i]);
+    }
+
+    std::lock_guard lock(mutex_);
+    version->number_ = next_number_++;
+    versions_.push_back(version);
+    if (versions_.size() > capacity_) {
+        versions_.pop_front();
+    }
+    current_.store(version);
+    return version;
+}
+
+std::vector<std::shared_ptr<const ConfigVersion>> ConfigHistory::versions() const {
+    std::lock_guard lock(mutex_);
+    return {versions_.begin(), versions_.end()};
+}
+
+ParserResult ConfigHistory::rollback(uint64_t number) {
+    std::lock_guard lock(mutex_);
+    auto it = std::find_if(versions_.begin(), versions_.end(),
+                           [number](const auto& version) { return version->number() == number; });
+    if (it == versions_.end()) {
+        ParserError err;
+        err << "Version " << number << " is no longer in the history";
+        return {{err}};
+    }
+
+    current_.store(*it);
+    return {};
+}
+
+ParserResult ConfigHistory::rollback() {
+    auto current = current_.load();
+    if (current == nullptr) {
+        return {{"No version to roll back to"}};
+    }
+
+    std::lock_guard lock(mutex_);
+    auto it = std::find(versions_.begin(), versions_.end(), current);
+    if (it == versions_.begin() || it == versions_.end()) {
+        ParserError err;
+        err << "No version before " << current->number() << " to roll back to";
+        return {{err}};
+    }
+
+    current_.store(*std::prev(it));
+    return {};
+}
+
+} // namespace config_much
@@ -0,0 +1,206 @@
+#include "internal/decompress.h"
+
+#include <zlib.h>
+#if defined(CONFIG_MUCH_ZSTD)
+#include <zstd.h>
+#endif
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <optional>
+
+namespace config_much::internal {
+
+// Static helpers
+namespace {
+/// Smallest start and growth of the output.
+constexpr size_t CHUNK = 64 * 1024;
+
+ParserError too_large(const std::filesystem::path& name, size_t max_size) {
+    ParserError err;
+    err << name << ": Decompresses to more than " << max_size << " bytes";
+    return err;
+}
+
+/**
+ * Size to start the output at. Sizes declared by the stream can't be
+ * trusted, a few crafted bytes could claim max_size, so they only ever
+ * lower the start from a small multiple of the compressed size.
+ */
+size_t initial_size(size_t compressed, std::optional<uint64_t> declared, size_t max_size) {
+    size_t size = std::max(CHUNK, compressed * 4);
+    if (declared) {
+        size = static_cast<size_t>(std::min<uint64_t>(size, *declared));
+    }
+    return std::min(size, max_size);
+}
+
+/// Make room for more output, false once max_size is reached.
+bool grow(std::string& out, size_t filled, size_t max_size) {
+    if (filled < out.size()) {
+        return true;
+    }
+    if (out.size() >= max_size) {
+        return false;
+    }
+    out.resize(std::min(max_size, std::max(out.size() + out.size() / 2, out.size() + CHUNK)));
+    return true;
+}
+
+std::optional<ParserError> gunzip(const std::filesystem::path& name, std::string& buffer, size_t max_size) {
+    // The trailer holds the size of the last member modulo 4 GiB, a hint good enough for single members
+    std::optional<uint64_t> declared;
+    if (buffer.size() >= 18) {
+        uint32_t isize = 0;
+        for (size_t i = 0; i < 4; i++) {
+            isize |= static_cast<uint32_t>(static_cast<uint8_t>(buffer[buffer.size() - 4 + i])) << (8 * i);
+        }
+        declared = isize;
+    }
+    std::string out(initial_size(buffer.size(), declared, max_size), '\0');
+
+    z_stream stream{};
+    if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK) {
+        ParserError err;
+        err << name << ": Failed to set up gzip decompression";
+        return err;
+    }
+
+    size_t consumed = 0;
+    size_t filled   = 0;
+    bool ended      = false;
+    std::optional<ParserError> error;
+    while (!error) {
+        if (!grow(out, filled, max_size)) {
+            error = too_large(name, max_size);
+            break;
+        }
+
+        // zlib counts in 32 bits, larger buffers go through in several steps
+        const size_t in  = std::min<size_t>(buffer.size() - consumed, UINT_MAX);
+        const size_t cap = std::min<size_t>(out.size() - filled, UINT_MAX);
+        stream.next_in   = reinterpret_cast<Bytef*>(buffer.data() + consumed);
+        stream.avail_in  = static_cast<uInt>(in);
+        stream.next_out  = reinterpret_cast<Bytef*>(out.data() + filled);
+        stream.avail_out = static_cast<uInt>(cap);
+
+        const int res = inflate(&stream, Z_NO_FLUSH);
+        consumed += in - stream.avail_in;
+        filled += cap - stream.avail_out;
+
+        if (res == Z_STREAM_END) {
+            ended = consumed == buffer.size();
+            if (ended) {
+                break;
+            }
+            // Another member follows
+            inflateReset(&stream);
+        } else if (res == Z_BUF_ERROR && consumed == buffer.size() && stream.avail_out != 0) {
+            break;
+        } else if (res != Z_OK && res != Z_BUF_ERROR) {
+            error = ParserError();
+            *error << name << ": Invalid gzip data: " << (stream.msg != nullptr ? stream.msg : "unknown error");
+        }
+    }
+    inflateEnd(&stream);
+
+    if (!error && !ended) {
+        error = ParserError();
+        *error << name << ": Truncated gzip data";
+    }
+    if (error) {
+        return error;
+    }
+
+    out.resize(filled);
+    buffer.swap(out);
+    return {};
+}
+
+#if defined(CONFIG_MUCH_ZSTD)
+std::optional<ParserError> unzstd(const std::filesystem::path& name, std::string& buffer, size_t max_size) {
+    const auto declared = ZSTD_getFrameContentSize(buffer.data(), buffer.size());
+    if (declared != ZSTD_CONTENTSIZE_UNKNOWN && declared != ZSTD_CONTENTSIZE_ERROR && declared > max_size) {
+        return too_large(name, max_size);
+    }
+    std::optional<uint64_t> hint;
+    if (declared != ZSTD_CONTENTSIZE_UNKNOWN && declared != ZSTD_CONTENTSIZE_ERROR) {
+        hint = declared;
+    }
+    std::string out(initial_size(buffer.size(), hint, max_size), '\0');
+
+    ZSTD_DStream* stream = ZSTD_createDStream();
+    if (stream == nullptr) {
+        ParserError err;
+        err << name << ": Failed to set up zstd decompression";
+        return err;
+    }
+
+    ZSTD_inBuffer in{buffer.data(), buffer.size(), 0};
+    size_t filled = 0;
+    size_t res    = 0;
+    std::optional<ParserError> error;
+    while (!error) {
+        if (in.pos == in.size && res == 0) {
+            break;
+        }
+        if (!grow(out, filled, max_size)) {
+            error = too_large(name, max_size);
+            break;
+        }
+
+        ZSTD_outBuffer output{out.data(), out.size(), filled};
+        res    = ZSTD_decompressStream(stream, &output, &in);
+        filled = output.pos;
+        if (ZSTD_isError(res) != 0) {
+            error = ParserError();
+            *error << name << ": Invalid zstd data: " << ZSTD_getErrorName(res);
+        } else if (in.pos == in.size && res != 0 && output.pos < output.size) {
+            // The decoder wants input there is none of
+            error = ParserError();
+            *error << name << ": Truncated zstd data";
+        }
+    }
+    ZSTD_freeDStream(stream);
+
+    if (error) {
+        return error;
+    }
+    out.resize(filled);
+    buffer.swap(out);
+    return {};
+}
+#endif
+} // namespace
+
+Compression detect_compression(std::string_view data) {
+    if (data.size() >= 2 && data[0] == '\x1f' && data[1] == '\x8b') {
+        return Compression::GZIP;
+    }
+    if (data.size() >= 4 && data.substr(0, 4) == std::string_view("\x28\xb5\x2f\xfd", 4)) {
+        return Compression::ZSTD;
+    }
+    return Compression::NONE;
+}
+
+std::optional<ParserError> decompress(const std::filesystem::path& name, std::string& buffer, size_t max_size) {
+    switch (detect_compression(buffer)) {
+    case Compression::NONE:
+        return {};
+    case Compression::GZIP:
+        return gunzip(name, buffer, max_size);
+    case Compression::ZSTD:
+#if defined(CONFIG_MUCH_ZSTD)
+        return unzstd(name, buffer, max_size);
+#else
+        break;
+#endif
+    }
+
+    ParserError err;
+    err << name << ": zstd compressed, but config-much was built without zstd support";
+    return err;
+}
+
+} // namespace config_much::internal
@@ -0,0 +1,118 @@
+#include "internal/default-values.h"
+#include "internal/descriptor-cache.h"
+#include "internal/parser-yaml.h"
+
+#include "config-much/options.pb.h"
+
+#include <algorithm>
+
+namespace config_much::internal {
+
+// Static helpers
+namespace {
+bool has_defaults(const google::protobuf::Descriptor* descriptor,
+                  std::vector<const google::protobuf::Descriptor*>& stack) {
+    using google::protobuf::FieldDescriptor;
+    if (std::find(stack.begin(), stack.end(), descriptor) != stack.end()) {
+        return false;
+    }
+
+    stack.push_back(descriptor);
+    bool found = false;
+    for (int i = 0; i < descriptor->field_count() && !found; i++) {
+        const auto* field = descriptor->field(i);
+        if (field->options().HasExtension(config_much::default_value)) {
+            found = true;
+        } else if (!field->is_repeated() && field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+            found = has_defaults(field->message_type(), stack);
+        }
+    }
+    stack.pop_back();
+    return found;
+}
+} // namespace
+
+const DefaultValues& DefaultValues::get(const google::protobuf::Message& msg) {
+    static DescriptorCache<google::protobuf::Descriptor, DefaultValues> defaults;
+    return defaults.get(msg.GetDescriptor(), [&msg] { return std::make_unique<DefaultValues>(msg); });
+}
+
+DefaultValues::DefaultValues(const google::protobuf::Message& msg) {
+    std::vector<const google::protobuf::Descriptor*> stack;
+    if (!has_defaults(msg.GetDescriptor(), stack)) {
+        return;
+    }
+
+    prototype_.reset(msg.New());
+    std::vector<const google::protobuf::FieldDescriptor*> path;
+    collect(prototype_.get(), path, stack);
+}
+
+void DefaultValues::collect(google::protobuf::Message* msg, std::vector<const google::protobuf::FieldDescriptor*>& path,
+                            std::vector<const google::protobuf::Descriptor*>& stack) {
+    using google::protobuf::FieldDescriptor;
+
+    const auto* descriptor = msg->GetDescriptor();
+    stack.push_back(descriptor);
+
+    for (int i = 0; i < descriptor->field_count(); i++) {
+        const auto* field = descriptor->field(i);
+
+        if (field->options().HasExtension(config_much::default_value)) {
+            // Decoded like any YAML value, errors point at the field declaring it
+            const std::string yaml = field->name() + ": " + field->options().GetExtension(config_much::default_value);
+            ParserYaml parser(std::make_unique<MemorySource>(field->file()->name() + ":" + field->full_name(), yaml));
+            auto err = parser.parse(msg);
+            if (err) {
+                errors_.insert(errors_.end(), err->begin(), err->end());
+            } else {
+                path.push_back(field);
+                origins_.push_back({path, field->file()->name()});
+                path.pop_back();
+            }
+            continue;
+        }
+
+        // Sub-messages are only set when they hold defaults
+        if (!field->is_repeated() && field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE &&
+            has_defaults(field->message_type(), stack)) {
+            path.push_back(field);
+            collect(msg->GetReflection()->MutableMessage(msg, field), path, stack);
+            path.pop_back();
+        }
+    }
+
+    stack.pop_back();
+}
+
+void DefaultValues::apply(google::protobuf::Message* msg, Provenance* provenance) const {
+    if (prototype_ == nullptr) {
+        return;
+    }
+
+    msg->CopyFrom(*prototype_);
+    if (provenance == nullptr) {
+        return;
+    }
+
+    const std::string* file     = nullptr;
+    Provenance::SourceId source = 0;
+    std::vector<FieldPath> chain;
+    for (const auto& origin : origins_) {
+        if (file == nullptr || *file != origin.file) {
+            file   = &origin.file;
+            source = provenance->add_source(origin.file);
+        }
+
+        // Links point into chain, which is never reallocated while it is built
+        chain.clear();
+        chain.reserve(origin.fields.size() + 1);
+        chain.emplace_back();
+        for (const auto* field : origin.fields) {
+            chain.push_back(chain.back().child(field));
+        }
+        provenance->record(chain.back(), source);
+    }
+}
+
+} // namespace config_much::internal
@@ -0,0 +1,114 @@
+#include "internal/deferred-sections.h"
+#include "internal/validation.h"
+
+#include "config-much/options.pb.h"
+
+namespace config_much {
+
+bool DeferredSections::marked(const google::protobuf::FieldDescriptor* field) {
+    return field->type() == google::protobuf::FieldDescriptor::TYPE_MESSAGE && !field->is_repeated() &&
+           field->options().GetExtension(config_much::deferred);
+}
+
+void DeferredSections::reset(const google::protobuf::Message& root) {
+    sections_.clear();
+
+    const auto* descriptor = root.GetDescriptor();
+    for (int i = 0; i < descriptor->field_count(); i++) {
+        const auto* field = descriptor->field(i);
+        if (!marked(field)) {
+            continue;
+        }
+
+        auto section   = std::make_shared<Section>();
+        section->field = field;
+        section->root.reset(root.New());
+        sections_.emplace_back(std::move(section));
+    }
+}
+
+void DeferredSections::add(const google::protobuf::FieldDescriptor* field, Layer layer) {
+    auto* section = find(field);
+    if (section != nullptr) {
+        section->layers.emplace_back(std::move(layer));
+    }
+}
+
+const google::protobuf::Message* DeferredSections::get(std::string_view name) {
+    auto* section = find(name);
+    if (section == nullptr) {
+        return nullptr;
+    }
+    return &decode(*section);
+}
+
+ParserResult DeferredSections::errors(std::string_view name) {
+    auto* section = find(name);
+    if (section == nullptr) {
+        ParserError err;
+        err << "Unknown deferred section '" << name << "'";
+        return {{err}};
+    }
+
+    decode(*section);
+    return section->errors;
+}
+
+void DeferredSections::prefetch(const Executor& executor) {
+    for (const auto& section : sections_) {
+        executor([section] { decode(*section); });
+    }
+}
+
+const google::protobuf::Message& DeferredSections::decode(Section& section) {
+    std::call_once(section.once, [&section] {
+        auto* root = section.root.get();
+        std::vector<ParserError> errors;
+        for (auto& layer : section.layers) {
+            auto err = layer(root);
+            if (err) {
+                errors.insert(errors.end(), err->begin(), err->end());
+            }
+        }
+
+        // What the layers hold isn't needed anymore
+        section.layers = std::vector<Layer>();
+
+        const auto* field      = section.field;
+        const auto* reflection = root->GetReflection();
+        if (reflection->HasField(*root, field)) {
+            internal::ValidationProgram::get(field->message_type())
+                .check_complete(reflection->GetMessage(*root, field), field->name(), errors);
+        } else if (field->options().GetExtension(config_much::rules).required()) {
+            ParserError err;
+            err << "Missing required field '" << field->name() << "'";
+            errors.emplace_back(std::move(err));
+        }
+
+        if (!errors.empty()) {
+            section.errors = std::move(errors);
+        }
+    });
+
+    return section.root->GetReflection()->GetMessage(*section.root, section.field);
+}
+
+DeferredSections::Section* DeferredSections::find(const google::protobuf::FieldDescriptor* field) const {
+    for (const auto& section : sections_) {
+        if (section->field == field) {
+            return section.get();
+        }
+    }
+    return nullptr;
+}
+
+DeferredSections::Section* DeferredSections::find(std::string_view name) const {
+    for (const auto& section : sections_) {
+        if (section->field->name() == name) {
+            return section.get();
+        }
+    }
+    return nullptr;
+}
+
+} // namespace config_much
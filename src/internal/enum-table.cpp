@@ -0,0 +1,105 @@
+#include "internal/enum-table.h"
+#include "internal/descriptor-cache.h"
+
+#include <algorithm>
+#include <charconv>
+#include <memory>
+
+namespace config_much::internal {
+
+// Static helpers
+namespace {
+char upper(char c) {
+    return (c >= 'a' && c <= 'z') ? static_cast<char>(c - 'a' + 'A') : c;
+}
+
+/// FNV-1a over the upper case version of the input.
+uint64_t hash(std::string_view name) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (char c : name) {
+        h ^= static_cast<uint8_t>(upper(c));
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+bool equals_ignore_case(std::string_view lhs, std::string_view rhs) {
+    if (lhs.size() != rhs.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < lhs.size(); i++) {
+        if (upper(lhs[i]) != upper(rhs[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+const EnumTable& EnumTable::get(const google::protobuf::EnumDescriptor* descriptor) {
+    static DescriptorCache<google::protobuf::EnumDescriptor, EnumTable> tables;
+    return tables.get(descriptor, [descriptor] { return std::make_unique<EnumTable>(descriptor); });
+}
+
+EnumTable::EnumTable(const google::protobuf::EnumDescriptor* descriptor) {
+    size_t capacity = 1;
+    while (capacity < static_cast<size_t>(descriptor->value_count()) * 2) {
+        capacity <<= 1U;
+    }
+    slots_.resize(capacity);
+    mask_ = capacity - 1;
+
+    for (int i = 0; i < descriptor->value_count(); i++) {
+        const auto* value = descriptor->value(i);
+        numbers_.push_back(value->number());
+
+        // Enum names differing only in case are not something we can
+        // tell apart, first one wins.
+        if (resolve_name(value->name())) {
+            continue;
+        }
+
+        for (uint64_t idx = hash(value->name()) & mask_;; idx = (idx + 1) & mask_) {
+            if (slots_[idx].name.empty()) {
+                slots_[idx] = {value->name(), value->number()};
+                break;
+            }
+        }
+    }
+
+    std::sort(numbers_.begin(), numbers_.end());
+}
+
+std::optional<int> EnumTable::resolve(std::string_view value) const {
+    auto res = resolve_name(value);
+    if (res) {
+        return res;
+    }
+    return resolve_number(value);
+}
+
+std::optional<int> EnumTable::resolve_name(std::string_view name) const {
+    for (uint64_t idx = hash(name) & mask_; !slots_[idx].name.empty(); idx = (idx + 1) & mask_) {
+        if (equals_ignore_case(slots_[idx].name, name)) {
+            return slots_[idx].number;
+        }
+    }
+    return {};
+}
+
+std::optional<int> EnumTable::resolve_number(std::string_view value) const {
+    int number      = 0;
+    const char* end = value.data() + value.size();
+
+    auto [ptr, ec] = std::from_chars(value.data(), end, number);
+    if (ec != std::errc() || ptr != end) {
+        return {};
+    }
+
+    if (!std::binary_search(numbers_.begin(), numbers_.end(), number)) {
+        return {};
+    }
+    return number;
+}
+
+} // namespace config_much::internal
@@ -0,0 +1,49 @@
+#include "internal/field-table.h"
+#include "internal/case-convert.h"
+#include "internal/descriptor-cache.h"
+
+#include <memory>
+
+namespace config_much::internal {
+
+const FieldTable& FieldTable::get(const google::protobuf::Descriptor* descriptor) {
+    static DescriptorCache<google::protobuf::Descriptor, FieldTable> tables;
+    return tables.get(descriptor, [descriptor] { return std::make_unique<FieldTable>(descriptor); });
+}
+
+FieldTable::FieldTable(const google::protobuf::Descriptor* descriptor) {
+    size_t capacity = 1;
+    while (capacity < static_cast<size_t>(descriptor->field_count()) * 2) {
+        capacity <<= 1U;
+    }
+    slots_.resize(capacity);
+    mask_ = capacity - 1;
+
+    for (int i = 0; i < descriptor->field_count(); i++) {
+        const auto* field = descriptor->field(i);
+        camel_names_.push_back(case_convert::snake_to_camel(field->name()));
+
+        // Fields whose names only differ in spelling can't be told apart, first one wins
+        if (find(field->name()) != nullptr) {
+            continue;
+        }
+
+        for (uint64_t idx = case_convert::name_hash(field->name()) & mask_;; idx = (idx + 1) & mask_) {
+            if (slots_[idx] == nullptr) {
+                slots_[idx] = field;
+                break;
+            }
+        }
+    }
+}
+
+const google::protobuf::FieldDescriptor* FieldTable::find(std::string_view key) const {
+    for (uint64_t idx = case_convert::name_hash(key) & mask_; slots_[idx] != nullptr; idx = (idx + 1) & mask_) {
+        if (case_convert::same_name(slots_[idx]->name(), key)) {
+            return slots_[idx];
+        }
+    }
+    return nullptr;
+}
+
+} // namespace config_much::internal
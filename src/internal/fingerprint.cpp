@@ -0,0 +1,227 @@
+#include "internal/fingerprint.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace config_much {
+
+// Static helpers
+namespace {
+constexpr uint64_t GOLDEN = 0x9e3779b97f4a7c15ULL;
+
+uint64_t mix(uint64_t x) {
+    // splitmix64 finalizer
+    x = (x ^ (x >> 30U)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27U)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31U);
+}
+
+uint64_t combine(uint64_t hash, uint64_t value) { return mix(hash ^ (value + GOLDEN + (hash << 6U) + (hash >> 2U))); }
+
+uint64_t hash_double(double value) {
+    uint64_t bits = 0x7ff8000000000000ULL;
+    if (!std::isnan(value)) {
+        std::memcpy(&bits, &value, sizeof(bits));
+    }
+    return bits;
+}
+
+bool is_section(const google::protobuf::FieldDescriptor* field) {
+    return !field->is_repeated() && field->cpp_type() == google::protobuf::FieldDescriptor::CPPTYPE_MESSAGE;
+}
+
+/// One value into a running hash, a multiply each, finished with mix once all are in.
+uint64_t step(uint64_t hash, uint64_t value) {
+    hash = (hash ^ value) * 0xbf58476d1ce4e5b9ULL;
+    return hash ^ (hash >> 29U);
+}
+
+/// The elements of a repeated field, read through a single accessor instead of a reflection call each.
+template <typename T, typename Convert>
+uint64_t hash_repeated(const google::protobuf::Message& msg, const google::protobuf::FieldDescriptor* field,
+                       uint64_t hash, Convert&& convert) {
+    const auto values = msg.GetReflection()->GetRepeatedFieldRef<T>(msg, field);
+    for (int i = 0; i < values.size(); i++) {
+        hash = step(hash, convert(values.Get(i)));
+    }
+    return hash;
+}
+
+uint64_t hash_single(const google::protobuf::Message& msg, const google::protobuf::FieldDescriptor* field) {
+    using google::protobuf::FieldDescriptor;
+    const auto* r = msg.GetReflection();
+    std::string scratch;
+
+    switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+        return static_cast<uint64_t>(r->GetInt32(msg, field));
+    case FieldDescriptor::CPPTYPE_INT64:
+        return static_cast<uint64_t>(r->GetInt64(msg, field));
+    case FieldDescriptor::CPPTYPE_UINT32:
+        return r->GetUInt32(msg, field);
+    case FieldDescriptor::CPPTYPE_UINT64:
+        return r->GetUInt64(msg, field);
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+        return hash_double(r->GetDouble(msg, field));
+    case FieldDescriptor::CPPTYPE_FLOAT:
+        return hash_double(r->GetFloat(msg, field));
+    case FieldDescriptor::CPPTYPE_BOOL:
+        return static_cast<uint64_t>(r->GetBool(msg, field));
+    case FieldDescriptor::CPPTYPE_ENUM:
+        return static_cast<uint64_t>(r->GetEnumValue(msg, field));
+    case FieldDescriptor::CPPTYPE_STRING:
+        return internal::hash_bytes(r->GetStringReference(msg, field, &scratch));
+    case FieldDescriptor::CPPTYPE_MESSAGE:
+        return internal::hash_message(r->GetMessage(msg, field));
+    }
+    return 0;
+}
+
+/// The value or values of a field that isn't a map, with their count.
+uint64_t hash_field(const google::protobuf::Message& msg, const google::protobuf::FieldDescriptor* field) {
+    using google::protobuf::FieldDescriptor;
+    if (!field->is_repeated()) {
+        return mix(step(GOLDEN ^ 1U, hash_single(msg, field)));
+    }
+
+    const auto* r   = msg.GetReflection();
+    const auto seed = GOLDEN ^ static_cast<uint64_t>(r->FieldSize(msg, field));
+    auto as_is      = [](auto value) { return static_cast<uint64_t>(value); };
+
+    switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+    case FieldDescriptor::CPPTYPE_ENUM:
+        return mix(hash_repeated<int32_t>(msg, field, seed, as_is));
+    case FieldDescriptor::CPPTYPE_INT64:
+        return mix(hash_repeated<int64_t>(msg, field, seed, as_is));
+    case FieldDescriptor::CPPTYPE_UINT32:
+        return mix(hash_repeated<uint32_t>(msg, field, seed, as_is));
+    case FieldDescriptor::CPPTYPE_UINT64:
+        return mix(hash_repeated<uint64_t>(msg, field, seed, as_is));
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+        return mix(hash_repeated<double>(msg, field, seed, hash_double));
+    case FieldDescriptor::CPPTYPE_FLOAT:
+        return mix(hash_repeated<float>(msg, field, seed, hash_double));
+    case FieldDescriptor::CPPTYPE_BOOL:
+        return mix(hash_repeated<bool>(msg, field, seed, as_is));
+    case FieldDescriptor::CPPTYPE_STRING: {
+        // Strings by reference, the accessor would copy them
+        std::string scratch;
+        uint64_t hash = seed;
+        for (int i = 0; i < r->FieldSize(msg, field); i++) {
+            hash = step(hash, internal::hash_bytes(r->GetRepeatedStringReference(msg, field, i, &scratch)));
+        }
+        return mix(hash);
+    }
+    case FieldDescriptor::CPPTYPE_MESSAGE: {
+        uint64_t hash = seed;
+        for (int i = 0; i < r->FieldSize(msg, field); i++) {
+            hash = step(hash, internal::hash_message(r->GetRepeatedMessage(msg, field, i)));
+        }
+        return mix(hash);
+    }
+    }
+    return 0;
+}
+} // namespace
+
+namespace internal {
+uint64_t hash_bytes(std::string_view data) {
+    // Eight bytes at a time, the finalizer spreads every byte over the whole hash
+    uint64_t hash = GOLDEN ^ data.size();
+    size_t i      = 0;
+    for (; i + 8 <= data.size(); i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data.data() + i, 8);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        word = __builtin_bswap64(word);
+#endif
+        hash = (hash ^ word) * 0xbf58476d1ce4e5b9ULL;
+        hash ^= hash >> 29U;
+    }
+    uint64_t tail = 0;
+    for (; i < data.size(); i++) {
+        tail = tail << 8U | static_cast<uint8_t>(data[i]);
+    }
+    return mix(hash ^ tail);
+}
+
+uint64_t hash_message(const google::protobuf::Message& msg, bool sections) {
+    // ListFields gives the fields that are set, in number order
+    std::vector<const google::protobuf::FieldDescriptor*> fields;
+    msg.GetReflection()->ListFields(msg, &fields);
+
+    uint64_t hash = GOLDEN;
+    for (const auto* field : fields) {
+        if (!sections && is_section(field)) {
+            continue;
+        }
+
+        hash = combine(hash, static_cast<uint64_t>(field->number()));
+        if (!field->is_map()) {
+            hash = combine(hash, hash_field(msg, field));
+            continue;
+        }
+
+        // Entries come in no particular order, their sum doesn't depend on it
+        const auto* reflection = msg.GetReflection();
+        const int count        = reflection->FieldSize(msg, field);
+        uint64_t sum           = 0;
+        for (int i = 0; i < count; i++) {
+            sum += mix(hash_message(reflection->GetRepeatedMessage(msg, field, i)));
+        }
+        hash = combine(combine(hash, sum), static_cast<uint64_t>(count));
+    }
+    return hash;
+}
+} // namespace internal
+
+Fingerprint::Fingerprint(const google::protobuf::Message& msg) : Fingerprint(internal::hash_message(msg, false)) {
+    std::vector<const google::protobuf::FieldDescriptor*> fields;
+    msg.GetReflection()->ListFields(msg, &fields);
+    for (const auto* field : fields) {
+        if (is_section(field)) {
+            add(field, internal::hash_message(msg.GetReflection()->GetMessage(msg, field)));
+        }
+    }
+}
+
+void Fingerprint::add(const google::protobuf::FieldDescriptor* field, uint64_t hash) {
+    sections_.push_back({field, hash});
+    value_ = combine(combine(value_, static_cast<uint64_t>(field->number())), hash);
+}
+
+std::optional<uint64_t> Fingerprint::section(std::string_view name) const {
+    for (const auto& section : sections_) {
+        if (section.field->name() == name) {
+            return section.hash;
+        }
+    }
+    return {};
+}
+
+std::vector<std::string> Fingerprint::changed(const Fingerprint& other) const {
+    std::vector<std::string> out;
+    for (const auto& entry : sections_) {
+        if (other.section(entry.field->name()) != entry.hash) {
+            out.push_back(entry.field->name());
+        }
+    }
+    for (const auto& entry : other.sections_) {
+        if (!section(entry.field->name())) {
+            out.push_back(entry.field->name());
+        }
+    }
+    return out;
+}
+
+std::string Fingerprint::hex() const {
+    static constexpr char DIGITS[] = "0123456789abcdef";
+    std::string out(16, '0');
+    for (size_t i = 0; i < 16; i++) {
+        out[15 - i] = DIGITS[(value_ >> (4 * i)) & 0xfU];
+    }
+    return out;
+}
+
+} // namespace config_much
@@ -0,0 +1,226 @@
+#include "internal/flat-view.h"
+
+#include "config-much/options.pb.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace config_much {
+
+// Static helpers
+namespace {
+/// A field to flatten, found while walking the message.
+struct Field {
+    std::string path;
+    const google::protobuf::Message* msg;
+    const google::protobuf::FieldDescriptor* field;
+};
+
+uint64_t hash_path(std::string_view path) {
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    for (char c : path) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+uint64_t mix(uint64_t x) {
+    // splitmix64 finalizer
+    x = (x ^ (x >> 30U)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27U)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31U);
+}
+
+MembershipIndex::Kind index_kind(const google::protobuf::FieldDescriptor* field) {
+    switch (field->options().GetExtension(config_much::index)) {
+    case config_much::HASH:
+        return MembershipIndex::HASH;
+    case config_much::BLOOM:
+        return MembershipIndex::BLOOM;
+    default:
+        return MembershipIndex::SORTED;
+    }
+}
+
+void collect(const google::protobuf::Message& msg, const std::string& path, std::vector<Field>& fields,
+             std::vector<const google::protobuf::Descriptor*>& stack, std::vector<ParserError>& errors) {
+    using google::protobuf::FieldDescriptor;
+
+    const auto* descriptor = msg.GetDescriptor();
+    const auto* reflection = msg.GetReflection();
+    stack.push_back(descriptor);
+
+    for (int i = 0; i < descriptor->field_count(); i++) {
+        const auto* field    = descriptor->field(i);
+        const bool indexed   = field->options().GetExtension(config_much::index) != config_much::NO_INDEX;
+        const bool supported = indexed && field->is_repeated() && MembershipIndex::supports(field);
+        auto field_path      = path.empty() ? field->name() : path + '.' + field->name();
+        if (indexed && !supported) {
+            ParserError err;
+            err << "Field '" << field_path << "' of type " << (field->is_repeated() ? "repeated " : "")
+                << field->type_name() << " can't have an index";
+            errors.push_back(std::move(err));
+        }
+        if (field->is_repeated() && !supported) {
+            continue;
+        }
+
+        if (field->is_repeated() || field->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE) {
+            fields.push_back({std::move(field_path), &msg, field});
+            continue;
+        }
+
+        const bool recursive = std::find(stack.begin(), stack.end(), field->message_type()) != stack.end();
+        if (!recursive || reflection->HasField(msg, field)) {
+            collect(reflection->GetMessage(msg, field), field_path, fields, stack, errors);
+        }
+    }
+
+    stack.pop_back();
+}
+
+void write_scalar(std::string& blob, size_t offset, const Field& f) {
+    using google::protobuf::FieldDescriptor;
+    const auto* r = f.msg->GetReflection();
+
+    auto put = [&blob, offset](auto value) { std::memcpy(blob.data() + offset, &value, sizeof(value)); };
+    switch (f.field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+        put(r->GetInt32(*f.msg, f.field));
+        break;
+    case FieldDescriptor::CPPTYPE_INT64:
+        put(r->GetInt64(*f.msg, f.field));
+        break;
+    case FieldDescriptor::CPPTYPE_UINT32:
+        put(r->GetUInt32(*f.msg, f.field));
+        break;
+    case FieldDescriptor::CPPTYPE_UINT64:
+        put(r->GetUInt64(*f.msg, f.field));
+        break;
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+        put(r->GetDouble(*f.msg, f.field));
+        break;
+    case FieldDescriptor::CPPTYPE_FLOAT:
+        put(r->GetFloat(*f.msg, f.field));
+        break;
+    case FieldDescriptor::CPPTYPE_BOOL:
+        put(r->GetBool(*f.msg, f.field));
+        break;
+    case FieldDescriptor::CPPTYPE_ENUM:
+        put(static_cast<int32_t>(r->GetEnumValue(*f.msg, f.field)));
+        break;
+    case FieldDescriptor::CPPTYPE_STRING:
+    case FieldDescriptor::CPPTYPE_MESSAGE:
+        break;
+    }
+}
+} // namespace
+
+FlatView::FlatView(const google::protobuf::Message& msg) {
+    using google::protobuf::FieldDescriptor;
+
+    std::vector<Field> fields;
+    std::vector<const google::protobuf::Descriptor*> stack;
+    collect(msg, "", fields, stack, errors_);
+
+    // Scalars first so their offsets don't depend on string contents,
+    // then string values, then the paths to check lookups against.
+    // Indexed fields keep their values in their index.
+    size_t scalars = 0;
+    for (const auto& f : fields) {
+        size_ += f.field->is_repeated() ? 0 : 1;
+        scalars += !f.field->is_repeated() && f.field->cpp_type() != FieldDescriptor::CPPTYPE_STRING ? 1 : 0;
+    }
+    blob_.assign(scalars * 8, '\0');
+
+    std::vector<Slot> entries(fields.size());
+    size_t next_scalar = 0;
+    std::string scratch;
+    for (size_t i = 0; i < fields.size(); i++) {
+        const auto& f = fields[i];
+        auto& entry   = entries[i];
+        entry.type    = static_cast<uint8_t>(f.field->cpp_type());
+
+        if (f.field->is_repeated()) {
+            entry.type  = INDEX;
+            entry.value = static_cast<uint32_t>(indexes_.size());
+            indexes_.emplace_back(*f.msg, f.field, index_kind(f.field));
+        } else if (f.field->cpp_type() == FieldDescriptor::CPPTYPE_STRING) {
+            const auto& value = f.msg->GetReflection()->GetStringReference(*f.msg, f.field, &scratch);
+            entry.value       = static_cast<uint32_t>(blob_.size());
+            entry.size        = static_cast<uint32_t>(value.size());
+            blob_ += value;
+        } else {
+            entry.value = static_cast<uint32_t>(next_scalar++ * 8);
+            write_scalar(blob_, entry.value, f);
+        }
+    }
+    for (size_t i = 0; i < fields.size(); i++) {
+        entries[i].path      = static_cast<uint32_t>(blob_.size());
+        entries[i].path_size = static_cast<uint32_t>(fields[i].path.size());
+        blob_ += fields[i].path;
+    }
+
+    // Hash and displace: keys are spread over buckets, then each bucket,
+    // largest first, looks for a seed that sends all its keys to free slots.
+    const size_t n       = fields.size();
+    const size_t buckets = n / 4 + 1;
+    slots_.assign(n + n / 4 + 1, Slot{});
+    seeds_.assign(buckets, 0);
+
+    std::vector<std::vector<uint32_t>> by_bucket(buckets);
+    std::vector<uint64_t> hashes(n);
+    for (size_t i = 0; i < n; i++) {
+        hashes[i] = hash_path(fields[i].path);
+        by_bucket[hashes[i] % buckets].push_back(static_cast<uint32_t>(i));
+    }
+
+    std::vector<uint32_t> order(buckets);
+    for (size_t b = 0; b < buckets; b++) {
+        order[b] = static_cast<uint32_t>(b);
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&by_bucket](uint32_t a, uint32_t b) { return by_bucket[a].size() > by_bucket[b].size(); });
+
+    std::vector<size_t> taken;
+    for (uint32_t b : order) {
+        if (by_bucket[b].empty()) {
+            break;
+        }
+
+        for (uint32_t seed = 1; seed < std::numeric_limits<uint32_t>::max(); seed++) {
+            taken.clear();
+            bool ok = true;
+            for (uint32_t key : by_bucket[b]) {
+                const size_t slot = mix(hashes[key] + seed) % slots_.size();
+                if (slots_[slot].type != 0 || std::find(taken.begin(), taken.end(), slot) != taken.end()) {
+                    ok = false;
+                    break;
+                }
+                taken.push_back(slot);
+            }
+            if (!ok) {
+                continue;
+            }
+
+            seeds_[b] = seed;
+            for (size_t k = 0; k < taken.size(); k++) {
+                slots_[taken[k]] = entries[by_bucket[b][k]];
+            }
+            break;
+        }
+    }
+}
+
+const FlatView::Slot* FlatView::find(std::string_view path) const {
+    const uint64_t hash = hash_path(path);
+    const Slot& slot    = slots_[mix(hash + seeds_[hash % seeds_.size()]) % slots_.size()];
+    if (slot.type == 0 || std::string_view(blob_.data() + slot.path, slot.path_size) != path) {
+        return nullptr;
+    }
+    return &slot;
+}
+
+} // namespace config_much
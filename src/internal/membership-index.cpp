@@ -0,0 +1,228 @@
+#include "internal/membership-index.h"
+#include "internal/fingerprint.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace config_much {
+
+// Static helpers
+namespace {
+constexpr int8_t EMPTY   = -128;
+constexpr size_t GROUP   = 16;
+constexpr size_t BLOOM_K = 4;
+
+uint64_t mix(uint64_t x) {
+    // splitmix64 finalizer
+    x = (x ^ (x >> 30U)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27U)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31U);
+}
+
+/// Bit i is set when control byte i of the group equals tag.
+uint32_t match(const int8_t* group, int8_t tag) {
+#if defined(__SSE2__)
+    const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(tag))));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < GROUP; i++) {
+        mask |= static_cast<uint32_t>(group[i] == tag) << i;
+    }
+    return mask;
+#endif
+}
+
+/// The bits of the bloom filter block a hash sets, 6 bits of the hash each.
+uint64_t bloom_bits(uint64_t hash) {
+    uint64_t bits = 0;
+    for (size_t i = 0; i < BLOOM_K; i++) {
+        bits |= 1ULL << ((hash >> (32 + 6 * i)) & 63U);
+    }
+    return bits;
+}
+
+int64_t integer(const google::protobuf::Message& msg, const google::protobuf::FieldDescriptor* field, int i) {
+    using google::protobuf::FieldDescriptor;
+    const auto* r = msg.GetReflection();
+
+    switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+        return r->GetRepeatedInt32(msg, field, i);
+    case FieldDescriptor::CPPTYPE_INT64:
+        return r->GetRepeatedInt64(msg, field, i);
+    case FieldDescriptor::CPPTYPE_UINT32:
+        return r->GetRepeatedUInt32(msg, field, i);
+    case FieldDescriptor::CPPTYPE_UINT64:
+        return static_cast<int64_t>(r->GetRepeatedUInt64(msg, field, i));
+    case FieldDescriptor::CPPTYPE_ENUM:
+        return r->GetRepeatedEnumValue(msg, field, i);
+    default:
+        return 0;
+    }
+}
+
+bool is_integer(const google::protobuf::FieldDescriptor* field) {
+    using google::protobuf::FieldDescriptor;
+    switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+    case FieldDescriptor::CPPTYPE_INT64:
+    case FieldDescriptor::CPPTYPE_UINT32:
+    case FieldDescriptor::CPPTYPE_UINT64:
+    case FieldDescriptor::CPPTYPE_ENUM:
+        return true;
+    default:
+        return false;
+    }
+}
+} // namespace
+
+MembershipIndex::MembershipIndex(const google::protobuf::Message& msg, const google::protobuf::FieldDescriptor* field,
+                                 Kind kind)
+    : kind_(kind) {
+    using google::protobuf::FieldDescriptor;
+
+    const auto* reflection = msg.GetReflection();
+    const int count        = field->is_repeated() ? reflection->FieldSize(msg, field) : 0;
+    strings_               = field->cpp_type() == FieldDescriptor::CPPTYPE_STRING;
+
+    std::vector<uint64_t> hashes;
+    if (strings_) {
+        std::string scratch;
+        views_.reserve(count);
+        for (int i = 0; i < count; i++) {
+            const auto& value = reflection->GetRepeatedStringReference(msg, field, i, &scratch);
+            views_.push_back({static_cast<uint32_t>(blob_.size()), static_cast<uint32_t>(value.size())});
+            blob_ += value;
+        }
+
+        // Duplicates are left in the blob, only their views are dropped
+        auto less  = [this](const View& a, const View& b) { return view(a) < view(b); };
+        auto equal = [this](const View& a, const View& b) { return view(a) == view(b); };
+        std::sort(views_.begin(), views_.end(), less);
+        views_.erase(std::unique(views_.begin(), views_.end(), equal), views_.end());
+
+        hashes.reserve(views_.size());
+        for (const auto& v : views_) {
+            hashes.push_back(internal::hash_bytes(view(v)));
+        }
+    } else if (is_integer(field)) {
+        ints_.reserve(count);
+        for (int i = 0; i < count; i++) {
+            ints_.push_back(static_cast<uint64_t>(integer(msg, field, i)));
+        }
+        std::sort(ints_.begin(), ints_.end());
+        ints_.erase(std::unique(ints_.begin(), ints_.end()), ints_.end());
+
+        hashes.reserve(ints_.size());
+        for (uint64_t value : ints_) {
+            hashes.push_back(mix(value));
+        }
+    }
+
+    size_ = hashes.size();
+    if (kind_ == HASH) {
+        // The table holds the values, the sorted arrays were only needed to drop duplicates
+        build_table(hashes);
+        views_.clear();
+        views_.shrink_to_fit();
+        ints_.clear();
+        ints_.shrink_to_fit();
+    } else if (kind_ == BLOOM) {
+        // One 64 bit block per 6 values, about 10 bits each
+        bloom_.assign(hashes.size() / 6 + 1, 0);
+        for (uint64_t hash : hashes) {
+            bloom_[hash % bloom_.size()] |= bloom_bits(hash);
+        }
+    }
+}
+
+bool MembershipIndex::supports(const google::protobuf::FieldDescriptor* field) {
+    return field->cpp_type() == google::protobuf::FieldDescriptor::CPPTYPE_STRING || is_integer(field);
+}
+
+void MembershipIndex::build_table(const std::vector<uint64_t>& hashes) {
+    // Groups are a power of two, with at least an eighth of the slots left empty to end probes
+    size_t groups = 1;
+    while (groups * GROUP * 7 / 8 < hashes.size()) {
+        groups *= 2;
+    }
+    control_.assign(groups * GROUP, EMPTY);
+    slots_.assign(groups * GROUP, 0);
+
+    for (uint32_t i = 0; i < hashes.size(); i++) {
+        size_t group = (hashes[i] >> 7U) & (groups - 1);
+        for (;;) {
+            const uint32_t empty = match(control_.data() + group * GROUP, EMPTY);
+            if (empty != 0) {
+                const size_t slot = group * GROUP + __builtin_ctz(empty);
+                control_[slot]    = static_cast<int8_t>(hashes[i] & 0x7fU);
+                slots_[slot]      = strings_ ? uint64_t{views_[i].offset} << 32U | views_[i].size : ints_[i];
+                break;
+            }
+            group = (group + 1) & (groups - 1);
+        }
+    }
+}
+
+template <typename Equal> bool MembershipIndex::probe(uint64_t hash, Equal&& equal) const {
+    const size_t groups = control_.size() / GROUP;
+    const auto tag      = static_cast<int8_t>(hash & 0x7fU);
+
+    size_t group = (hash >> 7U) & (groups - 1);
+    for (;;) {
+        const int8_t* control = control_.data() + group * GROUP;
+        for (uint32_t mask = match(control, tag); mask != 0; mask &= mask - 1) {
+            if (equal(slots_[group * GROUP + __builtin_ctz(mask)])) {
+                return true;
+            }
+        }
+        // Nothing is ever removed, an empty slot means the value would have been placed here
+        if (match(control, EMPTY) != 0) {
+            return false;
+        }
+        group = (group + 1) & (groups - 1);
+    }
+}
+
+bool MembershipIndex::maybe(uint64_t hash) const {
+    const uint64_t bits = bloom_bits(hash);
+    return (bloom_[hash % bloom_.size()] & bits) == bits;
+}
+
+bool MembershipIndex::contains(std::string_view value) const {
+    if (!strings_) {
+        return false;
+    }
+
+    if (kind_ == HASH) {
+        return probe(internal::hash_bytes(value), [this, value](uint64_t slot) {
+            return view({static_cast<uint32_t>(slot >> 32U), static_cast<uint32_t>(slot)}) == value;
+        });
+    }
+    if (kind_ == BLOOM && !maybe(internal::hash_bytes(value))) {
+        return false;
+    }
+    auto it = std::lower_bound(views_.begin(), views_.end(), value,
+                               [this](const View& v, std::string_view rhs) { return view(v) < rhs; });
+    return it != views_.end() && view(*it) == value;
+}
+
+bool MembershipIndex::contains(uint64_t value) const {
+    if (strings_) {
+        return false;
+    }
+
+    if (kind_ == HASH) {
+        return probe(mix(value), [value](uint64_t slot) { return slot == value; });
+    }
+    if (kind_ == BLOOM && !maybe(mix(value))) {
+        return false;
+    }
+    return std::binary_search(ints_.begin(), ints_.end(), value);
+}
+
+} // namespace config_much
@@ -0,0 +1,206 @@
+#include "internal/metrics.h"
+
+#include <cmath>
+#include <locale>
+#include <sstream>
+
+namespace config_much {
+
+// Static helpers
+namespace {
+constexpr std::array<const char*, Metrics::ERROR_KINDS> ERROR_KIND_NAMES = {"file", "env", "required", "cancelled",
+                                                                            "budget"};
+
+std::string label(std::string_view name, std::string_view value) {
+    std::string out(name);
+    out += "=\"";
+    for (char c : value) {
+        switch (c) {
+        case '\\':
+            out += "\\\\";
+            break;
+        case '"':
+            out += "\\\"";
+            break;
+        case '\n':
+            out += "\\n";
+            break;
+        default:
+            out += c;
+        }
+    }
+    out += '"';
+    return out;
+}
+
+std::string format_value(double value) {
+    if (std::isinf(value)) {
+        return value > 0 ? "+Inf" : "-Inf";
+    }
+
+    std::ostringstream os;
+    os.imbue(std::locale::classic());
+    os.precision(15);
+    os << value;
+    return os.str();
+}
+
+const char* type_name(Metrics::Type type) {
+    switch (type) {
+    case Metrics::Type::COUNTER:
+        return "counter";
+    case Metrics::Type::GAUGE:
+        return "gauge";
+    case Metrics::Type::HISTOGRAM:
+        return "histogram";
+    }
+    return "untyped";
+}
+
+void collect_histogram(const Metrics::Callback& callback, std::string_view family, const std::string& labels,
+                       const Metrics::Histogram& histogram) {
+    using Type = Metrics::Type;
+
+    const std::string prefix = labels.empty() ? labels : labels + ',';
+
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i <= Metrics::Histogram::BUCKETS; i++) {
+        cumulative += histogram.bucket(i);
+        callback({family, Type::HISTOGRAM, "_bucket", prefix + label("le", format_value(Metrics::Histogram::bound(i))),
+                  static_cast<double>(cumulative)});
+    }
+    callback({family, Type::HISTOGRAM, "_sum", labels, histogram.sum()});
+    callback({family, Type::HISTOGRAM, "_count", labels, static_cast<double>(histogram.count())});
+}
+} // namespace
+
+void Metrics::Histogram::observe(std::chrono::nanoseconds duration) {
+    const uint64_t ns = duration.count() > 0 ? static_cast<uint64_t>(duration.count()) : 0;
+    const uint64_t us = (ns + 999) / 1000;
+
+    // Smallest i with us <= 2^i
+    size_t i = us <= 1 ? 0 : 64 - static_cast<size_t>(__builtin_clzll(us - 1));
+    if (i > BUCKETS) {
+        i = BUCKETS;
+    }
+
+    buckets_[i].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_ns_.fetch_add(ns, std::memory_order_relaxed);
+}
+
+double Metrics::Histogram::bound(size_t i) {
+    if (i >= BUCKETS) {
+        return INFINITY;
+    }
+    return std::ldexp(1e-6, static_cast<int>(i));
+}
+
+Metrics::Source& Metrics::source(const std::string& name) {
+    std::lock_guard lock(mutex_);
+    for (auto& source : sources_) {
+        if (source->name == name) {
+            return *source;
+        }
+    }
+    return *sources_.emplace_back(std::make_unique<Source>(name));
+}
+
+void Metrics::parse_done(std::chrono::nanoseconds duration, bool failed) {
+    parses_.fetch_add(1, std::memory_order_relaxed);
+    if (failed) {
+        failures_.fetch_add(1, std::memory_order_relaxed);
+    }
+    latency_.observe(duration);
+}
+
+void Metrics::measure(google::protobuf::Message* msg) {
+    const auto* descriptor = msg->GetDescriptor();
+    const auto* reflection = msg->GetReflection();
+
+    // Sections are detached while the rest of the message is measured so every byte is walked once,
+    // without copies even on an arena.
+    std::vector<std::pair<const google::protobuf::FieldDescriptor*, google::protobuf::Message*>> sections;
+    for (int i = 0; i < descriptor->field_count(); i++) {
+        const auto* field = descriptor->field(i);
+        if (field->cpp_type() != google::protobuf::FieldDescriptor::CPPTYPE_MESSAGE || field->is_repeated() ||
+            !reflection->HasField(*msg, field)) {
+            continue;
+        }
+        sections.emplace_back(field, reflection->UnsafeArenaReleaseMessage(msg, field));
+    }
+
+    size_t total = msg->SpaceUsedLong();
+    std::vector<std::pair<std::string, size_t>> fields;
+    fields.reserve(sections.size());
+    for (const auto& [field, section] : sections) {
+        const size_t bytes = section->SpaceUsedLong();
+        total += bytes;
+        fields.emplace_back(field->name(), bytes);
+        reflection->UnsafeArenaSetAllocatedMessage(msg, section, field);
+    }
+
+    std::lock_guard lock(mutex_);
+    message_bytes_ = total;
+    field_bytes_   = std::move(fields);
+}
+
+void Metrics::collect(const Callback& callback) const {
+    callback({"config_much_parses_total", Type::COUNTER, "", "", static_cast<double>(parses())});
+    callback({"config_much_parse_failures_total", Type::COUNTER, "", "", static_cast<double>(failures())});
+    for (size_t kind = 0; kind < ERROR_KINDS; kind++) {
+        callback({"config_much_parse_errors_total", Type::COUNTER, "", label("kind", ERROR_KIND_NAMES[kind]),
+                  static_cast<double>(errors(static_cast<ErrorKind>(kind)))});
+    }
+    collect_histogram(callback, "config_much_parse_duration_seconds", "", latency_);
+
+    std::lock_guard lock(mutex_);
+    for (const auto& source : sources_) {
+        callback({"config_much_source_bytes_total", Type::COUNTER, "", label("source", source->name),
+                  static_cast<double>(source->bytes.load(std::memory_order_relaxed))});
+    }
+    for (const auto& source : sources_) {
+        callback({"config_much_source_errors_total", Type::COUNTER, "", label("source", source->name),
+                  static_cast<double>(source->errors.load(std::memory_order_relaxed))});
+    }
+    for (const auto& source : sources_) {
+        collect_histogram(callback, "config_much_source_duration_seconds", label("source", source->name),
+                          source->latency);
+    }
+
+    callback({"config_much_message_bytes", Type::GAUGE, "", "", static_cast<double>(message_bytes_)});
+    for (const auto& [field, bytes] : field_bytes_) {
+        callback({"config_much_message_field_bytes", Type::GAUGE, "", label("field", field),
+                  static_cast<double>(bytes)});
+    }
+}
+
+std::string Metrics::prometheus() const {
+    std::string out;
+    std::string_view family;
+
+    collect([&](const Sample& sample) {
+        if (sample.family != family) {
+            family = sample.family;
+            out += "# TYPE ";
+            out += family;
+            out += ' ';
+            out += type_name(sample.type);
+            out += '\n';
+        }
+
+        out += sample.family;
+        out += sample.suffix;
+        if (!sample.labels.empty()) {
+            out += '{';
+            out += sample.labels;
+            out += '}';
+        }
+        out += ' ';
+        out += format_value(sample.value);
+        out += '\n';
+    });
+    return out;
+}
+
+} // namespace config_much
@@ -1,172 +1,390 @@
 #include "internal/parser-env.h"
+#include "internal/bytes-value.h"
+#include "internal/deferred-sections.h"
+#include "internal/enum-table.h"
+#include "internal/time-parse.h"
+#include "internal/validation.h"
+#include "internal/yaml-scanner.h"
 
+#include <cctype>
+#include <charconv>
 #include <cstdlib>
+#include <cstring>
 #include <google/protobuf/descriptor.h>
 
 namespace config_much::internal {
+
+// Static helpers
+namespace {
+/// Decode value and hand it to set, false when it isn't a valid T. Numbers are read in base 10, as a whole.
+template <typename T, typename Set> bool set_value(const char* value, Set&& set) {
+    if constexpr (std::is_same_v<T, std::string>) {
+        set(std::string(value));
+        return true;
+    } else if constexpr (std::is_same_v<T, bool>) {
+        // Same spellings as in YAML files
+        auto parsed = convert_scalar<bool>(value);
+        if (parsed) {
+            set(*parsed);
+        }
+        return parsed.has_value();
+    } else {
+        const char* end = value + std::strlen(value);
+        if (*value == '+') {
+            value++;
+        }
+
+        T parsed{};
+        auto res = std::from_chars(value, end, parsed);
+        if (res.ec != std::errc() || res.ptr != end || value == end) {
+            return false;
+        }
+        set(parsed);
+        return true;
+    }
+}
+
+/// Charge value to budget, false once it is exceeded.
+bool charge(MemoryBudget* budget, const char* value) {
+    return budget == nullptr || budget->charge(MemoryBudget::NODE_COST + std::strlen(value));
+}
+
+ParserError invalid_value(const std::string& env_var, const char* value,
+                          const google::protobuf::FieldDescriptor* field) {
+    ParserError err;
+    err << env_var << ": Invalid value '" << value << "' for field " << field->name();
+    return err;
+}
+} // namespace
+
 ParserResult ParserEnv::parse(google::protobuf::Message* msg) {
     using namespace google::protobuf;
 
+    std::vector<ParserError> errors;
+
     const Descriptor* descriptor = msg->GetDescriptor();
     for (int i = 0; i < descriptor->field_count(); i++) {
         const FieldDescriptor* field = descriptor->field(i);
-        parse(msg, prefix_, field);
+
+        // Variables of deferred sections are read when the section is decoded
+        if (deferred_ != nullptr && deferred_->is_deferred(field)) {
+            deferred_->add(field, [prefix = prefix_, field](Message* root) {
+                return ParserEnv(prefix).parse(root, prefix, field, FieldPath().child(field));
+            });
+            continue;
+        }
+
+        auto err = parse(msg, prefix_, field, FieldPath().child(field));
+        if (err) {
+            errors.insert(errors.end(), err->begin(), err->end());
+        }
     }
 
+    if (!errors.empty()) {
+        return errors;
+    }
     return {};
 }
 
-void ParserEnv::parse(google::protobuf::Message* msg, const std::string& prefix,
-                      const google::protobuf::FieldDescriptor* field) {
+ParserResult ParserEnv::parse(google::protobuf::Message* msg, const std::string& prefix,
+                              const google::protobuf::FieldDescriptor* field, const FieldPath& path) {
     using namespace google::protobuf;
 
     std::string env_var = cook_env_var(prefix, field->name());
 
     if (field->label() == FieldDescriptor::LABEL_REPEATED) {
-        return parse_array(msg, env_var, field);
+        // Arrays without elements keep what earlier layers set, when
+        // there are elements the field is attributed to the first one.
+        std::string first = env_var + "_0";
+        if (std::getenv(first.c_str()) == nullptr) {
+            return {};
+        }
+
+        auto res = parse_array(msg, env_var, field);
+        if (res) {
+            return res;
+        }
+        return field_set(msg, field, path, first);
     }
 
     if (field->type() == FieldDescriptor::TYPE_MESSAGE) {
         const Reflection* reflection = msg->GetReflection();
 
+        // Well-known time types can be set in one go, e.g. PREFIX_TIMEOUT=30s,
+        // the seconds and nanos fields are still reachable when it is unset.
+        const TimeType time = time_type(field->message_type());
+        const char* value   = time != TimeType::NONE ? std::getenv(env_var.c_str()) : nullptr;
+        if (value != nullptr) {
+            auto res = parse_time(time, value);
+            if (std::holds_alternative<ParserError>(res)) {
+                ParserError err;
+                err << env_var << ": Invalid " << (time == TimeType::DURATION ? "duration" : "timestamp") << " '"
+                    << value << "' for field " << field->name() << ": " << std::get<ParserError>(res);
+                return {{err}};
+            }
+
+            set_time(reflection->MutableMessage(msg, field), std::get<TimeValue>(res));
+            return field_set(msg, field, path, env_var);
+        }
+
         Message* m = reflection->MutableMessage(msg, field);
 
+        std::vector<ParserError> errors;
         const Descriptor* descriptor = m->GetDescriptor();
         for (int i = 0; i < descriptor->field_count(); i++) {
             const FieldDescriptor* f = descriptor->field(i);
 
-            parse(m, env_var, f);
+            auto err = parse(m, env_var, f, path.child(f));
+            if (err) {
+                errors.insert(errors.end(), err->begin(), err->end());
+            }
         }
-        return;
+
+        if (!errors.empty()) {
+            return errors;
+        }
+        return {};
     }
 
     const char* value = std::getenv(env_var.c_str());
-    if (value == nullptr) {
-        return;
+    if (value == nullptr || !charge(budget_, value)) {
+        return {};
     }
 
+    const Reflection* reflection = msg->GetReflection();
+    bool valid                   = true;
     switch (field->type()) {
     case FieldDescriptor::TYPE_DOUBLE:
-        msg->GetReflection()->SetDouble(msg, field, std::stod(value));
+        valid = set_value<double>(value, [&](double v) { reflection->SetDouble(msg, field, v); });
         break;
     case FieldDescriptor::TYPE_FLOAT:
-        msg->GetReflection()->SetFloat(msg, field, std::stof(value));
+        valid = set_value<float>(value, [&](float v) { reflection->SetFloat(msg, field, v); });
         break;
     case FieldDescriptor::TYPE_SFIXED64:
     case FieldDescriptor::TYPE_INT64:
-        msg->GetReflection()->SetInt64(msg, field, std::stoll(value));
+        valid = set_value<int64_t>(value, [&](int64_t v) { reflection->SetInt64(msg, field, v); });
         break;
     case FieldDescriptor::TYPE_SINT64:
     case FieldDescriptor::TYPE_FIXED64:
     case FieldDescriptor::TYPE_UINT64:
-        msg->GetReflection()->SetUInt64(msg, field, std::stoull(value));
+        valid = set_value<uint64_t>(value, [&](uint64_t v) { reflection->SetUInt64(msg, field, v); });
         break;
     case FieldDescriptor::TYPE_FIXED32:
     case FieldDescriptor::TYPE_UINT32:
-        msg->GetReflection()->SetUInt32(msg, field, std::stoul(value));
+        valid = set_value<uint32_t>(value, [&](uint32_t v) { reflection->SetUInt32(msg, field, v); });
         break;
     case FieldDescriptor::TYPE_SINT32:
     case FieldDescriptor::TYPE_SFIXED32:
     case FieldDescriptor::TYPE_INT32:
-        msg->GetReflection()->SetInt32(msg, field, std::stoi(value));
+        valid = set_value<int32_t>(value, [&](int32_t v) { reflection->SetInt32(msg, field, v); });
+        break;
+    case FieldDescriptor::TYPE_BOOL:
+        valid = set_value<bool>(value, [&](bool v) { reflection->SetBool(msg, field, v); });
         break;
-    case FieldDescriptor::TYPE_BOOL: {
-        bool parsed = false;
-        std::istringstream is(value);
-        is >> std::boolalpha >> parsed;
-        msg->GetReflection()->SetBool(msg, field, parsed);
-    } break;
     case FieldDescriptor::TYPE_STRING:
         msg->GetReflection()->SetString(msg, field, value);
         break;
-    case FieldDescriptor::TYPE_BYTES:
-        std::cerr << "Unsupported type BYTES" << std::endl;
-        break;
+    case FieldDescriptor::TYPE_BYTES: {
+        // Relative file references are resolved against the working directory
+        std::string parsed;
+        auto err = parse_bytes(value, {}, &parsed);
+        if (err) {
+            ParserError e;
+            e << env_var << ": Invalid bytes value for field " << field->name() << ": " << *err;
+            return {{e}};
+        }
+        msg->GetReflection()->SetString(msg, field, std::move(parsed));
+    } break;
     case FieldDescriptor::TYPE_ENUM: {
-        const EnumValueDescriptor* v = field->enum_type()->FindValueByName(value);
-        msg->GetReflection()->SetEnum(msg, field, v);
+        auto v = EnumTable::get(field->enum_type()).resolve(value);
+        if (!v) {
+            ParserError err;
+            err << env_var << ": Invalid enum value '" << value << "' for field " << field->name();
+            return {{err}};
+        }
+        msg->GetReflection()->SetEnumValue(msg, field, *v);
     } break;
 
     case FieldDescriptor::TYPE_MESSAGE:
     case FieldDescriptor::TYPE_GROUP:
         std::cerr << "Unexpected type!" << std::endl;
+        return {};
+    }
+
+    if (!valid) {
+        return {{invalid_value(env_var, value, field)}};
+    }
+    return field_set(msg, field, path, env_var);
+}
+
+ParserResult ParserEnv::field_set(const google::protobuf::Message* msg, const google::protobuf::FieldDescriptor* field,
+                                  const FieldPath& path, const std::string& env_var) {
+    // Arrays cut short by the budget aren't worth validating
+    if (budget_ != nullptr && budget_->exceeded()) {
+        return {};
+    }
+
+    if (provenance_ != nullptr) {
+        provenance_->record(path, provenance_->add_source(env_var));
+    }
+
+    const auto& program = ValidationProgram::get(msg->GetDescriptor());
+    if (!program.has_rules(field)) {
+        return {};
+    }
+
+    auto err = program.check(*msg, field, path.str());
+    if (err) {
+        ParserError e;
+        e << env_var << ": " << *err;
+        return {{e}};
     }
+    return {};
 }
 
 namespace {
 template <typename T>
-void parse_array_inner(google::protobuf::MutableRepeatedFieldRef<T> field, const std::string& prefix,
-                       std::function<T(const char*)> p) {
+ParserResult parse_array_inner(google::protobuf::MutableRepeatedFieldRef<T> f, const std::string& prefix,
+                               const google::protobuf::FieldDescriptor* field, MemoryBudget* budget) {
+    std::vector<ParserError> errors;
     std::string name;
     const char* value = nullptr;
-    field.Clear();
+    f.Clear();
     for (int i = 0;; i++) {
         name  = prefix + '_' + std::to_string(i);
         value = std::getenv(name.c_str());
-        if (value == nullptr) {
+        if (value == nullptr || !charge(budget, value)) {
             break;
         }
 
-        field.Add(p(value));
+        if (!set_value<T>(value, [&f](const T& v) { f.Add(v); })) {
+            errors.push_back(invalid_value(name, value, field));
+        }
+    }
+
+    if (!errors.empty()) {
+        return errors;
     }
+    return {};
 }
 } // namespace
 
-void ParserEnv::parse_array(google::protobuf::Message* msg, const std::string& prefix,
-                            const google::protobuf::FieldDescriptor* field) {
+ParserResult ParserEnv::parse_array_enum(google::protobuf::Message* msg, const std::string& prefix,
+                                         const google::protobuf::FieldDescriptor* field) {
+    std::vector<ParserError> errors;
+    auto f = msg->GetReflection()->GetMutableRepeatedFieldRef<int32_t>(msg, field);
+    f.Clear();
+
+    const EnumTable& table = EnumTable::get(field->enum_type());
+    std::string name;
+    for (int i = 0;; i++) {
+        name              = prefix + '_' + std::to_string(i);
+        const char* value = std::getenv(name.c_str());
+        if (value == nullptr || !charge(budget_, value)) {
+            break;
+        }
+
+        auto v = table.resolve(value);
+        if (!v) {
+            ParserError err;
+            err << name << ": Invalid enum value '" << value << "' for field " << field->name();
+            errors.emplace_back(std::move(err));
+            continue;
+        }
+        f.Add(*v);
+    }
+
+    if (!errors.empty()) {
+        return errors;
+    }
+    return {};
+}
+
+ParserResult ParserEnv::parse_array_bytes(google::protobuf::Message* msg, const std::string& prefix,
+                                          const google::protobuf::FieldDescriptor* field) {
+    std::vector<ParserError> errors;
+    const auto* reflection = msg->GetReflection();
+    reflection->ClearField(msg, field);
+
+    std::string name;
+    for (int i = 0;; i++) {
+        name              = prefix + '_' + std::to_string(i);
+        const char* value = std::getenv(name.c_str());
+        if (value == nullptr || !charge(budget_, value)) {
+            break;
+        }
+
+        std::string parsed;
+        auto err = parse_bytes(value, {}, &parsed);
+        if (err) {
+            ParserError e;
+            e << name << ": Invalid bytes value for field " << field->name() << ": " << *err;
+            errors.emplace_back(std::move(e));
+            continue;
+        }
+        reflection->AddString(msg, field, std::move(parsed));
+    }
+
+    if (!errors.empty()) {
+        return errors;
+    }
+    return {};
+}
+
+ParserResult ParserEnv::parse_array(google::protobuf::Message* msg, const std::string& prefix,
+                                    const google::protobuf::FieldDescriptor* field) {
     using namespace google::protobuf;
     switch (field->cpp_type()) {
-    case google::protobuf::FieldDescriptor::CPPTYPE_INT32: {
-        auto f = msg->GetReflection()->GetMutableRepeatedFieldRef<int32_t>(msg, field);
-        parse_array_inner<int32_t>(f, prefix, [](const char* s) { return std::stoi(s); });
-    } break;
-    case google::protobuf::FieldDescriptor::CPPTYPE_INT64: {
-        auto f = msg->GetReflection()->GetMutableRepeatedFieldRef<int64_t>(msg, field);
-        parse_array_inner<int64_t>(f, prefix, [](const char* s) { return std::stoi(s); });
-    } break;
-    case google::protobuf::FieldDescriptor::CPPTYPE_UINT32: {
-        auto f = msg->GetReflection()->GetMutableRepeatedFieldRef<uint32_t>(msg, field);
-        parse_array_inner<uint32_t>(f, prefix, [](const char* s) { return std::stoul(s); });
-    } break;
-    case google::protobuf::FieldDescriptor::CPPTYPE_UINT64: {
-        auto f = msg->GetReflection()->GetMutableRepeatedFieldRef<uint64_t>(msg, field);
-        parse_array_inner<uint64_t>(f, prefix, [](const char* s) { return std::stoull(s); });
-    } break;
-    case google::protobuf::FieldDescriptor::CPPTYPE_DOUBLE: {
-        auto f = msg->GetReflection()->GetMutableRepeatedFieldRef<double>(msg, field);
-        parse_array_inner<double>(f, prefix, [](const char* s) { return std::stod(s); });
-    } break;
-    case google::protobuf::FieldDescriptor::CPPTYPE_FLOAT: {
-        auto f = msg->GetReflection()->GetMutableRepeatedFieldRef<float>(msg, field);
-        parse_array_inner<float>(f, prefix, [](const char* s) { return std::stof(s); });
-    } break;
-    case google::protobuf::FieldDescriptor::CPPTYPE_BOOL: {
-        auto f = msg->GetReflection()->GetMutableRepeatedFieldRef<bool>(msg, field);
-        parse_array_inner<bool>(f, prefix, [](const char* s) {
-            bool parsed = false;
-            std::istringstream is(s);
-            is >> std::boolalpha >> parsed;
-            return parsed;
-        });
-    } break;
-    case google::protobuf::FieldDescriptor::CPPTYPE_ENUM: {
-        auto f = msg->GetReflection()->GetMutableRepeatedFieldRef<int32>(msg, field);
-        parse_array_inner<int32>(f, prefix, [&](const char* s) {
-            const google::protobuf::EnumValueDescriptor* v = field->enum_type()->FindValueByName(s);
-            return v->number();
-        });
-    } break;
-    case google::protobuf::FieldDescriptor::CPPTYPE_STRING: {
-        auto f = msg->GetReflection()->GetMutableRepeatedFieldRef<std::string>(msg, field);
-        parse_array_inner<std::string>(f, prefix, [](const char* s) { return s; });
-    } break;
-    case google::protobuf::FieldDescriptor::CPPTYPE_MESSAGE:
+    case FieldDescriptor::CPPTYPE_INT32:
+        return parse_array_inner(msg->GetReflection()->GetMutableRepeatedFieldRef<int32_t>(msg, field), prefix,
+                                 field, budget_);
+    case FieldDescriptor::CPPTYPE_INT64:
+        return parse_array_inner(msg->GetReflection()->GetMutableRepeatedFieldRef<int64_t>(msg, field), prefix,
+                                 field, budget_);
+    case FieldDescriptor::CPPTYPE_UINT32:
+        return parse_array_inner(msg->GetReflection()->GetMutableRepeatedFieldRef<uint32_t>(msg, field), prefix,
+                                 field, budget_);
+    case FieldDescriptor::CPPTYPE_UINT64:
+        return parse_array_inner(msg->GetReflection()->GetMutableRepeatedFieldRef<uint64_t>(msg, field), prefix,
+                                 field, budget_);
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+        return parse_array_inner(msg->GetReflection()->GetMutableRepeatedFieldRef<double>(msg, field), prefix,
+                                 field, budget_);
+    case FieldDescriptor::CPPTYPE_FLOAT:
+        return parse_array_inner(msg->GetReflection()->GetMutableRepeatedFieldRef<float>(msg, field), prefix,
+                                 field, budget_);
+    case FieldDescriptor::CPPTYPE_BOOL:
+        return parse_array_inner(msg->GetReflection()->GetMutableRepeatedFieldRef<bool>(msg, field), prefix,
+                                 field, budget_);
+    case FieldDescriptor::CPPTYPE_ENUM:
+        return parse_array_enum(msg, prefix, field);
+    case FieldDescriptor::CPPTYPE_STRING:
+        if (field->type() == FieldDescriptor::TYPE_BYTES) {
+            return parse_array_bytes(msg, prefix, field);
+        }
+        return parse_array_inner(msg->GetReflection()->GetMutableRepeatedFieldRef<std::string>(msg, field), prefix,
+                                 field, budget_);
+    case FieldDescriptor::CPPTYPE_MESSAGE:
         std::cerr << "Unsupported repeated type MESSAGE" << std::endl;
         break;
     }
+
+    return {};
 }
 
 std::string ParserEnv::cook_env_var(const std::string& prefix, const std::string& suffix) {
-    return prefix + '_' + case_convert::all_caps(case_convert::camel_to_snake(suffix));
+    // Same as all_caps(camel_to_snake(suffix)), written straight into the result
+    std::string out;
+    out.reserve(prefix.size() + 1 + suffix.size() * 2);
+    out += prefix;
+    out += '_';
+    for (size_t i = 0; i < suffix.size(); i++) {
+        const char c = suffix[i];
+        if (i != 0 && std::isupper(c) != 0) {
+            out += '_';
+        }
+        out += static_cast<char>(std::toupper(c));
+    }
+    return out;
 }
 } // namespace config_much::internal
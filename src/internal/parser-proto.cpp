@@ -0,0 +1,356 @@
+#include "internal/parser-proto.h"
+#include "internal/deferred-sections.h"
+#include "internal/time-parse.h"
+#include "internal/validation.h"
+
+#include <google/protobuf/io/tokenizer.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <google/protobuf/stubs/common.h>
+#include <google/protobuf/wire_format_lite.h>
+
+#include <algorithm>
+#include <climits>
+#include <set>
+#include <utility>
+
+namespace config_much::internal {
+
+// Static helpers
+namespace {
+using google::protobuf::internal::WireFormatLite;
+
+/// Fields that are set as a whole, everything but sub-messages.
+bool is_leaf(const google::protobuf::FieldDescriptor* field) {
+    return field->is_repeated() || field->type() != google::protobuf::FieldDescriptor::TYPE_MESSAGE ||
+           time_type(field->message_type()) != TimeType::NONE;
+}
+
+/// Drop the first count elements of a repeated field, the others keep their order.
+void remove_first(google::protobuf::Message* msg, const google::protobuf::FieldDescriptor* field, int count) {
+    const auto* reflection = msg->GetReflection();
+    const int size         = reflection->FieldSize(*msg, field);
+    for (int i = count; i < size; i++) {
+        reflection->SwapElements(msg, field, i - count, i);
+    }
+    for (int i = 0; i < count; i++) {
+        reflection->RemoveLast(msg, field);
+    }
+}
+
+/// Drop the elements of a repeated field past size.
+void truncate(google::protobuf::Message* msg, const google::protobuf::FieldDescriptor* field, int size) {
+    const auto* reflection = msg->GetReflection();
+    for (int i = reflection->FieldSize(*msg, field); i > size; i--) {
+        reflection->RemoveLast(msg, field);
+    }
+}
+
+class ErrorCollector : public google::protobuf::io::ErrorCollector {
+public:
+    ErrorCollector(const std::filesystem::path& file, std::vector<ParserError>& errors)
+        : file_(file), errors_(errors) {}
+
+#if GOOGLE_PROTOBUF_VERSION >= 4022000
+    void RecordError(int line, google::protobuf::io::ColumnNumber column, absl::string_view message) override {
+#else
+    void AddError(int line, google::protobuf::io::ColumnNumber column, const std::string& message) override {
+#endif
+        ParserError err;
+        err << file_ << ": error at line " << line + 1 << ", column " << column + 1 << ": " << message;
+        errors_.emplace_back(std::move(err));
+    }
+
+private:
+    const std::filesystem::path& file_;
+    std::vector<ParserError>& errors_;
+};
+} // namespace
+
+std::optional<ParserProto::Format> ParserProto::format_for(const std::filesystem::path& file) {
+    const auto ext = file.extension();
+    if (ext == ".binpb" || ext == ".pb") {
+        return BINARY;
+    }
+    if (ext == ".txtpb" || ext == ".textproto" || ext == ".pbtxt") {
+        return TEXT;
+    }
+    return {};
+}
+
+ParserResult ParserProto::parse(google::protobuf::Message* msg) {
+    auto err = source_->load();
+    if (err) {
+        source_->release();
+        return {{*err}};
+    }
+    // The loaded bytes plus the message, about as large as its encoding. Parser reports the exceeded budget.
+    if (budget_ != nullptr && !budget_->charge(2 * source_->data().size())) {
+        source_->release();
+        return {};
+    }
+    if (provenance_ != nullptr) {
+        source_id_ = provenance_->add_source(file_.string());
+    }
+
+    auto res = format_ == BINARY ? parse_binary(msg, source_->data()) : parse_text(msg, source_->data());
+    source_->release();
+    return res;
+}
+
+ParserResult ParserProto::parse_binary(google::protobuf::Message* msg, std::string_view data) {
+    if (data.size() > INT_MAX) {
+        ParserError err;
+        err << file_ << ": File too large";
+        return {{err}};
+    }
+
+    const auto* buffer = reinterpret_cast<const uint8_t*>(data.data());
+    const int size     = static_cast<int>(data.size());
+
+    // A first pass over the tags finds the repeated fields to replace,
+    // the merge then reads straight from the source's buffer.
+    std::vector<Touched> touched;
+    std::vector<Skipped> skipped;
+    google::protobuf::io::CodedInputStream scan_input(buffer, size);
+    bool ok = scan(&scan_input, msg, FieldPath(), touched, skipped);
+
+    // Interleaved fields show up once per run, they're validated once. The merge appends to repeated
+    // fields, what they held before is only dropped once it succeeded.
+    std::set<std::pair<const google::protobuf::Message*, const google::protobuf::FieldDescriptor*>> seen;
+    touched.erase(std::remove_if(touched.begin(), touched.end(),
+                                 [&seen](const Touched& t) { return !seen.insert({t.msg, t.field}).second; }),
+                  touched.end());
+    // Durations and timestamps are replaced as a whole rather than merged, their value is set aside until then
+    for (auto& t : touched) {
+        const auto* reflection = t.msg->GetReflection();
+        if (t.field->is_repeated()) {
+            t.kept = reflection->FieldSize(*t.msg, t.field);
+        } else if (t.field->cpp_type() == google::protobuf::FieldDescriptor::CPPTYPE_MESSAGE &&
+                   reflection->HasField(*t.msg, t.field)) {
+            t.previous.reset(reflection->ReleaseMessage(t.msg, t.field));
+        }
+    }
+
+    // Top-level fields can be merged in any number of pieces, deferred
+    // ones are cut out and copied for their section.
+    int begin = 0;
+    for (size_t i = 0; ok && i <= skipped.size(); i++) {
+        const int end = i < skipped.size() ? skipped[i].begin : size;
+        if (end > begin) {
+            google::protobuf::io::CodedInputStream input(buffer + begin, end - begin);
+            ok = msg->MergeFromCodedStream(&input) && input.ConsumedEntireMessage();
+        }
+        if (i < skipped.size()) {
+            begin = skipped[i].end;
+        }
+    }
+
+    for (auto& t : touched) {
+        if (t.kept > 0 && ok) {
+            remove_first(t.msg, t.field, t.kept);
+        } else if (t.kept > 0) {
+            truncate(t.msg, t.field, t.kept);
+        } else if (t.previous && !ok) {
+            t.msg->GetReflection()->SetAllocatedMessage(t.msg, t.previous.release(), t.field);
+        }
+    }
+
+    if (!ok) {
+        ParserError err;
+        err << file_ << ": Failed to parse binary " << msg->GetDescriptor()->full_name();
+        return {{err}};
+    }
+
+    // Every occurrence of a deferred field goes to its section, in order
+    std::vector<std::pair<const google::protobuf::FieldDescriptor*, std::shared_ptr<std::string>>> parts;
+    for (const auto& skip : skipped) {
+        auto it = std::find_if(parts.begin(), parts.end(), [&skip](const auto& p) { return p.first == skip.field; });
+        if (it == parts.end()) {
+            it = parts.emplace(parts.end(), skip.field, std::make_shared<std::string>());
+        }
+        it->second->append(data.substr(skip.begin, static_cast<size_t>(skip.end - skip.begin)));
+    }
+
+    for (auto& [field, bytes] : parts) {
+        deferred_->add(field, [file = file_, bytes = std::move(bytes)](google::protobuf::Message* root) {
+            return ParserProto(std::make_unique<MemorySource>(file, *bytes), BINARY).parse(root);
+        });
+    }
+    return finish(touched);
+}
+
+ParserResult ParserProto::parse_text(google::protobuf::Message* msg, std::string_view data) {
+    if (data.size() > INT_MAX) {
+        ParserError err;
+        err << file_ << ": File too large";
+        return {{err}};
+    }
+
+    std::vector<ParserError> errors;
+    ErrorCollector collector(file_, errors);
+    google::protobuf::TextFormat::ParseInfoTree tree;
+
+    google::protobuf::TextFormat::Parser parser;
+    parser.RecordErrorsTo(&collector);
+    parser.WriteLocationsTo(&tree);
+
+    // Text format merges append to repeated fields, so the input is
+    // parsed on its own first to find out what it sets.
+    std::unique_ptr<google::protobuf::Message> layer(msg->New());
+    google::protobuf::io::ArrayInputStream input(data.data(), static_cast<int>(data.size()));
+    if (!parser.Merge(&input, layer.get())) {
+        if (errors.empty()) {
+            ParserError err;
+            err << file_ << ": Failed to parse " << msg->GetDescriptor()->full_name();
+            errors.emplace_back(std::move(err));
+        }
+        return errors;
+    }
+
+    if (deferred_ != nullptr) {
+        const auto* descriptor = layer->GetDescriptor();
+        const auto* reflection = layer->GetReflection();
+        for (int i = 0; i < descriptor->field_count(); i++) {
+            const auto* field = descriptor->field(i);
+            if (!deferred_->is_deferred(field) || !reflection->HasField(*layer, field)) {
+                continue;
+            }
+
+            // Text is decoded as a whole, the section only gets to merge it later
+            std::shared_ptr<google::protobuf::Message> part(msg->New());
+            part->GetReflection()->SetAllocatedMessage(part.get(), reflection->ReleaseMessage(layer.get(), field),
+                                                       field);
+            deferred_->add(field, [file = file_, part](google::protobuf::Message* root) {
+                return ParserProto(std::make_unique<MemorySource>(file, std::string_view()), TEXT)
+                    .merge(root, *part, nullptr);
+            });
+        }
+    }
+
+    return merge(msg, *layer, &tree);
+}
+
+ParserResult ParserProto::merge(google::protobuf::Message* msg, const google::protobuf::Message& layer,
+                                const google::protobuf::TextFormat::ParseInfoTree* tree) {
+    std::vector<Touched> touched;
+    walk(layer, msg, FieldPath(), tree, touched);
+    msg->MergeFrom(layer);
+    return finish(touched);
+}
+
+bool ParserProto::scan(google::protobuf::io::CodedInputStream* input, google::protobuf::Message* msg,
+                       const FieldPath& path, std::vector<Touched>& touched, std::vector<Skipped>& skipped) {
+    const auto* descriptor = msg->GetDescriptor();
+    const auto* reflection = msg->GetReflection();
+
+    for (;;) {
+        const int begin    = input->CurrentPosition();
+        const uint32_t tag = input->ReadTag();
+        if (tag == 0) {
+            return input->ConsumedEntireMessage();
+        }
+
+        const auto* field = descriptor->FindFieldByNumber(WireFormatLite::GetTagFieldNumber(tag));
+        if (field != nullptr && is_deferred(field, path)) {
+            if (!WireFormatLite::SkipField(input, tag)) {
+                return false;
+            }
+            skipped.push_back({field, begin, input->CurrentPosition()});
+            continue;
+        }
+
+        if (field != nullptr && !is_leaf(field) &&
+            WireFormatLite::GetTagWireType(tag) == WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+            uint32_t length = 0;
+            if (!input->ReadVarint32(&length) || length > INT_MAX) {
+                return false;
+            }
+
+            auto limit = input->PushLimit(static_cast<int>(length));
+            if (!scan(input, reflection->MutableMessage(msg, field), path.child(field), touched, skipped)) {
+                return false;
+            }
+            input->PopLimit(limit);
+            continue;
+        }
+
+        // Elements of repeated fields usually come one after the other, the others are deduplicated later
+        const bool seen = !touched.empty() && touched.back().msg == msg && touched.back().field == field;
+        if (field != nullptr && !seen) {
+            touch(msg, path.child(field), 0, touched);
+        }
+
+        if (!WireFormatLite::SkipField(input, tag)) {
+            return false;
+        }
+    }
+}
+
+void ParserProto::walk(const google::protobuf::Message& layer, google::protobuf::Message* msg,
+                       const FieldPath& path, const google::protobuf::TextFormat::ParseInfoTree* tree,
+                       std::vector<Touched>& touched) {
+    const auto* descriptor       = layer.GetDescriptor();
+    const auto* layer_reflection = layer.GetReflection();
+    const auto* reflection       = msg->GetReflection();
+
+    for (int i = 0; i < descriptor->field_count(); i++) {
+        const auto* field = descriptor->field(i);
+        const int index   = field->is_repeated() ? 0 : -1;
+        if (is_deferred(field, path)) {
+            continue;
+        }
+
+        // Fields explicitly set to their default don't show up as set,
+        // the locations tell them apart from fields not in the input.
+        const bool set = field->is_repeated() ? layer_reflection->FieldSize(layer, field) > 0
+                                              : layer_reflection->HasField(layer, field);
+        const int line = tree != nullptr ? tree->GetLocation(field, index).line : -1;
+        if (!set && line < 0) {
+            continue;
+        }
+
+        if (!is_leaf(field)) {
+            walk(layer_reflection->GetMessage(layer, field), reflection->MutableMessage(msg, field), path.child(field),
+                 tree != nullptr ? tree->GetTreeForNested(field, -1) : nullptr, touched);
+            continue;
+        }
+
+        // The merge doesn't copy default values over and would mix two durations or timestamps, clearing takes
+        // care of both
+        reflection->ClearField(msg, field);
+        touch(msg, path.child(field), static_cast<uint32_t>(line + 1), touched);
+    }
+}
+
+void ParserProto::touch(google::protobuf::Message* msg, const FieldPath& path, uint32_t line,
+                        std::vector<Touched>& touched) {
+    if (provenance_ != nullptr) {
+        provenance_->record(path, source_id_, line);
+    }
+
+    const bool rules = ValidationProgram::get(msg->GetDescriptor()).has_rules(path.field);
+    touched.push_back({msg, path.field, rules ? path.str() : std::string(), line});
+}
+
+bool ParserProto::is_deferred(const google::protobuf::FieldDescriptor* field, const FieldPath& path) const {
+    return deferred_ != nullptr && path.empty() && deferred_->is_deferred(field);
+}
+
+ParserResult ParserProto::finish(const std::vector<Touched>& touched) {
+    std::vector<ParserError> errors;
+    for (const auto& t : touched) {
+        auto err = ValidationProgram::get(t.msg->GetDescriptor()).check(*t.msg, t.field, t.path);
+        if (err) {
+            ParserError e;
+            e << file_ << ": " << *err;
+            errors.emplace_back(std::move(e));
+        }
+    }
+
+    if (!errors.empty()) {
+        return errors;
+    }
+    return {};
+}
+
+} // namespace config_much::internal
@@ -1,9 +1,21 @@
 #include "internal/parser-yaml.h"
+#include "internal/bytes-value.h"
 #include "internal/case-convert.h"
+#include "internal/deferred-sections.h"
+#include "internal/enum-table.h"
+#include "internal/field-table.h"
+#include "internal/time-parse.h"
+#include "internal/validation.h"
 
 #include <yaml-cpp/exceptions.h>
 
+#include <atomic>
+#include <condition_variable>
 #include <exception>
+#include <istream>
+#include <mutex>
+#include <streambuf>
+#include <type_traits>
 
 namespace config_much::internal {
 
@@ -26,52 +38,228 @@ std::string node_type_to_string(YAML::NodeType::value type) {
     return ""; // Unreachable
 }
 
-std::string concat_path(const std::string& path, const std::string& name) {
-    auto out = path;
-    if (!path.empty()) {
-        out += ".";
+// Children of a map as key and value, yaml-cpp iterates over pairs while YamlNode's children know their key
+std::string_view map_key(const YAML::const_iterator::value_type& child) { return child.first.Scalar(); }
+const YAML::Node& map_value(const YAML::const_iterator::value_type& child) { return child.second; }
+std::string_view map_key(const YamlNode& child) { return child.key(); }
+const YamlNode& map_value(const YamlNode& child) { return child; }
+std::string_view map_key(const OverlayNode& child) { return child.key(); }
+const OverlayNode& map_value(const OverlayNode& child) { return child; }
+
+// What looking up a missing key gives, a default YAML::Node is a null rather than undefined
+template <typename Node> Node undefined() {
+    if constexpr (std::is_same_v<Node, YAML::Node>) {
+        static const YAML::Node node(YAML::NodeType::Undefined);
+        return node;
+    } else {
+        return Node();
     }
-    out += name;
-    return out;
 }
+
+// The value of the key spelling name in any convention, undefined if there's none. Keys are
+// usually spelled the way the parser expects, those are looked for first.
+template <typename Node> Node find_key(const Node& node, std::string_view name, std::string_view expected) {
+    if (!node.IsMap()) {
+        return undefined<Node>();
+    }
+    for (const auto& child : node) {
+        if (map_key(child) == expected) {
+            return map_value(child);
+        }
+    }
+    for (const auto& child : node) {
+        if (case_convert::same_name(map_key(child), name)) {
+            return map_value(child);
+        }
+    }
+    return undefined<Node>();
+}
+OverlayNode find_key(const OverlayNode& node, std::string_view name, std::string_view /*expected*/) {
+    return node[name];
+}
+
+// Charge a decoded node to budget, false once it is exceeded
+template <typename Node> bool charge(MemoryBudget* budget, const Node& node) {
+    return budget == nullptr || budget->charge(MemoryBudget::NODE_COST + (node.IsScalar() ? node.Scalar().size() : 0));
+}
+
+// Lets yaml-cpp read straight from a source's buffer without copying it
+// into a stringstream first.
+class ViewBuf : public std::streambuf {
+public:
+    ViewBuf(std::string_view data) {
+        // The get area is never written to
+        char* begin = const_cast<char*>(data.data());
+        setg(begin, begin, begin + data.size());
+    }
+};
 }; // namespace
 
 ParserResult ParserYaml::parse(google::protobuf::Message* msg) {
     using namespace google::protobuf;
     YAML::Node node;
 
-    try {
-        node = YAML::LoadFile(file_);
-    } catch (const YAML::BadFile& e) {
-        return {{wrap_error(e)}};
-    } catch (const YAML::ParserException& e) {
-        return {{wrap_error(e)}};
+    auto err = source_->load();
+    if (!err && budget_ != nullptr && !budget_->charge(source_->data().size())) {
+        // Not even the document fits, the parser reports the exceeded budget
+        source_->release();
+        return {};
+    }
+    if (!err && backend_ == SCANNER) {
+        // Deferred sections are decoded after the source is released, they get their own copy
+        auto document = YamlDocument::scan(source_->data(), deferred_ != nullptr);
+        if (document) {
+            nodes_   = document;
+            auto res = parse_document(msg, document->root());
+            source_->release();
+            nodes_.reset();
+            return res;
+        }
+    }
+
+    if (!err) {
+        try {
+            ViewBuf buf(source_->data());
+            std::istream input(&buf);
+            node = YAML::Load(input);
+        } catch (const YAML::ParserException& e) {
+            err = wrap_error(e, file_);
+        }
+    }
+
+    // The node holds its own copy of everything it needs
+    source_->release();
+    if (err) {
+        return {{*err}};
     }
 
     return parse(msg, node);
 }
 
 ParserResult ParserYaml::parse(google::protobuf::Message* msg, const YAML::Node& node) {
+    return parse_document(msg, node);
+}
+
+std::optional<ParserError> ParserYaml::load(YAML::Node* root) {
+    auto err = source_->load();
+    if (!err && budget_ != nullptr && !budget_->charge(source_->data().size())) {
+        source_->release();
+        return {};
+    }
+    if (!err) {
+        try {
+            ViewBuf buf(source_->data());
+            std::istream input(&buf);
+            root->reset(YAML::Load(input));
+        } catch (const YAML::ParserException& e) {
+            err = wrap_error(e, file_);
+        }
+    }
+
+    // The node holds its own copy of everything it needs
+    source_->release();
+    return err;
+}
+
+ParserResult ParserYaml::parse_overlay(const std::vector<ParserYaml*>& layers, google::protobuf::Message* msg) {
+    std::vector<ParserError> errors;
+    auto overlay = std::make_shared<YamlOverlay>();
+
+    ParserYaml& first = *layers.front();
+    first.layer_sources_.clear();
+    for (auto* layer : layers) {
+        YAML::Node root;
+        auto err = layer->load(&root);
+        if (layer->budget_ != nullptr && layer->budget_->exceeded()) {
+            // Not even the layers fit, the parser reports the exceeded budget
+            return errors.empty() ? ParserResult() : ParserResult(std::move(errors));
+        }
+        if (!err && !root.IsMap()) {
+            err = "Invalid configuration: root node should be a map.";
+        }
+        if (err) {
+            errors.emplace_back(std::move(*err));
+            continue;
+        }
+
+        overlay->add(layer->file_, root);
+        if (first.provenance_ != nullptr) {
+            first.layer_sources_.push_back(first.provenance_->add_source(layer->file_.string()));
+        }
+    }
+
+    if (overlay->layers() != 0) {
+        first.nodes_ = overlay;
+        auto err     = first.parse_document(msg, overlay->root());
+        first.nodes_.reset();
+        if (err) {
+            errors.insert(errors.end(), err->begin(), err->end());
+        }
+    }
+
+    if (!errors.empty()) {
+        return errors;
+    }
+    return {};
+}
+
+template <typename Node> ParserResult ParserYaml::parse_document(google::protobuf::Message* msg, const Node& node) {
     using namespace google::protobuf;
 
     if (node.IsScalar() || node.IsNull()) {
         return {{"Invalid configuration: root node should be a map."}};
     }
 
+    // Layers of an overlay are registered up front, one source each
+    if (provenance_ != nullptr && !std::is_same_v<Node, OverlayNode>) {
+        source_id_ = provenance_->add_source(file_.string());
+    }
+
     std::vector<ParserError> errors;
+    std::vector<Subtree<Node>> subtrees;
+
+    // Records of provenance are shared by every field, they're only ever written from here
+    const bool parallel = parallel_ && provenance_ == nullptr;
 
     const Descriptor* descriptor = msg->GetDescriptor();
     for (int i = 0; i < descriptor->field_count(); i++) {
         const FieldDescriptor* field = descriptor->field(i);
-        std::string path;
+        if (deferred_ != nullptr && deferred_->is_deferred(field)) {
+            defer(node, field);
+            continue;
+        }
+
+        if (parallel && field->type() == FieldDescriptor::TYPE_MESSAGE &&
+            field->label() != FieldDescriptor::LABEL_REPEATED) {
+            Node value = find_key(node, field->name(), field_name(field));
+            if (value.IsMap() && value.size() >= parallel_min_keys_) {
+                // Created here, tasks must not touch the parent
+                Message* m = msg->GetReflection()->MutableMessage(msg, field);
+                subtrees.push_back({field, m, std::move(value), errors.size(), {}});
+                continue;
+            }
+        }
 
-        auto err = parse(msg, node, field, path);
+        auto err = parse(msg, node, field, FieldPath());
         if (err) {
             errors.insert(errors.end(), err->begin(), err->end());
         }
     }
 
-    if (validation_mode_ != PERMISSIVE) {
+    if (!subtrees.empty()) {
+        decode_parallel(subtrees);
+
+        // Back to front so the positions of earlier subtrees stay valid
+        for (auto it = subtrees.rbegin(); it != subtrees.rend(); ++it) {
+            if (it->errors) {
+                errors.insert(errors.begin() + static_cast<ptrdiff_t>(it->errors_at), it->errors->begin(),
+                              it->errors->end());
+            }
+        }
+    }
+
+    // Fields left undecoded past the budget aren't unknown
+    if (validation_mode_ != PERMISSIVE && (budget_ == nullptr || !budget_->exceeded())) {
         auto res = find_unknown_fields(*msg, node);
         if (res) {
             errors.insert(errors.end(), res->begin(), res->end());
@@ -84,13 +272,81 @@ ParserResult ParserYaml::parse(google::protobuf::Message* msg, const YAML::Node&
     return {};
 }
 
-template <typename T>
-ParserResult ParserYaml::parse_array_inner(google::protobuf::Message* msg, const YAML::Node& node,
+template <typename Node> void ParserYaml::decode_parallel(std::vector<Subtree<Node>>& subtrees) {
+    struct State {
+        std::atomic<size_t> next{0};
+        std::mutex mutex;
+        std::condition_variable finished;
+        size_t done = 0;
+    };
+    auto state = std::make_shared<State>();
+
+    // Every task, and the calling thread, takes subtrees until none are left. Tasks the executor
+    // only gets to after that find nothing to do, so waiting on them can't deadlock.
+    auto drain = [this, state, items = subtrees.data(), count = subtrees.size()] {
+        for (size_t i = state->next++; i < count; i = state->next++) {
+            items[i].errors = decode_subtree(items[i]);
+
+            std::lock_guard lock(state->mutex);
+            if (++state->done == count) {
+                state->finished.notify_all();
+            }
+        }
+    };
+
+    for (size_t i = 1; i < subtrees.size(); i++) {
+        parallel_(drain);
+    }
+    drain();
+
+    std::unique_lock lock(state->mutex);
+    state->finished.wait(lock, [&] { return state->done == subtrees.size(); });
+}
+
+template <typename Node> ParserResult ParserYaml::decode_subtree(const Subtree<Node>& subtree) {
+    // Same as parse() does for a message field, minus creating the message
+    std::vector<ParserError> errors;
+    const FieldPath root;
+    const FieldPath path                           = root.child(subtree.field);
+    const google::protobuf::Descriptor* descriptor = subtree.msg->GetDescriptor();
+    for (int i = 0; i < descriptor->field_count(); i++) {
+        auto err = parse(subtree.msg, subtree.node, descriptor->field(i), path);
+        if (err) {
+            errors.insert(errors.end(), err->begin(), err->end());
+        }
+    }
+
+    if (!errors.empty()) {
+        return errors;
+    }
+    return {};
+}
+
+template <typename Node>
+void ParserYaml::defer(const Node& node, const google::protobuf::FieldDescriptor* field) {
+    if (!find_key(node, field->name(), field_name(field))) {
+        return;
+    }
+
+    // Parsed like a file holding only the field once the section is needed, with the settings of this parser.
+    // nodes_ keeps the nodes alive.
+    deferred_->add(field, [file = file_, camelcase = camelcase_, mode = validation_mode_, node, field,
+                           nodes = nodes_](google::protobuf::Message* root) {
+        return ParserYaml(std::make_unique<MemorySource>(file, std::string_view()), camelcase, mode)
+            .parse(root, node, field, FieldPath());
+    });
+}
+
+template <typename T, typename Node>
+ParserResult ParserYaml::parse_array_inner(google::protobuf::Message* msg, const Node& node,
                                            const google::protobuf::FieldDescriptor* field) {
     std::vector<ParserError> errors;
     auto f = msg->GetReflection()->GetMutableRepeatedFieldRef<T>(msg, field);
     f.Clear();
     for (const auto& n : node) {
+        if (!charge(budget_, n)) {
+            break;
+        }
         auto value = try_convert<T>(n);
         if (!is_error(value)) {
             f.Add(std::get<T>(value));
@@ -105,7 +361,8 @@ ParserResult ParserYaml::parse_array_inner(google::protobuf::Message* msg, const
     return {};
 }
 
-ParserResult ParserYaml::parse_array_enum(google::protobuf::Message* msg, const YAML::Node& node,
+template <typename Node>
+ParserResult ParserYaml::parse_array_enum(google::protobuf::Message* msg, const Node& node,
                                           const google::protobuf::FieldDescriptor* field) {
     using namespace google::protobuf;
 
@@ -113,8 +370,11 @@ ParserResult ParserYaml::parse_array_enum(google::protobuf::Message* msg, const
     auto f = msg->GetReflection()->GetMutableRepeatedFieldRef<int32>(msg, field);
     f.Clear();
 
-    const EnumDescriptor* desc = field->enum_type();
+    const EnumTable& table = EnumTable::get(field->enum_type());
     for (const auto& n : node) {
+        if (!charge(budget_, n)) {
+            break;
+        }
         auto v = try_convert<std::string_view>(n);
         if (is_error(v)) {
             errors.emplace_back(std::move(std::get<ParserError>(v)));
@@ -122,16 +382,16 @@ ParserResult ParserYaml::parse_array_enum(google::protobuf::Message* msg, const
         }
         const auto name = std::get<std::string_view>(v);
 
-        const EnumValueDescriptor* value = desc->FindValueByName(name);
-        if (value == nullptr) {
+        auto value = table.resolve(name);
+        if (!value) {
             ParserError err;
-            err << file_ << ": Invalid enum value '" << name << "' for field "
-                << (camelcase_ ? case_convert::snake_to_camel(field->name()) : field->name());
+            err << file_of(node) << ": Invalid enum value '" << name << "' for field "
+                << field_name(field);
             errors.emplace_back(std::move(err));
             continue;
         }
 
-        f.Add(value->number());
+        f.Add(*value);
     }
 
     if (!errors.empty()) {
@@ -140,37 +400,76 @@ ParserResult ParserYaml::parse_array_enum(google::protobuf::Message* msg, const
     return {};
 }
 
-ParserResult ParserYaml::find_unknown_fields(const google::protobuf::Message& msg, const YAML::Node& node) {
+template <typename Node>
+ParserResult ParserYaml::parse_array_bytes(google::protobuf::Message* msg, const Node& node,
+                                           const google::protobuf::FieldDescriptor* field) {
+    std::vector<ParserError> errors;
+    const auto* reflection = msg->GetReflection();
+    reflection->ClearField(msg, field);
+
+    for (const auto& n : node) {
+        if (!charge(budget_, n)) {
+            break;
+        }
+        auto v = try_convert<std::string_view>(n);
+        if (is_error(v)) {
+            errors.emplace_back(std::move(std::get<ParserError>(v)));
+            continue;
+        }
+
+        std::string value;
+        auto err = parse_bytes(std::get<std::string_view>(v), file_of(node).parent_path(), &value);
+        if (err) {
+            ParserError e;
+            e << file_of(node) << ": Invalid bytes value for field "
+              << field_name(field) << ": " << *err;
+            errors.emplace_back(std::move(e));
+            continue;
+        }
+
+        reflection->AddString(msg, field, std::move(value));
+    }
+
+    if (!errors.empty()) {
+        return errors;
+    }
+    return {};
+}
+
+template <typename Node>
+ParserResult ParserYaml::find_unknown_fields(const google::protobuf::Message& msg, const Node& node) {
     using namespace google::protobuf;
 
-    const auto* descriptor = msg.GetDescriptor();
+    const FieldTable& fields = FieldTable::get(msg.GetDescriptor());
     std::vector<ParserError> errors;
 
-    for (YAML::const_iterator it = node.begin(); it != node.end(); it++) {
-        auto name = it->first.as<std::string>();
-        if (camelcase_) {
-            name = case_convert::camel_to_snake(name);
-        }
+    for (const auto& child : node) {
+        const std::string_view key = map_key(child);
+        const auto& value          = map_value(child);
 
-        const FieldDescriptor* field = descriptor->FindFieldByName(name);
+        const FieldDescriptor* field = fields.find(key);
         if (field == nullptr) {
             ParserError err;
-            err << "Unknown field '" << name << "'";
+            if constexpr (std::is_same_v<Node, OverlayNode>) {
+                // Layers are checked together, name the file the key comes from
+                err << value.file() << ": ";
+            }
+            err << "Unknown field '" << (camelcase_ ? case_convert::camel_to_snake(std::string(key)) : key) << "'";
             errors.emplace_back(std::move(err));
             continue;
         }
 
-        if (it->second.IsMap()) {
+        if (value.IsMap()) {
             if (field->type() != FieldDescriptor::TYPE_MESSAGE) {
                 ParserError err;
-                err << file_ << ": Invalid type '" << node_type_to_string(it->second.Type()) << "' for field "
-                    << it->first.as<std::string_view>() << ", expected '" << field->type_name() << "'";
+                err << file_of(value) << ": Invalid type '" << node_type_to_string(value.Type()) << "' for field "
+                    << key << ", expected '" << field->type_name() << "'";
                 errors.emplace_back(std::move(err));
                 continue;
             }
 
             const auto* reflection = msg.GetReflection();
-            auto res               = find_unknown_fields(reflection->GetMessage(msg, field), it->second);
+            auto res               = find_unknown_fields(reflection->GetMessage(msg, field), value);
 
             if (res) {
                 errors.insert(errors.end(), res->begin(), res->end());
@@ -184,42 +483,60 @@ ParserResult ParserYaml::find_unknown_fields(const google::protobuf::Message& ms
     return {};
 }
 
-ParserResult ParserYaml::parse(google::protobuf::Message* msg, const YAML::Node& node,
-                               const google::protobuf::FieldDescriptor* field, const std::string& path) {
+template <typename Node>
+ParserResult ParserYaml::parse(google::protobuf::Message* msg, const Node& node,
+                               const google::protobuf::FieldDescriptor* field, const FieldPath& path) {
     using namespace google::protobuf;
 
-    std::unique_ptr<std::string> name_ptr = nullptr;
-    const std::string* name               = &field->name();
-    if (camelcase_) {
-        name_ptr = std::make_unique<std::string>(case_convert::snake_to_camel(*name));
-        name     = name_ptr.get();
+    // Once the budget is exceeded the rest of the document is skipped, the parser reports it
+    if (budget_ != nullptr && budget_->exceeded()) {
+        return {};
     }
 
-    if (!node[*name]) {
+    const std::string& name = field_name(field);
+    const Node value        = find_key(node, field->name(), name);
+    if (!value) {
         if (validation_mode_ == STRICT) {
             ParserError err;
-            err << "Missing field '" << concat_path(path, *name) << "'";
+            err << "Missing field '" << path.child(field).str() << "'";
             return {{err}};
         }
         return {};
     }
+    if (!charge(budget_, value)) {
+        return {};
+    }
 
     if (field->label() == FieldDescriptor::LABEL_REPEATED) {
-        if (!node[*name].IsSequence()) {
+        if (!value.IsSequence()) {
             ParserError err;
-            YAML::NodeType::value type = node[*name].Type();
-            err << file_ << ": Type mismatch for '" << *name << "' - expected Sequence, got "
+            YAML::NodeType::value type = value.Type();
+            err << file_of(value) << ": Type mismatch for '" << name << "' - expected Sequence, got "
                 << node_type_to_string(type);
             return {{err}};
         }
-        return parse_array(msg, node[*name], field);
+        auto res = parse_array(msg, value, field);
+        if (res) {
+            return res;
+        }
+        return field_set(msg, field, path, value);
     }
 
     if (field->type() == FieldDescriptor::TYPE_MESSAGE) {
-        if (!node[*name].IsMap()) {
+        const TimeType time = time_type(field->message_type());
+        if (time != TimeType::NONE && value.IsScalar()) {
+            auto res = parse_time(msg, value, field, time, name);
+            if (res) {
+                return res;
+            }
+            return field_set(msg, field, path, value);
+        }
+
+        if (!value.IsMap()) {
             ParserError err;
-            YAML::NodeType::value type = node[*name].Type();
-            err << file_ << ": Type mismatch for '" << *name << "' - expected Map, got " << node_type_to_string(type);
+            YAML::NodeType::value type = value.Type();
+            err << file_of(value) << ": Type mismatch for '" << name << "' - expected Map, got "
+                << node_type_to_string(type);
             return {{err}};
         }
         std::vector<ParserError> errors;
@@ -227,11 +544,12 @@ ParserResult ParserYaml::parse(google::protobuf::Message* msg, const YAML::Node&
 
         Message* m = reflection->MutableMessage(msg, field);
 
+        const FieldPath sub_path     = path.child(field);
         const Descriptor* descriptor = m->GetDescriptor();
         for (int i = 0; i < descriptor->field_count(); i++) {
             const FieldDescriptor* f = descriptor->field(i);
 
-            auto err = parse(m, node[*name], f, concat_path(path, *name));
+            auto err = parse(m, value, f, sub_path);
             if (err) {
                 errors.insert(errors.end(), err->begin(), err->end());
             }
@@ -243,16 +561,51 @@ ParserResult ParserYaml::parse(google::protobuf::Message* msg, const YAML::Node&
         return {};
     }
 
-    if (!node[*name].IsScalar()) {
+    if (!value.IsScalar()) {
         ParserError err;
-        err << file_ << ": Attempting to parse non-scalar field as scalar";
+        err << file_of(value) << ": Attempting to parse non-scalar field as scalar";
         return {{err}};
     }
 
-    return parse_scalar(msg, node[*name], field, *name);
+    auto res = parse_scalar(msg, value, field, name);
+    if (res) {
+        return res;
+    }
+    return field_set(msg, field, path, value);
+}
+
+template <typename Node>
+ParserResult ParserYaml::field_set(const google::protobuf::Message* msg, const google::protobuf::FieldDescriptor* field,
+                                   const FieldPath& path, const Node& node) {
+    // What was cut short by the budget isn't worth validating
+    if (budget_ != nullptr && budget_->exceeded()) {
+        return {};
+    }
+
+    const auto& program = ValidationProgram::get(msg->GetDescriptor());
+    if (provenance_ == nullptr && !program.has_rules(field)) {
+        return {};
+    }
+
+    const FieldPath full_path = path.child(field);
+    if (provenance_ != nullptr) {
+        provenance_->record(full_path, source_of(node), static_cast<uint32_t>(node.Mark().line + 1));
+    }
+    if (!program.has_rules(field)) {
+        return {};
+    }
+
+    auto err = program.check(*msg, field, full_path.str());
+    if (err) {
+        ParserError e;
+        e << file_of(node) << ": " << *err;
+        return {{e}};
+    }
+    return {};
 }
 
-ParserResult ParserYaml::parse_scalar(google::protobuf::Message* msg, const YAML::Node& node,
+template <typename Node>
+ParserResult ParserYaml::parse_scalar(google::protobuf::Message* msg, const Node& node,
                                       const google::protobuf::FieldDescriptor* field, const std::string& name) {
     using namespace google::protobuf;
 
@@ -329,20 +682,27 @@ ParserResult ParserYaml::parse_scalar(google::protobuf::Message* msg, const YAML
         msg->GetReflection()->SetString(msg, field, std::get<std::string>(value));
 
     } break;
-    case FieldDescriptor::TYPE_BYTES:
-        return {{"Unsupported type BYTES"}};
+    case FieldDescriptor::TYPE_BYTES: {
+        std::string value;
+        auto err = parse_bytes(node.Scalar(), file_of(node).parent_path(), &value);
+        if (err) {
+            ParserError e;
+            e << file_of(node) << ": Invalid bytes value for field " << name << ": " << *err;
+            return {{e}};
+        }
+
+        msg->GetReflection()->SetString(msg, field, std::move(value));
+    } break;
     case FieldDescriptor::TYPE_ENUM: {
-        // We assume enum definitions use UPPER_CASE
-        const auto enum_name = case_convert::all_caps(node.as<std::string>());
+        const std::string_view enum_name = node.Scalar();
 
-        const EnumDescriptor* descriptor = field->enum_type();
-        const EnumValueDescriptor* value = descriptor->FindValueByName(enum_name);
-        if (value == nullptr) {
+        auto value = EnumTable::get(field->enum_type()).resolve(enum_name);
+        if (!value) {
             ParserError err;
-            err << file_ << ": Invalid enum value '" << enum_name << "' for field " << name;
+            err << file_of(node) << ": Invalid enum value '" << enum_name << "' for field " << name;
             return {{err}};
         }
-        msg->GetReflection()->SetEnumValue(msg, field, value->number());
+        msg->GetReflection()->SetEnumValue(msg, field, *value);
     } break;
 
     case FieldDescriptor::TYPE_MESSAGE:
@@ -356,7 +716,26 @@ ParserResult ParserYaml::parse_scalar(google::protobuf::Message* msg, const YAML
     return {};
 }
 
-ParserResult ParserYaml::parse_array(google::protobuf::Message* msg, const YAML::Node& node,
+template <typename Node>
+ParserResult ParserYaml::parse_time(google::protobuf::Message* msg, const Node& node,
+                                    const google::protobuf::FieldDescriptor* field, TimeType type,
+                                    const std::string& name) {
+    const std::string_view input = node.Scalar();
+
+    auto value = internal::parse_time(type, input);
+    if (std::holds_alternative<ParserError>(value)) {
+        ParserError err;
+        err << file_of(node) << ": Invalid " << (type == TimeType::DURATION ? "duration" : "timestamp") << " '" << input
+            << "' for field " << name << ": " << std::get<ParserError>(value);
+        return {{err}};
+    }
+
+    set_time(msg->GetReflection()->MutableMessage(msg, field), std::get<TimeValue>(value));
+    return {};
+}
+
+template <typename Node>
+ParserResult ParserYaml::parse_array(google::protobuf::Message* msg, const Node& node,
                                      const google::protobuf::FieldDescriptor* field) {
     using namespace google::protobuf;
 
@@ -380,6 +759,9 @@ ParserResult ParserYaml::parse_array(google::protobuf::Message* msg, const YAML:
     case google::protobuf::FieldDescriptor::CPPTYPE_ENUM:
         return parse_array_enum(msg, node, field);
     case google::protobuf::FieldDescriptor::CPPTYPE_STRING:
+        if (field->type() == FieldDescriptor::TYPE_BYTES) {
+            return parse_array_bytes(msg, node, field);
+        }
         return parse_array_inner<std::string>(msg, node, field);
     case google::protobuf::FieldDescriptor::CPPTYPE_MESSAGE: {
         return {{"Unsupport repeated type MESSAGE"}};
@@ -392,19 +774,40 @@ ParserResult ParserYaml::parse_array(google::protobuf::Message* msg, const YAML:
     }
 }
 
-ParserError ParserYaml::wrap_error(const std::exception& e) {
-    std::stringstream ss;
-    ss << file_ << ": " << e.what();
-    return ss.str();
+ParserError ParserYaml::wrap_error(const std::exception& e, const std::filesystem::path& file) {
+    ParserError err;
+    err << file << ": " << e.what();
+    return err;
+}
+
+template <typename T>
+std::variant<T, ParserError> ParserYaml::try_convert(const YAML::Node& node, const std::filesystem::path& file) {
+    // What node.as<T>() gives, without going through its exceptions
+    if (!node.IsDefined()) {
+        return wrap_error(YAML::BadConversion(YAML::Mark::null_mark()), file);
+    }
+
+    std::optional<T> value;
+    if constexpr (std::is_same_v<T, std::string>) {
+        if (node.IsNull()) {
+            value = "null";
+        }
+    }
+    if (!value && node.IsScalar()) {
+        value = convert_scalar<T>(node.Scalar());
+    }
+    if (!value) {
+        return wrap_error(YAML::BadConversion(node.Mark()), file);
+    }
+    return *std::move(value);
 }
 
-template <typename T> std::variant<T, ParserError> ParserYaml::try_convert(const YAML::Node& node) {
-    try {
-        return node.as<T>();
-    } catch (YAML::InvalidNode& e) {
-        return wrap_error(e);
-    } catch (YAML::BadConversion& e) {
-        return wrap_error(e);
+template <typename T> std::variant<T, ParserError> ParserYaml::try_convert(const YamlNode& node) {
+    auto value = node.convert<T>();
+    if (!value) {
+        // Same message yaml-cpp gives
+        return wrap_error(YAML::BadConversion(node.Mark()), file_);
     }
+    return *std::move(value);
 }
 } // namespace config_much::internal
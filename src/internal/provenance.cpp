@@ -0,0 +1,74 @@
+#include "internal/provenance.h"
+
+namespace config_much {
+
+Provenance::SourceId Provenance::add_source(std::string name) {
+    sources_.emplace_back(std::move(name));
+    return static_cast<SourceId>(sources_.size() - 1);
+}
+
+uint32_t Provenance::node(const internal::FieldPath& path) {
+    if (path.empty()) {
+        return NONE;
+    }
+
+    const uint32_t parent = path.parent != nullptr ? node(*path.parent) : NONE;
+    auto [it, added]      = children_.try_emplace({parent, path.field}, static_cast<uint32_t>(nodes_.size()));
+    if (added) {
+        nodes_.push_back({path.field, parent});
+    }
+    return it->second;
+}
+
+void Provenance::record(const internal::FieldPath& path, SourceId source, uint32_t line) {
+    const uint32_t id = node(path);
+    if (id == NONE) {
+        return;
+    }
+
+    auto& entry = nodes_[id];
+    recorded_ += entry.source == NONE ? 1 : 0;
+    entry.source = source;
+    entry.line   = line;
+}
+
+std::optional<Provenance::Origin> Provenance::find(const std::string& path) const {
+    // Paths are matched from their last field up, without spelling them out
+    for (const auto& entry : nodes_) {
+        if (entry.source == NONE) {
+            continue;
+        }
+
+        size_t end        = path.size();
+        const Node* field = &entry;
+        for (;;) {
+            const auto& name = field->field->name();
+            if (end < name.size() || path.compare(end - name.size(), name.size(), name) != 0) {
+                break;
+            }
+            end -= name.size();
+
+            if (field->parent == NONE) {
+                if (end == 0) {
+                    return Origin{sources_.at(entry.source), entry.line};
+                }
+                break;
+            }
+            if (end == 0 || path[end - 1] != '.') {
+                break;
+            }
+            end--;
+            field = &nodes_[field->parent];
+        }
+    }
+    return {};
+}
+
+void Provenance::clear() {
+    sources_.clear();
+    nodes_.clear();
+    children_.clear();
+    recorded_ = 0;
+}
+
+} // namespace config_much
@@ -0,0 +1,95 @@
+#include "internal/section-registry.h"
+#include "internal/default-values.h"
+#include "internal/parser-env.h"
+#include "internal/validation.h"
+
+namespace config_much {
+
+SectionRegistry& SectionRegistry::bind(const std::string& section, google::protobuf::Message* msg) {
+    for (auto& binding : bindings_) {
+        if (binding.section == section) {
+            binding.msg = msg;
+            return *this;
+        }
+    }
+    bindings_.push_back({section, msg});
+    return *this;
+}
+
+std::unordered_map<std::string, ParserResult> SectionRegistry::parse() {
+    std::vector<std::vector<ParserError>> errors(bindings_.size());
+    for (size_t i = 0; i < bindings_.size(); i++) {
+        const auto& defaults = internal::DefaultValues::get(*bindings_[i].msg);
+        defaults.apply(bindings_[i].msg, nullptr);
+        errors[i] = defaults.errors();
+    }
+
+    // Read all files up front with as few syscalls as possible
+    std::vector<FileSource*> sources;
+    for (auto& file : files_) {
+        if (file->source()->as_file() != nullptr) {
+            sources.push_back(file->source()->as_file());
+        }
+    }
+    if (sources.size() > 1) {
+        BatchReader{}.read(sources);
+    }
+
+    for (auto& file : files_) {
+        YAML::Node root;
+        auto load_err = file->load(&root);
+        if (!load_err && !root.IsMap()) {
+            load_err = "Invalid configuration: root node should be a map.";
+        }
+
+        // No component can trust its configuration when a file is broken
+        if (load_err) {
+            for (auto& section_errors : errors) {
+                section_errors.push_back(*load_err);
+            }
+            continue;
+        }
+
+        for (size_t i = 0; i < bindings_.size(); i++) {
+            const YAML::Node node = root[bindings_[i].section];
+            if (!node || node.IsNull()) {
+                continue;
+            }
+            if (!node.IsMap()) {
+                ParserError err;
+                err << file->get_file() << ": Section '" << bindings_[i].section << "' should be a map";
+                errors[i].emplace_back(std::move(err));
+                continue;
+            }
+
+            auto err = file->parse(bindings_[i].msg, node);
+            if (err) {
+                errors[i].insert(errors[i].end(), err->begin(), err->end());
+            }
+        }
+    }
+
+    std::unordered_map<std::string, ParserResult> results;
+    for (size_t i = 0; i < bindings_.size(); i++) {
+        auto& binding = bindings_[i];
+        if (env_prefix_) {
+            auto err = internal::ParserEnv(*env_prefix_ + "_" + binding.section).parse(binding.msg);
+            if (err) {
+                errors[i].insert(errors[i].end(), err->begin(), err->end());
+            }
+        }
+
+        // Required fields can be set by any source, only check them once all are done
+        const auto& validation = internal::ValidationProgram::get(binding.msg->GetDescriptor());
+        validation.check_complete(*binding.msg, "", errors[i], true);
+
+        ParserResult result;
+        if (!errors[i].empty()) {
+            result = std::move(errors[i]);
+        }
+        results.emplace(binding.section, std::move(result));
+    }
+    return results;
+}
+
+} // namespace config_much
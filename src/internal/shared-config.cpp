@@ -0,0 +1,261 @@
+#include "internal/shared-config.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <thread>
+
+namespace config_much {
+
+// Static helpers
+namespace {
+/// Reads of a segment being written, about 100ms of yields, before a publisher is assumed dead mid-write.
+constexpr int MAX_ATTEMPTS = 100000;
+
+ParserError errno_error(const char* action) {
+    ParserError err;
+    err << action << ": " << std::strerror(errno);
+    return err;
+}
+
+std::string shm_name(const std::string& name) {
+    if (!name.empty() && name[0] == '/') {
+        return name;
+    }
+    return "/" + name;
+}
+
+const uint8_t* payload(const internal::SharedHeader* header) {
+    return reinterpret_cast<const uint8_t*>(header + 1);
+}
+} // namespace
+
+SharedConfigPublisher::SharedConfigPublisher(SharedConfigPublisher&& other) noexcept
+    : name_(std::move(other.name_)), fd_(other.fd_), mapped_(other.mapped_), header_(other.header_) {
+    other.name_.clear();
+    other.fd_     = -1;
+    other.mapped_ = 0;
+    other.header_ = nullptr;
+}
+
+SharedConfigPublisher& SharedConfigPublisher::operator=(SharedConfigPublisher&& other) noexcept {
+    if (this != &other) {
+        std::swap(name_, other.name_);
+        std::swap(fd_, other.fd_);
+        std::swap(mapped_, other.mapped_);
+        std::swap(header_, other.header_);
+    }
+    return *this;
+}
+
+SharedConfigPublisher::~SharedConfigPublisher() {
+    if (header_ != nullptr) {
+        munmap(header_, mapped_);
+    }
+    if (fd_ != -1) {
+        close(fd_);
+    }
+    if (!name_.empty()) {
+        shm_unlink(name_.c_str());
+    }
+}
+
+std::variant<SharedConfigPublisher, ParserError> SharedConfigPublisher::create(const std::string& name,
+                                                                               size_t capacity) {
+    SharedConfigPublisher publisher;
+    publisher.name_ = shm_name(name);
+    publisher.fd_   = shm_open(publisher.name_.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+    if (publisher.fd_ == -1 && errno == EEXIST) {
+        ParserError err;
+        err << "Shared memory segment " << publisher.name_ << " already exists";
+        publisher.name_.clear();
+        return err;
+    }
+    if (publisher.fd_ == -1) {
+        publisher.name_.clear();
+        return errno_error("Failed to open shared memory segment");
+    }
+
+    auto err = publisher.map(capacity);
+    if (err) {
+        return *err;
+    }
+    return publisher;
+}
+
+std::variant<SharedConfigPublisher, ParserError> SharedConfigPublisher::create(size_t capacity) {
+    SharedConfigPublisher publisher;
+    publisher.fd_ = memfd_create("config-much", MFD_CLOEXEC);
+    if (publisher.fd_ == -1) {
+        return errno_error("Failed to create memfd");
+    }
+
+    auto err = publisher.map(capacity);
+    if (err) {
+        return *err;
+    }
+    return publisher;
+}
+
+std::optional<ParserError> SharedConfigPublisher::map(size_t capacity) {
+    mapped_ = sizeof(internal::SharedHeader) + capacity;
+    if (ftruncate(fd_, static_cast<off_t>(mapped_)) != 0) {
+        return errno_error("Failed to resize shared memory segment");
+    }
+
+    void* addr = mmap(nullptr, mapped_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (addr == MAP_FAILED) {
+        return errno_error("Failed to map shared memory segment");
+    }
+
+    header_           = new (addr) internal::SharedHeader{};
+    header_->capacity = capacity;
+    return {};
+}
+
+ParserResult SharedConfigPublisher::publish(const google::protobuf::Message& msg) {
+    const size_t size = msg.ByteSizeLong();
+    if (size > header_->capacity) {
+        ParserError err;
+        err << "Message of " << size << " bytes does not fit shared segment of " << header_->capacity << " bytes";
+        return {{err}};
+    }
+
+    // Readers retry while the counter is odd or if it changed under them,
+    // so the payload can be serialized in place.
+    const uint64_t seq = header_->seq.load(std::memory_order_relaxed);
+    header_->seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    msg.SerializeWithCachedSizesToArray(reinterpret_cast<uint8_t*>(header_ + 1));
+    header_->size.store(size, std::memory_order_relaxed);
+
+    header_->seq.store(seq + 2, std::memory_order_release);
+    return {};
+}
+
+uint64_t SharedConfigPublisher::generation() const {
+    return header_->seq.load(std::memory_order_acquire) / 2;
+}
+
+SharedConfigReader::SharedConfigReader(SharedConfigReader&& other) noexcept
+    : mapped_(other.mapped_), header_(other.header_), generation_(other.generation_),
+      buffer_(std::move(other.buffer_)) {
+    other.mapped_ = 0;
+    other.header_ = nullptr;
+}
+
+SharedConfigReader& SharedConfigReader::operator=(SharedConfigReader&& other) noexcept {
+    if (this != &other) {
+        std::swap(mapped_, other.mapped_);
+        std::swap(header_, other.header_);
+        std::swap(generation_, other.generation_);
+        std::swap(buffer_, other.buffer_);
+    }
+    return *this;
+}
+
+SharedConfigReader::~SharedConfigReader() {
+    if (header_ != nullptr) {
+        munmap(const_cast<internal::SharedHeader*>(header_), mapped_);
+    }
+}
+
+std::variant<SharedConfigReader, ParserError> SharedConfigReader::attach(const std::string& name) {
+    int fd = shm_open(shm_name(name).c_str(), O_RDONLY, 0);
+    if (fd == -1) {
+        return errno_error("Failed to open shared memory segment");
+    }
+
+    auto res = map(fd);
+    close(fd);
+    return res;
+}
+
+std::variant<SharedConfigReader, ParserError> SharedConfigReader::attach(int fd) {
+    return map(fd);
+}
+
+std::variant<SharedConfigReader, ParserError> SharedConfigReader::map(int fd) {
+    struct stat st {};
+    if (fstat(fd, &st) != 0) {
+        return errno_error("Failed to stat shared memory segment");
+    }
+
+    if (static_cast<size_t>(st.st_size) < sizeof(internal::SharedHeader)) {
+        return {"Shared memory segment is too small"};
+    }
+
+    SharedConfigReader reader;
+    reader.mapped_ = st.st_size;
+
+    void* addr = mmap(nullptr, reader.mapped_, PROT_READ, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        return errno_error("Failed to map shared memory segment");
+    }
+
+    reader.header_ = static_cast<const internal::SharedHeader*>(addr);
+    if (reader.header_->capacity + sizeof(internal::SharedHeader) > reader.mapped_) {
+        return {"Shared memory segment header is corrupted"};
+    }
+    return reader;
+}
+
+std::variant<bool, ParserError> SharedConfigReader::poll(std::string* bytes) {
+    for (int attempt = 0; attempt < MAX_ATTEMPTS; attempt++) {
+        const uint64_t seq = header_->seq.load(std::memory_order_acquire);
+        if ((seq & 1) != 0) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        if (seq / 2 == generation_) {
+            return false;
+        }
+
+        const uint64_t size = header_->size.load(std::memory_order_relaxed);
+        if (size <= header_->capacity) {
+            bytes->assign(reinterpret_cast<const char*>(payload(header_)), size);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (header_->seq.load(std::memory_order_relaxed) != seq) {
+            continue;
+        }
+        // A size that doesn't fit while nothing is being written won't fix itself
+        if (size > header_->capacity) {
+            ParserError err;
+            err << "Shared memory segment header is corrupted, generation " << seq / 2 << " has " << size
+                << " bytes for a capacity of " << header_->capacity;
+            return err;
+        }
+
+        generation_ = seq / 2;
+        return true;
+    }
+
+    ParserError err;
+    err << "Shared memory segment is still being written after " << MAX_ATTEMPTS << " attempts";
+    return err;
+}
+
+std::variant<bool, ParserError> SharedConfigReader::poll(google::protobuf::Message* msg) {
+    auto res = poll(&buffer_);
+    if (std::holds_alternative<ParserError>(res) || !std::get<bool>(res)) {
+        return res;
+    }
+
+    if (!msg->ParseFromString(buffer_)) {
+        ParserError err;
+        err << "Failed to parse generation " << generation_ << " as " << msg->GetTypeName();
+        return err;
+    }
+    return true;
+}
+
+} // namespace config_much
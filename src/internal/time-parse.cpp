@@ -0,0 +1,419 @@
+#include "internal/time-parse.h"
+
+#include <google/protobuf/descriptor.h>
+
+#include <array>
+#include <limits>
+
+namespace config_much::internal {
+
+// Static helpers
+namespace {
+constexpr int64_t NANOS_PER_SECOND = 1000000000;
+
+// Limits defined in duration.proto and timestamp.proto
+constexpr int64_t MAX_DURATION_SECONDS  = 315576000000;
+constexpr int64_t MIN_TIMESTAMP_SECONDS = -62135596800; // 0001-01-01T00:00:00Z
+constexpr int64_t MAX_TIMESTAMP_SECONDS = 253402300799; // 9999-12-31T23:59:59Z
+
+struct Unit {
+    std::string_view name;
+    int64_t nanos;
+};
+
+constexpr std::array UNITS{
+    Unit{"ns", 1},
+    Unit{"us", 1000},
+    Unit{"ms", 1000000},
+    Unit{"s", NANOS_PER_SECOND},
+    Unit{"m", 60 * NANOS_PER_SECOND},
+    Unit{"h", 3600 * NANOS_PER_SECOND},
+    Unit{"d", 86400 * NANOS_PER_SECOND},
+};
+
+bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+bool is_alpha(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+/// Consume leading digits, returns false if they don't fit in out.
+bool read_uint(std::string_view& input, uint64_t& out, size_t& digits) {
+    out    = 0;
+    digits = 0;
+    while (!input.empty() && is_digit(input[0])) {
+        const auto digit = static_cast<uint64_t>(input[0] - '0');
+        if (out > (std::numeric_limits<uint64_t>::max() - digit) / 10) {
+            return false;
+        }
+        out = out * 10 + digit;
+        digits++;
+        input.remove_prefix(1);
+    }
+    return true;
+}
+
+/// Consume a fraction after the dot as nanoseconds, digits past the ninth are dropped.
+int64_t read_fraction(std::string_view& input, size_t& digits) {
+    int64_t nanos = 0;
+    digits        = 0;
+    while (!input.empty() && is_digit(input[0])) {
+        if (digits < 9) {
+            nanos = nanos * 10 + (input[0] - '0');
+        }
+        digits++;
+        input.remove_prefix(1);
+    }
+
+    for (size_t i = digits; i < 9; i++) {
+        nanos *= 10;
+    }
+    return nanos;
+}
+
+/// Consume exactly n digits.
+bool read_fixed(std::string_view& input, size_t n, int& out) {
+    if (input.size() < n) {
+        return false;
+    }
+
+    out = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (!is_digit(input[i])) {
+            return false;
+        }
+        out = out * 10 + (input[i] - '0');
+    }
+    input.remove_prefix(n);
+    return true;
+}
+
+bool consume(std::string_view& input, char c) {
+    if (input.empty() || input[0] != c) {
+        return false;
+    }
+    input.remove_prefix(1);
+    return true;
+}
+
+bool is_leap(int year) {
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+int days_in_month(int year, int month) {
+    constexpr std::array<int, 12> DAYS{31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    return month == 2 && is_leap(year) ? 29 : DAYS.at(month - 1);
+}
+
+/// Days since the unix epoch, from http://howardhinnant.github.io/date_algorithms.html
+int64_t days_from_civil(int64_t year, int month, int day) {
+    year -= month <= 2 ? 1 : 0;
+    const int64_t era = (year >= 0 ? year : year - 399) / 400;
+    const int64_t yoe = year - era * 400;
+    const int64_t doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+struct Civil {
+    int64_t year;
+    int month;
+    int day;
+};
+
+/// Inverse of days_from_civil, from the same source.
+Civil civil_from_days(int64_t days) {
+    days += 719468;
+    const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const int64_t doe = days - era * 146097;
+    const int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const int64_t mp  = (5 * doy + 2) / 153;
+    const auto day    = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+    const auto month  = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+    return {yoe + era * 400 + (month <= 2 ? 1 : 0), month, day};
+}
+
+void append_fixed(std::string* out, int64_t value, int width) {
+    char buf[20];
+    for (int i = width - 1; i >= 0; i--) {
+        buf[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    out->append(buf, width);
+}
+
+/// Append ".fraction" without trailing zeros, nothing for 0.
+void append_fraction(std::string* out, int64_t nanos) {
+    if (nanos == 0) {
+        return;
+    }
+
+    int width = 9;
+    while (nanos % 10 == 0) {
+        nanos /= 10;
+        width--;
+    }
+    out->push_back('.');
+    append_fixed(out, nanos, width);
+}
+} // namespace
+
+TimeType time_type(const google::protobuf::Descriptor* descriptor) {
+    if (descriptor == nullptr) {
+        return TimeType::NONE;
+    }
+
+    const auto& name = descriptor->full_name();
+    if (name == "google.protobuf.Duration") {
+        return TimeType::DURATION;
+    }
+    if (name == "google.protobuf.Timestamp") {
+        return TimeType::TIMESTAMP;
+    }
+    return TimeType::NONE;
+}
+
+std::variant<TimeValue, ParserError> parse_duration(std::string_view input) {
+    bool negative = false;
+    if (!input.empty() && (input[0] == '-' || input[0] == '+')) {
+        negative = input[0] == '-';
+        input.remove_prefix(1);
+    }
+
+    if (input.empty()) {
+        return {"empty duration"};
+    }
+
+    if (input == "0") {
+        return TimeValue{};
+    }
+
+    int64_t seconds = 0;
+    int64_t nanos   = 0;
+    while (!input.empty()) {
+        uint64_t whole = 0;
+        size_t digits  = 0;
+        if (!read_uint(input, whole, digits)) {
+            return {"value out of range"};
+        }
+
+        int64_t fraction   = 0;
+        size_t frac_digits = 0;
+        if (consume(input, '.')) {
+            fraction = read_fraction(input, frac_digits);
+        }
+
+        if (digits == 0 && frac_digits == 0) {
+            return {"expected a number"};
+        }
+
+        size_t unit_len = 0;
+        while (unit_len < input.size() && is_alpha(input[unit_len])) {
+            unit_len++;
+        }
+
+        const auto unit_name = input.substr(0, unit_len);
+        input.remove_prefix(unit_len);
+        if (unit_name.empty()) {
+            return {"missing unit"};
+        }
+
+        const Unit* unit = nullptr;
+        for (const auto& u : UNITS) {
+            if (u.name == unit_name) {
+                unit = &u;
+            }
+        }
+
+        if (unit == nullptr) {
+            ParserError err;
+            err << "unknown unit '" << unit_name << "'";
+            return err;
+        }
+
+        if (unit->nanos >= NANOS_PER_SECOND) {
+            const int64_t unit_seconds = unit->nanos / NANOS_PER_SECOND;
+            if (whole > static_cast<uint64_t>(MAX_DURATION_SECONDS / unit_seconds)) {
+                return {"value out of range"};
+            }
+            seconds += static_cast<int64_t>(whole) * unit_seconds;
+            nanos += fraction * unit_seconds;
+        } else {
+            if (whole > static_cast<uint64_t>(std::numeric_limits<int64_t>::max() / unit->nanos)) {
+                return {"value out of range"};
+            }
+            const int64_t total = static_cast<int64_t>(whole) * unit->nanos + fraction * unit->nanos / NANOS_PER_SECOND;
+            seconds += total / NANOS_PER_SECOND;
+            nanos += total % NANOS_PER_SECOND;
+        }
+
+        seconds += nanos / NANOS_PER_SECOND;
+        nanos %= NANOS_PER_SECOND;
+        if (seconds > MAX_DURATION_SECONDS) {
+            return {"value out of range"};
+        }
+    }
+
+    if (negative) {
+        seconds = -seconds;
+        nanos   = -nanos;
+    }
+    return TimeValue{seconds, static_cast<int32_t>(nanos)};
+}
+
+std::variant<TimeValue, ParserError> parse_timestamp(std::string_view input) {
+    int year   = 0;
+    int month  = 0;
+    int day    = 0;
+    int hour   = 0;
+    int minute = 0;
+    int second = 0;
+
+    if (!read_fixed(input, 4, year) || !consume(input, '-') || !read_fixed(input, 2, month) || !consume(input, '-') ||
+        !read_fixed(input, 2, day)) {
+        return {"expected a YYYY-MM-DD date"};
+    }
+
+    if (year < 1 || month < 1 || month > 12) {
+        return {"date out of range"};
+    }
+
+    if (day < 1 || day > days_in_month(year, month)) {
+        return {"day out of range"};
+    }
+
+    if (!consume(input, 'T') && !consume(input, 't') && !consume(input, ' ')) {
+        return {"expected 'T' between date and time"};
+    }
+
+    if (!read_fixed(input, 2, hour) || !consume(input, ':') || !read_fixed(input, 2, minute) ||
+        !consume(input, ':') || !read_fixed(input, 2, second)) {
+        return {"expected a HH:MM:SS time"};
+    }
+
+    if (hour > 23 || minute > 59 || second > 59) {
+        return {"time out of range"};
+    }
+
+    int64_t nanos = 0;
+    if (consume(input, '.')) {
+        size_t digits = 0;
+        nanos         = read_fraction(input, digits);
+        if (digits == 0 || digits > 9) {
+            return {"fraction must have between 1 and 9 digits"};
+        }
+    }
+
+    int64_t offset = 0;
+    if (!consume(input, 'Z') && !consume(input, 'z')) {
+        if (input.empty() || (input[0] != '+' && input[0] != '-')) {
+            return {"expected 'Z' or a +HH:MM offset"};
+        }
+
+        const int64_t sign = input[0] == '-' ? -1 : 1;
+        input.remove_prefix(1);
+
+        int offset_hours   = 0;
+        int offset_minutes = 0;
+        if (!read_fixed(input, 2, offset_hours) || !consume(input, ':') || !read_fixed(input, 2, offset_minutes) ||
+            offset_hours > 23 || offset_minutes > 59) {
+            return {"expected 'Z' or a +HH:MM offset"};
+        }
+        offset = sign * (offset_hours * 3600 + offset_minutes * 60);
+    }
+
+    if (!input.empty()) {
+        ParserError err;
+        err << "unexpected trailing '" << input << "'";
+        return err;
+    }
+
+    const int64_t seconds = days_from_civil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second - offset;
+    if (seconds < MIN_TIMESTAMP_SECONDS || seconds > MAX_TIMESTAMP_SECONDS) {
+        return {"timestamp out of range"};
+    }
+    return TimeValue{seconds, static_cast<int32_t>(nanos)};
+}
+
+std::variant<TimeValue, ParserError> parse_time(TimeType type, std::string_view input) {
+    switch (type) {
+    case TimeType::DURATION:
+        return parse_duration(input);
+    case TimeType::TIMESTAMP:
+        return parse_timestamp(input);
+    case TimeType::NONE:
+        break;
+    }
+    return {"not a time type"};
+}
+
+void set_time(google::protobuf::Message* msg, const TimeValue& value) {
+    const auto* descriptor = msg->GetDescriptor();
+    const auto* reflection = msg->GetReflection();
+
+    // Both types use the same field numbers
+    reflection->SetInt64(msg, descriptor->FindFieldByNumber(1), value.seconds);
+    reflection->SetInt32(msg, descriptor->FindFieldByNumber(2), value.nanos);
+}
+
+TimeValue get_time(const google::protobuf::Message& msg) {
+    const auto* descriptor = msg.GetDescriptor();
+    const auto* reflection = msg.GetReflection();
+    return {reflection->GetInt64(msg, descriptor->FindFieldByNumber(1)),
+            reflection->GetInt32(msg, descriptor->FindFieldByNumber(2))};
+}
+
+bool format_time(TimeType type, const TimeValue& value, std::string* out) {
+    if (value.nanos <= -NANOS_PER_SECOND || value.nanos >= NANOS_PER_SECOND) {
+        return false;
+    }
+
+    if (type == TimeType::DURATION) {
+        if ((value.seconds < 0 && value.nanos > 0) || (value.seconds > 0 && value.nanos < 0) ||
+            value.seconds < -MAX_DURATION_SECONDS || value.seconds > MAX_DURATION_SECONDS) {
+            return false;
+        }
+
+        if (value.seconds < 0 || value.nanos < 0) {
+            out->push_back('-');
+        }
+        *out += std::to_string(value.seconds < 0 ? -value.seconds : value.seconds);
+        append_fraction(out, value.nanos < 0 ? -value.nanos : value.nanos);
+        out->push_back('s');
+        return true;
+    }
+
+    if (type != TimeType::TIMESTAMP || value.nanos < 0 || value.seconds < MIN_TIMESTAMP_SECONDS ||
+        value.seconds > MAX_TIMESTAMP_SECONDS) {
+        return false;
+    }
+
+    // Floor division, seconds before the epoch still have a positive time of day
+    int64_t days = value.seconds / 86400;
+    int64_t secs = value.seconds % 86400;
+    if (secs < 0) {
+        secs += 86400;
+        days--;
+    }
+
+    const Civil date = civil_from_days(days);
+    append_fixed(out, date.year, 4);
+    out->push_back('-');
+    append_fixed(out, date.month, 2);
+    out->push_back('-');
+    append_fixed(out, date.day, 2);
+    out->push_back('T');
+    append_fixed(out, secs / 3600, 2);
+    out->push_back(':');
+    append_fixed(out, secs / 60 % 60, 2);
+    out->push_back(':');
+    append_fixed(out, secs % 60, 2);
+    append_fraction(out, value.nanos);
+    out->push_back('Z');
+    return true;
+}
+
+} // namespace config_much::internal
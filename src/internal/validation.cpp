@@ -0,0 +1,277 @@
+#include "internal/validation.h"
+#include "internal/descriptor-cache.h"
+
+#include "config-much/options.pb.h"
+
+#include <memory>
+
+namespace config_much::internal {
+
+// Static helpers
+namespace {
+std::string concat_path(const std::string& path, const std::string& name) {
+    return path.empty() ? name : path + '.' + name;
+}
+
+bool is_numeric(const google::protobuf::FieldDescriptor* field) {
+    using google::protobuf::FieldDescriptor;
+
+    switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+    case FieldDescriptor::CPPTYPE_INT64:
+    case FieldDescriptor::CPPTYPE_UINT32:
+    case FieldDescriptor::CPPTYPE_UINT64:
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+    case FieldDescriptor::CPPTYPE_FLOAT:
+    case FieldDescriptor::CPPTYPE_ENUM:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/// Value of a numeric field, index is -1 for singular fields.
+double number(const google::protobuf::Message& msg, const google::protobuf::FieldDescriptor* field, int index) {
+    using google::protobuf::FieldDescriptor;
+    const auto* r = msg.GetReflection();
+
+    switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+        return index < 0 ? r->GetInt32(msg, field) : r->GetRepeatedInt32(msg, field, index);
+    case FieldDescriptor::CPPTYPE_INT64:
+        return static_cast<double>(index < 0 ? r->GetInt64(msg, field) : r->GetRepeatedInt64(msg, field, index));
+    case FieldDescriptor::CPPTYPE_UINT32:
+        return index < 0 ? r->GetUInt32(msg, field) : r->GetRepeatedUInt32(msg, field, index);
+    case FieldDescriptor::CPPTYPE_UINT64:
+        return static_cast<double>(index < 0 ? r->GetUInt64(msg, field) : r->GetRepeatedUInt64(msg, field, index));
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+        return index < 0 ? r->GetDouble(msg, field) : r->GetRepeatedDouble(msg, field, index);
+    case FieldDescriptor::CPPTYPE_FLOAT:
+        return index < 0 ? r->GetFloat(msg, field) : r->GetRepeatedFloat(msg, field, index);
+    case FieldDescriptor::CPPTYPE_ENUM:
+        return index < 0 ? r->GetEnumValue(msg, field) : r->GetRepeatedEnumValue(msg, field, index);
+    default:
+        return 0;
+    }
+}
+
+ParserError error_at(const std::string& path, int index) {
+    ParserError err;
+    err << path;
+    if (index >= 0) {
+        err << '[' << index << ']';
+    }
+    err << ": ";
+    return err;
+}
+} // namespace
+
+const ValidationProgram& ValidationProgram::get(const google::protobuf::Descriptor* descriptor) {
+    // Parsers ask for the same descriptor for every field they set
+    thread_local const google::protobuf::Descriptor* last_descriptor = nullptr;
+    thread_local const ValidationProgram* last_program               = nullptr;
+    if (descriptor == last_descriptor) {
+        return *last_program;
+    }
+
+    static DescriptorCache<google::protobuf::Descriptor, ValidationProgram> programs;
+    const ValidationProgram* program =
+        &programs.get(descriptor, [descriptor] { return std::make_unique<ValidationProgram>(descriptor); });
+
+    last_descriptor = descriptor;
+    last_program    = program;
+    return *program;
+}
+
+ValidationProgram::ValidationProgram(const google::protobuf::Descriptor* descriptor) {
+    using google::protobuf::FieldDescriptor;
+
+    by_index_.assign(descriptor->field_count(), -1);
+    for (int i = 0; i < descriptor->field_count(); i++) {
+        const FieldDescriptor* field = descriptor->field(i);
+        if (field->type() == FieldDescriptor::TYPE_MESSAGE && !field->is_repeated()) {
+            nested_.push_back(field);
+        }
+
+        if (!field->options().HasExtension(config_much::rules)) {
+            continue;
+        }
+
+        const auto& options = field->options().GetExtension(config_much::rules);
+        Rule rule;
+        rule.field = field;
+        if (options.has_min()) {
+            rule.flags |= MIN;
+            rule.min = options.min();
+        }
+        if (options.has_max()) {
+            rule.flags |= MAX;
+            rule.max = options.max();
+        }
+        if (options.has_min_len()) {
+            rule.flags |= MIN_LEN;
+            rule.min_len = options.min_len();
+        }
+        if (options.has_max_len()) {
+            rule.flags |= MAX_LEN;
+            rule.max_len = options.max_len();
+        }
+        if (!options.pattern().empty()) {
+            rule.flags |= PATTERN;
+            rule.pattern_str = options.pattern();
+            try {
+                rule.pattern.emplace(options.pattern(), std::regex::ECMAScript | std::regex::optimize);
+            } catch (const std::regex_error& e) {
+                rule.error = ParserError();
+                *rule.error << "invalid pattern '" << options.pattern() << "': " << e.what();
+            }
+        }
+        if (options.required()) {
+            rule.flags |= REQUIRED;
+            if (field->options().GetExtension(config_much::deferred)) {
+                required_deferred_.push_back(field);
+            } else {
+                required_.push_back(field);
+            }
+        }
+        if (options.non_empty()) {
+            rule.flags |= NON_EMPTY;
+        }
+
+        by_index_[i] = static_cast<int>(rules_.size());
+        rules_.emplace_back(std::move(rule));
+    }
+}
+
+std::optional<ParserError> ValidationProgram::check(const google::protobuf::Message& msg,
+                                                    const google::protobuf::FieldDescriptor* field,
+                                                    const std::string& path) const {
+    if (!has_rules(field)) {
+        return {};
+    }
+
+    const Rule& rule = rules_[by_index_[field->index()]];
+    if (rule.error) {
+        ParserError err = error_at(path, -1);
+        err << *rule.error;
+        return err;
+    }
+
+    if (!field->is_repeated()) {
+        return check_element(rule, msg, -1, path);
+    }
+
+    const auto size = static_cast<uint64_t>(msg.GetReflection()->FieldSize(msg, field));
+    if ((rule.flags & NON_EMPTY) != 0 && size == 0) {
+        ParserError err = error_at(path, -1);
+        err << "must not be empty";
+        return err;
+    }
+    if ((rule.flags & MIN_LEN) != 0 && size < rule.min_len) {
+        ParserError err = error_at(path, -1);
+        err << "has " << size << " elements, expected at least " << rule.min_len;
+        return err;
+    }
+    if ((rule.flags & MAX_LEN) != 0 && size > rule.max_len) {
+        ParserError err = error_at(path, -1);
+        err << "has " << size << " elements, expected at most " << rule.max_len;
+        return err;
+    }
+
+    for (int i = 0; i < static_cast<int>(size); i++) {
+        auto err = check_element(rule, msg, i, path);
+        if (err) {
+            return err;
+        }
+    }
+    return {};
+}
+
+std::optional<ParserError> ValidationProgram::check_element(const Rule& rule, const google::protobuf::Message& msg,
+                                                            int index, const std::string& path) const {
+    using google::protobuf::FieldDescriptor;
+    const FieldDescriptor* field = rule.field;
+
+    if ((rule.flags & (MIN | MAX)) != 0 && is_numeric(field)) {
+        const double value = number(msg, field, index);
+        if ((rule.flags & MIN) != 0 && value < rule.min) {
+            ParserError err = error_at(path, index);
+            err << "value " << value << " is below the minimum of " << rule.min;
+            return err;
+        }
+        if ((rule.flags & MAX) != 0 && value > rule.max) {
+            ParserError err = error_at(path, index);
+            err << "value " << value << " is above the maximum of " << rule.max;
+            return err;
+        }
+    }
+
+    if (field->cpp_type() != FieldDescriptor::CPPTYPE_STRING) {
+        return {};
+    }
+
+    const auto* reflection = msg.GetReflection();
+    std::string scratch;
+    const std::string& value = index < 0 ? reflection->GetStringReference(msg, field, &scratch)
+                                         : reflection->GetRepeatedStringReference(msg, field, index, &scratch);
+
+    // Lengths of repeated fields are about the number of elements
+    if (index < 0) {
+        if ((rule.flags & NON_EMPTY) != 0 && value.empty()) {
+            ParserError err = error_at(path, index);
+            err << "must not be empty";
+            return err;
+        }
+        if ((rule.flags & MIN_LEN) != 0 && value.size() < rule.min_len) {
+            ParserError err = error_at(path, index);
+            err << "length " << value.size() << " is below the minimum of " << rule.min_len;
+            return err;
+        }
+        if ((rule.flags & MAX_LEN) != 0 && value.size() > rule.max_len) {
+            ParserError err = error_at(path, index);
+            err << "length " << value.size() << " is above the maximum of " << rule.max_len;
+            return err;
+        }
+    }
+
+    if (rule.pattern && field->type() == FieldDescriptor::TYPE_STRING && !std::regex_search(value, *rule.pattern)) {
+        ParserError err = error_at(path, index);
+        err << "'" << value << "' does not match '" << rule.pattern_str << "'";
+        return err;
+    }
+    return {};
+}
+
+void ValidationProgram::check_complete(const google::protobuf::Message& msg, const std::string& path,
+                                       std::vector<ParserError>& errors, bool with_deferred) const {
+    const auto* reflection = msg.GetReflection();
+
+    auto check_set = [&](const google::protobuf::FieldDescriptor* field) {
+        const bool set =
+            field->is_repeated() ? reflection->FieldSize(msg, field) > 0 : reflection->HasField(msg, field);
+        if (!set) {
+            ParserError err;
+            err << "Missing required field '" << concat_path(path, field->name()) << "'";
+            errors.emplace_back(std::move(err));
+        }
+    };
+
+    for (const auto* field : required_) {
+        check_set(field);
+    }
+    if (with_deferred) {
+        for (const auto* field : required_deferred_) {
+            check_set(field);
+        }
+    }
+
+    // Like protobuf's own required fields, rules in unset sub-messages don't apply
+    for (const auto* field : nested_) {
+        if (reflection->HasField(msg, field)) {
+            get(field->message_type())
+                .check_complete(reflection->GetMessage(msg, field), concat_path(path, field->name()), errors);
+        }
+    }
+}
+
+} // namespace config_much::internal
@@ -0,0 +1,101 @@
+#include "internal/work-stealing-pool.h"
+
+#include <algorithm>
+
+namespace config_much {
+
+// Static helpers
+namespace {
+// Lets submit tell its own workers apart from other threads
+thread_local const WorkStealingPool* current_pool = nullptr;
+thread_local size_t current_index                 = 0;
+} // namespace
+
+WorkStealingPool::WorkStealingPool(size_t threads) {
+    threads = std::max<size_t>(threads, 1);
+    for (size_t i = 0; i < threads; i++) {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+    for (size_t i = 0; i < threads; i++) {
+        threads_.emplace_back([this, i] { run(i); });
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::submit(std::function<void()> task) {
+    size_t index = current_index;
+    if (current_pool != this) {
+        index = next_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+    }
+
+    {
+        std::lock_guard lock(queues_[index]->mutex);
+        queues_[index]->tasks.push_back(std::move(task));
+    }
+
+    // A worker counts itself as sleeping before it checks pending_, one of the two sees the other
+    pending_.fetch_add(1);
+    if (sleeping_.load() != 0) {
+        // Held from counting itself to waiting, the worker can't miss the notification
+        std::lock_guard lock(mutex_);
+        wake_.notify_one();
+    }
+}
+
+void WorkStealingPool::run(size_t index) {
+    current_pool  = this;
+    current_index = index;
+
+    for (;;) {
+        std::function<void()> task;
+        if (take(index, &task)) {
+            pending_.fetch_sub(1);
+            task();
+            continue;
+        }
+
+        // A task taken but not yet counted keeps pending_ up, the worker just tries again
+        std::unique_lock lock(mutex_);
+        sleeping_.fetch_add(1);
+        wake_.wait(lock, [this] { return pending_.load() != 0 || stop_; });
+        sleeping_.fetch_sub(1);
+        if (pending_.load() == 0) {
+            return;
+        }
+    }
+}
+
+bool WorkStealingPool::take(size_t index, std::function<void()>* task) {
+    {
+        auto& own = *queues_[index];
+        std::lock_guard lock(own.mutex);
+        if (!own.tasks.empty()) {
+            *task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    for (size_t i = 1; i < queues_.size(); i++) {
+        auto& other = *queues_[(index + i) % queues_.size()];
+        std::lock_guard lock(other.mutex);
+        if (!other.tasks.empty()) {
+            *task = std::move(other.tasks.front());
+            other.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace config_much
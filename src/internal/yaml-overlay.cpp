@@ -0,0 +1,98 @@
+#include "internal/yaml-overlay.h"
+
+namespace config_much::internal {
+
+void YamlOverlay::add(std::filesystem::path file, const YAML::Node& root) {
+    const auto layer = static_cast<uint32_t>(files_.size());
+    files_.push_back(std::move(file));
+
+    if (entries_.empty()) {
+        insert({}, root, layer);
+    } else {
+        merge(0, root, layer);
+    }
+}
+
+uint32_t YamlOverlay::insert(std::string_view key, const YAML::Node& node, uint32_t layer) {
+    const auto index = static_cast<uint32_t>(entries_.size());
+    entries_.push_back({key, node, layer, node.IsMap(), {}});
+    keys_.emplace_back();
+
+    if (node.IsMap()) {
+        for (const auto& child : node) {
+            const std::string& name = child.first.Scalar();
+            const uint32_t value    = insert(name, child.second, layer);
+
+            // Duplicate keys resolve to the first one, like a lookup in yaml-cpp does
+            keys_[index].emplace(name, entries_[index].children.size());
+            entries_[index].children.push_back(value);
+        }
+    }
+    return index;
+}
+
+void YamlOverlay::merge(uint32_t index, const YAML::Node& node, uint32_t layer) {
+    if (!entries_[index].map || !node.IsMap()) {
+        return;
+    }
+
+    // Marks point at the latest layer holding the map, reset rebinds where assigning would modify the old node
+    entries_[index].node.reset(node);
+    entries_[index].layer = layer;
+
+    for (const auto& child : node) {
+        const std::string& name = child.first.Scalar();
+        auto it                 = keys_[index].find(name);
+        if (it == keys_[index].end()) {
+            const uint32_t value = insert(name, child.second, layer);
+            keys_[index].emplace(name, entries_[index].children.size());
+            entries_[index].children.push_back(value);
+            continue;
+        }
+
+        const size_t pos      = it->second;
+        const uint32_t before = entries_[index].children[pos];
+        if (entries_[before].map && child.second.IsMap()) {
+            merge(before, child.second, layer);
+        } else {
+            // Replaced entries are left unreachable, they're dropped with the overlay
+            const uint32_t value          = insert(name, child.second, layer);
+            entries_[index].children[pos] = value;
+        }
+    }
+}
+
+OverlayNode::iterator OverlayNode::begin() const {
+    if (IsSequence() && !is_item_) {
+        return {overlay_, index_, overlay_->entries_[index_].node.begin()};
+    }
+    return {overlay_, index_, 0};
+}
+
+OverlayNode OverlayNode::operator[](std::string_view key) const {
+    if (!IsMap() || is_item_) {
+        return {};
+    }
+
+    const auto& keys = overlay_->keys_[index_];
+    auto it          = keys.find(key);
+    if (it == keys.end()) {
+        return {};
+    }
+    return {overlay_, overlay_->entries_[index_].children[it->second]};
+}
+
+const YAML::Node& OverlayNode::yaml() const {
+    static const YAML::Node null;
+    if (is_item_) {
+        return item_;
+    }
+    return overlay_ != nullptr ? overlay_->entries_[index_].node : null;
+}
+
+const std::filesystem::path& OverlayNode::file() const {
+    static const std::filesystem::path none;
+    return overlay_ != nullptr ? overlay_->files_[layer()] : none;
+}
+
+} // namespace config_much::internal
@@ -0,0 +1,909 @@
+#include "internal/yaml-scanner.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace config_much::internal {
+
+// Static helpers
+namespace {
+constexpr int MAX_FLOW_DEPTH = 64;
+
+struct Line {
+    const char* begin;
+    const char* end; ///< Before the line break
+    uint32_t indent; ///< Leading spaces
+    bool blank;      ///< Only whitespace or a comment
+};
+
+bool is_space(char c) { return c == ' ' || c == '\t'; }
+
+bool is_null(std::string_view value) {
+    return value.empty() || value == "~" || value == "null" || value == "Null" || value == "NULL";
+}
+
+/// Characters that can't start a plain scalar, or start something outside the subset.
+bool is_indicator(char c) {
+    switch (c) {
+    case '?':
+    case ':':
+    case ',':
+    case '[':
+    case ']':
+    case '{':
+    case '}':
+    case '#':
+    case '&':
+    case '*':
+    case '!':
+    case '|':
+    case '>':
+    case '\'':
+    case '"':
+    case '%':
+    case '@':
+    case '`':
+        return true;
+    default:
+        return false;
+    }
+}
+
+const char* skip_spaces(const char* p, const char* end) {
+    while (p < end && is_space(*p)) {
+        p++;
+    }
+    return p;
+}
+
+const char* trim_right(const char* begin, const char* end) {
+    while (end > begin && is_space(end[-1])) {
+        end--;
+    }
+    return end;
+}
+
+/// Start of each line of input, 16 bytes at a time.
+void find_line_starts(std::string_view input, std::vector<uint32_t>& starts) {
+    const char* data  = input.data();
+    const size_t size = input.size();
+
+    starts.push_back(0);
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i newline = _mm_set1_epi8('\n');
+    for (; i + 16 <= size; i += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        auto mask           = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)));
+        while (mask != 0) {
+            starts.push_back(static_cast<uint32_t>(i + __builtin_ctz(mask) + 1));
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for (; i < size; i++) {
+        if (data[i] == '\n') {
+            starts.push_back(static_cast<uint32_t>(i + 1));
+        }
+    }
+}
+
+uint32_t count_spaces(const char* p, const char* end) {
+    const char* begin = p;
+#if defined(__SSE2__)
+    const __m128i space = _mm_set1_epi8(' ');
+    for (; end - p >= 16; p += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const auto mask     = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, space))) ^ 0xffffU;
+        if (mask != 0) {
+            return static_cast<uint32_t>(p - begin + __builtin_ctz(mask));
+        }
+    }
+#endif
+    while (p < end && *p == ' ') {
+        p++;
+    }
+    return static_cast<uint32_t>(p - begin);
+}
+
+/// First occurrence of a or b in [p, end), end if there is none.
+const char* find_either(const char* p, const char* end, char a, char b) {
+#if defined(__SSE2__)
+    const __m128i va = _mm_set1_epi8(a);
+    const __m128i vb = _mm_set1_epi8(b);
+    for (; end - p >= 16; p += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const auto mask     = static_cast<uint32_t>(
+            _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, va), _mm_cmpeq_epi8(chunk, vb))));
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+#endif
+    while (p < end && *p != a && *p != b) {
+        p++;
+    }
+    return p;
+}
+
+void append_utf8(std::string& out, uint32_t cp) {
+    if (cp <= 0x7f) {
+        out += static_cast<char>(cp);
+    } else if (cp <= 0x7ff) {
+        out += static_cast<char>(0xc0 | (cp >> 6U));
+        out += static_cast<char>(0x80 | (cp & 0x3fU));
+    } else if (cp <= 0xffff) {
+        out += static_cast<char>(0xe0 | (cp >> 12U));
+        out += static_cast<char>(0x80 | ((cp >> 6U) & 0x3fU));
+        out += static_cast<char>(0x80 | (cp & 0x3fU));
+    } else {
+        out += static_cast<char>(0xf0 | (cp >> 18U));
+        out += static_cast<char>(0x80 | ((cp >> 12U) & 0x3fU));
+        out += static_cast<char>(0x80 | ((cp >> 6U) & 0x3fU));
+        out += static_cast<char>(0x80 | (cp & 0x3fU));
+    }
+}
+
+/// What yaml-cpp's stream based conversions leave out, trailing whitespace is accepted.
+std::string_view trim_stream(std::string_view value) {
+    while (!value.empty() && std::isspace(static_cast<unsigned char>(value.back())) != 0) {
+        value.remove_suffix(1);
+    }
+    return value;
+}
+
+/// Integers as read by a stream without a base set, 0x for hex and a leading 0 for octal.
+template <typename T> std::optional<T> to_integer(std::string_view value) {
+    value = trim_stream(value);
+
+    bool negative = false;
+    if (!value.empty() && (value[0] == '+' || value[0] == '-')) {
+        negative = value[0] == '-';
+        value.remove_prefix(1);
+    }
+    if (negative && std::is_unsigned_v<T>) {
+        return {};
+    }
+
+    int base = 10;
+    if (value.size() > 1 && value[0] == '0' && (value[1] == 'x' || value[1] == 'X')) {
+        base = 16;
+        value.remove_prefix(2);
+    } else if (value.size() > 1 && value[0] == '0') {
+        base = 8;
+        value.remove_prefix(1);
+    }
+    if (value.empty()) {
+        return {};
+    }
+
+    uint64_t magnitude = 0;
+    auto res           = std::from_chars(value.data(), value.data() + value.size(), magnitude, base);
+    if (res.ec != std::errc() || res.ptr != value.data() + value.size()) {
+        return {};
+    }
+
+    if constexpr (std::is_unsigned_v<T>) {
+        if (magnitude > std::numeric_limits<T>::max()) {
+            return {};
+        }
+        return static_cast<T>(magnitude);
+    } else {
+        const auto limit = static_cast<uint64_t>(std::numeric_limits<T>::max()) + (negative ? 1 : 0);
+        if (magnitude > limit) {
+            return {};
+        }
+        return negative ? static_cast<T>(0 - magnitude) : static_cast<T>(magnitude);
+    }
+}
+
+/// Floating point numbers as read by a stream, plus YAML's spellings of infinity and NaN.
+template <typename T> std::optional<T> to_floating(std::string_view value) {
+    if (value == ".inf" || value == ".Inf" || value == ".INF" || value == "+.inf" || value == "+.Inf" ||
+        value == "+.INF") {
+        return std::numeric_limits<T>::infinity();
+    }
+    if (value == "-.inf" || value == "-.Inf" || value == "-.INF") {
+        return -std::numeric_limits<T>::infinity();
+    }
+    if (value == ".nan" || value == ".NaN" || value == ".NAN") {
+        return std::numeric_limits<T>::quiet_NaN();
+    }
+
+    value           = trim_stream(value);
+    const bool plus = !value.empty() && value[0] == '+';
+    if (plus) {
+        value.remove_prefix(1);
+    }
+
+    // Streams only take digits, unlike from_chars which also reads "inf" and "nan"
+    const size_t first = !plus && !value.empty() && value[0] == '-' ? 1 : 0;
+    if (value.size() <= first || (std::isdigit(static_cast<unsigned char>(value[first])) == 0 && value[first] != '.')) {
+        return {};
+    }
+
+    T out{};
+    auto res = std::from_chars(value.data(), value.data() + value.size(), out);
+    if (res.ptr != value.data() + value.size()) {
+        return {};
+    }
+    if (res.ec == std::errc::result_out_of_range) {
+        // Streams keep values that underflow, only overflows are errors
+        const std::string copy(value);
+        if constexpr (std::is_same_v<T, float>) {
+            out = std::strtof(copy.c_str(), nullptr);
+        } else {
+            out = std::strtod(copy.c_str(), nullptr);
+        }
+        if (std::isinf(out)) {
+            return {};
+        }
+    } else if (res.ec != std::errc()) {
+        return {};
+    }
+    return out;
+}
+
+/// Booleans as yaml-cpp reads them: y, yes, true and on, all lowercase, uppercase or capitalized.
+std::optional<bool> to_bool(std::string_view value) {
+    if (value.size() > 5) {
+        return {};
+    }
+
+    auto lower = [](char c) { return c >= 'a' && c <= 'z'; };
+    auto upper = [](char c) { return c >= 'A' && c <= 'Z'; };
+
+    bool all_lower = true;
+    bool all_upper = true;
+    for (size_t i = 1; i < value.size(); i++) {
+        all_lower = all_lower && lower(value[i]);
+        all_upper = all_upper && upper(value[i]);
+    }
+    if (!value.empty() && !(lower(value[0]) && all_lower) && !(upper(value[0]) && (all_lower || all_upper))) {
+        return {};
+    }
+
+    char buf[5];
+    for (size_t i = 0; i < value.size(); i++) {
+        buf[i] = static_cast<char>(value[i] | 0x20);
+    }
+    const std::string_view name(buf, value.size());
+    if (name == "y" || name == "yes" || name == "true" || name == "on") {
+        return true;
+    }
+    if (name == "n" || name == "no" || name == "false" || name == "off") {
+        return false;
+    }
+    return {};
+}
+} // namespace
+
+template <typename T> std::optional<T> convert_scalar(std::string_view value) {
+    if constexpr (std::is_same_v<T, bool>) {
+        return to_bool(value);
+    } else if constexpr (std::is_floating_point_v<T>) {
+        return to_floating<T>(value);
+    } else if constexpr (std::is_integral_v<T>) {
+        return to_integer<T>(value);
+    } else {
+        return T(value);
+    }
+}
+
+template std::optional<bool> convert_scalar<bool>(std::string_view value);
+template std::optional<int32_t> convert_scalar<int32_t>(std::string_view value);
+template std::optional<int64_t> convert_scalar<int64_t>(std::string_view value);
+template std::optional<uint32_t> convert_scalar<uint32_t>(std::string_view value);
+template std::optional<uint64_t> convert_scalar<uint64_t>(std::string_view value);
+template std::optional<float> convert_scalar<float>(std::string_view value);
+template std::optional<double> convert_scalar<double>(std::string_view value);
+template std::optional<std::string> convert_scalar<std::string>(std::string_view value);
+template std::optional<std::string_view> convert_scalar<std::string_view>(std::string_view value);
+
+/**
+ * Recursive descent over the lines of the input.
+ *
+ * Every method returns the index of the node it added, anything the
+ * subset doesn't cover sets failed_ and the whole scan is dropped.
+ */
+class YamlDocument::Scanner {
+public:
+    Scanner(YamlDocument* doc, std::string_view input) : doc_(doc), input_(input) {}
+
+    bool run() {
+        if (!index_lines()) {
+            return false;
+        }
+
+        if (!next_content()) {
+            doc_->root_ = add(YAML::NodeType::Null, 0, input_.data());
+            return true;
+        }
+
+        const Line& line = lines_[line_];
+        doc_->root_      = block_node(line.begin + line.indent, line.indent);
+        return !failed_ && !next_content();
+    }
+
+private:
+    bool index_lines() {
+        // Byte order marks, directives and document markers are left to yaml-cpp
+        if (input_.size() >= 3 && input_.substr(0, 3) == "\xef\xbb\xbf") {
+            return false;
+        }
+
+        std::vector<uint32_t> starts;
+        find_line_starts(input_, starts);
+        lines_.reserve(starts.size());
+
+        for (size_t i = 0; i < starts.size(); i++) {
+            const char* begin = input_.data() + starts[i];
+            const char* end   = input_.data() + (i + 1 < starts.size() ? starts[i + 1] - 1 : input_.size());
+            if (end > begin && end[-1] == '\r') {
+                end--;
+            }
+
+            Line line{begin, end, count_spaces(begin, end), false};
+            const char* content = begin + line.indent;
+            const char* rest    = skip_spaces(content, end);
+            line.blank          = rest == end || *rest == '#';
+            if (!line.blank && (content != rest || *content == '%')) {
+                // Tabs in indentation or a directive
+                return false;
+            }
+
+            const std::string_view text(begin, end - begin);
+            if (!line.blank && (text.substr(0, 3) == "---" || text.substr(0, 3) == "...") &&
+                (text.size() == 3 || is_space(text[3]))) {
+                return false;
+            }
+            lines_.push_back(line);
+        }
+        return true;
+    }
+
+    /// Move line_ to the next line holding content, false at the end of the input.
+    bool next_content() {
+        while (line_ < lines_.size() && lines_[line_].blank) {
+            line_++;
+        }
+        return line_ < lines_.size();
+    }
+
+    uint32_t add(YAML::NodeType::value type, size_t line, const char* at) {
+        Entry entry;
+        entry.type   = type;
+        entry.line   = static_cast<uint32_t>(line);
+        entry.column = static_cast<uint32_t>(at - lines_[line].begin);
+        entry.pos    = static_cast<uint32_t>(at - input_.data());
+        doc_->entries_.push_back(entry);
+        return static_cast<uint32_t>(doc_->entries_.size() - 1);
+    }
+
+    uint32_t add_scalar(std::string_view value, size_t line, const char* at) {
+        const uint32_t index        = add(YAML::NodeType::Scalar, line, at);
+        doc_->entries_[index].value = value;
+        return index;
+    }
+
+    void append(uint32_t parent, uint32_t child) {
+        Entry& p = doc_->entries_[parent];
+        if (p.first == YamlNode::NONE) {
+            p.first = child;
+        } else {
+            doc_->entries_[p.last].next = child;
+        }
+        p.last = child;
+        p.size++;
+    }
+
+    uint32_t fail() {
+        failed_ = true;
+        return YamlNode::NONE;
+    }
+
+    static bool is_entry(const char* c, const char* end) { return *c == '-' && (c + 1 == end || is_space(c[1])); }
+
+    /// The colon ending the key at c, nullptr when c doesn't start a key.
+    const char* find_key_end(const char* c, const char* end) {
+        if (*c == '"' || *c == '\'' || *c == '?') {
+            // Quoted and complex keys are left to yaml-cpp
+            const char* close = *c == '?' ? c : find_either(c + 1, end, *c, *c);
+            if (*c == '?' || find_either(close, end, ':', ':') != end) {
+                failed_ = true;
+            }
+            return nullptr;
+        }
+        if (*c == '[' || *c == '{') {
+            return nullptr;
+        }
+
+        for (const char* p = c;;) {
+            const char* q = find_either(p, end, ':', '#');
+            if (q == end) {
+                return nullptr;
+            }
+            if (*q == '#') {
+                if (q > c && is_space(q[-1])) {
+                    return nullptr;
+                }
+            } else if (q + 1 == end || is_space(q[1])) {
+                return q;
+            }
+            p = q + 1;
+        }
+    }
+
+    uint32_t block_node(const char* c, uint32_t column) {
+        const Line& line = lines_[line_];
+        if (is_entry(c, line.end)) {
+            return block_sequence(c, column);
+        }
+
+        const char* colon = find_key_end(c, line.end);
+        if (failed_) {
+            return YamlNode::NONE;
+        }
+        if (colon != nullptr) {
+            return block_map(c, column);
+        }
+
+        const uint32_t index = inline_value(c, line.end);
+        line_++;
+        return index;
+    }
+
+    /// Value of a key or sequence entry, on the following lines when nothing follows on this one.
+    uint32_t nested_value(const char* after, uint32_t column, bool in_map) {
+        const size_t here = line_;
+        line_++;
+        if (next_content()) {
+            const Line& next = lines_[line_];
+            const char* c    = next.begin + next.indent;
+            if (next.indent > column) {
+                return block_node(c, next.indent);
+            }
+            // yaml-cpp also takes sequences at the same indentation as their key
+            if (in_map && next.indent == column && is_entry(c, next.end)) {
+                return block_sequence(c, column);
+            }
+        }
+        return add(YAML::NodeType::Null, here, after);
+    }
+
+    /// After an entry, true when the next line holds another entry of the collection at column.
+    bool continues(uint32_t column, bool sequence) {
+        if (failed_ || !next_content()) {
+            return false;
+        }
+
+        const Line& next = lines_[line_];
+        if (next.indent > column) {
+            failed_ = true;
+            return false;
+        }
+        return next.indent == column && is_entry(next.begin + next.indent, next.end) == sequence;
+    }
+
+    uint32_t block_map(const char* c, uint32_t column) {
+        const uint32_t map = add(YAML::NodeType::Map, line_, c);
+
+        do {
+            const Line& line  = lines_[line_];
+            c                 = line.begin + column;
+            const char* colon = find_key_end(c, line.end);
+            if (colon == nullptr || is_indicator(*c) || (*c == '-' && is_entry(c, line.end))) {
+                return fail();
+            }
+
+            const std::string_view key(c, trim_right(c, colon) - c);
+            const char* v = skip_spaces(colon + 1, line.end);
+
+            uint32_t value = 0;
+            if (v == line.end || *v == '#') {
+                value = nested_value(v, column, true);
+            } else {
+                value = inline_value(v, line.end);
+                line_++;
+            }
+            if (failed_) {
+                return YamlNode::NONE;
+            }
+
+            doc_->entries_[value].key = key;
+            append(map, value);
+        } while (continues(column, false));
+
+        return failed_ ? YamlNode::NONE : map;
+    }
+
+    uint32_t block_sequence(const char* c, uint32_t column) {
+        const uint32_t sequence = add(YAML::NodeType::Sequence, line_, c);
+
+        do {
+            const Line& line = lines_[line_];
+            c                = line.begin + column;
+            const char* v    = skip_spaces(c + 1, line.end);
+
+            uint32_t item = 0;
+            if (v == line.end || *v == '#') {
+                item = nested_value(v, column, false);
+            } else {
+                item = block_node(v, static_cast<uint32_t>(v - line.begin));
+            }
+            if (failed_) {
+                return YamlNode::NONE;
+            }
+
+            append(sequence, item);
+        } while (continues(column, true));
+
+        return failed_ ? YamlNode::NONE : sequence;
+    }
+
+    /// A scalar or flow collection that must end with the line.
+    uint32_t inline_value(const char* c, const char* end) {
+        uint32_t index = 0;
+        if (*c == '"' || *c == '\'' || *c == '[' || *c == '{') {
+            index = flow_node(c, end, 0);
+            if (failed_) {
+                return YamlNode::NONE;
+            }
+
+            // Only a comment may follow
+            const char* rest = skip_spaces(c, end);
+            if (rest != end && (*rest != '#' || rest == c)) {
+                return fail();
+            }
+            return index;
+        }
+
+        if (is_indicator(*c) || is_entry(c, end)) {
+            return fail();
+        }
+
+        const char* p = c;
+        for (;;) {
+            const char* q = find_either(p, end, ':', '#');
+            if (q == end) {
+                break;
+            }
+            if (*q == '#' && is_space(q[-1])) {
+                end = q;
+                break;
+            }
+            if (*q == ':' && (q + 1 == end || is_space(q[1]))) {
+                // A second key on the line
+                return fail();
+            }
+            p = q + 1;
+        }
+
+        const std::string_view value(c, trim_right(c, end) - c);
+        if (is_null(value)) {
+            return add(YAML::NodeType::Null, line_, c);
+        }
+        return add_scalar(value, line_, c);
+    }
+
+    /// A flow node starting at p, moves p past it.
+    uint32_t flow_node(const char*& p, const char* end, int depth) {
+        if (depth > MAX_FLOW_DEPTH) {
+            return fail();
+        }
+
+        const char* start = p;
+        switch (*p) {
+        case '"':
+            return double_quoted(p, end);
+        case '\'':
+            return single_quoted(p, end);
+        case '[': {
+            const uint32_t sequence = add(YAML::NodeType::Sequence, line_, start);
+            p                       = skip_spaces(p + 1, end);
+            while (p < end && *p != ']') {
+                const uint32_t item = flow_node(p, end, depth + 1);
+                if (failed_) {
+                    return YamlNode::NONE;
+                }
+                append(sequence, item);
+
+                p = skip_spaces(p, end);
+                if (p < end && *p == ',') {
+                    p = skip_spaces(p + 1, end);
+                } else if (p == end || *p != ']') {
+                    return fail();
+                }
+            }
+            if (p == end) {
+                return fail();
+            }
+            p++;
+            return sequence;
+        }
+        case '{': {
+            const uint32_t map = add(YAML::NodeType::Map, line_, start);
+            p                  = skip_spaces(p + 1, end);
+            while (p < end && *p != '}') {
+                const char* key = p;
+                while (p < end && *p != ':' && *p != ',' && *p != '{' && *p != '}' && *p != '[' && *p != ']') {
+                    p++;
+                }
+                if (p == end || *p != ':' || p == key || is_indicator(*key) || is_entry(key, end)) {
+                    return fail();
+                }
+                const std::string_view name(key, trim_right(key, p) - key);
+
+                const char* colon = p;
+                p                 = skip_spaces(p + 1, end);
+                uint32_t value    = 0;
+                if (p < end && (*p == ',' || *p == '}')) {
+                    value = add(YAML::NodeType::Null, line_, colon + 1);
+                } else if (p < end && colon + 1 < end && is_space(colon[1])) {
+                    value = flow_node(p, end, depth + 1);
+                } else {
+                    return fail();
+                }
+                if (failed_) {
+                    return YamlNode::NONE;
+                }
+                doc_->entries_[value].key = name;
+                append(map, value);
+
+                p = skip_spaces(p, end);
+                if (p < end && *p == ',') {
+                    p = skip_spaces(p + 1, end);
+                } else if (p == end || *p != '}') {
+                    return fail();
+                }
+            }
+            if (p == end) {
+                return fail();
+            }
+            p++;
+            return map;
+        }
+        default:
+            break;
+        }
+
+        if (is_indicator(*p) || is_entry(p, end)) {
+            return fail();
+        }
+
+        // Plain scalars end at flow indicators, a comment or a colon followed by a space
+        while (p < end && *p != ',' && *p != '[' && *p != ']' && *p != '{' && *p != '}' &&
+               !(*p == '#' && is_space(p[-1])) && !(*p == ':' && (p + 1 == end || is_space(p[1])))) {
+            p++;
+        }
+
+        const std::string_view value(start, trim_right(start, p) - start);
+        if (is_null(value)) {
+            return add(YAML::NodeType::Null, line_, start);
+        }
+        return add_scalar(value, line_, start);
+    }
+
+    uint32_t single_quoted(const char*& p, const char* end) {
+        const char* start    = p;
+        const char* run      = ++p;
+        std::string* decoded = nullptr;
+
+        for (;;) {
+            const char* q = find_either(p, end, '\'', '\'');
+            if (q == end) {
+                // Multi-line scalar
+                return fail();
+            }
+            if (q + 1 < end && q[1] == '\'') {
+                if (decoded == nullptr) {
+                    decoded = &doc_->decoded_.emplace_back();
+                }
+                decoded->append(run, q + 1);
+                p = run = q + 2;
+                continue;
+            }
+
+            p = q + 1;
+            if (decoded == nullptr) {
+                return add_scalar(std::string_view(run, q - run), line_, start);
+            }
+            decoded->append(run, q);
+            return add_scalar(*decoded, line_, start);
+        }
+    }
+
+    uint32_t double_quoted(const char*& p, const char* end) {
+        const char* start    = p;
+        const char* run      = ++p;
+        std::string* decoded = nullptr;
+
+        for (;;) {
+            const char* q = find_either(p, end, '"', '\\');
+            if (q == end || (*q == '\\' && q + 1 == end)) {
+                // Multi-line scalar or line continuation
+                return fail();
+            }
+
+            if (*q == '"') {
+                p = q + 1;
+                if (decoded == nullptr) {
+                    return add_scalar(std::string_view(run, q - run), line_, start);
+                }
+                decoded->append(run, q);
+                return add_scalar(*decoded, line_, start);
+            }
+
+            if (decoded == nullptr) {
+                decoded = &doc_->decoded_.emplace_back();
+            }
+            decoded->append(run, q);
+            p = escape(q + 1, end, *decoded);
+            if (p == nullptr) {
+                return fail();
+            }
+            run = p;
+        }
+    }
+
+    /// Decode the escape after a backslash, same table as yaml-cpp, nullptr on invalid ones.
+    static const char* escape(const char* p, const char* end, std::string& out) {
+        int digits = 0;
+        switch (*p) {
+        case '0':
+            out += '\0';
+            break;
+        case 'a':
+            out += '\a';
+            break;
+        case 'b':
+            out += '\b';
+            break;
+        case 't':
+        case '\t':
+            out += '\t';
+            break;
+        case 'n':
+            out += '\n';
+            break;
+        case 'v':
+            out += '\v';
+            break;
+        case 'f':
+            out += '\f';
+            break;
+        case 'r':
+            out += '\r';
+            break;
+        case 'e':
+            out += '\x1b';
+            break;
+        case ' ':
+        case '"':
+        case '\'':
+        case '\\':
+        case '/':
+            out += *p;
+            break;
+        case 'N':
+            out += '\x85';
+            break;
+        case '_':
+            out += '\xa0';
+            break;
+        case 'L':
+            out += "\xe2\x80\xa8";
+            break;
+        case 'P':
+            out += "\xe2\x80\xa9";
+            break;
+        case 'x':
+            digits = 2;
+            break;
+        case 'u':
+            digits = 4;
+            break;
+        case 'U':
+            digits = 8;
+            break;
+        default:
+            return nullptr;
+        }
+
+        p++;
+        if (digits == 0) {
+            return p;
+        }
+
+        uint32_t cp = 0;
+        if (end - p < digits || std::from_chars(p, p + digits, cp, 16).ptr != p + digits) {
+            return nullptr;
+        }
+        if ((cp >= 0xd800 && cp <= 0xdfff) || cp > 0x10ffff) {
+            return nullptr;
+        }
+        append_utf8(out, cp);
+        return p + digits;
+    }
+
+    YamlDocument* doc_;
+    std::string_view input_;
+    std::vector<Line> lines_;
+    size_t line_ = 0;
+    bool failed_ = false;
+};
+
+std::shared_ptr<const YamlDocument> YamlDocument::scan(std::string_view input, bool copy) {
+    auto doc = std::make_shared<YamlDocument>();
+    if (copy) {
+        doc->copy_ = input;
+        input      = doc->copy_;
+    }
+
+    // Offsets are kept in 32 bits
+    if (input.size() >= std::numeric_limits<uint32_t>::max()) {
+        return nullptr;
+    }
+
+    if (!Scanner(doc.get(), input).run()) {
+        return nullptr;
+    }
+    return doc;
+}
+
+YAML::Mark YamlNode::Mark() const {
+    YAML::Mark mark;
+    if (doc_ != nullptr) {
+        const auto& entry = doc_->entries_[index_];
+        mark.pos          = static_cast<int>(entry.pos);
+        mark.line         = static_cast<int>(entry.line);
+        mark.column       = static_cast<int>(entry.column);
+    }
+    return mark;
+}
+
+YamlNode YamlNode::operator[](std::string_view key) const {
+    if (!IsMap()) {
+        return {};
+    }
+
+    for (uint32_t i = doc_->entries_[index_].first; i != NONE; i = doc_->entries_[i].next) {
+        if (doc_->entries_[i].key == key) {
+            return {doc_, i};
+        }
+    }
+    return {};
+}
+
+template <typename T> std::optional<T> YamlNode::convert() const {
+    if constexpr (std::is_same_v<T, std::string>) {
+        // Like as<std::string>(), which spells out nulls
+        if (IsNull()) {
+            return "null";
+        }
+    }
+    if (!IsScalar()) {
+        return {};
+    }
+
+    return convert_scalar<T>(Scalar());
+}
+
+template std::optional<bool> YamlNode::convert<bool>() const;
+template std::optional<int32_t> YamlNode::convert<int32_t>() const;
+template std::optional<int64_t> YamlNode::convert<int64_t>() const;
+template std::optional<uint32_t> YamlNode::convert<uint32_t>() const;
+template std::optional<uint64_t> YamlNode::convert<uint64_t>() const;
+template std::optional<float> YamlNode::convert<float>() const;
+template std::optional<double> YamlNode::convert<double>() const;
+template std::optional<std::string> YamlNode::convert<std::string>() const;
+template std::optional<std::string_view> YamlNode::convert<std::string_view>() const;
+
+} // namespace config_much::internal
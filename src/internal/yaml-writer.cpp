@@ -0,0 +1,340 @@
+#include "internal/yaml-writer.h"
+
+#include "internal/bytes-value.h"
+#include "internal/case-convert.h"
+#include "internal/default-values.h"
+#include "internal/time-parse.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <unordered_map>
+#include <vector>
+
+namespace config_much::internal {
+
+// Static helpers
+namespace {
+constexpr size_t FLUSH_SIZE = 64 * 1024;
+
+bool needs_escape(char c) {
+    const auto u = static_cast<unsigned char>(c);
+    return u < 0x20 || u == 0x7f || c == '"' || c == '\\';
+}
+
+/// Output buffer, flushed to fd as it fills up when writing to a file.
+class Emitter {
+public:
+    Emitter(std::string* out, int fd, bool camelcase) : out_(out), fd_(fd), camelcase_(camelcase) {}
+
+    /// Write msg as the root of the document, empty messages as `{}`.
+    void document(const google::protobuf::Message& msg) {
+        const auto* prototype = DefaultValues::get(msg).prototype();
+        if (fields(msg, prototype).empty()) {
+            out_->append("{}");
+            line_done();
+        } else {
+            message(msg, prototype, 0, false);
+        }
+    }
+
+    std::optional<ParserError> flush() {
+        size_t offset = 0;
+        while (offset < out_->size()) {
+            ssize_t res = ::write(fd_, out_->data() + offset, out_->size() - offset);
+            if (res < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                ParserError err;
+                err << "Failed to write YAML: " << std::strerror(errno);
+                return err;
+            }
+            offset += static_cast<size_t>(res);
+        }
+        out_->clear();
+        return {};
+    }
+
+    const std::optional<ParserError>& error() const { return error_; }
+
+private:
+    /**
+     * Fields to write in field number order: those set in msg, and those
+     * prototype holds defaults for, which would otherwise read back as
+     * their default rather than as 0, "", [] or the first enum value.
+     */
+    static std::vector<const google::protobuf::FieldDescriptor*> fields(const google::protobuf::Message& msg,
+                                                                        const google::protobuf::Message* prototype) {
+        std::vector<const google::protobuf::FieldDescriptor*> set;
+        msg.GetReflection()->ListFields(msg, &set);
+        if (prototype == nullptr) {
+            return set;
+        }
+
+        std::vector<const google::protobuf::FieldDescriptor*> defaults;
+        prototype->GetReflection()->ListFields(*prototype, &defaults);
+        std::vector<const google::protobuf::FieldDescriptor*> all;
+        std::set_union(set.begin(), set.end(), defaults.begin(), defaults.end(), std::back_inserter(all),
+                       [](const auto* a, const auto* b) { return a->number() < b->number(); });
+        return all;
+    }
+
+    /// Fields of msg one per line at indent, the first one without indentation when inline_first.
+    void message(const google::protobuf::Message& msg, const google::protobuf::Message* prototype, int indent,
+                 bool inline_first);
+
+    /// Everything after "key:" or "-", up to the end of the line for scalars.
+    void value(const google::protobuf::Message& msg, const google::protobuf::FieldDescriptor* field, int index,
+               const google::protobuf::Message* prototype, int indent, bool in_sequence);
+    void scalar(const google::protobuf::Message& msg, const google::protobuf::FieldDescriptor* field, int index);
+
+    void key(const google::protobuf::FieldDescriptor* field);
+    void string(const std::string& value);
+
+    template <typename T> void number(T value) {
+        char buf[32];
+        auto res = std::to_chars(buf, buf + sizeof(buf), value);
+        out_->append(buf, res.ptr);
+    }
+
+    template <typename T> void floating(T value) {
+        if (std::isnan(value)) {
+            out_->append(".nan");
+        } else if (std::isinf(value)) {
+            out_->append(value < 0 ? "-.inf" : ".inf");
+        } else {
+            number(value);
+        }
+    }
+
+    void indent(int n) { out_->append(static_cast<size_t>(n), ' '); }
+
+    /// Called at the end of every line, only writes whole lines out.
+    void line_done() {
+        out_->push_back('\n');
+        if (fd_ < 0 || out_->size() < FLUSH_SIZE) {
+            return;
+        }
+
+        // After a failure the rest is only formatted and dropped
+        if (!error_) {
+            error_ = flush();
+        }
+        out_->clear();
+    }
+
+    std::string* out_;
+    int fd_;
+    bool camelcase_;
+    std::optional<ParserError> error_;
+    std::unordered_map<const google::protobuf::FieldDescriptor*, std::string> names_;
+};
+
+void Emitter::message(const google::protobuf::Message& msg, const google::protobuf::Message* prototype, int indent,
+                      bool inline_first) {
+    for (const auto* field : fields(msg, prototype)) {
+        if (!inline_first) {
+            this->indent(indent);
+        }
+        inline_first = false;
+        key(field);
+
+        if (!field->is_repeated()) {
+            // Defaults of sub-messages are compared field by field
+            const google::protobuf::Message* sub = nullptr;
+            if (prototype != nullptr && field->cpp_type() == google::protobuf::FieldDescriptor::CPPTYPE_MESSAGE &&
+                prototype->GetReflection()->HasField(*prototype, field)) {
+                sub = &prototype->GetReflection()->GetMessage(*prototype, field);
+            }
+            value(msg, field, -1, sub, indent + 2, false);
+            continue;
+        }
+
+        const int size = msg.GetReflection()->FieldSize(msg, field);
+        if (size == 0) {
+            out_->append(" []");
+            line_done();
+            continue;
+        }
+
+        line_done();
+        for (int i = 0; i < size; i++) {
+            this->indent(indent + 2);
+            out_->push_back('-');
+            value(msg, field, i, nullptr, indent + 4, true);
+        }
+    }
+}
+
+void Emitter::value(const google::protobuf::Message& msg, const google::protobuf::FieldDescriptor* field, int index,
+                    const google::protobuf::Message* prototype, int indent, bool in_sequence) {
+    if (field->cpp_type() != google::protobuf::FieldDescriptor::CPPTYPE_MESSAGE) {
+        out_->push_back(' ');
+        scalar(msg, field, index);
+        line_done();
+        return;
+    }
+
+    const auto* r   = msg.GetReflection();
+    const auto& sub = index < 0 ? r->GetMessage(msg, field) : r->GetRepeatedMessage(msg, field, index);
+
+    const TimeType type = time_type(field->message_type());
+    if (type != TimeType::NONE) {
+        out_->push_back(' ');
+        const size_t mark = out_->size();
+        if (format_time(type, get_time(sub), out_)) {
+            line_done();
+            return;
+        }
+        // Out of range values are kept as they are, as a map
+        out_->resize(mark - 1);
+    }
+
+    if (fields(sub, prototype).empty()) {
+        out_->append(" {}");
+        line_done();
+        return;
+    }
+
+    if (in_sequence) {
+        out_->push_back(' ');
+        message(sub, prototype, indent, true);
+    } else {
+        line_done();
+        message(sub, prototype, indent, false);
+    }
+}
+
+void Emitter::scalar(const google::protobuf::Message& msg, const google::protobuf::FieldDescriptor* field, int index) {
+    using google::protobuf::FieldDescriptor;
+    const auto* r = msg.GetReflection();
+
+    switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+        number(index < 0 ? r->GetInt32(msg, field) : r->GetRepeatedInt32(msg, field, index));
+        break;
+    case FieldDescriptor::CPPTYPE_INT64:
+        number(index < 0 ? r->GetInt64(msg, field) : r->GetRepeatedInt64(msg, field, index));
+        break;
+    case FieldDescriptor::CPPTYPE_UINT32:
+        number(index < 0 ? r->GetUInt32(msg, field) : r->GetRepeatedUInt32(msg, field, index));
+        break;
+    case FieldDescriptor::CPPTYPE_UINT64:
+        number(index < 0 ? r->GetUInt64(msg, field) : r->GetRepeatedUInt64(msg, field, index));
+        break;
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+        floating(index < 0 ? r->GetDouble(msg, field) : r->GetRepeatedDouble(msg, field, index));
+        break;
+    case FieldDescriptor::CPPTYPE_FLOAT:
+        floating(index < 0 ? r->GetFloat(msg, field) : r->GetRepeatedFloat(msg, field, index));
+        break;
+    case FieldDescriptor::CPPTYPE_BOOL:
+        out_->append((index < 0 ? r->GetBool(msg, field) : r->GetRepeatedBool(msg, field, index)) ? "true" : "false");
+        break;
+    case FieldDescriptor::CPPTYPE_ENUM: {
+        const int value        = index < 0 ? r->GetEnumValue(msg, field) : r->GetRepeatedEnumValue(msg, field, index);
+        const auto* enum_value = field->enum_type()->FindValueByNumber(value);
+        if (enum_value != nullptr) {
+            out_->append(enum_value->name());
+        } else {
+            number(value);
+        }
+        break;
+    }
+    case FieldDescriptor::CPPTYPE_STRING: {
+        std::string scratch;
+        const std::string& value = index < 0 ? r->GetStringReference(msg, field, &scratch)
+                                             : r->GetRepeatedStringReference(msg, field, index, &scratch);
+        if (field->type() == FieldDescriptor::TYPE_BYTES) {
+            out_->push_back('"');
+            base64_encode(value, out_);
+            out_->push_back('"');
+        } else {
+            string(value);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void Emitter::key(const google::protobuf::FieldDescriptor* field) {
+    if (!camelcase_) {
+        out_->append(field->name());
+    } else {
+        auto it = names_.find(field);
+        if (it == names_.end()) {
+            it = names_.emplace(field, case_convert::snake_to_camel(field->name())).first;
+        }
+        out_->append(it->second);
+    }
+    out_->push_back(':');
+}
+
+void Emitter::string(const std::string& value) {
+    out_->push_back('"');
+
+    size_t start = 0;
+    for (size_t i = 0; i < value.size(); i++) {
+        const char c = value[i];
+        if (!needs_escape(c)) {
+            continue;
+        }
+
+        out_->append(value, start, i - start);
+        start = i + 1;
+        switch (c) {
+        case '"':
+            out_->append("\\\"");
+            break;
+        case '\\':
+            out_->append("\\\\");
+            break;
+        case '\n':
+            out_->append("\\n");
+            break;
+        case '\t':
+            out_->append("\\t");
+            break;
+        case '\r':
+            out_->append("\\r");
+            break;
+        default: {
+            constexpr std::string_view digits = "0123456789abcdef";
+            const auto u                      = static_cast<unsigned char>(c);
+            out_->append("\\x");
+            out_->push_back(digits[u >> 4U]);
+            out_->push_back(digits[u & 0xfU]);
+        }
+        }
+    }
+    out_->append(value, start, value.size() - start);
+
+    out_->push_back('"');
+}
+} // namespace
+
+void YamlWriter::write(const google::protobuf::Message& msg, std::string* out) const {
+    Emitter(out, -1, camelcase_).document(msg);
+}
+
+std::optional<ParserError> YamlWriter::write(const google::protobuf::Message& msg, int fd) const {
+    std::string buffer;
+    buffer.reserve(FLUSH_SIZE + FLUSH_SIZE / 4);
+
+    Emitter emitter(&buffer, fd, camelcase_);
+    emitter.document(msg);
+    if (emitter.error()) {
+        return emitter.error();
+    }
+    return emitter.flush();
+}
+
+} // namespace config_much::internal
@@ -0,0 +1,237 @@
+#include "config-much.h"
+
+#include "proto/test-config.pb.h"
+
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace config_much {
+
+class ByteSourceTests : public testing::Test {
+protected:
+    void SetUp() override {
+        dir_ = std::filesystem::temp_directory_path() /
+               ("config-much-" + std::string(testing::UnitTest::GetInstance()->current_test_info()->name()));
+        std::filesystem::create_directories(dir_);
+    }
+
+    void TearDown() override { std::filesystem::remove_all(dir_); }
+
+    std::filesystem::path write(const std::string& name, const std::string& content) {
+        auto path = dir_ / name;
+        std::ofstream(path) << content;
+        return path;
+    }
+
+    std::filesystem::path dir_;
+};
+
+namespace {
+std::string gzip(const std::string& content) {
+    z_stream stream{};
+    deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+
+    std::string out(deflateBound(&stream, content.size()), '\0');
+    stream.next_in   = reinterpret_cast<Bytef*>(const_cast<char*>(content.data()));
+    stream.avail_in  = static_cast<uInt>(content.size());
+    stream.next_out  = reinterpret_cast<Bytef*>(out.data());
+    stream.avail_out = static_cast<uInt>(out.size());
+    deflate(&stream, Z_FINISH);
+    out.resize(stream.total_out);
+    deflateEnd(&stream);
+    return out;
+}
+} // namespace
+
+TEST_F(ByteSourceTests, Memory) {
+    constexpr std::string_view content = "enabled: true\n";
+    MemorySource source("memory", content);
+
+    ASSERT_FALSE(source.load());
+    ASSERT_EQ(source.data(), content);
+    ASSERT_EQ(source.name(), "memory");
+}
+
+TEST_F(ByteSourceTests, Mmap) {
+    const std::string content = "field_i32: 42\n";
+    MmapSource source(write("mmap.yml", content));
+
+    ASSERT_FALSE(source.load());
+    ASSERT_EQ(source.data(), content);
+    source.release();
+    ASSERT_TRUE(source.data().empty());
+
+    MmapSource empty(write("empty.yml", ""));
+    ASSERT_FALSE(empty.load());
+    ASSERT_TRUE(empty.data().empty());
+
+    MmapSource missing(dir_ / "missing.yml");
+    ASSERT_TRUE(missing.load());
+}
+
+TEST_F(ByteSourceTests, Fd) {
+    const std::string content = "field_string: from an fd\n";
+    auto path                 = write("fd.yml", content);
+
+    int fd = open(path.c_str(), O_RDONLY);
+    ASSERT_NE(fd, -1);
+
+    FdSource source(fd, path);
+    ASSERT_FALSE(source.load());
+    ASSERT_EQ(source.data(), content);
+    close(fd);
+}
+
+TEST_F(ByteSourceTests, File) {
+    const std::string content = "enabled: false\n";
+    FileSource source(write("file.yml", content));
+
+    ASSERT_FALSE(source.load());
+    ASSERT_EQ(source.data(), content);
+    source.release();
+
+    FileSource missing(dir_ / "missing.yml");
+    ASSERT_TRUE(missing.load());
+}
+
+TEST_F(ByteSourceTests, BatchRead) {
+    for (bool use_io_uring : {true, false}) {
+        std::vector<std::string> contents;
+        std::vector<std::unique_ptr<FileSource>> sources;
+        std::vector<FileSource*> files;
+
+        for (int i = 0; i < 100; i++) {
+            // Mix in some files bigger than a single read
+            contents.emplace_back(i % 10 == 0 ? std::string(1 << 20, 'a' + (i % 26)) : std::to_string(i));
+            sources.emplace_back(
+                std::make_unique<FileSource>(write("batch-" + std::to_string(i) + ".yml", contents.back())));
+            files.push_back(sources.back().get());
+        }
+        sources.emplace_back(std::make_unique<FileSource>(dir_ / "missing.yml"));
+        files.push_back(sources.back().get());
+
+        BatchReader reader(use_io_uring);
+        reader.read(files);
+        if (!use_io_uring) {
+            ASSERT_FALSE(reader.used_io_uring());
+        }
+
+        for (size_t i = 0; i < contents.size(); i++) {
+            ASSERT_FALSE(sources[i]->load()) << "io_uring: " << use_io_uring;
+            ASSERT_EQ(sources[i]->data(), contents[i]) << "io_uring: " << use_io_uring;
+        }
+        ASSERT_TRUE(sources.back()->load());
+    }
+}
+
+TEST_F(ByteSourceTests, Compressed) {
+    const std::string content = "field_i32: 7\nfield_string: zipped\n";
+
+    // Detected from the content, not the name
+    for (const auto* name : {"config.yml.gz", "config.yml"}) {
+        FileSource source(write(name, gzip(content)));
+        ASSERT_FALSE(source.load());
+        ASSERT_EQ(source.data(), content);
+    }
+
+    // Larger than any declared size hint, in two members
+    std::string large;
+    for (int i = 0; large.size() < (3 << 20); i++) {
+        large += "field_string: line " + std::to_string(i) + "\n";
+    }
+    FileSource members(write("members.gz", gzip(large) + gzip(content)));
+    ASSERT_FALSE(members.load());
+    ASSERT_EQ(members.data(), large + content);
+
+    // Batched reads and parses go through the same path
+    test_config::Config cfg;
+    auto res = Parser{}.add_file(dir_ / "config.yml.gz").add_file(write("plain.yml", "enabled: true\n")).parse(&cfg);
+    ASSERT_FALSE(res) << res->front();
+    ASSERT_EQ(cfg.field_i32(), 7);
+    ASSERT_EQ(cfg.field_string(), "zipped");
+    ASSERT_TRUE(cfg.enabled());
+}
+
+TEST_F(ByteSourceTests, ContentHash) {
+    const std::string content = "field_i32: 7\n";
+
+    // Only hashed when asked to, of the bytes parsers get
+    MemorySource memory("/memory.yml", content);
+    ASSERT_FALSE(memory.load());
+    ASSERT_EQ(memory.content_hash(), 0);
+    memory.set_hash_content(true);
+    ASSERT_FALSE(memory.load());
+    ASSERT_EQ(memory.content_hash(), internal::hash_bytes(content));
+
+    FileSource file(write("config.yml.gz", gzip(content)));
+    file.set_hash_content(true);
+    ASSERT_FALSE(file.load());
+    file.release();
+    ASSERT_EQ(file.content_hash(), internal::hash_bytes(content));
+    ASSERT_EQ(file.bytes_read(), gzip(content).size());
+}
+
+TEST_F(ByteSourceTests, CompressedErrors) {
+    const std::string zipped = gzip(std::string(1000, 'a'));
+    auto error               = [](const std::filesystem::path& path, const std::string& msg) {
+        ParserError err;
+        err << path << ": " << msg;
+        return err;
+    };
+
+    auto truncated = write("truncated.gz", zipped.substr(0, zipped.size() - 6));
+    ASSERT_EQ(FileSource(truncated).load(), error(truncated, "Truncated gzip data"));
+
+    std::string corrupted = zipped;
+    corrupted[12] ^= 0x55;
+    ASSERT_TRUE(FileSource(write("corrupted.gz", corrupted)).load());
+
+    auto large = write("large.gz", zipped);
+    ASSERT_EQ(FileSource(large, 100).load(), error(large, "Decompresses to more than 100 bytes"));
+
+    // A trailer claiming 4 GiB doesn't get that much allocated up front, zlib catches the lie at the end
+    std::string forged = zipped;
+    forged.replace(forged.size() - 4, 4, "\xf0\xff\xff\xff");
+    auto lying = write("lying.gz", forged);
+    ASSERT_EQ(FileSource(lying).load(), error(lying, "Invalid gzip data: incorrect length check"));
+
+    // Output grows well past the compressed size when it has to
+    const std::string repeated(4 << 20, 'b');
+    FileSource expanded(write("expanded.gz", gzip(repeated)));
+    ASSERT_FALSE(expanded.load());
+    ASSERT_EQ(expanded.data(), repeated);
+
+    // Supported or not, this isn't valid zstd
+    ASSERT_TRUE(FileSource(write("bad.zst", std::string("\x28\xb5\x2f\xfd garbage", 12))).load());
+
+    // Errors name the file through the parser too
+    test_config::Config cfg;
+    auto res = Parser{}.add_file(truncated).parse(&cfg);
+    ASSERT_EQ(res, ParserResult({error(truncated, "Truncated gzip data")}));
+}
+
+TEST_F(ByteSourceTests, ParserFromSources) {
+    constexpr std::string_view first = R"(
+        enabled: true
+        field_i32: -32
+    )";
+    auto second = write("second.yml", "field_i32: 32\n");
+    auto third  = write("third.yml", "field_u32: 3\n");
+
+    test_config::Config parsed;
+    auto res = Parser{}.add_buffer("first", first).add_file(second).add_file(third).parse(&parsed);
+    ASSERT_FALSE(res) << res->front();
+
+    test_config::Config expected;
+    expected.set_enabled(true);
+    expected.set_field_i32(32);
+    expected.set_field_u32(3);
+    ASSERT_EQ(parsed.SerializeAsString(), expected.SerializeAsString());
+}
+} // namespace config_much
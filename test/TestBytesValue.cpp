@@ -0,0 +1,228 @@
+#include "internal/bytes-value.h"
+#include "internal/parser-env.h"
+#include "internal/parser-yaml.h"
+
+#include "proto/test-config.pb.h"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+namespace config_much::internal {
+
+namespace {
+std::string encode(std::string_view input) {
+    constexpr std::string_view alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    std::string out;
+    size_t i = 0;
+    for (; i + 3 <= input.size(); i += 3) {
+        const uint32_t v = (static_cast<uint8_t>(input[i]) << 16U) | (static_cast<uint8_t>(input[i + 1]) << 8U) |
+                           static_cast<uint8_t>(input[i + 2]);
+        out += alphabet[(v >> 18U) & 0x3fU];
+        out += alphabet[(v >> 12U) & 0x3fU];
+        out += alphabet[(v >> 6U) & 0x3fU];
+        out += alphabet[v & 0x3fU];
+    }
+
+    if (input.size() - i == 1) {
+        const uint32_t v = static_cast<uint8_t>(input[i]) << 16U;
+        out += alphabet[(v >> 18U) & 0x3fU];
+        out += alphabet[(v >> 12U) & 0x3fU];
+        out += "==";
+    } else if (input.size() - i == 2) {
+        const uint32_t v = (static_cast<uint8_t>(input[i]) << 16U) | (static_cast<uint8_t>(input[i + 1]) << 8U);
+        out += alphabet[(v >> 18U) & 0x3fU];
+        out += alphabet[(v >> 12U) & 0x3fU];
+        out += alphabet[(v >> 6U) & 0x3fU];
+        out += "=";
+    }
+    return out;
+}
+
+std::string random_bytes(std::mt19937& rng, size_t size) {
+    std::string out(size, '\0');
+    for (auto& c : out) {
+        c = static_cast<char>(rng());
+    }
+    return out;
+}
+} // namespace
+
+class BytesValueTests : public testing::Test {
+protected:
+    void SetUp() override {
+        dir_ = std::filesystem::temp_directory_path() /
+               ("config-much-" + std::string(testing::UnitTest::GetInstance()->current_test_info()->name()));
+        std::filesystem::create_directories(dir_);
+    }
+
+    void TearDown() override { std::filesystem::remove_all(dir_); }
+
+    std::filesystem::path write(const std::string& name, const std::string& content) {
+        auto path = dir_ / name;
+        std::ofstream(path, std::ios::binary) << content;
+        return path;
+    }
+
+    std::filesystem::path dir_;
+};
+
+TEST_F(BytesValueTests, RoundTrip) {
+    std::mt19937 rng(42);
+    for (size_t size : {0, 1, 2, 3, 23, 24, 25, 47, 48, 100, 1000, 4096, 65537}) {
+        const auto input   = random_bytes(rng, size);
+        const auto encoded = encode(input);
+
+        for (bool simd : {true, false}) {
+            std::string decoded;
+            auto err = base64_decode(encoded, &decoded, simd);
+            ASSERT_FALSE(err) << "Size: " << size << " simd: " << simd << " error: " << *err;
+            ASSERT_EQ(decoded, input) << "Size: " << size << " simd: " << simd;
+        }
+    }
+}
+
+TEST_F(BytesValueTests, Encode) {
+    std::mt19937 rng(3);
+    for (size_t size : {0, 1, 2, 3, 4, 5, 100, 4097}) {
+        const auto input = random_bytes(rng, size);
+
+        std::string encoded = "prefix";
+        base64_encode(input, &encoded);
+        ASSERT_EQ(encoded, "prefix" + encode(input)) << "Size: " << size;
+    }
+}
+
+TEST_F(BytesValueTests, Whitespace) {
+    std::mt19937 rng(7);
+    const auto input   = random_bytes(rng, 3000);
+    const auto encoded = encode(input);
+
+    // Line wrapped like PEM files and YAML block scalars
+    std::string wrapped;
+    for (size_t i = 0; i < encoded.size(); i += 76) {
+        wrapped += encoded.substr(i, 76) + "\r\n";
+    }
+
+    for (bool simd : {true, false}) {
+        std::string decoded;
+        ASSERT_FALSE(base64_decode(wrapped, &decoded, simd));
+        ASSERT_EQ(decoded, input);
+    }
+
+    std::string unpadded;
+    ASSERT_FALSE(base64_decode("aGk", &unpadded));
+    ASSERT_EQ(unpadded, "hi");
+}
+
+TEST_F(BytesValueTests, InvalidCharacters) {
+    const std::string valid(96, 'A');
+
+    for (int c = 0; c < 256; c++) {
+        const char ch = static_cast<char>(c);
+        if ((ch >= 'A' && ch <= 'Z') || (ch >= 'a' && ch <= 'z') || (ch >= '0' && ch <= '9') || ch == '+' ||
+            ch == '/' || ch == '=' || ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n') {
+            continue;
+        }
+
+        for (size_t offset : {0, 17, 31, 40, 95}) {
+            auto input    = valid;
+            input[offset] = ch;
+
+            for (bool simd : {true, false}) {
+                std::string decoded;
+                auto err = base64_decode(input, &decoded, simd);
+                ASSERT_TRUE(err) << "Character: " << c << " offset: " << offset << " simd: " << simd;
+                ASSERT_EQ(*err, ParserError("invalid character at offset " + std::to_string(offset)));
+            }
+        }
+    }
+}
+
+TEST_F(BytesValueTests, Padding) {
+    struct test_case {
+        std::string input;
+        ParserError expected;
+    };
+
+    std::vector<test_case> tests = {
+        {"A", "truncated input"},
+        {"AB=", "incomplete padding"},
+        {"A===", "unexpected padding at offset 1"},
+        {"ABC==", "unexpected padding at offset 4"},
+        {"AB==AB==", "invalid character at offset 4"},
+        {"=", "unexpected padding at offset 0"},
+    };
+
+    for (const auto& [input, expected] : tests) {
+        std::string decoded;
+        auto err = base64_decode(input, &decoded);
+        ASSERT_TRUE(err) << "Input: '" << input << "'";
+        ASSERT_EQ(*err, expected) << "Input: '" << input << "'";
+    }
+}
+
+TEST_F(BytesValueTests, FileReference) {
+    const std::string content("\x00\x01binary\xff", 9);
+    const auto path = write("blob.bin", content);
+
+    std::string out;
+    ASSERT_FALSE(parse_bytes("file:" + path.string(), "/unused", &out));
+    ASSERT_EQ(out, content);
+
+    out.clear();
+    ASSERT_FALSE(parse_bytes("file:blob.bin", dir_, &out));
+    ASSERT_EQ(out, content);
+
+    ASSERT_TRUE(parse_bytes("file:missing.bin", dir_, &out));
+    ASSERT_EQ(*parse_bytes("file:", dir_, &out), ParserError("empty file reference"));
+}
+
+TEST_F(BytesValueTests, ParseYaml) {
+    const std::string content(1 << 20, 'x');
+    write("blob.bin", content);
+    const auto config = write("config.yml", R"(
+data: file:blob.bin
+chunks:
+  - aGVsbG8=
+  - |
+    d29y
+    bGQ=
+  - no!
+)");
+
+    test_config::Blobs cfg;
+    auto res = ParserYaml(config).parse(&cfg);
+
+    ParserError err;
+    err << config << ": Invalid bytes value for field chunks: invalid character at offset 2";
+    ASSERT_EQ(res, ParserResult{{err}});
+
+    ASSERT_EQ(cfg.data(), content);
+    ASSERT_EQ(cfg.chunks_size(), 2);
+    ASSERT_EQ(cfg.chunks(0), "hello");
+    ASSERT_EQ(cfg.chunks(1), "world");
+}
+
+TEST_F(BytesValueTests, ParseEnv) {
+    const auto path = write("blob.bin", "from a file");
+    setenv("BYTES_DATA", ("file:" + path.string()).c_str(), 0);
+    setenv("BYTES_CHUNKS_0", "aGVsbG8=", 0);
+    setenv("BYTES_CHUNKS_1", "%%%%", 0);
+
+    test_config::Blobs cfg;
+    auto res = ParserEnv("BYTES").parse(&cfg);
+
+    const ParserResult expected{{
+        "BYTES_CHUNKS_1: Invalid bytes value for field chunks: invalid character at offset 0",
+    }};
+    ASSERT_EQ(res, expected);
+    ASSERT_EQ(cfg.data(), "from a file");
+    ASSERT_EQ(cfg.chunks_size(), 1);
+    ASSERT_EQ(cfg.chunks(0), "hello");
+}
+
+} // namespace config_much::internal
@@ -74,4 +74,22 @@ TEST(CaseConvertTests, AllCaps) {
         ASSERT_EQ(processed, test.expected);
     }
 }
+TEST(CaseConvertTests, SameName) {
+    for (const std::string spelling : {"field_i32", "fieldI32", "FieldI32", "field-i32", "FIELD_I32", "Field_I32"}) {
+        ASSERT_TRUE(same_name(spelling, "field_i32")) << spelling;
+        ASSERT_TRUE(same_name("field_i32", spelling)) << spelling;
+        ASSERT_EQ(name_hash(spelling), name_hash("field_i32")) << spelling;
+    }
+
+    ASSERT_TRUE(same_name("HTTPServer", "http_server"));
+    ASSERT_TRUE(same_name("field1", "field_1"));
+    ASSERT_TRUE(same_name("ipv4Address", "ipv4_address"));
+
+    // Words have to line up, not just the letters
+    ASSERT_FALSE(same_name("fieldi32", "field_i32"));
+    ASSERT_FALSE(same_name("fIeld", "field"));
+    ASSERT_FALSE(same_name("field", "field_i32"));
+    ASSERT_FALSE(same_name("field_i32", "field"));
+    ASSERT_FALSE(same_name("", "field"));
+}
 } // namespace config_much::case_convert
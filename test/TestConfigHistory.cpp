@@ -0,0 +1,136 @@
+#include "config-much.h"
+
+#include "proto/test-config.pb.h"
+
+#include <google/protobuf/util/message_differencer.h>
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+namespace config_much {
+using google::protobuf::util::MessageDifferencer;
+
+TEST(ConfigHistoryTests, Record) {
+    test_config::Config cfg;
+    cfg.set_field_i32(1);
+    cfg.mutable_field_message()->set_enabled(true);
+
+    ConfigHistory history(2);
+    ASSERT_FALSE(history.current());
+    auto first = history.record(cfg, {{"/a.yml", 1}});
+    ASSERT_EQ(first->number(), 1);
+    ASSERT_EQ(first->sources().size(), 1);
+    ASSERT_EQ(first->sources()[0].hash, 1);
+    ASSERT_EQ(history.current(), first);
+    ASSERT_EQ(first->section("field_i32"), nullptr);
+    ASSERT_EQ(first->section("missing"), nullptr);
+
+    // The root only holds what isn't a section
+    const auto& root = dynamic_cast<const test_config::Config&>(first->root());
+    ASSERT_EQ(root.field_i32(), 1);
+    ASSERT_FALSE(root.has_field_message());
+
+    // Unchanged sections are shared, not copied
+    cfg.set_field_i32(2);
+    auto second = history.record(cfg, {});
+    ASSERT_EQ(second->number(), 2);
+    ASSERT_NE(second->section("field_message"), nullptr);
+    ASSERT_EQ(second->section("field_message"), first->section("field_message"));
+    ASSERT_NE(&second->root(), &first->root());
+
+    cfg.mutable_field_message()->set_enabled(false);
+    auto third = history.record(cfg, {});
+    ASSERT_NE(third->section("field_message"), second->section("field_message"));
+    ASSERT_EQ(&third->root(), &second->root());
+
+    test_config::Config rebuilt;
+    second->copy_to(&rebuilt);
+    cfg.mutable_field_message()->set_enabled(true);
+    ASSERT_TRUE(MessageDifferencer::Equals(rebuilt, cfg)) << rebuilt.DebugString();
+    ASSERT_TRUE(rebuilt.field_message().enabled());
+
+    // Versions held by readers outlive the history
+    const auto versions = history.versions();
+    ASSERT_EQ(versions.size(), 2);
+    ASSERT_EQ(versions[0]->number(), 2);
+    ASSERT_EQ(first->root().GetDescriptor(), cfg.GetDescriptor());
+}
+
+TEST(ConfigHistoryTests, Rollback) {
+    test_config::Config cfg;
+    ConfigHistory history(2);
+    ASSERT_EQ(history.rollback(), ParserResult({{"No version to roll back to"}}));
+
+    for (int i = 1; i <= 3; i++) {
+        cfg.set_field_i32(i);
+        history.record(cfg, {});
+    }
+
+    ASSERT_EQ(history.rollback(1), ParserResult({{"Version 1 is no longer in the history"}}));
+    ASSERT_EQ(history.current()->number(), 3);
+
+    ASSERT_FALSE(history.rollback());
+    ASSERT_EQ(history.current()->number(), 2);
+    ASSERT_EQ(history.rollback(), ParserResult({{"No version before 2 to roll back to"}}));
+
+    ASSERT_FALSE(history.rollback(3));
+    test_config::Config current;
+    history.current()->copy_to(&current);
+    ASSERT_EQ(current.field_i32(), 3);
+
+    // New versions are recorded after the newest one, whichever is current
+    history.rollback(2);
+    ASSERT_EQ(history.record(cfg, {})->number(), 4);
+}
+
+TEST(ConfigHistoryTests, ConcurrentRecords) {
+    ConfigHistory history(64);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&history, t] {
+            test_config::Config cfg;
+            cfg.mutable_field_message()->set_enabled(true);
+            for (int i = 0; i < 16; i++) {
+                cfg.set_field_i32(t * 100 + i);
+                history.record(cfg, {});
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // Records are serialized, every version shares the one unchanged section and follows its predecessor
+    const auto versions = history.versions();
+    ASSERT_EQ(versions.size(), 64);
+    for (size_t i = 1; i < versions.size(); i++) {
+        ASSERT_EQ(versions[i]->number(), versions[i - 1]->number() + 1);
+        ASSERT_EQ(versions[i]->section("field_message"), versions[0]->section("field_message"));
+        ASSERT_NE(&versions[i]->root(), &versions[i - 1]->root());
+    }
+}
+
+TEST(ConfigHistoryTests, Parser) {
+    const std::string good  = "field_i32: 1\nfield_message:\n  enabled: true\n";
+    const std::string other = "field_i32: 2\nfield_message:\n  enabled: true\n";
+    const std::string bad   = "field_i32: wrong\n";
+
+    ConfigHistory history(4);
+    test_config::Config cfg;
+    ASSERT_FALSE(Parser().add_buffer("/good.yml", good).set_history(&history).parse(&cfg));
+    ASSERT_FALSE(Parser().add_buffer("/good.yml", other).set_history(&history).parse(&cfg));
+    ASSERT_TRUE(Parser().add_buffer("/bad.yml", bad).set_history(&history).parse(&cfg));
+
+    // Failed parses aren't recorded
+    const auto versions = history.versions();
+    ASSERT_EQ(versions.size(), 2);
+    ASSERT_EQ(versions[0]->sources()[0].name, "/good.yml");
+    ASSERT_NE(versions[0]->sources()[0].hash, versions[1]->sources()[0].hash);
+    ASSERT_EQ(versions[0]->section("field_message"), versions[1]->section("field_message"));
+
+    ASSERT_FALSE(history.rollback());
+    history.current()->copy_to(&cfg);
+    ASSERT_EQ(cfg.field_i32(), 1);
+}
+} // namespace config_much
@@ -0,0 +1,93 @@
+#include "config-much.h"
+
+#include "proto/test-config.pb.h"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+
+namespace config_much::internal {
+
+TEST(DefaultValuesTests, Prototype) {
+    test_config::Defaults cfg;
+    cfg.set_port(1);
+    cfg.mutable_plain()->set_enabled(true);
+
+    const auto& defaults = DefaultValues::get(cfg);
+    ASSERT_EQ(&defaults, &DefaultValues::get(test_config::Defaults()));
+    ASSERT_FALSE(defaults.empty());
+    ASSERT_TRUE(defaults.errors().empty()) << defaults.errors().front();
+
+    // Whatever the message held is replaced
+    defaults.apply(&cfg, nullptr);
+    ASSERT_EQ(cfg.port(), 8080);
+    ASSERT_EQ(cfg.host(), "localhost");
+    ASSERT_EQ(cfg.timeout().seconds(), 30);
+    ASSERT_EQ(cfg.tags_size(), 2);
+    ASSERT_EQ(cfg.tags(1), "b");
+    ASSERT_EQ(cfg.kind(), test_config::TYPE2);
+    ASSERT_EQ(cfg.limits().port(), 443);
+    ASSERT_EQ(cfg.limits().name(), "edge");
+    ASSERT_TRUE(cfg.inner().enabled());
+
+    // Sub-messages without defaults stay unset
+    ASSERT_FALSE(cfg.has_plain());
+    ASSERT_FALSE(cfg.has_recursive());
+
+    ASSERT_TRUE(DefaultValues::get(test_config::Config()).empty());
+}
+
+TEST(DefaultValuesTests, Parse) {
+    const auto dir = std::filesystem::temp_directory_path() / "config-much-DefaultValuesParse";
+    std::filesystem::create_directories(dir);
+    std::ofstream(dir / "config.yml") << "port: 9090\ntags: [c]\ninner:\n  ratio: 0.5\n";
+
+    Provenance provenance;
+    Parser parser;
+    parser.add_file(dir / "config.yml").set_provenance(&provenance);
+
+    test_config::Defaults cfg;
+    ASSERT_FALSE(parser.parse(&cfg));
+    ASSERT_EQ(cfg.port(), 9090);
+    ASSERT_EQ(cfg.host(), "localhost");
+    ASSERT_EQ(cfg.tags_size(), 1);
+    ASSERT_TRUE(cfg.inner().enabled());
+    ASSERT_EQ(cfg.inner().ratio(), 0.5);
+
+    // Defaults come from the schema
+    using Origin       = Provenance::Origin;
+    const auto& schema = test_config::Defaults::descriptor()->file()->name();
+    ASSERT_EQ(provenance.find("port"), Origin({(dir / "config.yml").string(), 1}));
+    ASSERT_EQ(provenance.find("host"), Origin({schema, 0}));
+    ASSERT_EQ(provenance.find("inner.enabled"), Origin({schema, 0}));
+
+    // Reloads start over from the defaults
+    std::ofstream(dir / "config.yml") << "host: example.com\n";
+    ASSERT_FALSE(parser.parse(&cfg));
+    ASSERT_EQ(cfg.port(), 8080);
+    ASSERT_EQ(cfg.host(), "example.com");
+    ASSERT_EQ(cfg.tags_size(), 2);
+    ASSERT_EQ(provenance.find("port"), Origin({schema, 0}));
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST(DefaultValuesTests, Errors) {
+    const std::string prefix = "\"" + test_config::BrokenDefaults::descriptor()->file()->name() + ":test_config.";
+    const ParserResult expected{{
+        prefix + "BrokenDefaults.count\": yaml-cpp: error at line 1, column 8: bad conversion",
+        prefix + "BrokenDefaults.port\": port: value 70000 is above the maximum of 65535",
+    }};
+
+    // Broken defaults are left out and reported on every parse
+    Parser parser;
+    for (int i = 0; i < 2; i++) {
+        test_config::BrokenDefaults cfg;
+        ASSERT_EQ(parser.parse(&cfg), expected);
+        ASSERT_EQ(cfg.count(), 0);
+        ASSERT_TRUE(cfg.enabled());
+    }
+}
+
+} // namespace config_much::internal
@@ -0,0 +1,187 @@
+#include "config-much.h"
+
+#include "proto/test-config.pb.h"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+namespace config_much {
+
+class DeferredSectionsTests : public testing::Test {
+protected:
+    void SetUp() override {
+        dir_ = std::filesystem::temp_directory_path() /
+               ("config-much-" + std::string(testing::UnitTest::GetInstance()->current_test_info()->name()));
+        std::filesystem::create_directories(dir_);
+    }
+
+    void TearDown() override { std::filesystem::remove_all(dir_); }
+
+    std::filesystem::path write(const std::string& name, const std::string& content) {
+        auto path = dir_ / name;
+        std::ofstream(path, std::ios::binary) << content;
+        return path;
+    }
+
+    std::filesystem::path dir_;
+};
+
+TEST_F(DeferredSectionsTests, Yaml) {
+    auto first = write("first.yml", R"(
+        general:
+            enabled: true
+        routing:
+            port: 80
+            name: first
+        catalog:
+            field_i32: 1
+            field_repeated: [1, 2]
+    )");
+    auto second = write("second.yml", R"(
+        routing:
+            port: 8080
+        catalog:
+            field_repeated: [3]
+    )");
+    setenv("DEFERRED_YAML_CATALOG_FIELD_STRING", "env", 0);
+
+    DeferredSections sections;
+    Parser parser;
+    parser.add_file(first).add_file(second).set_env_var_prefix("DEFERRED_YAML").set_deferred(&sections);
+
+    test_config::Sections cfg;
+    ASSERT_FALSE(parser.parse(&cfg));
+    ASSERT_TRUE(cfg.general().enabled());
+    ASSERT_FALSE(cfg.has_routing());
+    ASSERT_FALSE(cfg.has_catalog());
+
+    const auto* routing = sections.get<test_config::Limits>("routing");
+    ASSERT_NE(routing, nullptr);
+    ASSERT_EQ(routing->port(), 8080);
+    ASSERT_EQ(routing->name(), "first");
+
+    const auto* catalog = sections.get<test_config::Config>("catalog");
+    ASSERT_NE(catalog, nullptr);
+    ASSERT_EQ(catalog->field_i32(), 1);
+    ASSERT_EQ(catalog->field_repeated_size(), 1);
+    ASSERT_EQ(catalog->field_repeated(0), 3);
+    ASSERT_EQ(catalog->field_string(), "env");
+    ASSERT_FALSE(sections.errors("catalog"));
+
+    ASSERT_EQ(sections.get("general"), nullptr);
+    ASSERT_EQ(sections.get<test_config::Config>("routing"), nullptr);
+}
+
+TEST_F(DeferredSectionsTests, Proto) {
+    test_config::Sections layer;
+    layer.mutable_general()->set_enabled(true);
+    layer.mutable_routing()->set_port(80);
+    layer.mutable_catalog()->set_field_i32(1);
+    layer.mutable_catalog()->add_field_repeated(1);
+
+    auto bin = write("config.binpb", layer.SerializeAsString());
+    auto txt = write("config.txtpb", "routing { name: \"text\" }\ncatalog { field_repeated: [2, 3] }\n");
+
+    DeferredSections sections;
+    Parser parser;
+    parser.add_file(bin).add_file(txt).set_deferred(&sections);
+
+    test_config::Sections cfg;
+    ASSERT_FALSE(parser.parse(&cfg));
+    ASSERT_TRUE(cfg.general().enabled());
+    ASSERT_FALSE(cfg.has_routing());
+    ASSERT_FALSE(cfg.has_catalog());
+
+    const auto* routing = sections.get<test_config::Limits>("routing");
+    ASSERT_EQ(routing->port(), 80);
+    ASSERT_EQ(routing->name(), "text");
+
+    const auto* catalog = sections.get<test_config::Config>("catalog");
+    ASSERT_EQ(catalog->field_i32(), 1);
+    ASSERT_EQ(catalog->field_repeated_size(), 2);
+    ASSERT_EQ(catalog->field_repeated(1), 3);
+}
+
+TEST_F(DeferredSectionsTests, Errors) {
+    auto path = write("config.yml", R"(
+        routing:
+            port: 0
+            name: valid
+    )");
+
+    DeferredSections sections;
+    Parser parser;
+    parser.add_file(path).set_deferred(&sections);
+
+    // Errors of sections only show up once they are decoded
+    test_config::Sections cfg;
+    ASSERT_FALSE(parser.parse(&cfg));
+    ASSERT_EQ(sections.errors("routing"),
+              ParserResult({{"\"" + path.string() + "\": routing.port: value 0 is below the minimum of 1"}}));
+    ASSERT_EQ(sections.errors("catalog"), ParserResult({{"Missing required field 'catalog'"}}));
+    ASSERT_EQ(sections.errors("general"), ParserResult({{"Unknown deferred section 'general'"}}));
+
+    // Without sections the same fields are decoded right away
+    parser.set_deferred(nullptr);
+    auto res = parser.parse(&cfg);
+    ASSERT_TRUE(res);
+    ASSERT_EQ(res->size(), 2);
+    ASSERT_EQ(cfg.routing().name(), "valid");
+}
+
+TEST_F(DeferredSectionsTests, Strict) {
+    auto path = write("config.yml", R"(
+        general:
+            enabled: true
+        routing:
+            name: strict
+    )");
+
+    test_config::Sections cfg;
+    DeferredSections sections;
+    sections.reset(cfg);
+
+    // Sections are decoded with the settings of the parser that deferred them
+    internal::ParserYaml parser(path, false, internal::ParserYaml::STRICT);
+    parser.set_deferred(&sections);
+    ASSERT_FALSE(parser.parse(&cfg));
+    ASSERT_EQ(sections.errors("routing"), ParserResult({{"Missing field 'routing.port'"}}));
+}
+
+TEST_F(DeferredSectionsTests, Prefetch) {
+    auto path = write("config.yml", R"(
+        routing:
+            port: 80
+            name: valid
+        catalog:
+            field_i32: 1
+    )");
+
+    DeferredSections sections;
+    Parser parser;
+    parser.add_file(path).set_deferred(&sections);
+
+    test_config::Sections cfg;
+    ASSERT_FALSE(parser.parse(&cfg));
+
+    std::vector<std::thread> threads;
+    sections.prefetch([&threads](std::function<void()> task) { threads.emplace_back(std::move(task)); });
+
+    std::vector<const google::protobuf::Message*> seen(4);
+    for (size_t i = 0; i < seen.size(); i++) {
+        threads.emplace_back([&sections, &seen, i] { seen[i] = sections.get(i % 2 == 0 ? "routing" : "catalog"); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    ASSERT_EQ(seen[0], seen[2]);
+    ASSERT_EQ(seen[1], seen[3]);
+    ASSERT_EQ(sections.get<test_config::Limits>("routing")->port(), 80);
+    ASSERT_EQ(sections.get<test_config::Config>("catalog")->field_i32(), 1);
+}
+
+} // namespace config_much
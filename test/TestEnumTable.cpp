@@ -0,0 +1,33 @@
+#include "internal/enum-table.h"
+
+#include "proto/test-config.pb.h"
+
+#include <gtest/gtest.h>
+
+namespace config_much::internal {
+
+TEST(EnumTableTests, Resolve) {
+    struct test_case {
+        std::string input;
+        std::optional<int> expected;
+    };
+
+    std::vector<test_case> tests = {
+        {"TYPE1", test_config::TYPE1}, {"TYPE2", test_config::TYPE2}, {"type2", test_config::TYPE2},
+        {"Type1", test_config::TYPE1}, {"0", test_config::TYPE1},     {"1", test_config::TYPE2},
+        {"2", {}},                     {"-1", {}},                    {"1a", {}},
+        {"TYPE3", {}},                 {"TYPE", {}},                  {"", {}},
+    };
+
+    const auto& table = EnumTable::get(test_config::EnumField_descriptor());
+    for (const auto& [input, expected] : tests) {
+        ASSERT_EQ(table.resolve(input), expected) << "Input: '" << input << "'";
+    }
+}
+
+TEST(EnumTableTests, BuiltOnce) {
+    const auto* descriptor = test_config::EnumField_descriptor();
+    ASSERT_EQ(&EnumTable::get(descriptor), &EnumTable::get(descriptor));
+}
+
+} // namespace config_much::internal
@@ -0,0 +1,31 @@
+#include "internal/field-table.h"
+
+#include "proto/test-config.pb.h"
+
+#include <gtest/gtest.h>
+
+namespace config_much::internal {
+
+TEST(FieldTableTests, Find) {
+    const auto* descriptor = test_config::Config::descriptor();
+    const auto& table      = FieldTable::get(descriptor);
+    ASSERT_EQ(&table, &FieldTable::get(descriptor));
+
+    for (int i = 0; i < descriptor->field_count(); i++) {
+        const auto* field = descriptor->field(i);
+        ASSERT_EQ(table.find(field->name()), field);
+        ASSERT_EQ(table.find(table.camel_name(field)), field);
+    }
+
+    const auto* field = descriptor->FindFieldByName("field_repeated_enum");
+    ASSERT_EQ(table.camel_name(field), "fieldRepeatedEnum");
+    for (const std::string key : {"FieldRepeatedEnum", "field-repeated-enum", "FIELD_REPEATED_ENUM"}) {
+        ASSERT_EQ(table.find(key), field) << key;
+    }
+
+    ASSERT_EQ(table.find("field_repeatedenum"), nullptr);
+    ASSERT_EQ(table.find("unknown"), nullptr);
+    ASSERT_EQ(table.find(""), nullptr);
+}
+
+} // namespace config_much::internal
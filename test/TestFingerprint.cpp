@@ -0,0 +1,114 @@
+#include "config-much.h"
+
+#include "proto/test-config.pb.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <string>
+
+namespace config_much {
+
+namespace {
+test_config::Fleet fleet(bool reversed) {
+    test_config::Fleet msg;
+    for (int i = 0; i < 100; i++) {
+        const int n = reversed ? 99 - i : i;
+        (*msg.mutable_weights())["host-" + std::to_string(n)] = n / 10.0;
+    }
+    msg.mutable_config()->set_field_i32(7);
+    msg.mutable_config()->add_field_repeated(1);
+    msg.mutable_sub()->set_enabled(true);
+    msg.add_names("a");
+    return msg;
+}
+} // namespace
+
+TEST(FingerprintTests, Canonical) {
+    const auto first  = fleet(false);
+    const auto second = fleet(true);
+    ASSERT_EQ(Fingerprint(first), Fingerprint(second));
+    ASSERT_EQ(Fingerprint(first).hex().size(), 16);
+
+    // Doesn't depend on the process or the platform
+    test_config::Config cfg;
+    cfg.set_field_i32(1);
+    cfg.set_field_string("value");
+    ASSERT_EQ(Fingerprint(cfg).hex(), "2e301bdd31c84213");
+
+    test_config::Config nan;
+    nan.set_field_double(std::nan("1"));
+    test_config::Config other_nan;
+    other_nan.set_field_double(-std::nan("2"));
+    ASSERT_EQ(Fingerprint(nan), Fingerprint(other_nan));
+
+    // Values of one field don't collide with the same values in another
+    test_config::Config moved;
+    moved.set_field_u32(1);
+    moved.set_field_string("value");
+    ASSERT_NE(Fingerprint(cfg), Fingerprint(moved));
+}
+
+TEST(FingerprintTests, Sections) {
+    auto msg                = fleet(false);
+    const Fingerprint first = Fingerprint(msg);
+    ASSERT_EQ(first.sections().size(), 2);
+    ASSERT_EQ(first.sections()[0].field->name(), "config");
+    ASSERT_TRUE(first.section("sub"));
+    ASSERT_FALSE(first.section("names"));
+    ASSERT_TRUE(first.changed(first).empty());
+
+    msg.mutable_config()->add_field_repeated(2);
+    ASSERT_NE(Fingerprint(msg), first);
+    ASSERT_EQ(Fingerprint(msg).changed(first), std::vector<std::string>{"config"});
+    ASSERT_EQ(Fingerprint(msg).section("sub"), first.section("sub"));
+
+    msg.clear_sub();
+    ASSERT_EQ(Fingerprint(msg).changed(first), (std::vector<std::string>{"config", "sub"}));
+
+    // Changes outside of sections only change the value
+    auto names = fleet(false);
+    names.add_names("b");
+    ASSERT_NE(Fingerprint(names), first);
+    ASSERT_TRUE(Fingerprint(names).changed(first).empty());
+}
+
+TEST(FingerprintTests, Incremental) {
+    // Versions only hash the sections that changed, and still match a full fingerprint
+    ConfigHistory history(2);
+    auto msg = fleet(false);
+    ASSERT_EQ(history.record(msg, {})->fingerprint(), Fingerprint(msg));
+
+    msg.add_names("b");
+    auto version = history.record(msg, {});
+    ASSERT_EQ(version->fingerprint(), Fingerprint(msg));
+    ASSERT_EQ(version->fingerprint().sections().size(), 2);
+
+    msg.mutable_sub()->set_enabled(false);
+    ASSERT_EQ(history.record(msg, {})->fingerprint(), Fingerprint(msg));
+    msg.clear_config();
+    ASSERT_EQ(history.record(msg, {})->fingerprint(), Fingerprint(msg));
+}
+
+TEST(FingerprintTests, Parser) {
+    const std::string first  = "field_i32: 1\nfield_message:\n  enabled: true\nfield_repeated: [1, 2]\n";
+    const std::string second = "field_repeated: [1, 2]\nfield_message: {enabled: true}\nfield_i32: 1\n";
+
+    AtomicSnapshot<Fingerprint> fingerprint;
+    AtomicSnapshot<Fingerprint> incremental;
+    ConfigHistory history(2);
+
+    test_config::Config cfg;
+    ASSERT_FALSE(Parser().add_buffer("/first.yml", first).set_fingerprint(&fingerprint).parse(&cfg));
+    const auto published = fingerprint.load();
+    ASSERT_EQ(*published, Fingerprint(cfg));
+
+    // The same configuration written differently has the same fingerprint
+    test_config::Config other;
+    Parser parser;
+    parser.add_buffer("/second.yml", second).set_fingerprint(&incremental).set_history(&history);
+    ASSERT_FALSE(parser.parse(&other));
+    ASSERT_EQ(*incremental.load(), *published);
+    ASSERT_EQ(incremental.load()->section("field_message"), published->section("field_message"));
+}
+} // namespace config_much
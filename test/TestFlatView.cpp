@@ -0,0 +1,161 @@
+#include "config-much.h"
+
+#include "proto/test-config.pb.h"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+
+namespace config_much {
+
+TEST(FlatViewTests, Get) {
+    test_config::Config cfg;
+    cfg.set_enabled(true);
+    cfg.set_field_i32(-32);
+    cfg.set_field_u32(32);
+    cfg.set_field_i64(-64);
+    cfg.set_field_u64(64);
+    cfg.set_field_double(0.5);
+    cfg.set_field_float(1.5F);
+    cfg.set_field_string("value");
+    cfg.mutable_field_message()->set_enabled(true);
+    cfg.set_field_enum(test_config::TYPE2);
+    cfg.add_field_repeated(1);
+
+    FlatView view(cfg);
+    ASSERT_EQ(view.size(), 10);
+    ASSERT_EQ(view.get<bool>("enabled"), true);
+    ASSERT_EQ(view.get<int32_t>("field_i32"), -32);
+    ASSERT_EQ(view.get<uint32_t>("field_u32"), 32);
+    ASSERT_EQ(view.get<int64_t>("field_i64"), -64);
+    ASSERT_EQ(view.get<uint64_t>("field_u64"), 64);
+    ASSERT_EQ(view.get<double>("field_double"), 0.5);
+    ASSERT_EQ(view.get<float>("field_float"), 1.5F);
+    ASSERT_EQ(view.get<std::string_view>("field_string"), "value");
+    ASSERT_EQ(view.get<bool>("field_message.enabled"), true);
+    ASSERT_EQ(view.get<int32_t>("field_enum"), test_config::TYPE2);
+
+    // Wrong types, repeated fields and unknown paths
+    ASSERT_EQ(view.get<int64_t>("field_i32"), std::nullopt);
+    ASSERT_EQ(view.get<uint64_t>("field_repeated"), std::nullopt);
+    ASSERT_EQ(view.get<bool>("field_message"), std::nullopt);
+    ASSERT_EQ(view.get<bool>("missing"), std::nullopt);
+    ASSERT_EQ(view.get<bool>(""), std::nullopt);
+}
+
+TEST(FlatViewTests, Defaults) {
+    test_config::WellKnown cfg;
+    cfg.mutable_timeout()->set_seconds(30);
+
+    FlatView view(cfg);
+    ASSERT_EQ(view.get<int64_t>("timeout.seconds"), 30);
+    ASSERT_EQ(view.get<int32_t>("timeout.nanos"), 0);
+    ASSERT_EQ(view.get<int64_t>("deadline.seconds"), 0);
+}
+
+TEST(FlatViewTests, FixedOffsets) {
+    test_config::Config first;
+    first.set_field_string("short");
+    first.set_field_u64(1);
+
+    test_config::Config second;
+    second.set_field_string(std::string(1000, 'x'));
+    second.set_field_u64(2);
+
+    // Strings come after every scalar, whatever their length
+    FlatView a(first);
+    FlatView b(second);
+    ASSERT_EQ(a.blob().find(std::string_view("short")), b.blob().find(std::string(1000, 'x')));
+}
+
+TEST(FlatViewTests, ManyPaths) {
+    // Descriptors make for a large, deeply nested and recursive message
+    google::protobuf::FileDescriptorProto proto;
+    test_config::Config::descriptor()->file()->CopyTo(&proto);
+    FlatView view(proto);
+    ASSERT_EQ(view.get<std::string_view>("name"), proto.name());
+    ASSERT_EQ(view.get<bool>("options.java_multiple_files"), false);
+    ASSERT_GT(view.size(), 20);
+}
+
+TEST(FlatViewTests, Indexes) {
+    test_config::Lists lists;
+    lists.add_hosts("a.example.com");
+    lists.add_tenants(42);
+    lists.add_offsets(-1);
+    lists.add_plain("not indexed");
+    lists.mutable_inner()->add_hosts("inner.example.com");
+
+    FlatView view(lists);
+    ASSERT_EQ(view.size(), 0);
+    ASSERT_TRUE(view.contains("hosts", "a.example.com"));
+    ASSERT_FALSE(view.contains("hosts", "b.example.com"));
+    ASSERT_TRUE(view.contains("tenants", 42));
+    ASSERT_TRUE(view.contains("offsets", -1));
+    ASSERT_TRUE(view.contains("inner.hosts", "inner.example.com"));
+    ASSERT_FALSE(view.contains("inner.inner.hosts", "inner.example.com"));
+
+    ASSERT_EQ(view.index("hosts")->kind(), MembershipIndex::HASH);
+    ASSERT_EQ(view.index("tenants")->kind(), MembershipIndex::SORTED);
+    ASSERT_EQ(view.index("offsets")->kind(), MembershipIndex::BLOOM);
+
+    // Fields without an index, and indexes aren't values
+    ASSERT_EQ(view.index("plain"), nullptr);
+    ASSERT_FALSE(view.contains("plain", "not indexed"));
+    ASSERT_EQ(view.get<std::string_view>("hosts"), std::nullopt);
+    ASSERT_EQ(view.index("missing"), nullptr);
+    ASSERT_TRUE(view.errors().empty());
+}
+
+TEST(FlatViewTests, UnsupportedIndexes) {
+    test_config::BadIndexes bad;
+    bad.add_ratios(0.5);
+    bad.add_hosts("a.example.com");
+
+    FlatView view(bad);
+    ASSERT_EQ(view.errors(), std::vector<ParserError>({
+                                 "Field 'ratios' of type repeated double can't have an index",
+                                 "Field 'host' of type string can't have an index",
+                                 "Field 'subs' of type repeated message can't have an index",
+                             }));
+    ASSERT_EQ(view.index("ratios"), nullptr);
+    ASSERT_EQ(view.index("subs"), nullptr);
+    ASSERT_TRUE(view.contains("hosts", "a.example.com"));
+
+    // The parser fails rather than publishing a view missing indexes
+    AtomicSnapshot<FlatView> snapshot;
+    ASSERT_EQ(Parser().add_buffer("/bad.yml", "ratios: [0.5]\n").set_flat_view(&snapshot).parse(&bad),
+              ParserResult(view.errors()));
+    ASSERT_EQ(snapshot.load(), nullptr);
+}
+
+TEST(FlatViewTests, Publish) {
+    const auto dir = std::filesystem::temp_directory_path() / "config-much-FlatViewPublish";
+    std::filesystem::create_directories(dir);
+    std::ofstream(dir / "config.yml") << "field_i32: 1\n";
+
+    AtomicSnapshot<FlatView> snapshot;
+    Parser parser;
+    parser.add_file(dir / "config.yml").set_flat_view(&snapshot);
+    ASSERT_EQ(snapshot.load(), nullptr);
+
+    test_config::Config cfg;
+    ASSERT_FALSE(parser.parse(&cfg));
+    auto first = snapshot.load();
+    ASSERT_EQ(first->get<int32_t>("field_i32"), 1);
+
+    // A failed parse keeps the last good view
+    std::ofstream(dir / "config.yml") << "field_i32: [\n";
+    ASSERT_TRUE(parser.parse(&cfg));
+    ASSERT_EQ(snapshot.load(), first);
+
+    std::ofstream(dir / "config.yml") << "field_i32: 2\n";
+    ASSERT_FALSE(parser.parse(&cfg));
+    ASSERT_EQ(snapshot.load()->get<int32_t>("field_i32"), 2);
+    ASSERT_EQ(first->get<int32_t>("field_i32"), 1);
+
+    std::filesystem::remove_all(dir);
+}
+
+} // namespace config_much
@@ -0,0 +1,85 @@
+#include "internal/membership-index.h"
+
+#include "proto/test-config.pb.h"
+
+#include <gtest/gtest.h>
+
+namespace config_much {
+
+namespace {
+const MembershipIndex::Kind KINDS[] = {MembershipIndex::SORTED, MembershipIndex::HASH, MembershipIndex::BLOOM};
+
+const google::protobuf::FieldDescriptor* field(const std::string& name) {
+    return test_config::Lists::descriptor()->FindFieldByName(name);
+}
+} // namespace
+
+TEST(MembershipIndexTests, Strings) {
+    test_config::Lists lists;
+    for (int i = 0; i < 1000; i++) {
+        lists.add_hosts("host-" + std::to_string(i * 2));
+    }
+    lists.add_hosts("host-0");
+    lists.add_hosts("");
+
+    for (auto kind : KINDS) {
+        const MembershipIndex index(lists, field("hosts"), kind);
+        ASSERT_EQ(index.kind(), kind);
+        ASSERT_EQ(index.size(), 1001);
+
+        for (int i = 0; i < 2000; i++) {
+            ASSERT_EQ(index.contains("host-" + std::to_string(i)), i % 2 == 0) << kind << " " << i;
+        }
+        ASSERT_TRUE(index.contains(""));
+        ASSERT_FALSE(index.contains("host-"));
+        ASSERT_FALSE(index.contains(uint64_t{0}));
+    }
+    ASSERT_TRUE(MembershipIndex::supports(field("hosts")));
+    ASSERT_TRUE(MembershipIndex::supports(field("offsets")));
+    ASSERT_FALSE(MembershipIndex::supports(field("inner")));
+}
+
+TEST(MembershipIndexTests, Integers) {
+    test_config::Lists lists;
+    for (uint64_t i = 0; i < 1000; i++) {
+        lists.add_tenants(i * 3);
+        lists.add_offsets(static_cast<int32_t>(i) - 500);
+    }
+    lists.add_tenants(UINT64_MAX);
+
+    for (auto kind : KINDS) {
+        const MembershipIndex tenants(lists, field("tenants"), kind);
+        ASSERT_EQ(tenants.size(), 1001);
+        for (uint64_t i = 0; i < 3000; i++) {
+            ASSERT_EQ(tenants.contains(i), i % 3 == 0) << kind << " " << i;
+        }
+        ASSERT_TRUE(tenants.contains(UINT64_MAX));
+        ASSERT_FALSE(tenants.contains("0"));
+
+        // Negative values of narrower fields are sign extended
+        const MembershipIndex offsets(lists, field("offsets"), kind);
+        ASSERT_TRUE(offsets.contains(-500));
+        ASSERT_TRUE(offsets.contains(499));
+        ASSERT_FALSE(offsets.contains(500));
+        ASSERT_FALSE(offsets.contains(uint64_t{UINT32_MAX}));
+    }
+}
+
+TEST(MembershipIndexTests, Empty) {
+    test_config::Lists lists;
+    for (auto kind : KINDS) {
+        ASSERT_FALSE(MembershipIndex(lists, field("hosts"), kind).contains(""));
+        ASSERT_FALSE(MembershipIndex(lists, field("tenants"), kind).contains(uint64_t{0}));
+
+        // Unsupported types hold nothing
+        lists.mutable_inner();
+        const MembershipIndex index(lists, field("inner"), kind);
+        ASSERT_EQ(index.size(), 0);
+        ASSERT_FALSE(index.contains(uint64_t{0}));
+    }
+    ASSERT_TRUE(MembershipIndex::supports(field("hosts")));
+    ASSERT_TRUE(MembershipIndex::supports(field("offsets")));
+    ASSERT_FALSE(MembershipIndex::supports(field("inner")));
+}
+
+} // namespace config_much
@@ -0,0 +1,113 @@
+#include "config-much.h"
+
+#include "proto/test-config.pb.h"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+
+namespace config_much {
+using namespace std::chrono_literals;
+
+TEST(MetricsTests, HistogramBuckets) {
+    Metrics::Histogram histogram;
+    histogram.observe(0ns);
+    histogram.observe(1us);
+    histogram.observe(1001ns);
+    histogram.observe(3ms);
+    histogram.observe(1h);
+
+    ASSERT_EQ(histogram.count(), 5);
+    ASSERT_EQ(histogram.bucket(0), 2);
+    ASSERT_EQ(histogram.bucket(1), 1);
+    ASSERT_EQ(histogram.bucket(12), 1); // 3000us <= 4096us
+    ASSERT_EQ(histogram.bucket(Metrics::Histogram::BUCKETS), 1);
+    ASSERT_DOUBLE_EQ(Metrics::Histogram::bound(0), 1e-6);
+    ASSERT_DOUBLE_EQ(Metrics::Histogram::bound(10), 1024e-6);
+    ASSERT_NEAR(histogram.sum(), 3600.003002001, 1e-9);
+}
+
+TEST(MetricsTests, Parser) {
+    const auto dir = std::filesystem::temp_directory_path() / "config-much-Metrics";
+    std::filesystem::create_directories(dir);
+    const std::string content = "field_i32: 32\nfield_message:\n  enabled: true\n";
+    std::ofstream(dir / "config.yml") << content;
+    std::ofstream(dir / "broken.yml") << "field_i32: [\n";
+
+    setenv("METRICS_FIELD_U32", "7", 0);
+
+    Metrics metrics;
+    Parser parser;
+    parser.add_file(dir / "config.yml").set_env_var_prefix("METRICS").set_metrics(&metrics);
+
+    test_config::Config cfg;
+    ASSERT_FALSE(parser.parse(&cfg));
+    ASSERT_FALSE(parser.parse(&cfg));
+
+    parser.add_file(dir / "broken.yml");
+    ASSERT_TRUE(parser.parse(&cfg));
+
+    ASSERT_EQ(metrics.parses(), 3);
+    ASSERT_EQ(metrics.failures(), 1);
+    ASSERT_EQ(metrics.errors(Metrics::FILE), 1);
+    ASSERT_EQ(metrics.errors(Metrics::ENV), 0);
+    ASSERT_EQ(metrics.latency().count(), 3);
+
+    auto& config = metrics.source((dir / "config.yml").string());
+    ASSERT_EQ(config.bytes, 3 * content.size());
+    ASSERT_EQ(config.latency.count(), 3);
+    ASSERT_EQ(metrics.source((dir / "broken.yml").string()).errors, 1);
+    ASSERT_EQ(metrics.source("METRICS_*").latency.count(), 3);
+
+    const std::string text = metrics.prometheus();
+    ASSERT_NE(text.find("# TYPE config_much_parses_total counter\nconfig_much_parses_total 3\n"), std::string::npos)
+        << text;
+    ASSERT_NE(text.find("config_much_parse_errors_total{kind=\"file\"} 1\n"), std::string::npos);
+    ASSERT_NE(text.find("config_much_parse_duration_seconds_bucket{le=\"+Inf\"} 3\n"), std::string::npos);
+    ASSERT_NE(text.find("config_much_source_bytes_total{source=\"" + (dir / "config.yml").string() + "\"} " +
+                        std::to_string(3 * content.size()) + "\n"),
+              std::string::npos);
+    ASSERT_NE(text.find("config_much_source_duration_seconds_count{source=\"METRICS_*\"} 3\n"), std::string::npos);
+    ASSERT_NE(text.find("config_much_message_field_bytes{field=\"field_message\"} "), std::string::npos);
+    ASSERT_TRUE(cfg.field_message().enabled());
+
+    // Each family is announced once
+    size_t types = 0;
+    metrics.collect([&types, last = std::string_view()](const Metrics::Sample& sample) mutable {
+        types += sample.family != last ? 1 : 0;
+        last = sample.family;
+    });
+    ASSERT_EQ(types, 9);
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST(MetricsTests, Measure) {
+    test_config::Config cfg;
+    cfg.set_field_string(std::string(1000, 'x'));
+    cfg.add_field_repeated(1);
+    cfg.mutable_field_message()->set_enabled(true);
+    const size_t total = cfg.SpaceUsedLong();
+    const size_t field = cfg.field_message().SpaceUsedLong();
+
+    // Walked once, the sizes add up to what SpaceUsedLong gives
+    Metrics metrics;
+    metrics.measure(&cfg);
+    const std::string text = metrics.prometheus();
+    ASSERT_NE(text.find("config_much_message_bytes " + std::to_string(total) + "\n"), std::string::npos) << text;
+    ASSERT_NE(text.find("config_much_message_field_bytes{field=\"field_message\"} " + std::to_string(field) + "\n"),
+              std::string::npos)
+        << text;
+    ASSERT_TRUE(cfg.has_field_message());
+    ASSERT_TRUE(cfg.field_message().enabled());
+    ASSERT_EQ(cfg.SpaceUsedLong(), total);
+}
+
+TEST(MetricsTests, LabelEscaping) {
+    Metrics metrics;
+    metrics.source("a \"quoted\"\\name\n").bytes = 1;
+    ASSERT_NE(metrics.prometheus().find("{source=\"a \\\"quoted\\\"\\\\name\\n\"} 1\n"), std::string::npos);
+}
+
+} // namespace config_much
@@ -0,0 +1,346 @@
+#include "config-much.h"
+
+#include "proto/test-config.pb.h"
+
+#include <google/protobuf/util/message_differencer.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+namespace config_much {
+using namespace google::protobuf::util;
+
+class ParserTests : public testing::Test {
+protected:
+    void SetUp() override {
+        dir_ = std::filesystem::temp_directory_path() /
+               ("config-much-" + std::string(testing::UnitTest::GetInstance()->current_test_info()->name()));
+        std::filesystem::create_directories(dir_);
+
+        write("first.yml", R"(
+            enabled: true
+            field_i32: -32
+            field_repeated:
+                - 1
+                - 2
+        )");
+        write("second.yml", R"(
+            field_i32: 32
+            field_string: second
+        )");
+    }
+
+    void TearDown() override { std::filesystem::remove_all(dir_); }
+
+    std::filesystem::path write(const std::string& name, const std::string& content) {
+        auto path = dir_ / name;
+        std::ofstream(path) << content;
+        return path;
+    }
+
+    static test_config::Config expected() {
+        test_config::Config cfg;
+        cfg.set_enabled(true);
+        cfg.set_field_i32(32);
+        cfg.add_field_repeated(1);
+        cfg.add_field_repeated(2);
+        cfg.set_field_string("second");
+        return cfg;
+    }
+
+    std::filesystem::path dir_;
+};
+
+TEST_F(ParserTests, ParseAsync) {
+    Parser parser;
+    parser.add_file(dir_ / "first.yml").add_file(dir_ / "second.yml");
+
+    test_config::Config parsed;
+    auto future = parser.parse_async(&parsed, thread_executor());
+    auto res    = future.get();
+    ASSERT_FALSE(res) << res->front();
+
+    const auto cfg = expected();
+    ASSERT_TRUE(MessageDifferencer::Equals(parsed, cfg)) << "### parsed: " << std::endl
+                                                         << parsed.DebugString() << std::endl
+                                                         << "### expected: " << std::endl
+                                                         << cfg.DebugString();
+}
+
+TEST_F(ParserTests, ParseAsyncRunsOnExecutor) {
+    std::vector<std::function<void()>> queue;
+    Executor executor = [&queue](std::function<void()> task) { queue.emplace_back(std::move(task)); };
+
+    Parser parser;
+    parser.add_file(dir_ / "first.yml").add_file(dir_ / "second.yml");
+
+    test_config::Config parsed;
+    auto future = parser.parse_async(&parsed, executor);
+    ASSERT_EQ(queue.size(), 1);
+    ASSERT_EQ(future.wait_for(std::chrono::seconds(0)), std::future_status::timeout);
+
+    queue.front()();
+    ASSERT_EQ(future.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+    ASSERT_FALSE(future.get());
+    ASSERT_TRUE(MessageDifferencer::Equals(parsed, expected()));
+}
+
+TEST_F(ParserTests, ParseAsyncThrows) {
+    class ThrowingSource : public ByteSource {
+    public:
+        ThrowingSource() : ByteSource("/throwing.yml") {}
+        std::optional<ParserError> load() override { throw std::runtime_error("source failed"); }
+        std::string_view data() const override { return {}; }
+    };
+
+    Parser parser;
+    parser.add_source(std::make_unique<ThrowingSource>());
+
+    // The exception reaches whoever waits on the future, not the executor
+    test_config::Config parsed;
+    auto future = parser.parse_async(&parsed, inline_executor());
+    ASSERT_EQ(future.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+    ASSERT_THROW(future.get(), std::runtime_error);
+}
+
+TEST_F(ParserTests, ParseAsyncCancelled) {
+    Parser parser;
+    parser.add_file(dir_ / "first.yml").add_file(dir_ / "second.yml");
+
+    auto cancelled = std::make_shared<std::atomic_bool>(true);
+    test_config::Config parsed;
+    auto res = parser.parse_async(&parsed, inline_executor(), cancelled).get();
+
+    const ParserResult expected{{"Parse cancelled"}};
+    ASSERT_EQ(res, expected);
+    ASSERT_TRUE(MessageDifferencer::Equals(parsed, test_config::Config{}));
+}
+
+TEST_F(ParserTests, Provenance) {
+    const auto third = write("third.yml", "field_enum: TYPE2\nfield_message:\n  enabled: true\n");
+    setenv("PROVENANCE_FIELD_U32", "7", 0);
+    setenv("PROVENANCE_FIELD_MESSAGE_ENABLED", "false", 0);
+    setenv("PROVENANCE_FIELD_REPEATED_0", "5", 0);
+
+    Provenance provenance;
+    Parser parser;
+    parser.add_file(dir_ / "first.yml")
+        .add_file(dir_ / "second.yml")
+        .add_file(third)
+        .set_env_var_prefix("PROVENANCE")
+        .set_provenance(&provenance);
+
+    test_config::Config parsed;
+    ASSERT_FALSE(parser.parse(&parsed));
+
+    using Origin = Provenance::Origin;
+    ASSERT_EQ(provenance.find("enabled"), Origin({(dir_ / "first.yml").string(), 2}));
+    ASSERT_EQ(provenance.find("field_i32"), Origin({(dir_ / "second.yml").string(), 2}));
+    ASSERT_EQ(provenance.find("field_string"), Origin({(dir_ / "second.yml").string(), 3}));
+    ASSERT_EQ(provenance.find("field_enum"), Origin({third.string(), 1}));
+    ASSERT_EQ(provenance.find("field_u32"), Origin({"PROVENANCE_FIELD_U32", 0}));
+    ASSERT_EQ(provenance.find("field_message.enabled"), Origin({"PROVENANCE_FIELD_MESSAGE_ENABLED", 0}));
+    ASSERT_EQ(provenance.find("field_repeated"), Origin({"PROVENANCE_FIELD_REPEATED_0", 0}));
+    ASSERT_FALSE(provenance.find("field_double"));
+    ASSERT_FALSE(provenance.find("field_message"));
+
+    // Entries don't leak from one parse to the next
+    parser.set_env_var_prefix("NOT_SET");
+    ASSERT_FALSE(parser.parse(&parsed));
+    ASSERT_EQ(provenance.find("field_u32"), std::nullopt);
+    ASSERT_EQ(provenance.find("field_message.enabled"), Origin({third.string(), 3}));
+}
+
+TEST_F(ParserTests, ProvenanceRepeated) {
+    std::string content = "field_repeated:\n";
+    for (int i = 0; i < 10000; i++) {
+        content += "  - " + std::to_string(i) + "\n";
+    }
+
+    Provenance provenance;
+    internal::ParserYaml parser(write("repeated.yml", content));
+    parser.set_provenance(&provenance);
+
+    test_config::Config parsed;
+    ASSERT_FALSE(parser.parse(&parsed));
+    ASSERT_EQ(parsed.field_repeated_size(), 10000);
+    ASSERT_EQ(provenance.size(), 1);
+    ASSERT_EQ(provenance.find("field_repeated"), Provenance::Origin({(dir_ / "repeated.yml").string(), 2}));
+}
+
+TEST_F(ParserTests, Overlay) {
+    write("third.yml", "field_repeated: [3]\nfield_message:\n  enabled: true\nfield_u32: 3\n");
+    write("middle.txtpb", "field_u32: 9 field_string: \"middle\"");
+    write("last.yml", "field_message: {}\nfield_double: 1.5\n");
+    setenv("OVERLAY_FIELD_ENUM", "TYPE2", 0);
+
+    auto parse = [this](bool overlay, Provenance* provenance) {
+        Parser parser;
+        parser.add_file(dir_ / "first.yml")
+            .add_file(dir_ / "second.yml")
+            .add_file(dir_ / "third.yml")
+            .add_file(dir_ / "middle.txtpb")
+            .add_file(dir_ / "last.yml")
+            .set_env_var_prefix("OVERLAY")
+            .set_provenance(provenance)
+            .set_overlay(overlay);
+
+        test_config::Config parsed;
+        EXPECT_FALSE(parser.parse(&parsed));
+        return parsed;
+    };
+
+    Provenance expected_origins;
+    Provenance origins;
+    const auto expected = parse(false, &expected_origins);
+    const auto parsed   = parse(true, &origins);
+    ASSERT_TRUE(MessageDifferencer::Equals(parsed, expected)) << parsed.DebugString() << expected.DebugString();
+    ASSERT_EQ(parsed.field_u32(), 9);
+    ASSERT_EQ(parsed.field_repeated_size(), 1);
+
+    ASSERT_EQ(origins.size(), expected_origins.size());
+    for (const std::string path : {"enabled", "field_i32", "field_string", "field_repeated", "field_message.enabled",
+                                   "field_u32", "field_double", "field_enum"}) {
+        ASSERT_EQ(origins.find(path), expected_origins.find(path)) << path;
+    }
+    ASSERT_EQ(origins.find("field_i32"), Provenance::Origin({(dir_ / "second.yml").string(), 2}));
+}
+
+TEST_F(ParserTests, OverlayErrors) {
+    write("bad.yml", "field_i32: wrong\nfield_u32: wrong\n");
+    write("fix.yml", "field_i32: 1\n");
+    write("blob.bin", "blob");
+    std::filesystem::create_directories(dir_ / "sub");
+    write("sub/blob.bin", "sub");
+    write("sub/blobs.yml", "data: file:blob.bin\n");
+
+    Parser parser;
+    parser.add_file(dir_ / "bad.yml").add_file(dir_ / "fix.yml").set_overlay(true);
+
+    // Only the value that wins is decoded
+    test_config::Config cfg;
+    const ParserResult expected{{
+        "\"" + (dir_ / "bad.yml").string() + "\": yaml-cpp: error at line 2, column 12: bad conversion",
+    }};
+    ASSERT_EQ(parser.parse(&cfg), expected);
+    ASSERT_EQ(cfg.field_i32(), 1);
+
+    // File references are relative to the file that holds them
+    Parser blobs;
+    blobs.add_file(dir_ / "first.yml").add_file(dir_ / "sub/blobs.yml").set_overlay(true);
+    test_config::Blobs parsed;
+    ASSERT_FALSE(blobs.parse(&parsed));
+    ASSERT_EQ(parsed.data(), "sub");
+}
+
+TEST_F(ParserTests, MemoryBudget) {
+    const std::string large = "field_string: " + std::string(4096, 'x') + "\n";
+    Parser parser;
+    parser.add_buffer("/small.yml", "field_i32: 1\n")
+        .add_buffer("/large.yml", large)
+        .add_buffer("/never.yml", "field_i32: 3\n")
+        .set_memory_budget(2048);
+
+    // The parse stops at the source that goes over budget, later ones aren't read
+    test_config::Config cfg;
+    ASSERT_EQ(parser.parse(&cfg), ParserResult({{"Memory budget of 2048 bytes exceeded while parsing /large.yml"}}));
+    ASSERT_EQ(cfg.field_i32(), 1);
+    ASSERT_TRUE(cfg.field_string().empty());
+
+    ASSERT_FALSE(parser.set_memory_budget(0).parse(&cfg));
+    ASSERT_EQ(cfg.field_i32(), 3);
+}
+
+TEST_F(ParserTests, MemoryBudgetOverlay) {
+    const std::string large = "field_string: " + std::string(4096, 'x') + "\n";
+    Parser parser;
+    parser.add_buffer("/small.yml", "field_i32: 1\n").add_buffer("/large.yml", large).set_overlay(true);
+    parser.set_memory_budget(2048);
+
+    // Overlaid files are decoded together, the error names all of them
+    test_config::Config cfg;
+    const ParserResult expected{{"Memory budget of 2048 bytes exceeded while parsing /small.yml, /large.yml"}};
+    ASSERT_EQ(parser.parse(&cfg), expected);
+}
+
+TEST_F(ParserTests, MemoryBudgetWithinFile) {
+    std::string large = "field_i32: 1\nfield_repeated: [0";
+    for (int i = 1; i < 10000; i++) {
+        large += ", " + std::to_string(i);
+    }
+    large += "]\nfield_enum: TYPE2\n";
+
+    // The file fits, decoding all of it doesn't
+    Parser parser;
+    parser.add_buffer("/large.yml", large).set_memory_budget(2 * large.size());
+
+    test_config::Config cfg;
+    const std::string error =
+        "Memory budget of " + std::to_string(2 * large.size()) + " bytes exceeded while parsing /large.yml";
+    ASSERT_EQ(parser.parse(&cfg), ParserResult({{error}}));
+    ASSERT_EQ(cfg.field_i32(), 1);
+    ASSERT_GT(cfg.field_repeated_size(), 0);
+    ASSERT_LT(cfg.field_repeated_size(), 10000);
+    ASSERT_EQ(cfg.field_enum(), test_config::TYPE1);
+}
+
+TEST_F(ParserTests, ArenaBuffer) {
+    // Any block the arena asks for beyond the caller's buffer is counted
+    static int allocations = 0;
+    alignas(8) static char buffer[16 * 1024];
+
+    google::protobuf::ArenaOptions options;
+    options.initial_block      = buffer;
+    options.initial_block_size = sizeof(buffer);
+    options.block_alloc        = [](size_t size) {
+        allocations++;
+        return ::operator new(size);
+    };
+    options.block_dealloc = [](void* block, size_t) { ::operator delete(block); };
+
+    Parser parser;
+    parser.add_file(dir_ / "first.yml").add_file(dir_ / "second.yml").set_memory_budget(sizeof(buffer));
+    {
+        google::protobuf::Arena arena(options);
+        auto* cfg = google::protobuf::Arena::CreateMessage<test_config::Config>(&arena);
+        ASSERT_FALSE(parser.parse(cfg));
+        ASSERT_TRUE(MessageDifferencer::Equals(*cfg, expected()));
+    }
+    ASSERT_EQ(allocations, 0);
+}
+
+TEST_F(ParserTests, ArenaBufferFailingAllocator) {
+    // The arena can't grow past the caller's buffer, the budget must stop the parse first
+    static bool grown = false;
+    alignas(8) static char buffer[64 * 1024];
+
+    google::protobuf::ArenaOptions options;
+    options.initial_block      = buffer;
+    options.initial_block_size = sizeof(buffer);
+    options.block_alloc        = [](size_t) -> void* {
+        grown = true;
+        std::abort();
+    };
+    options.block_dealloc = [](void*, size_t) {};
+
+    std::string large = "field_repeated: [0";
+    for (int i = 1; i < 30000; i++) {
+        large += ", " + std::to_string(i);
+    }
+    large += "]\n";
+
+    Parser parser;
+    parser.add_buffer("/large.yml", large).set_memory_budget(large.size() + sizeof(buffer));
+
+    google::protobuf::Arena arena(options);
+    auto* cfg = google::protobuf::Arena::CreateMessage<test_config::Config>(&arena);
+    ASSERT_TRUE(parser.parse(cfg));
+    ASSERT_FALSE(grown);
+    ASSERT_LT(cfg->field_repeated_size(), 30000);
+}
+} // namespace config_much
@@ -71,4 +71,74 @@ TEST(ParserEnvTests, Parsing) {
                         << "### expected: " << std::endl
                         << expected.DebugString();
 }
+
+TEST(ParserEnvTests, InvalidEnum) {
+    setenv("INVALID_ENUM_FIELD_ENUM", "NOT_REAL", 0);
+    setenv("INVALID_ENUM_FIELD_REPEATED_ENUM_0", "type2", 0);
+    setenv("INVALID_ENUM_FIELD_REPEATED_ENUM_1", "ALSO_INVALID", 0);
+    setenv("INVALID_ENUM_FIELD_REPEATED_ENUM_2", "0", 0);
+
+    const ParserResult expected{{
+        "INVALID_ENUM_FIELD_ENUM: Invalid enum value 'NOT_REAL' for field field_enum",
+        "INVALID_ENUM_FIELD_REPEATED_ENUM_1: Invalid enum value 'ALSO_INVALID' for field field_repeated_enum",
+    }};
+
+    test_config::Config parsed;
+    auto res = ParserEnv{"INVALID_ENUM"}.parse(&parsed);
+    ASSERT_EQ(res, expected);
+
+    ASSERT_EQ(parsed.field_repeated_enum_size(), 2);
+    ASSERT_EQ(parsed.field_repeated_enum(0), test_config::TYPE2);
+    ASSERT_EQ(parsed.field_repeated_enum(1), test_config::TYPE1);
+}
+
+TEST(ParserEnvTests, InvalidValues) {
+    setenv("INVALID_VALUE_ENABLED", "maybe", 0);
+    setenv("INVALID_VALUE_FIELD_I32", "12abc", 0);
+    setenv("INVALID_VALUE_FIELD_U32", "-1", 0);
+    setenv("INVALID_VALUE_FIELD_I64", "99999999999999999999", 0);
+    setenv("INVALID_VALUE_FIELD_DOUBLE", "", 0);
+    setenv("INVALID_VALUE_FIELD_FLOAT", "+1.5", 0);
+    setenv("INVALID_VALUE_FIELD_REPEATED_0", "1", 0);
+    setenv("INVALID_VALUE_FIELD_REPEATED_1", "two", 0);
+    setenv("INVALID_VALUE_FIELD_REPEATED_2", "3", 0);
+
+    // Nothing throws, every invalid value is reported and the valid ones are kept
+    const ParserResult expected{{
+        "INVALID_VALUE_ENABLED: Invalid value 'maybe' for field enabled",
+        "INVALID_VALUE_FIELD_I32: Invalid value '12abc' for field field_i32",
+        "INVALID_VALUE_FIELD_U32: Invalid value '-1' for field field_u32",
+        "INVALID_VALUE_FIELD_I64: Invalid value '99999999999999999999' for field field_i64",
+        "INVALID_VALUE_FIELD_DOUBLE: Invalid value '' for field field_double",
+        "INVALID_VALUE_FIELD_REPEATED_1: Invalid value 'two' for field field_repeated",
+    }};
+
+    test_config::Config parsed;
+    ASSERT_EQ(ParserEnv{"INVALID_VALUE"}.parse(&parsed), expected);
+    ASSERT_EQ(parsed.field_i32(), 0);
+    ASSERT_EQ(parsed.field_float(), 1.5F);
+    ASSERT_EQ(parsed.field_repeated_size(), 2);
+    ASSERT_EQ(parsed.field_repeated(1), 3);
+}
+
+TEST(ParserEnvTests, WellKnownTypes) {
+    setenv("WELL_KNOWN_TIMEOUT", "250ms", 0);
+    setenv("WELL_KNOWN_DEADLINE_SECONDS", "1709209800", 0);
+
+    test_config::WellKnown parsed;
+    auto res = ParserEnv{"WELL_KNOWN"}.parse(&parsed);
+    ASSERT_FALSE(res);
+    ASSERT_EQ(parsed.timeout().seconds(), 0);
+    ASSERT_EQ(parsed.timeout().nanos(), 250000000);
+    ASSERT_EQ(parsed.deadline().seconds(), 1709209800);
+
+    setenv("BAD_TIME_TIMEOUT", "1x", 0);
+    setenv("BAD_TIME_DEADLINE", "yesterday", 0);
+
+    const ParserResult expected{{
+        "BAD_TIME_TIMEOUT: Invalid duration '1x' for field timeout: unknown unit 'x'",
+        "BAD_TIME_DEADLINE: Invalid timestamp 'yesterday' for field deadline: expected a YYYY-MM-DD date",
+    }};
+    ASSERT_EQ(ParserEnv{"BAD_TIME"}.parse(&parsed), expected);
+}
 } // namespace config_much::internal
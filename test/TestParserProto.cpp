@@ -0,0 +1,214 @@
+#include "config-much.h"
+
+#include "proto/test-config.pb.h"
+
+#include <google/protobuf/util/message_differencer.h>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace config_much::internal {
+using google::protobuf::util::MessageDifferencer;
+
+class ParserProtoTests : public testing::Test {
+protected:
+    void SetUp() override {
+        dir_ = std::filesystem::temp_directory_path() /
+               ("config-much-" + std::string(testing::UnitTest::GetInstance()->current_test_info()->name()));
+        std::filesystem::create_directories(dir_);
+    }
+
+    void TearDown() override { std::filesystem::remove_all(dir_); }
+
+    std::filesystem::path write(const std::string& name, const std::string& content) {
+        auto path = dir_ / name;
+        std::ofstream(path, std::ios::binary) << content;
+        return path;
+    }
+
+    std::filesystem::path dir_;
+};
+
+TEST_F(ParserProtoTests, FormatFor) {
+    ASSERT_EQ(ParserProto::format_for("config.binpb"), ParserProto::BINARY);
+    ASSERT_EQ(ParserProto::format_for("config.pb"), ParserProto::BINARY);
+    ASSERT_EQ(ParserProto::format_for("config.txtpb"), ParserProto::TEXT);
+    ASSERT_EQ(ParserProto::format_for("config.textproto"), ParserProto::TEXT);
+    ASSERT_EQ(ParserProto::format_for("config.yml"), std::nullopt);
+}
+
+TEST_F(ParserProtoTests, Binary) {
+    test_config::Config expected;
+    expected.set_enabled(true);
+    expected.set_field_i32(-32);
+    expected.set_field_string("binary");
+    expected.mutable_field_message()->set_enabled(true);
+    expected.add_field_repeated(1);
+    expected.add_field_repeated(2);
+    expected.set_field_enum(test_config::TYPE2);
+
+    auto path = write("config.binpb", expected.SerializeAsString());
+
+    test_config::Config cfg;
+    ASSERT_FALSE(ParserProto(path, ParserProto::BINARY).parse(&cfg));
+    ASSERT_TRUE(MessageDifferencer::Equals(cfg, expected)) << cfg.DebugString();
+}
+
+TEST_F(ParserProtoTests, Text) {
+    auto path = write("config.txtpb", R"(
+        enabled: true
+        field_i32: -32
+        field_message { enabled: true }
+        field_repeated: [1, 2]
+        field_enum: TYPE2
+    )");
+
+    test_config::Config cfg;
+    ASSERT_FALSE(ParserProto(path, ParserProto::TEXT).parse(&cfg));
+    ASSERT_TRUE(cfg.enabled());
+    ASSERT_EQ(cfg.field_i32(), -32);
+    ASSERT_TRUE(cfg.field_message().enabled());
+    ASSERT_EQ(cfg.field_repeated_size(), 2);
+    ASSERT_EQ(cfg.field_enum(), test_config::TYPE2);
+}
+
+TEST_F(ParserProtoTests, Errors) {
+    auto text = write("broken.txtpb", "enabled: true\nunknown_field: 1\n");
+    auto bin  = write("broken.binpb", "\x0a\xff");
+
+    test_config::Config cfg;
+    auto res = ParserProto(text, ParserProto::TEXT).parse(&cfg);
+    ASSERT_TRUE(res);
+    ASSERT_EQ(res->size(), 1);
+    ASSERT_EQ(res->at(0).what().rfind("\"" + text.string() + "\": error at line 2, column 14: ", 0), 0) << res->at(0);
+    ASSERT_FALSE(cfg.enabled());
+
+    ASSERT_EQ(ParserProto(bin, ParserProto::BINARY).parse(&cfg),
+              ParserResult({{"\"" + bin.string() + "\": Failed to parse binary test_config.Config"}}));
+
+    ASSERT_EQ(ParserProto(dir_ / "missing.binpb", ParserProto::BINARY).parse(&cfg).has_value(), true);
+}
+
+TEST_F(ParserProtoTests, Layering) {
+    test_config::Config layer;
+    layer.set_field_i32(64);
+    layer.add_field_repeated(3);
+
+    auto yml = write("base.yml", R"(
+        enabled: true
+        field_i32: -32
+        field_string: base
+        field_repeated: [1, 2]
+    )");
+    auto bin = write("override.binpb", layer.SerializeAsString());
+    auto txt = write("override.txtpb", "field_string: \"\"\nfield_enum: TYPE2\n");
+
+    setenv("LAYERING_FIELD_U32", "7", 0);
+
+    Parser parser;
+    parser.add_file(yml).add_file(bin).add_file(txt).set_env_var_prefix("LAYERING");
+
+    test_config::Config cfg;
+    ASSERT_FALSE(parser.parse(&cfg));
+    ASSERT_TRUE(cfg.enabled());
+    ASSERT_EQ(cfg.field_i32(), 64);
+    ASSERT_EQ(cfg.field_u32(), 7);
+    ASSERT_EQ(cfg.field_enum(), test_config::TYPE2);
+
+    // Repeated fields are replaced, explicit defaults still override
+    ASSERT_EQ(cfg.field_repeated_size(), 1);
+    ASSERT_EQ(cfg.field_repeated(0), 3);
+    ASSERT_EQ(cfg.field_string(), "");
+}
+
+TEST_F(ParserProtoTests, LayeringDurations) {
+    test_config::WellKnown layer;
+    layer.mutable_timeout()->set_seconds(2);
+
+    auto yml = write("base.yml", "timeout: 1.5s\n");
+    auto bin = write("override.binpb", layer.SerializeAsString());
+    auto txt = write("override.txtpb", "timeout { seconds: 3 }\n");
+
+    // Durations are replaced, the nanos of the YAML value don't carry over
+    test_config::WellKnown cfg;
+    ASSERT_FALSE(Parser().add_file(yml).add_file(bin).parse(&cfg));
+    ASSERT_EQ(cfg.timeout().seconds(), 2);
+    ASSERT_EQ(cfg.timeout().nanos(), 0);
+
+    ASSERT_FALSE(Parser().add_file(yml).add_file(txt).parse(&cfg));
+    ASSERT_EQ(cfg.timeout().seconds(), 3);
+    ASSERT_EQ(cfg.timeout().nanos(), 0);
+
+    // A failed merge puts the previous value back
+    auto broken = write("broken.binpb", layer.SerializeAsString() + "\x0a\xff");
+    cfg.mutable_timeout()->set_nanos(500000000);
+    ASSERT_TRUE(ParserProto(broken, ParserProto::BINARY).parse(&cfg));
+    ASSERT_EQ(cfg.timeout().seconds(), 3);
+    ASSERT_EQ(cfg.timeout().nanos(), 500000000);
+}
+
+TEST_F(ParserProtoTests, Provenance) {
+    test_config::Config layer;
+    layer.set_field_i32(64);
+    layer.mutable_field_message()->set_enabled(true);
+
+    auto bin = write("config.binpb", layer.SerializeAsString());
+    auto txt = write("config.txtpb", "\nfield_string: \"text\"\nfield_repeated: [1, 2]\n");
+
+    Provenance provenance;
+    Parser parser;
+    parser.add_file(bin).add_file(txt).set_provenance(&provenance);
+
+    test_config::Config cfg;
+    ASSERT_FALSE(parser.parse(&cfg));
+
+    using Origin = Provenance::Origin;
+    ASSERT_EQ(provenance.find("field_i32"), Origin({bin.string(), 0}));
+    ASSERT_EQ(provenance.find("field_message.enabled"), Origin({bin.string(), 0}));
+    ASSERT_EQ(provenance.find("field_string"), Origin({txt.string(), 2}));
+    ASSERT_EQ(provenance.find("field_repeated"), Origin({txt.string(), 3}));
+}
+
+TEST_F(ParserProtoTests, Validation) {
+    test_config::Validated layer;
+    layer.mutable_limits()->set_port(70000);
+    auto bin = write("validated.binpb", layer.SerializeAsString());
+    auto txt = write("validated.txtpb", "limits { name: \"Not Valid\" }\n");
+
+    test_config::Validated cfg;
+    ASSERT_EQ(ParserProto(bin, ParserProto::BINARY).parse(&cfg),
+              ParserResult({{"\"" + bin.string() + "\": limits.port: value 70000 is above the maximum of 65535"}}));
+    ASSERT_EQ(ParserProto(txt, ParserProto::TEXT).parse(&cfg),
+              ParserResult(
+                  {{"\"" + txt.string() + "\": limits.name: 'Not Valid' does not match '^[a-z][a-z0-9-]*$'"}}));
+}
+
+TEST_F(ParserProtoTests, Interleaved) {
+    // port, name, port again: the port is validated once
+    auto bin = write("interleaved.binpb", "\x08\xf0\xa2\x04\x12\x02ok\x08\xf0\xa2\x04");
+
+    test_config::Limits limits;
+    ASSERT_EQ(ParserProto(bin, ParserProto::BINARY).parse(&limits),
+              ParserResult({{"\"" + bin.string() + "\": port: value 70000 is above the maximum of 65535"}}));
+    ASSERT_EQ(limits.name(), "ok");
+
+    // Elements 3 and 4 around a string replace 1 and 2, unless the merge fails on its invalid UTF-8
+    const std::string good = "\x50\x03\x42\x02ok\x50\x04";
+    const std::string bad  = "\x50\x03\x42\x01\xff\x50\x04";
+
+    test_config::Config cfg;
+    cfg.add_field_repeated(1);
+    cfg.add_field_repeated(2);
+    ASSERT_TRUE(ParserProto(write("bad.binpb", bad), ParserProto::BINARY).parse(&cfg));
+    ASSERT_EQ(std::vector<uint64_t>(cfg.field_repeated().begin(), cfg.field_repeated().end()),
+              std::vector<uint64_t>({1, 2}));
+
+    ASSERT_FALSE(ParserProto(write("good.binpb", good), ParserProto::BINARY).parse(&cfg));
+    ASSERT_EQ(std::vector<uint64_t>(cfg.field_repeated().begin(), cfg.field_repeated().end()),
+              std::vector<uint64_t>({3, 4}));
+    ASSERT_EQ(cfg.field_string(), "ok");
+}
+
+} // namespace config_much::internal
@@ -1,5 +1,6 @@
 #include "internal/parser-error.h"
 #include "internal/parser-yaml.h"
+#include "internal/work-stealing-pool.h"
 
 #include "proto/test-config.pb.h"
 
@@ -17,7 +18,27 @@ constexpr std::array ValidationModeStr{
     "UNKNOWN_FIELDS_ONLY",
 };
 
-TEST(TestParserYaml, Parsing) {
+// Every test runs against both backends, the scanner must give the same results as yaml-cpp
+class TestParserYaml : public ::testing::TestWithParam<ParserYaml::Backend> {
+protected:
+    ParserResult parse(google::protobuf::Message* msg, const std::string& input, bool camelcase = false,
+                       ParserYaml::ValidationMode mode = ParserYaml::PERMISSIVE) {
+        if (GetParam() == ParserYaml::YAML_CPP) {
+            return ParserYaml("/test.yml", camelcase, mode).parse(msg, YAML::Load(input));
+        }
+
+        // Make sure the scanner handles the input itself rather than falling back
+        EXPECT_TRUE(YamlDocument::scan(input)) << input;
+        return ParserYaml(std::make_unique<MemorySource>("/test.yml", input), camelcase, mode)
+            .set_backend(GetParam())
+            .parse(msg);
+    }
+};
+
+INSTANTIATE_TEST_SUITE_P(Backends, TestParserYaml, ::testing::Values(ParserYaml::YAML_CPP, ParserYaml::SCANNER),
+                         [](const auto& info) { return info.param == ParserYaml::YAML_CPP ? "YamlCpp" : "Scanner"; });
+
+TEST_P(TestParserYaml, Parsing) {
     struct test_case {
         std::string input;
         test_config::Config expected;
@@ -89,8 +110,7 @@ TEST(TestParserYaml, Parsing) {
 
     for (const auto& [input, expected, camelcase] : tests) {
         test_config::Config parsed;
-        ParserYaml parser("/test.yml", camelcase);
-        parser.parse(&parsed, YAML::Load(input));
+        parse(&parsed, input, camelcase);
 
         bool equals = MessageDifferencer::Equals(parsed, expected);
 
@@ -101,7 +121,7 @@ TEST(TestParserYaml, Parsing) {
     }
 }
 
-TEST(TestParserYaml, OverwrittingFields) {
+TEST_P(TestParserYaml, OverwrittingFields) {
     test_config::Config cfg;
     std::string input = R"(
         enabled: false
@@ -121,8 +141,7 @@ TEST(TestParserYaml, OverwrittingFields) {
     expected.mutable_field_repeated()->Add(15);
     expected.set_field_enum(test_config::EnumField::TYPE1);
     expected.mutable_field_repeated_enum()->Add(0);
-    ParserYaml parser("/test.yml");
-    parser.parse(&cfg, YAML::Load(input));
+    parse(&cfg, input);
 
     bool equals = MessageDifferencer::Equals(cfg, expected);
     ASSERT_TRUE(equals) << "### parsed: " << std::endl
@@ -154,7 +173,7 @@ TEST(TestParserYaml, OverwrittingFields) {
     expected.mutable_field_repeated_enum()->Add(1);
     expected.mutable_field_repeated_enum()->Add(1);
 
-    parser.parse(&cfg, YAML::Load(input));
+    parse(&cfg, input);
 
     equals = MessageDifferencer::Equals(cfg, expected);
     ASSERT_TRUE(equals) << "### parsed: " << std::endl
@@ -163,9 +182,8 @@ TEST(TestParserYaml, OverwrittingFields) {
                         << expected.DebugString();
 }
 
-TEST(TestParserYaml, ParserErrors) {
+TEST_P(TestParserYaml, ParserErrors) {
     test_config::Config cfg;
-    ParserYaml parser("/test.yml");
     const std::string input = R"(
         enabled: 1
         field_i32: wrong
@@ -199,7 +217,7 @@ TEST(TestParserYaml, ParserErrors) {
         "\"/test.yml\": Invalid enum value 'ALSO_INVALID' for field field_repeated_enum",
     };
 
-    auto errors = parser.parse(&cfg, YAML::Load(input));
+    auto errors = parse(&cfg, input);
     ASSERT_TRUE(errors);
     ASSERT_EQ(errors->size(), expected.size());
 
@@ -208,7 +226,7 @@ TEST(TestParserYaml, ParserErrors) {
     }
 }
 
-TEST(TestParserYaml, ValidationMode) {
+TEST_P(TestParserYaml, ValidationMode) {
     test_config::Config cfg;
     struct test_case {
         ParserYaml::ValidationMode mode;
@@ -304,9 +322,136 @@ TEST(TestParserYaml, ValidationMode) {
 
     for (auto& [mode, input, expected] : tests) {
         test_config::Config cfg;
-        ParserYaml parser("/test.yml", false, mode);
-        auto res = parser.parse(&cfg, YAML::Load(input));
+        auto res = parse(&cfg, input, false, mode);
         EXPECT_EQ(res, expected) << "Mode: " << ValidationModeStr.at(mode);
     }
 }
+
+TEST_P(TestParserYaml, MixedConventions) {
+    const std::string input = R"(
+        enabled: true
+        fieldI32: -32
+        field-u32: 32
+        FIELD_I64: -64
+        FieldMessage:
+            ENABLED: true
+        field_repeated_enum: [TYPE2]
+    )";
+
+    for (const bool camelcase : {false, true}) {
+        test_config::Config cfg;
+        ASSERT_FALSE(parse(&cfg, input, camelcase, ParserYaml::UNKNOWN_FIELDS_ONLY)) << camelcase;
+        ASSERT_TRUE(cfg.enabled());
+        ASSERT_EQ(cfg.field_i32(), -32);
+        ASSERT_EQ(cfg.field_u32(), 32);
+        ASSERT_EQ(cfg.field_i64(), -64);
+        ASSERT_TRUE(cfg.field_message().enabled());
+        ASSERT_EQ(cfg.field_repeated_enum_size(), 1);
+    }
+
+    // Errors still name fields the way the parser was set up
+    test_config::Config cfg;
+    const ParserResult expected{{"\"/test.yml\": Invalid enum value 'TYPE3' for field fieldRepeatedEnum"}};
+    ASSERT_EQ(parse(&cfg, "field-repeated-enum: [TYPE3]\n", true), expected);
+}
+
+TEST_P(TestParserYaml, ProvenancePaths) {
+    const std::string input = "fieldI32: 1\nfieldMessage:\n    enabled: true\n";
+
+    // Paths are the schema's names, the same as for every other source
+    Provenance provenance;
+    ParserYaml parser(std::make_unique<MemorySource>("/test.yml", input), true);
+    parser.set_backend(GetParam()).set_provenance(&provenance);
+
+    test_config::Config cfg;
+    ASSERT_FALSE(parser.parse(&cfg));
+    ASSERT_EQ(provenance.find("field_i32"), Provenance::Origin({"/test.yml", 1}));
+    ASSERT_EQ(provenance.find("field_message.enabled"), Provenance::Origin({"/test.yml", 3}));
+    ASSERT_FALSE(provenance.find("fieldMessage.enabled"));
+}
+
+TEST_P(TestParserYaml, Parallel) {
+    const std::string input = R"(
+        first:
+            field_i32: wrong
+            field_string: first
+            field_message: {enabled: true}
+            field_repeated: [1, 2, 3]
+        second:
+            field_u32: -1
+            field_enum: NOT_REAL
+            unknown: 1
+        limits:
+            port: 0
+            name: Invalid
+        third: {enabled: true}
+        enabled: wrong
+        small: {enabled: true}
+    )";
+
+    auto parse = [&](Executor executor, test_config::Wide* msg) {
+        auto parser = ParserYaml(std::make_unique<MemorySource>("/wide.yml", input), false,
+                                 ParserYaml::UNKNOWN_FIELDS_ONLY);
+        parser.set_backend(GetParam()).set_parallel(std::move(executor), 1);
+        return parser.parse(msg);
+    };
+
+    test_config::Wide expected;
+    const auto expected_errors = parse(nullptr, &expected);
+    ASSERT_TRUE(expected_errors);
+    ASSERT_EQ(expected_errors->size(), 7);
+
+    // Tasks the executor never runs are picked up by the parsing thread
+    WorkStealingPool pool(4);
+    std::vector<Executor> executors = {pool.executor(), inline_executor(), [](const std::function<void()>&) {}};
+    for (auto& executor : executors) {
+        for (int i = 0; i < 20; i++) {
+            test_config::Wide parsed;
+            ASSERT_EQ(parse(executor, &parsed), expected_errors);
+            ASSERT_TRUE(MessageDifferencer::Equals(parsed, expected)) << parsed.DebugString();
+        }
+    }
+}
+
+TEST_P(TestParserYaml, WellKnownTypes) {
+    test_config::WellKnown cfg;
+    const std::string input = R"(
+        timeout: 1h30m
+        deadline: 2024-02-29T12:30:00.5Z
+    )";
+
+    auto errors = parse(&cfg, input);
+    ASSERT_FALSE(errors);
+    ASSERT_EQ(cfg.timeout().seconds(), 5400);
+    ASSERT_EQ(cfg.timeout().nanos(), 0);
+    ASSERT_EQ(cfg.deadline().seconds(), 1709209800);
+    ASSERT_EQ(cfg.deadline().nanos(), 500000000);
+
+    // The long form is still accepted
+    const std::string long_form = R"(
+        timeout:
+            seconds: 10
+            nanos: 20
+    )";
+    errors = parse(&cfg, long_form);
+    ASSERT_FALSE(errors);
+    ASSERT_EQ(cfg.timeout().seconds(), 10);
+    ASSERT_EQ(cfg.timeout().nanos(), 20);
+}
+
+TEST_P(TestParserYaml, WellKnownTypesErrors) {
+    test_config::WellKnown cfg;
+    const std::string input = R"(
+        timeout: 30
+        deadline: 2024-02-30T12:30:00Z
+    )";
+
+    const ParserResult expected{{
+        "\"/test.yml\": Invalid duration '30' for field timeout: missing unit",
+        "\"/test.yml\": Invalid timestamp '2024-02-30T12:30:00Z' for field deadline: day out of range",
+    }};
+
+    ASSERT_EQ(parse(&cfg, input), expected);
+}
+
 } // namespace config_much::internal
@@ -0,0 +1,97 @@
+#include "internal/section-registry.h"
+
+#include "proto/test-config.pb.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+
+namespace config_much {
+
+TEST(SectionRegistryTests, Dispatch) {
+    const std::string base = R"(
+        server:
+            enabled: true
+            field_i32: 1
+            field_repeated: [1, 2]
+        limits:
+            port: 80
+            name: edge
+        other_binary:
+            anything: goes
+    )";
+    const std::string local = R"(
+        server:
+            field_i32: 2
+            field_message:
+                enabled: true
+        limits:
+        timing: {timeout: 5s}
+    )";
+    setenv("SECTIONS_SERVER_FIELD_STRING", "from-env", 0);
+    setenv("SECTIONS_LIMITS_PORT", "8080", 0);
+
+    auto first        = std::make_unique<MemorySource>("/base.yml", base);
+    auto second       = std::make_unique<MemorySource>("/local.yml", local);
+    const auto* bytes = first.get();
+
+    test_config::Config server;
+    test_config::Limits limits;
+    test_config::WellKnown timing;
+    test_config::Config unused;
+
+    SectionRegistry registry;
+    registry.add_source(std::move(first))
+        .add_source(std::move(second))
+        .set_env_var_prefix("SECTIONS")
+        .bind("server", &unused)
+        .bind("limits", &limits)
+        .bind("timing", &timing)
+        .bind("server", &server);
+
+    const auto results = registry.parse();
+    ASSERT_EQ(results.size(), 3);
+    for (const auto& [section, result] : results) {
+        ASSERT_FALSE(result) << section << ": " << result->front();
+    }
+
+    // Every file is read once for all sections
+    ASSERT_EQ(bytes->bytes_read(), base.size());
+
+    ASSERT_TRUE(server.enabled());
+    ASSERT_EQ(server.field_i32(), 2);
+    ASSERT_EQ(server.field_repeated_size(), 2);
+    ASSERT_TRUE(server.field_message().enabled());
+    ASSERT_EQ(server.field_string(), "from-env");
+    ASSERT_EQ(unused.ByteSizeLong(), 0);
+
+    ASSERT_EQ(limits.port(), 8080);
+    ASSERT_EQ(limits.name(), "edge");
+    ASSERT_EQ(timing.timeout().seconds(), 5);
+}
+
+TEST(SectionRegistryTests, Errors) {
+    test_config::Config server;
+    test_config::Limits limits;
+    test_config::WellKnown timing;
+
+    SectionRegistry registry;
+    registry.add_buffer("/app.yml", "server:\n  field_i32: wrong\nlimits:\n  port: 1\ntiming: 5s\n")
+        .add_buffer("/broken.yml", "server: [1\n")
+        .bind("server", &server)
+        .bind("limits", &limits)
+        .bind("timing", &timing);
+
+    // Each component only sees the errors of its own section, and of files nobody can read
+    const std::string broken = "\"/broken.yml\": yaml-cpp: error at line 2, column 1: end of sequence flow not found";
+    auto results             = registry.parse();
+    ASSERT_EQ(results["server"], ParserResult({{
+                                     "\"/app.yml\": yaml-cpp: error at line 2, column 14: bad conversion",
+                                     broken,
+                                 }}));
+    ASSERT_EQ(results["limits"], ParserResult({{broken, "Missing required field 'name'"}}));
+    ASSERT_EQ(results["timing"], ParserResult({{"\"/app.yml\": Section 'timing' should be a map", broken}}));
+    ASSERT_EQ(limits.port(), 1);
+}
+
+} // namespace config_much
@@ -0,0 +1,195 @@
+#include "internal/shared-config.h"
+
+#include "proto/test-config.pb.h"
+
+#include <google/protobuf/util/message_differencer.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+namespace config_much {
+using namespace google::protobuf::util;
+
+namespace {
+constexpr uint64_t GENERATIONS = 500;
+constexpr int READERS          = 4;
+
+test_config::Config make_config(uint64_t generation) {
+    test_config::Config cfg;
+    cfg.set_field_u64(generation);
+    cfg.set_field_i64(-static_cast<int64_t>(generation));
+    cfg.set_field_string(std::string(generation % 512, 'x'));
+    for (uint64_t i = 0; i < generation % 64; i++) {
+        cfg.add_field_repeated(generation);
+    }
+    return cfg;
+}
+
+bool is_consistent(const test_config::Config& cfg) {
+    const uint64_t generation = cfg.field_u64();
+    if (cfg.field_i64() != -static_cast<int64_t>(generation) || cfg.field_string().size() != generation % 512 ||
+        static_cast<uint64_t>(cfg.field_repeated_size()) != generation % 64) {
+        return false;
+    }
+
+    for (auto v : cfg.field_repeated()) {
+        if (v != generation) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int run_reader(int fd) {
+    auto res = SharedConfigReader::attach(fd);
+    if (std::holds_alternative<ParserError>(res)) {
+        return 1;
+    }
+    auto& reader = std::get<SharedConfigReader>(res);
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    test_config::Config cfg;
+    while (cfg.field_u64() != GENERATIONS) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return 2;
+        }
+
+        auto updated = reader.poll(&cfg);
+        if (std::holds_alternative<ParserError>(updated)) {
+            return 3;
+        }
+
+        if (std::get<bool>(updated) && !is_consistent(cfg)) {
+            return 4;
+        }
+    }
+    return 0;
+}
+} // namespace
+
+TEST(SharedConfigTests, PublishAndPoll) {
+    auto publisher = SharedConfigPublisher::create(4096);
+    ASSERT_TRUE(std::holds_alternative<SharedConfigPublisher>(publisher)) << std::get<ParserError>(publisher);
+    auto& pub = std::get<SharedConfigPublisher>(publisher);
+
+    auto attached = SharedConfigReader::attach(pub.fd());
+    ASSERT_TRUE(std::holds_alternative<SharedConfigReader>(attached)) << std::get<ParserError>(attached);
+    auto& reader = std::get<SharedConfigReader>(attached);
+
+    test_config::Config parsed;
+    auto res = reader.poll(&parsed);
+    ASSERT_FALSE(std::get<bool>(res));
+
+    const auto expected = make_config(42);
+    ASSERT_FALSE(pub.publish(expected));
+    ASSERT_EQ(pub.generation(), 1);
+
+    res = reader.poll(&parsed);
+    ASSERT_TRUE(std::get<bool>(res));
+    ASSERT_EQ(reader.generation(), 1);
+    ASSERT_TRUE(MessageDifferencer::Equals(parsed, expected)) << "### parsed: " << std::endl
+                                                              << parsed.DebugString() << std::endl
+                                                              << "### expected: " << std::endl
+                                                              << expected.DebugString();
+
+    res = reader.poll(&parsed);
+    ASSERT_FALSE(std::get<bool>(res));
+}
+
+TEST(SharedConfigTests, NamedSegment) {
+    const std::string name = "/config-much-test-" + std::to_string(getpid());
+    auto publisher         = SharedConfigPublisher::create(name, 4096);
+    ASSERT_TRUE(std::holds_alternative<SharedConfigPublisher>(publisher)) << std::get<ParserError>(publisher);
+    auto& pub = std::get<SharedConfigPublisher>(publisher);
+
+    // A live segment is never taken over by a second publisher
+    auto second = SharedConfigPublisher::create(name, 4096);
+    ASSERT_TRUE(std::holds_alternative<ParserError>(second));
+    ASSERT_EQ(std::get<ParserError>(second).what(), "Shared memory segment " + name + " already exists");
+
+    const auto expected = make_config(7);
+    ASSERT_FALSE(pub.publish(expected));
+
+    auto attached = SharedConfigReader::attach(name);
+    ASSERT_TRUE(std::holds_alternative<SharedConfigReader>(attached)) << std::get<ParserError>(attached);
+
+    std::string bytes;
+    auto res = std::get<SharedConfigReader>(attached).poll(&bytes);
+    ASSERT_TRUE(std::get<bool>(res));
+    ASSERT_EQ(bytes, expected.SerializeAsString());
+}
+
+TEST(SharedConfigTests, MessageTooLarge) {
+    auto publisher = SharedConfigPublisher::create(16);
+    ASSERT_TRUE(std::holds_alternative<SharedConfigPublisher>(publisher)) << std::get<ParserError>(publisher);
+    auto& pub = std::get<SharedConfigPublisher>(publisher);
+
+    auto res = pub.publish(make_config(100));
+    ASSERT_TRUE(res);
+    ASSERT_EQ(res->size(), 1);
+    ASSERT_EQ(pub.generation(), 0);
+}
+
+TEST(SharedConfigTests, BrokenPublisher) {
+    auto publisher = SharedConfigPublisher::create(64);
+    ASSERT_TRUE(std::holds_alternative<SharedConfigPublisher>(publisher)) << std::get<ParserError>(publisher);
+    auto& pub = std::get<SharedConfigPublisher>(publisher);
+
+    auto attached = SharedConfigReader::attach(pub.fd());
+    ASSERT_TRUE(std::holds_alternative<SharedConfigReader>(attached)) << std::get<ParserError>(attached);
+    auto& reader = std::get<SharedConfigReader>(attached);
+
+    const size_t mapped = sizeof(internal::SharedHeader) + 64;
+    void* addr          = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_SHARED, pub.fd(), 0);
+    ASSERT_NE(addr, MAP_FAILED);
+    auto* header = static_cast<internal::SharedHeader*>(addr);
+
+    // A publisher that died mid-write leaves the counter odd
+    header->seq.store(1);
+    std::string bytes;
+    auto res = reader.poll(&bytes);
+    ASSERT_TRUE(std::holds_alternative<ParserError>(res));
+    ASSERT_EQ(std::get<ParserError>(res).what(), "Shared memory segment is still being written after 100000 attempts");
+
+    header->seq.store(2);
+    header->size.store(65);
+    res = reader.poll(&bytes);
+    ASSERT_TRUE(std::holds_alternative<ParserError>(res));
+    ASSERT_EQ(std::get<ParserError>(res).what(),
+              "Shared memory segment header is corrupted, generation 1 has 65 bytes for a capacity of 64");
+    ASSERT_EQ(reader.generation(), 0);
+
+    munmap(addr, mapped);
+}
+
+TEST(SharedConfigTests, ConcurrentRepublish) {
+    auto publisher = SharedConfigPublisher::create(64 * 1024);
+    ASSERT_TRUE(std::holds_alternative<SharedConfigPublisher>(publisher)) << std::get<ParserError>(publisher);
+    auto& pub = std::get<SharedConfigPublisher>(publisher);
+
+    std::vector<pid_t> readers;
+    for (int i = 0; i < READERS; i++) {
+        pid_t pid = fork();
+        ASSERT_NE(pid, -1);
+        if (pid == 0) {
+            _exit(run_reader(pub.fd()));
+        }
+        readers.push_back(pid);
+    }
+
+    for (uint64_t generation = 1; generation <= GENERATIONS; generation++) {
+        ASSERT_FALSE(pub.publish(make_config(generation)));
+    }
+
+    for (auto pid : readers) {
+        int status = 0;
+        ASSERT_EQ(waitpid(pid, &status, 0), pid);
+        ASSERT_TRUE(WIFEXITED(status));
+        EXPECT_EQ(WEXITSTATUS(status), 0) << "Reader " << pid << " failed";
+    }
+}
+} // namespace config_much
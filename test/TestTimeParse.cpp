@@ -0,0 +1,168 @@
+#include "internal/time-parse.h"
+
+#include "proto/test-config.pb.h"
+
+#include <gtest/gtest.h>
+
+namespace config_much::internal {
+
+TEST(TimeParseTests, Duration) {
+    struct test_case {
+        std::string input;
+        TimeValue expected;
+    };
+
+    std::vector<test_case> tests = {
+        {"0", {0, 0}},
+        {"30s", {30, 0}},
+        {"5m", {300, 0}},
+        {"1h30m", {5400, 0}},
+        {"2d", {172800, 0}},
+        {"250ms", {0, 250000000}},
+        {"1.5s", {1, 500000000}},
+        {"-1.5s", {-1, -500000000}},
+        {"+10us", {0, 10000}},
+        {"1s500ms100ns", {1, 500000100}},
+        {".5h", {1800, 0}},
+        {"1500ms", {1, 500000000}},
+        {"0.0000000015s", {0, 1}},
+    };
+
+    for (const auto& [input, expected] : tests) {
+        auto res = parse_duration(input);
+        ASSERT_TRUE(std::holds_alternative<TimeValue>(res))
+            << "Input: '" << input << "' error: " << std::get<ParserError>(res);
+        ASSERT_EQ(std::get<TimeValue>(res), expected) << "Input: '" << input << "'";
+    }
+}
+
+TEST(TimeParseTests, DurationErrors) {
+    struct test_case {
+        std::string input;
+        ParserError expected;
+    };
+
+    std::vector<test_case> tests = {
+        {"", "empty duration"},
+        {"-", "empty duration"},
+        {"30", "missing unit"},
+        {"1h30", "missing unit"},
+        {"s", "expected a number"},
+        {"10 s", "missing unit"},
+        {"10sec", "unknown unit 'sec'"},
+        {"3w", "unknown unit 'w'"},
+        {"99999999999999999999s", "value out of range"},
+        {"3660000d", "value out of range"},
+        {"315576000000s1s", "value out of range"},
+    };
+
+    for (const auto& [input, expected] : tests) {
+        auto res = parse_duration(input);
+        ASSERT_TRUE(std::holds_alternative<ParserError>(res)) << "Input: '" << input << "'";
+        ASSERT_EQ(std::get<ParserError>(res), expected) << "Input: '" << input << "'";
+    }
+}
+
+TEST(TimeParseTests, Timestamp) {
+    struct test_case {
+        std::string input;
+        TimeValue expected;
+    };
+
+    std::vector<test_case> tests = {
+        {"1970-01-01T00:00:00Z", {0, 0}},
+        {"2024-02-29T12:30:00Z", {1709209800, 0}},
+        {"2024-02-29T12:30:00.5+01:00", {1709206200, 500000000}},
+        {"2024-02-29t12:30:00.123456789-00:30", {1709211600, 123456789}},
+        {"2024-02-29 12:30:00z", {1709209800, 0}},
+        {"1969-12-31T23:59:59.999Z", {-1, 999000000}},
+        {"0001-01-01T00:00:00Z", {-62135596800, 0}},
+        {"9999-12-31T23:59:59Z", {253402300799, 0}},
+    };
+
+    for (const auto& [input, expected] : tests) {
+        auto res = parse_timestamp(input);
+        ASSERT_TRUE(std::holds_alternative<TimeValue>(res))
+            << "Input: '" << input << "' error: " << std::get<ParserError>(res);
+        ASSERT_EQ(std::get<TimeValue>(res), expected) << "Input: '" << input << "'";
+    }
+}
+
+TEST(TimeParseTests, TimestampErrors) {
+    struct test_case {
+        std::string input;
+        ParserError expected;
+    };
+
+    std::vector<test_case> tests = {
+        {"", "expected a YYYY-MM-DD date"},
+        {"2024-2-29T12:30:00Z", "expected a YYYY-MM-DD date"},
+        {"2023-02-29T12:30:00Z", "day out of range"},
+        {"2024-13-01T12:30:00Z", "date out of range"},
+        {"0000-01-01T00:00:00Z", "date out of range"},
+        {"2024-02-29", "expected 'T' between date and time"},
+        {"2024-02-29T12:30Z", "expected a HH:MM:SS time"},
+        {"2024-02-29T24:00:00Z", "time out of range"},
+        {"2024-02-29T12:30:00.Z", "fraction must have between 1 and 9 digits"},
+        {"2024-02-29T12:30:00.1234567891Z", "fraction must have between 1 and 9 digits"},
+        {"2024-02-29T12:30:00", "expected 'Z' or a +HH:MM offset"},
+        {"2024-02-29T12:30:00+0100", "expected 'Z' or a +HH:MM offset"},
+        {"2024-02-29T12:30:00Z ", "unexpected trailing ' '"},
+        {"0001-01-01T00:00:00+01:00", "timestamp out of range"},
+    };
+
+    for (const auto& [input, expected] : tests) {
+        auto res = parse_timestamp(input);
+        ASSERT_TRUE(std::holds_alternative<ParserError>(res)) << "Input: '" << input << "'";
+        ASSERT_EQ(std::get<ParserError>(res), expected) << "Input: '" << input << "'";
+    }
+}
+
+TEST(TimeParseTests, Format) {
+    struct test_case {
+        TimeType type;
+        TimeValue value;
+        std::string expected;
+    };
+
+    std::vector<test_case> tests = {
+        {TimeType::DURATION, {0, 0}, "0s"},
+        {TimeType::DURATION, {5400, 0}, "5400s"},
+        {TimeType::DURATION, {1, 500000000}, "1.5s"},
+        {TimeType::DURATION, {-1, -500000000}, "-1.5s"},
+        {TimeType::DURATION, {0, -1}, "-0.000000001s"},
+        {TimeType::TIMESTAMP, {0, 0}, "1970-01-01T00:00:00Z"},
+        {TimeType::TIMESTAMP, {1709209800, 0}, "2024-02-29T12:30:00Z"},
+        {TimeType::TIMESTAMP, {-1, 999000000}, "1969-12-31T23:59:59.999Z"},
+        {TimeType::TIMESTAMP, {-62135596800, 0}, "0001-01-01T00:00:00Z"},
+        {TimeType::TIMESTAMP, {253402300799, 123456789}, "9999-12-31T23:59:59.123456789Z"},
+    };
+
+    for (const auto& [type, value, expected] : tests) {
+        std::string out;
+        ASSERT_TRUE(format_time(type, value, &out)) << "Expected: '" << expected << "'";
+        ASSERT_EQ(out, expected);
+
+        auto res = parse_time(type, out);
+        ASSERT_TRUE(std::holds_alternative<TimeValue>(res)) << "Output: '" << out << "'";
+        ASSERT_EQ(std::get<TimeValue>(res), value) << "Output: '" << out << "'";
+    }
+
+    std::string out;
+    ASSERT_FALSE(format_time(TimeType::DURATION, {1, -1}, &out));
+    ASSERT_FALSE(format_time(TimeType::DURATION, {315576000001, 0}, &out));
+    ASSERT_FALSE(format_time(TimeType::TIMESTAMP, {0, -1}, &out));
+    ASSERT_FALSE(format_time(TimeType::TIMESTAMP, {253402300800, 0}, &out));
+    ASSERT_FALSE(format_time(TimeType::NONE, {0, 0}, &out));
+    ASSERT_TRUE(out.empty());
+}
+
+TEST(TimeParseTests, TimeType) {
+    const auto* descriptor = test_config::WellKnown::descriptor();
+    ASSERT_EQ(time_type(descriptor->FindFieldByName("timeout")->message_type()), TimeType::DURATION);
+    ASSERT_EQ(time_type(descriptor->FindFieldByName("deadline")->message_type()), TimeType::TIMESTAMP);
+    ASSERT_EQ(time_type(test_config::SubField::descriptor()), TimeType::NONE);
+    ASSERT_EQ(time_type(nullptr), TimeType::NONE);
+}
+
+} // namespace config_much::internal
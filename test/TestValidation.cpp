@@ -0,0 +1,117 @@
+#include "config-much.h"
+#include "internal/validation.h"
+
+#include "proto/test-config.pb.h"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+
+namespace config_much::internal {
+
+TEST(ValidationTests, ValidConfig) {
+    test_config::Validated cfg;
+    const std::string input = R"(
+        limits:
+            port: 8080
+            name: my-service
+        ratios: [0, 0.5, 1]
+        owner: someone
+        tags: [a, b]
+    )";
+
+    ASSERT_FALSE(ParserYaml("/test.yml").parse(&cfg, YAML::Load(input)));
+    ASSERT_EQ(cfg.limits().port(), 8080);
+    ASSERT_EQ(cfg.ratios_size(), 3);
+}
+
+TEST(ValidationTests, ParseYaml) {
+    test_config::Validated cfg;
+    const std::string input = R"(
+        limits:
+            port: 0
+            name: Not Valid
+        ratios: [0.5, 1.5]
+        owner: ""
+        tags: []
+        broken: anything
+    )";
+
+    auto res = ParserYaml("/test.yml").parse(&cfg, YAML::Load(input));
+    ASSERT_TRUE(res);
+    ASSERT_EQ(res->size(), 6);
+    ASSERT_EQ(res->at(0), ParserError("\"/test.yml\": limits.port: value 0 is below the minimum of 1"));
+    ASSERT_EQ(res->at(1),
+              ParserError("\"/test.yml\": limits.name: 'Not Valid' does not match '^[a-z][a-z0-9-]*$'"));
+    ASSERT_EQ(res->at(2), ParserError("\"/test.yml\": ratios[1]: value 1.5 is above the maximum of 1"));
+    ASSERT_EQ(res->at(3), ParserError("\"/test.yml\": owner: must not be empty"));
+    ASSERT_EQ(res->at(4), ParserError("\"/test.yml\": tags: must not be empty"));
+    ASSERT_EQ(res->at(5).what().rfind("\"/test.yml\": broken: invalid pattern '[unclosed': ", 0), 0)
+        << res->at(5);
+}
+
+TEST(ValidationTests, Lengths) {
+    test_config::Validated cfg;
+    const std::string input = R"(
+        limits:
+            port: 1
+            name: much-too-long-for-a-name
+        ratios: [0, 0, 0, 0]
+    )";
+
+    const ParserResult expected{{
+        "\"/test.yml\": limits.name: length 24 is above the maximum of 16",
+        "\"/test.yml\": ratios: has 4 elements, expected at most 3",
+    }};
+    ASSERT_EQ(ParserYaml("/test.yml").parse(&cfg, YAML::Load(input)), expected);
+}
+
+TEST(ValidationTests, ParseEnv) {
+    setenv("VALIDATED_LIMITS_PORT", "70000", 0);
+    setenv("VALIDATED_RATIOS_0", "-1", 0);
+
+    const ParserResult expected{{
+        "VALIDATED_LIMITS_PORT: limits.port: value 70000 is above the maximum of 65535",
+        "VALIDATED_RATIOS_0: ratios[0]: value -1 is below the minimum of 0",
+    }};
+
+    test_config::Validated cfg;
+    ASSERT_EQ(ParserEnv("VALIDATED").parse(&cfg), expected);
+}
+
+TEST(ValidationTests, Required) {
+    const auto dir = std::filesystem::temp_directory_path() / "config-much-ValidationRequired";
+    std::filesystem::create_directories(dir);
+    std::ofstream(dir / "first.yml") << "owner: someone\n";
+    std::ofstream(dir / "second.yml") << "limits:\n  port: 80\n";
+
+    Parser parser;
+    parser.add_file(dir / "first.yml");
+
+    test_config::Validated cfg;
+    ASSERT_EQ(parser.parse(&cfg), ParserResult({{"Missing required field 'limits'"}}));
+
+    // Required fields are satisfied by any layer
+    cfg.Clear();
+    parser.add_file(dir / "second.yml");
+    ASSERT_EQ(parser.parse(&cfg), ParserResult({{"Missing required field 'limits.name'"}}));
+
+    cfg.Clear();
+    setenv("REQUIRED_LIMITS_NAME", "from-env", 0);
+    parser.set_env_var_prefix("REQUIRED");
+    ASSERT_FALSE(parser.parse(&cfg));
+    ASSERT_EQ(cfg.limits().name(), "from-env");
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST(ValidationTests, CompiledOnce) {
+    const auto* descriptor = test_config::Validated::descriptor();
+    ASSERT_EQ(&ValidationProgram::get(descriptor), &ValidationProgram::get(descriptor));
+    ASSERT_EQ(&ValidationProgram::get(test_config::Limits::descriptor()),
+              &ValidationProgram::get(test_config::Limits::descriptor()));
+    ASSERT_NE(&ValidationProgram::get(descriptor), &ValidationProgram::get(test_config::Limits::descriptor()));
+}
+
+} // namespace config_much::internal
@@ -0,0 +1,77 @@
+#include "internal/work-stealing-pool.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace config_much {
+
+TEST(WorkStealingPoolTests, RunsEverything) {
+    std::atomic<int> count{0};
+    {
+        WorkStealingPool pool(3);
+        ASSERT_EQ(pool.size(), 3);
+
+        // Tasks spawning tasks land on the queue of their worker, idle workers steal them
+        auto executor = pool.executor();
+        for (int i = 0; i < 100; i++) {
+            executor([&] {
+                for (int j = 0; j < 10; j++) {
+                    pool.submit([&] { count++; });
+                }
+                count++;
+            });
+        }
+    }
+
+    // Destroying the pool runs what's still queued
+    ASSERT_EQ(count, 1100);
+}
+
+TEST(WorkStealingPoolTests, Concurrent) {
+    std::promise<void> started;
+    std::promise<void> release;
+    std::promise<int> result;
+    auto released = release.get_future().share();
+    WorkStealingPool pool(2);
+
+    // A blocked worker doesn't keep the other from running tasks
+    pool.submit([&started, released] {
+        started.set_value();
+        released.wait();
+    });
+    started.get_future().wait();
+
+    pool.submit([&] { result.set_value(42); });
+    ASSERT_EQ(result.get_future().get(), 42);
+    release.set_value();
+}
+
+TEST(WorkStealingPoolTests, ManySubmitters) {
+    std::atomic<int> count{0};
+    {
+        WorkStealingPool pool(2);
+
+        // Workers go to sleep and wake up again while outside threads keep submitting
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 4; i++) {
+            threads.emplace_back([&] {
+                for (int j = 0; j < 1000; j++) {
+                    pool.submit([&] { count++; });
+                    if (j % 100 == 0) {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+    ASSERT_EQ(count, 4000);
+}
+
+} // namespace config_much
@@ -0,0 +1,126 @@
+#include "internal/parser-yaml.h"
+#include "internal/yaml-overlay.h"
+
+#include "proto/test-config.pb.h"
+
+#include <google/protobuf/util/message_differencer.h>
+#include <gtest/gtest.h>
+
+namespace config_much::internal {
+using google::protobuf::util::MessageDifferencer;
+
+TEST(YamlOverlayTests, Merge) {
+    YamlOverlay overlay;
+    ASSERT_FALSE(overlay.root());
+
+    overlay.add("/a.yml", YAML::Load("a: 1\nmap:\n  x: 1\n  y: [1, 2]\nreplaced:\n  z: 1\n"));
+    overlay.add("/b.yml", YAML::Load("b: 2\nmap:\n  y: [3]\n  w: 4\nreplaced: scalar\n"));
+    overlay.add("/c.yml", YAML::Load("a: 3\nmap: {x: 5}\n"));
+    ASSERT_EQ(overlay.layers(), 3);
+
+    const OverlayNode root = overlay.root();
+    ASSERT_TRUE(root.IsMap());
+    ASSERT_EQ(root.size(), 4);
+
+    // Keys keep the order they were first seen in
+    std::vector<std::string> keys;
+    for (const auto& child : root) {
+        keys.emplace_back(child.key());
+    }
+    ASSERT_EQ(keys, (std::vector<std::string>{"a", "map", "replaced", "b"}));
+
+    ASSERT_EQ(root["a"].Scalar(), "3");
+    ASSERT_EQ(root["a"].file(), "/c.yml");
+    ASSERT_EQ(root["b"].layer(), 1);
+
+    const OverlayNode map = root["map"];
+    ASSERT_TRUE(map.IsMap());
+    ASSERT_EQ(map.size(), 3);
+    ASSERT_EQ(map["x"].Scalar(), "5");
+    ASSERT_EQ(map["w"].Scalar(), "4");
+    ASSERT_EQ(map.layer(), 2);
+
+    // Sequences are replaced, not appended to
+    ASSERT_TRUE(map["y"].IsSequence());
+    ASSERT_EQ(map["y"].size(), 1);
+    ASSERT_EQ((*map["y"].begin()).Scalar(), "3");
+    ASSERT_EQ(map["y"].Mark().line, 2);
+
+    ASSERT_TRUE(root["replaced"].IsScalar());
+    ASSERT_FALSE(root["replaced"]["z"]);
+    ASSERT_FALSE(root["missing"]);
+    ASSERT_EQ(root["missing"].Type(), YAML::NodeType::Undefined);
+
+    // Spellings of the same name are the same key
+    overlay.add("/d.yml", YAML::Load("MAP: {X: 6}\nReplaced: 7\n"));
+    ASSERT_EQ(root.size(), 4);
+    ASSERT_EQ(root["map"]["x"].Scalar(), "6");
+    ASSERT_EQ(root["replaced"].Scalar(), "7");
+    ASSERT_EQ(root["Map"].key(), "map");
+}
+
+TEST(YamlOverlayTests, SameAsLayers) {
+    const std::vector<std::string> files = {
+        R"(
+            enabled: true
+            field_i32: -32
+            field_string: first
+            field_message:
+                enabled: true
+            field_repeated: [1, 2, 3]
+            field_repeated_enum: [TYPE1]
+        )",
+        R"(
+            field_i32: 32
+            field_message: {}
+            field_repeated: [4]
+            field_enum: TYPE2
+        )",
+        R"(
+            field_string: third
+            field_double: 1.5
+            field_repeated_enum: [TYPE2, TYPE2]
+        )",
+    };
+
+    std::vector<std::unique_ptr<ParserYaml>> parsers;
+    std::vector<ParserYaml*> layers;
+    test_config::Config expected;
+    for (size_t i = 0; i < files.size(); i++) {
+        const std::string name = "/layer" + std::to_string(i) + ".yml";
+        ASSERT_FALSE(ParserYaml(std::make_unique<MemorySource>(name, files[i])).parse(&expected));
+
+        parsers.push_back(std::make_unique<ParserYaml>(std::make_unique<MemorySource>(name, files[i])));
+        layers.push_back(parsers.back().get());
+    }
+
+    test_config::Config merged;
+    ASSERT_FALSE(ParserYaml::parse_overlay(layers, &merged));
+    ASSERT_TRUE(MessageDifferencer::Equals(merged, expected)) << merged.DebugString() << expected.DebugString();
+}
+
+TEST(YamlOverlayTests, Errors) {
+    auto layer = [](const std::string& name, std::string_view content) {
+        return std::make_unique<ParserYaml>(std::make_unique<MemorySource>(name, content), false,
+                                            ParserYaml::UNKNOWN_FIELDS_ONLY);
+    };
+
+    auto first  = layer("/first.yml", "field_i32: wrong\nfield_u32: also wrong\nunknown: 1\n");
+    auto second = layer("/second.yml", "field_i32: 1\nfield_message:\n  typo: true\n");
+    auto broken = layer("/broken.yml", "field_i32: [1\n");
+    auto empty  = layer("/empty.yml", "");
+
+    // Replaced values are never decoded, errors point at the layer a value comes from
+    test_config::Config cfg;
+    const ParserResult expected{{
+        "\"/broken.yml\": yaml-cpp: error at line 2, column 1: end of sequence flow not found",
+        "Invalid configuration: root node should be a map.",
+        "\"/first.yml\": yaml-cpp: error at line 2, column 12: bad conversion",
+        "\"/first.yml\": Unknown field 'unknown'",
+        "\"/second.yml\": Unknown field 'typo'",
+    }};
+    ASSERT_EQ(ParserYaml::parse_overlay({first.get(), broken.get(), empty.get(), second.get()}, &cfg), expected);
+    ASSERT_EQ(cfg.field_i32(), 1);
+}
+
+} // namespace config_much::internal
@@ -0,0 +1,299 @@
+#include "internal/deferred-sections.h"
+#include "internal/parser-yaml.h"
+#include "internal/provenance.h"
+#include "internal/yaml-scanner.h"
+#include "internal/yaml-writer.h"
+
+#include "proto/test-config.pb.h"
+
+#include <google/protobuf/util/message_differencer.h>
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+namespace config_much::internal {
+using google::protobuf::util::MessageDifferencer;
+
+namespace {
+/// Compare a scanned node with what yaml-cpp makes of the same input, recursively.
+void expect_same(const YamlNode& node, const YAML::Node& expected, const std::string& path) {
+    ASSERT_EQ(node.Type(), expected.Type()) << path;
+    if (!expected.IsNull()) {
+        EXPECT_EQ(node.Mark().line, expected.Mark().line) << path;
+        EXPECT_EQ(node.Mark().column, expected.Mark().column) << path;
+    }
+
+    if (expected.IsScalar()) {
+        EXPECT_EQ(node.Scalar(), expected.Scalar()) << path;
+        return;
+    }
+    ASSERT_EQ(node.size(), expected.size()) << path;
+
+    auto child = node.begin();
+    if (expected.IsMap()) {
+        for (auto it = expected.begin(); it != expected.end(); ++it, ++child) {
+            const auto key = it->first.as<std::string>();
+            ASSERT_EQ((*child).key(), key) << path;
+            expect_same(*child, it->second, path + "." + key);
+        }
+    } else if (expected.IsSequence()) {
+        for (size_t i = 0; i < expected.size(); i++, ++child) {
+            expect_same(*child, expected[i], path + "[" + std::to_string(i) + "]");
+        }
+    }
+}
+
+void expect_same(const std::string& input) {
+    auto doc = YamlDocument::scan(input);
+    ASSERT_TRUE(doc) << input;
+    expect_same(doc->root(), YAML::Load(input), "");
+}
+
+/// Whether node converts to T like yaml-cpp's as<T>() does, to the same value.
+template <typename T> void expect_same_conversion(const YamlNode& node, const YAML::Node& expected) {
+    std::optional<T> value;
+    try {
+        value = expected.as<T>();
+    } catch (const YAML::Exception&) {
+    }
+
+    const auto converted = node.convert<T>();
+    ASSERT_EQ(converted.has_value(), value.has_value()) << "'" << expected.Scalar() << "' as " << typeid(T).name();
+    if constexpr (std::is_floating_point_v<T>) {
+        if (value && std::isnan(*value)) {
+            ASSERT_TRUE(std::isnan(*converted));
+            return;
+        }
+    }
+    if (value) {
+        ASSERT_EQ(*converted, *value) << "'" << expected.Scalar() << "' as " << typeid(T).name();
+    }
+}
+
+test_config::Config parse(const std::string& input, ParserYaml::Backend backend, Provenance* provenance = nullptr) {
+    test_config::Config cfg;
+    ParserYaml parser(std::make_unique<MemorySource>("/test.yml", input));
+    parser.set_backend(backend);
+    parser.set_provenance(provenance);
+    auto res = parser.parse(&cfg);
+    EXPECT_FALSE(res) << res->at(0);
+    return cfg;
+}
+} // namespace
+
+TEST(YamlScannerTests, Structure) {
+    const std::string input = "# leading comment\n"
+                              "name: plain value # comment\n"
+                              "empty:\n"
+                              "tilde: ~\n"
+                              "nested:\n"
+                              "  inner:\n"
+                              "    - 1\n"
+                              "    -   two\n"
+                              "    -\n"
+                              "    - key: value\n"
+                              "      other: 2\n"
+                              "  after: x:y\n"
+                              "indentless:\n"
+                              "- a\n"
+                              "- b\n"
+                              "flow: [1, 'two', \"three\", {a: 1, b: [x, y]}, []]\r\n"
+                              "\n"
+                              "last: 'it''s'\n";
+
+    auto doc = YamlDocument::scan(input);
+    ASSERT_TRUE(doc);
+
+    const YamlNode root = doc->root();
+    ASSERT_TRUE(root.IsMap());
+    ASSERT_EQ(root.size(), 7);
+    ASSERT_EQ(root["name"].Scalar(), "plain value");
+    ASSERT_TRUE(root["empty"].IsNull());
+    ASSERT_TRUE(root["tilde"].IsNull());
+    ASSERT_FALSE(root["missing"]);
+    ASSERT_EQ(root["missing"].Type(), YAML::NodeType::Undefined);
+    ASSERT_FALSE(root["name"]["inner"]);
+
+    const YamlNode inner = root["nested"]["inner"];
+    ASSERT_TRUE(inner.IsSequence());
+    ASSERT_EQ(inner.size(), 4);
+    ASSERT_EQ(inner.Mark().line, 6);
+    ASSERT_EQ(inner.Mark().column, 4);
+
+    std::vector<YAML::NodeType::value> types;
+    for (const auto& item : inner) {
+        types.push_back(item.Type());
+    }
+    ASSERT_EQ(types, (std::vector<YAML::NodeType::value>{YAML::NodeType::Scalar, YAML::NodeType::Scalar,
+                                                          YAML::NodeType::Null, YAML::NodeType::Map}));
+    ASSERT_EQ((*++inner.begin()).Scalar(), "two");
+    ASSERT_EQ(root["nested"]["after"].Scalar(), "x:y");
+    ASSERT_EQ(root["indentless"].size(), 2);
+    ASSERT_EQ(root["flow"].size(), 5);
+    ASSERT_EQ(root["last"].Scalar(), "it's");
+
+    expect_same(input);
+}
+
+TEST(YamlScannerTests, SameAsYamlCpp) {
+    const std::vector<std::string> inputs = {
+        "",
+        "# only a comment\n",
+        "scalar",
+        "- 1\n- 2\n",
+        "a: 1\nb:\n  c: 2\n  d:\n    - x\n    - y: z\n      w: v\n",
+        "  indented: root\n  next: 1\n",
+        "list:\n- 1\n-\n- - nested\n  - deeper\n",
+        "a: {x: 1, y: [1, 2, {z: 3}], e: }\n",
+        "a: [ 1 , 2 ,3 ]\nb: {}\nc: []\n",
+        "quoted: \"tab\\there \\x41 \\u00e9 \\U0001d11e \\\\ \\\" \\/ \\N \\_\"\n",
+        "single: 'a # b'\ndouble: \"a # b\"\nplain: a#b\n",
+        "url: http://example.com:8080/path\nkey with spaces: value with:colon inside\n",
+        "trailing: value   \nspaces:    1   # comment\n",
+        "nulls: [~, null, Null, NULL, '~', \"null\"]\n",
+        "dash: -1\nneg: -x\n",
+        "windows: line\r\nendings: here\r\n",
+        "emoji: 𝄞 é\n",
+    };
+
+    for (const auto& input : inputs) {
+        SCOPED_TRACE(input);
+        expect_same(input);
+    }
+}
+
+TEST(YamlScannerTests, Conversions) {
+    const std::vector<std::string> values = {
+        "0", "1", "-1", "+1", "007", "0x1f", "0X1F", "-0x10", "08", "0x", "2147483647", "2147483648", "-2147483648",
+        "-2147483649", "4294967295", "4294967296", "9223372036854775807", "9223372036854775808",
+        "-9223372036854775808", "18446744073709551615", "18446744073709551616", "1e5", "1.5", "-.5", ".5", "+.5",
+        "+-1", "1.", "3.14", "-3.14e-2", "1e-400", "1e400", "-1e400", "3.5e38", ".inf", "-.Inf", "+.INF", ".nan",
+        ".NaN", "inf", "nan", "infinity", "0x1p3", "y", "Y", "yes", "Yes", "YES", "yEs", "true", "True", "TRUE", "on",
+        "ON", "n", "no", "No", "false", "FALSE", "off", "Off", "oFF", "truee", "t", "abc", "1 2", "'1'", "\"1\"",
+        "\"true\"", "''", "~", "null", "[1]", "{a: 1}", "\" 1 \"", "\"1 \"", "\"1\\n\"", "\"\\t1\"",
+    };
+
+    for (const auto& value : values) {
+        const std::string input = "v: " + value + "\n";
+        auto doc                = YamlDocument::scan(input);
+        ASSERT_TRUE(doc) << input;
+
+        const YamlNode node       = doc->root()["v"];
+        const YAML::Node expected = YAML::Load(input)["v"];
+        expect_same_conversion<bool>(node, expected);
+        expect_same_conversion<int32_t>(node, expected);
+        expect_same_conversion<int64_t>(node, expected);
+        expect_same_conversion<uint32_t>(node, expected);
+        expect_same_conversion<uint64_t>(node, expected);
+        expect_same_conversion<float>(node, expected);
+        expect_same_conversion<double>(node, expected);
+        expect_same_conversion<std::string>(node, expected);
+    }
+}
+
+TEST(YamlScannerTests, Fallback) {
+    const std::vector<std::string> inputs = {
+        "\xef\xbb\xbf" "field_i32: 1\n",
+        "%YAML 1.2\n---\nfield_i32: 1\n",
+        "---\nfield_i32: 1\n...\n",
+        "field_i32: &a 1\nfield_u32: *a\n",
+        "field_i32: !!int 1\n",
+        "field_string: |\n  line\n",
+        "field_string: >-\n  folded\n",
+        "field_string: first\n  second\n",
+        "field_string: \"first\n  second\"\n",
+        "field_string: 'first\n  second'\n",
+        "\"field_i32\": 1\n",
+        "'field_i32': 1\n",
+        "? field_i32\n: 1\n",
+        "field_repeated: [1,\n  2]\n",
+        "field_message:\n\tenabled: true\n",
+        "field_message: {enabled: true} extra\n",
+        "field_string: a: b\n",
+        "field_repeated: [1, 2\n",
+        "field_string: 'open\n",
+        "field_i32: 1\n field_u32: 2\n",
+        "field_string: \"\\q\"\n",
+    };
+
+    for (const auto& input : inputs) {
+        ASSERT_FALSE(YamlDocument::scan(input)) << input;
+
+        // Parsed by yaml-cpp instead, errors included
+        test_config::Config expected;
+        auto expected_res = ParserYaml(std::make_unique<MemorySource>("/test.yml", input)).parse(&expected);
+
+        test_config::Config cfg;
+        auto res = ParserYaml(std::make_unique<MemorySource>("/test.yml", input))
+                       .set_backend(ParserYaml::SCANNER)
+                       .parse(&cfg);
+        ASSERT_EQ(res, expected_res) << input;
+        ASSERT_TRUE(MessageDifferencer::Equals(cfg, expected)) << input;
+    }
+}
+
+TEST(YamlScannerTests, Differential) {
+    test_config::Config cfg;
+    cfg.set_enabled(true);
+    cfg.set_field_i32(-32);
+    cfg.set_field_u64(18446744073709551615ULL);
+    cfg.set_field_double(1e-300);
+    cfg.set_field_float(0.12345F);
+    cfg.set_field_string("quotes \" and \\ and \t and é");
+    cfg.mutable_field_message()->set_enabled(true);
+    cfg.add_field_repeated(1);
+    cfg.add_field_repeated(2);
+    cfg.set_field_enum(test_config::EnumField::TYPE2);
+    cfg.add_field_repeated_enum(test_config::EnumField::TYPE1);
+
+    std::string input;
+    YamlWriter().write(cfg, &input);
+    ASSERT_TRUE(YamlDocument::scan(input));
+
+    Provenance yaml_cpp_origins;
+    Provenance scanner_origins;
+    const auto expected = parse(input, ParserYaml::YAML_CPP, &yaml_cpp_origins);
+    const auto parsed   = parse(input, ParserYaml::SCANNER, &scanner_origins);
+    ASSERT_TRUE(MessageDifferencer::Equals(parsed, cfg));
+    ASSERT_TRUE(MessageDifferencer::Equals(parsed, expected));
+
+    ASSERT_EQ(scanner_origins.size(), yaml_cpp_origins.size());
+    for (const std::string path : {"enabled", "field_string", "field_message.enabled", "field_repeated"}) {
+        ASSERT_EQ(scanner_origins.find(path), yaml_cpp_origins.find(path)) << path;
+    }
+    ASSERT_EQ(scanner_origins.find("field_repeated")->line, 10);
+}
+
+TEST(YamlScannerTests, Deferred) {
+    const std::string input = R"(
+        general:
+            enabled: true
+        routing:
+            port: 80
+            name: "edge\x2d1"
+    )";
+
+    DeferredSections sections;
+    test_config::Sections cfg;
+    sections.reset(cfg);
+
+    {
+        // The document outlives the parser and the buffer it was read from
+        std::string buffer = input;
+        ParserYaml parser(std::make_unique<MemorySource>("/test.yml", buffer));
+        parser.set_backend(ParserYaml::SCANNER);
+        parser.set_deferred(&sections);
+        ASSERT_FALSE(parser.parse(&cfg));
+        buffer.assign(buffer.size(), '#');
+    }
+    ASSERT_TRUE(cfg.general().enabled());
+    ASSERT_FALSE(cfg.has_routing());
+
+    const auto* routing = sections.get<test_config::Limits>("routing");
+    ASSERT_NE(routing, nullptr);
+    ASSERT_EQ(routing->port(), 80);
+    ASSERT_EQ(routing->name(), "edge-1");
+    ASSERT_FALSE(sections.errors("routing"));
+}
+
+} // namespace config_much::internal
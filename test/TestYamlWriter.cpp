@@ -0,0 +1,275 @@
+#include "config-much.h"
+#include "internal/default-values.h"
+#include "internal/parser-yaml.h"
+#include "internal/yaml-writer.h"
+
+#include "proto/test-config.pb.h"
+
+#include <google/protobuf/util/message_differencer.h>
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+namespace config_much::internal {
+using google::protobuf::util::MessageDifferencer;
+
+namespace {
+test_config::Config all_fields() {
+    test_config::Config cfg;
+    cfg.set_enabled(true);
+    cfg.set_field_i32(std::numeric_limits<int32_t>::min());
+    cfg.set_field_u32(std::numeric_limits<uint32_t>::max());
+    cfg.set_field_i64(std::numeric_limits<int64_t>::min());
+    cfg.set_field_u64(std::numeric_limits<uint64_t>::max());
+    cfg.set_field_double(0.1);
+    cfg.set_field_float(0.12345F);
+    cfg.set_field_string("Yes, this is some random string for testing");
+    cfg.mutable_field_message()->set_enabled(true);
+    cfg.add_field_repeated(1);
+    cfg.add_field_repeated(18446744073709551615ULL);
+    cfg.set_field_enum(test_config::EnumField::TYPE2);
+    cfg.add_field_repeated_enum(test_config::EnumField::TYPE2);
+    cfg.add_field_repeated_enum(test_config::EnumField::TYPE1);
+    return cfg;
+}
+
+/// Write msg and parse it back into out.
+void round_trip(const google::protobuf::Message& msg, google::protobuf::Message* out, bool camelcase = false) {
+    std::string yaml;
+    YamlWriter(camelcase).write(msg, &yaml);
+
+    auto res = ParserYaml(std::make_unique<MemorySource>("/dump.yml", yaml), camelcase, ParserYaml::UNKNOWN_FIELDS_ONLY)
+                   .parse(out);
+    ASSERT_FALSE(res) << res->at(0) << "\n" << yaml;
+    ASSERT_TRUE(MessageDifferencer::Equals(msg, *out)) << yaml;
+}
+} // namespace
+
+TEST(YamlWriterTests, Output) {
+    test_config::Config cfg;
+    cfg.set_enabled(true);
+    cfg.set_field_double(-1.5);
+    cfg.set_field_string("a \"quoted\"\nline");
+    cfg.mutable_field_message();
+    cfg.add_field_repeated(1);
+    cfg.add_field_repeated(2);
+    cfg.set_field_enum(test_config::EnumField::TYPE2);
+
+    std::string out;
+    YamlWriter().write(cfg, &out);
+    ASSERT_EQ(out, "enabled: true\n"
+                   "field_double: -1.5\n"
+                   "field_string: \"a \\\"quoted\\\"\\nline\"\n"
+                   "field_message: {}\n"
+                   "field_repeated:\n"
+                   "  - 1\n"
+                   "  - 2\n"
+                   "field_enum: TYPE2\n");
+
+    out.clear();
+    YamlWriter(true).write(cfg.field_message(), &out);
+    ASSERT_EQ(out, "{}\n");
+}
+
+TEST(YamlWriterTests, RoundTrip) {
+    const auto cfg = all_fields();
+
+    test_config::Config parsed;
+    round_trip(cfg, &parsed);
+
+    test_config::Config camel;
+    round_trip(cfg, &camel, true);
+
+    test_config::Config empty;
+    round_trip(test_config::Config(), &empty);
+}
+
+TEST(YamlWriterTests, Floats) {
+    for (double value : {0.0, -0.0, 1e-320, 1.7976931348623157e308, 3.141592653589793, 1e21,
+                         std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity()}) {
+        test_config::Config cfg;
+        cfg.set_field_double(value);
+        cfg.set_field_float(static_cast<float>(value));
+
+        test_config::Config parsed;
+        round_trip(cfg, &parsed);
+    }
+
+    test_config::Config cfg;
+    cfg.set_field_double(std::nan(""));
+
+    std::string out;
+    YamlWriter().write(cfg, &out);
+    ASSERT_EQ(out, "field_double: .nan\n");
+
+    test_config::Config parsed;
+    ASSERT_FALSE(ParserYaml(std::make_unique<MemorySource>("/dump.yml", out)).parse(&parsed));
+    ASSERT_TRUE(std::isnan(parsed.field_double()));
+}
+
+TEST(YamlWriterTests, Strings) {
+    const std::vector<std::string> values = {
+        "", " leading space", "trailing space ", "# not a comment", "key: value", "null", "~", "true", "42",
+        "- item", "[flow]", "{flow}", "'single'", "back\\slash", "tab\there", "cr\rlf\n", "\x01\x1f\x7f",
+        std::string("nul\0byte", 8), "é ✓ 𝄞",
+    };
+
+    for (const auto& value : values) {
+        test_config::Config cfg;
+        cfg.set_field_string(value);
+
+        test_config::Config parsed;
+        round_trip(cfg, &parsed);
+        ASSERT_EQ(parsed.field_string(), value);
+    }
+}
+
+TEST(YamlWriterTests, Bytes) {
+    std::string data;
+    for (int i = 0; i < 256; i++) {
+        data.push_back(static_cast<char>(i));
+    }
+
+    test_config::Blobs blobs;
+    blobs.set_data(data);
+    blobs.add_chunks("");
+    blobs.add_chunks("a");
+    blobs.add_chunks("ab");
+    blobs.add_chunks("file:not-a-reference");
+
+    test_config::Blobs parsed;
+    round_trip(blobs, &parsed);
+}
+
+TEST(YamlWriterTests, WellKnown) {
+    struct test_case {
+        int64_t seconds;
+        int32_t nanos;
+    };
+
+    for (const auto& [seconds, nanos] : std::vector<test_case>{{0, 0}, {5400, 0}, {1, 500000000}, {-1, -500000000},
+                                                               {0, -1}, {-62135596800, 0}, {253402300799, 999999999}}) {
+        test_config::WellKnown wk;
+        wk.mutable_timeout()->set_seconds(seconds);
+        wk.mutable_timeout()->set_nanos(nanos);
+        if (nanos >= 0) {
+            wk.mutable_deadline()->set_seconds(seconds);
+            wk.mutable_deadline()->set_nanos(nanos);
+        }
+
+        test_config::WellKnown parsed;
+        round_trip(wk, &parsed);
+    }
+
+    // Values parse_time can't represent are written as maps
+    test_config::WellKnown wk;
+    wk.mutable_timeout()->set_seconds(1);
+    wk.mutable_timeout()->set_nanos(-1);
+    wk.mutable_deadline()->set_seconds(253402300800);
+
+    std::string out;
+    YamlWriter().write(wk, &out);
+    ASSERT_EQ(out, "timeout:\n  seconds: 1\n  nanos: -1\ndeadline:\n  seconds: 253402300800\n");
+
+    test_config::WellKnown parsed;
+    round_trip(wk, &parsed);
+}
+
+TEST(YamlWriterTests, Nested) {
+    test_config::Sections sections;
+    sections.mutable_general()->set_enabled(true);
+    sections.mutable_routing()->set_port(80);
+    sections.mutable_routing()->set_name("edge");
+    *sections.mutable_catalog() = all_fields();
+
+    std::string out;
+    YamlWriter().write(sections, &out);
+    const std::string head = "general:\n  enabled: true\nrouting:\n  port: 80\n  name: \"edge\"\ncatalog:\n";
+    ASSERT_EQ(out.rfind(head, 0), 0) << out;
+
+    test_config::Sections parsed;
+    round_trip(sections, &parsed);
+}
+
+TEST(YamlWriterTests, Defaults) {
+    test_config::Defaults cfg;
+    DefaultValues::get(cfg).apply(&cfg, nullptr);
+    cfg.set_port(0);
+    cfg.set_kind(test_config::TYPE1);
+    cfg.clear_tags();
+    cfg.mutable_inner()->set_enabled(false);
+
+    // Fields holding zero values are written when the schema gives them another default
+    std::string yaml;
+    YamlWriter().write(cfg, &yaml);
+    ASSERT_NE(yaml.find("port: 0\n"), std::string::npos) << yaml;
+    ASSERT_NE(yaml.find("tags: []\n"), std::string::npos) << yaml;
+    ASSERT_NE(yaml.find("kind: TYPE1\n"), std::string::npos) << yaml;
+
+    test_config::Defaults parsed;
+    auto res = Parser().add_buffer("/dump.yml", yaml).parse(&parsed);
+    ASSERT_FALSE(res) << res->at(0) << "\n" << yaml;
+    ASSERT_TRUE(MessageDifferencer::Equals(cfg, parsed)) << yaml << parsed.DebugString();
+}
+
+TEST(YamlWriterTests, RepeatedMessages) {
+    test_config::Validated validated;
+    validated.add_tags("a");
+    validated.add_tags("b");
+
+    std::string out;
+    YamlWriter().write(validated, &out);
+    ASSERT_EQ(out, "tags:\n  - \"a\"\n  - \"b\"\n");
+
+    // Checked against yaml-cpp since ParserYaml doesn't read repeated messages
+    google::protobuf::FileDescriptorProto file;
+    test_config::Config::descriptor()->file()->CopyTo(&file);
+    file.add_dependency("unused.proto");
+
+    out.clear();
+    YamlWriter().write(file, &out);
+
+    const YAML::Node node = YAML::Load(out);
+    ASSERT_EQ(node["name"].as<std::string>(), file.name());
+    ASSERT_EQ(node["message_type"].size(), static_cast<size_t>(file.message_type_size()));
+    ASSERT_EQ(node["message_type"][1]["name"].as<std::string>(), "Config");
+    ASSERT_EQ(node["message_type"][1]["field"][1]["name"].as<std::string>(), "field_i32");
+    ASSERT_EQ(node["message_type"][1]["field"][1]["type"].as<std::string>(), "TYPE_INT32");
+}
+
+TEST(YamlWriterTests, Fd) {
+    const auto path = std::filesystem::temp_directory_path() / "config-much-YamlWriterFd.yml";
+
+    // Large enough to be written in several chunks
+    test_config::Config cfg = all_fields();
+    for (int i = 0; i < 20000; i++) {
+        cfg.add_field_repeated(i);
+    }
+
+    const int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    ASSERT_GE(fd, 0);
+    ASSERT_FALSE(YamlWriter().write(cfg, fd));
+    close(fd);
+
+    std::string expected;
+    YamlWriter().write(cfg, &expected);
+    std::stringstream content;
+    content << std::ifstream(path).rdbuf();
+    ASSERT_EQ(content.str(), expected);
+
+    test_config::Config parsed;
+    ASSERT_FALSE(ParserYaml(path).parse(&parsed));
+    ASSERT_TRUE(MessageDifferencer::Equals(cfg, parsed));
+
+    ASSERT_TRUE(YamlWriter().write(cfg, -1));
+    std::filesystem::remove(path);
+}
+
+} // namespace config_much::internal